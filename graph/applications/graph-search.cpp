@@ -31,7 +31,11 @@
 
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <Eigen/Geometry>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_scheduler_init.h>
 #include <comma/application/command_line_options.h>
 #include <comma/csv/traits.h>
 #include <comma/name_value/parser.h>
@@ -56,6 +60,11 @@ static void usage( bool verbose )
     std::cerr << "    --nodes,--vertices=<filename>[,<csv options>]: graph nodes; default fields: x,y,z,id" << std::endl;
     std::cerr << "    --source,--start-id,--from,--start,--origin: source node id" << std::endl;
     std::cerr << "    --target,--target-id,--to,--destination: target node id" << std::endl;
+    std::cerr << "    --a-star: a-star search with euclidean distance to target as heuristic, stops once target reached" << std::endl;
+    std::cerr << "    --bidirectional: bidirectional search from source and target, with euclidean heuristic, if --a-star" << std::endl;
+    std::cerr << "    --batch=<size>: read queries as source,target ids from stdin and search them in batches of given size, e.g. 1000;" << std::endl;
+    std::cerr << "                    queries of a batch with the same source share one search; output: path records, each followed by query" << std::endl;
+    std::cerr << "    --threads=<n>: --batch only: number of threads searching queries of a batch; default: 1" << std::endl;
     std::cerr << "    --verbose,-v: more output" << std::endl;
     if( verbose ) { std::cerr << std::endl << "csv options" << std::endl << comma::csv::options::usage() << std::endl; }
     std::cerr << std::endl;
@@ -79,6 +88,13 @@ struct edge {};
 
 struct record { comma::uint32 id; };
 
+struct query
+{
+    comma::uint32 source;
+    comma::uint32 target;
+    query() : source( 0 ), target( 0 ) {}
+};
+
 namespace comma { namespace visiting {
 
 template <> struct traits< node >
@@ -114,6 +130,21 @@ template <> struct traits< record >
         v.apply( "id", n.id );
     }
 };
+
+template <> struct traits< query >
+{
+    template < typename K, typename V > static void visit( const K&, query& n, V& v )
+    {
+        v.apply( "source", n.source );
+        v.apply( "target", n.target );
+    }
+
+    template < typename K, typename V > static void visit( const K&, const query& n, V& v )
+    {
+        v.apply( "source", n.source );
+        v.apply( "target", n.target );
+    }
+};
     
 } } // namespace comma { namespace visiting {
 
@@ -123,6 +154,8 @@ typedef search_graph_t::vertex_iter vertex_iterator;
 typedef search_graph_t::vertex_desc vertex_descriptor;
 typedef boost::unordered_map< comma::uint32, std::string > records_t;
 static bool verbose = false;
+static bool a_star = false;
+static bool bidirectional = false;
 static graph_t graph;
 static records_t records;
 
@@ -161,19 +194,27 @@ static boost::optional< node > advance( const node& from, const node& to ) { ret
 
 static bool valid( const node& n ) { return true; }
 
-static void reset_graph()
+struct euclidean_heuristic
 {
-    for( std::pair< vertex_iterator, vertex_iterator > d = boost::vertices( graph ); d.first != d.second; ++d.first )
-    {
-        search_graph_t::node& n = graph[ *d.first ];
-        n.best_parent.reset();
-        n.value.distance = 0;
-    }
-}
+    Eigen::Vector3d target;
+    euclidean_heuristic( const Eigen::Vector3d& target ) : target( target ) {}
+    double operator()( const search_graph_t::node& n ) const { return -( n.value.position - target ).norm(); }
+};
+
+struct euclidean_distance
+{
+    double operator()( const search_graph_t::node& a, const search_graph_t::node& b ) const { return ( a.value.position - b.value.position ).norm(); }
+};
+
+struct edge_length
+{
+    boost::optional< double > operator()( const search_graph_t::node& from, const search_graph_t::node& to ) const { return ( to.value.position - from.value.position ).norm(); }
+};
 
-static std::vector< vertex_descriptor > best_path( comma::uint32 source_id, comma::uint32 target_id )
+typedef snark::search_workspace< graph_t > workspace_t;
+
+static std::vector< vertex_descriptor > best_path( workspace_t& workspace, comma::uint32 source_id, comma::uint32 target_id )
 {
-    reset_graph();
     vertex_descriptor source = NULL;
     vertex_descriptor target = NULL;
     for( std::pair< vertex_iterator, vertex_iterator > d = boost::vertices( graph ); d.first != d.second; ++d.first )
@@ -186,9 +227,118 @@ static std::vector< vertex_descriptor > best_path( comma::uint32 source_id, comm
     if( !target ) { std::cerr << "graph-search: target id " << target_id << " not found in the graph" << std::endl; exit( 1 ); }
     if( source == target ) { return std::vector< vertex_descriptor >( 1, source ); }
     if( verbose ) { std::cerr << "graph-search: searching..." << std::endl; }
-    snark::forward_search( graph, source, &advance, &objective_function, &valid );
-    if( verbose ) { std::cerr << "graph-search: extracting best path from " << source_id << " to " << target_id << "..." << std::endl; }
-    return snark::best_path( graph, source, target );
+    if( bidirectional )
+    {
+        std::size_t expanded;
+        const std::vector< vertex_descriptor >& p = a_star ? snark::bidirectional_search( graph, source, target, edge_length(), euclidean_distance(), &expanded )
+                                                           : snark::bidirectional_search( graph, source, target, edge_length(), snark::impl::no_heuristic(), &expanded );
+        if( verbose ) { std::cerr << "graph-search: expanded " << expanded << " vertices" << std::endl; }
+        return p;
+    }
+    std::size_t expanded = a_star ? snark::a_star_search( workspace, source, target, &advance, &objective_function, &valid, euclidean_heuristic( graph[target].value.position ) )
+                                  : snark::forward_search( workspace, source, &advance, &objective_function, &valid );
+    if( verbose ) { std::cerr << "graph-search: expanded " << expanded << " vertices; extracting best path from " << source_id << " to " << target_id << "..." << std::endl; }
+    return workspace.best_path( source, target );
+}
+
+struct batch_query
+{
+    vertex_descriptor source;
+    vertex_descriptor target;
+    std::string record;
+    std::vector< vertex_descriptor > path;
+};
+
+/// search queries grouped by source, i-th thread takes every n-th group
+struct search_batch
+{
+    std::vector< workspace_t* >& workspaces;
+    const std::vector< std::vector< std::size_t > >& groups;
+    std::vector< batch_query >& queries;
+
+    search_batch( std::vector< workspace_t* >& workspaces, const std::vector< std::vector< std::size_t > >& groups, std::vector< batch_query >& queries ) : workspaces( workspaces ), groups( groups ), queries( queries ) {}
+
+    void operator()( const tbb::blocked_range< std::size_t >& range ) const
+    {
+        for( std::size_t t = range.begin(); t < range.end(); ++t )
+        {
+            for( std::size_t g = t; g < groups.size(); g += workspaces.size() )
+            {
+                vertex_descriptor source = queries[ groups[g][0] ].source;
+                snark::forward_search( *workspaces[t], source, &advance, &objective_function, &valid );
+                std::vector< vertex_descriptor > targets( groups[g].size() );
+                for( std::size_t i = 0; i < groups[g].size(); ++i ) { targets[i] = queries[ groups[g][i] ].target; }
+                const std::vector< workspace_t::path >& paths = workspaces[t]->best_paths( source, targets );
+                for( std::size_t i = 0; i < groups[g].size(); ++i ) { queries[ groups[g][i] ].path = paths[i].vertices; }
+            }
+        }
+    }
+};
+
+static void search_batch_( std::vector< workspace_t* >& workspaces, std::vector< batch_query >& queries )
+{
+    std::map< vertex_descriptor, std::size_t > sources;
+    std::vector< std::vector< std::size_t > > groups;
+    for( std::size_t i = 0; i < queries.size(); ++i )
+    {
+        std::map< vertex_descriptor, std::size_t >::const_iterator it = sources.insert( std::make_pair( queries[i].source, groups.size() ) ).first;
+        if( it->second == groups.size() ) { groups.push_back( std::vector< std::size_t >() ); }
+        groups[ it->second ].push_back( i );
+    }
+    tbb::parallel_for( tbb::blocked_range< std::size_t >( 0, workspaces.size(), 1 ), search_batch( workspaces, groups, queries ) );
+}
+
+static int run_batches( const comma::command_line_options& options, const comma::csv::options& node_csv )
+{
+    std::size_t size = options.value< std::size_t >( "--batch" );
+    unsigned int threads = options.value< unsigned int >( "--threads", 1 );
+    if( size == 0 ) { std::cerr << "graph-search: expected positive --batch size" << std::endl; return 1; }
+    if( threads == 0 ) { std::cerr << "graph-search: expected positive number of threads" << std::endl; return 1; }
+    boost::unordered_map< comma::uint32, vertex_descriptor > vertices;
+    for( std::pair< vertex_iterator, vertex_iterator > d = boost::vertices( graph ); d.first != d.second; ++d.first ) { vertices[ graph[ *d.first ].id ] = *d.first; }
+    tbb::task_scheduler_init init( threads );
+    std::vector< workspace_t* > workspaces( threads );
+    for( unsigned int i = 0; i < threads; ++i ) { workspaces[i] = new workspace_t( graph ); }
+    comma::csv::options csv( options, "source,target" );
+    comma::csv::input_stream< query > istream( std::cin, csv );
+    std::vector< batch_query > queries;
+    queries.reserve( size );
+    int result = 0;
+    while( result == 0 )
+    {
+        queries.clear();
+        while( queries.size() < size && ( istream.ready() || ( std::cin.good() && !std::cin.eof() ) ) )
+        {
+            const query* q = istream.read();
+            if( !q ) { break; }
+            boost::unordered_map< comma::uint32, vertex_descriptor >::const_iterator source = vertices.find( q->source );
+            if( source == vertices.end() ) { std::cerr << "graph-search: source id " << q->source << " not found in the graph" << std::endl; result = 1; break; }
+            boost::unordered_map< comma::uint32, vertex_descriptor >::const_iterator target = vertices.find( q->target );
+            if( target == vertices.end() ) { std::cerr << "graph-search: target id " << q->target << " not found in the graph" << std::endl; result = 1; break; }
+            queries.push_back( batch_query() );
+            queries.back().source = source->second;
+            queries.back().target = target->second;
+            queries.back().record = csv.binary() ? std::string( istream.binary().last(), csv.format().size() ) : comma::join( istream.ascii().last(), csv.delimiter );
+        }
+        if( queries.empty() ) { break; }
+        search_batch_( workspaces, queries );
+        for( std::size_t i = 0; i < queries.size(); ++i )
+        {
+            const batch_query& q = queries[i];
+            if( q.path.empty() ) { std::cerr << "graph-search: failed to find path from " << graph[ q.source ].id << " to " << graph[ q.target ].id << std::endl; result = 1; break; }
+            for( std::size_t k = 0; k < q.path.size(); ++k )
+            {
+                const std::string& s = records[ graph[ q.path[k] ].id ];
+                std::cout.write( &s[0], s.size() );
+                if( !node_csv.binary() ) { std::cout << csv.delimiter; }
+                std::cout.write( &q.record[0], q.record.size() );
+                if( !node_csv.binary() ) { std::cout << std::endl; }
+            }
+        }
+        if( verbose ) { std::cerr << "graph-search: answered batch of " << queries.size() << " queries" << std::endl; }
+    }
+    for( unsigned int i = 0; i < threads; ++i ) { delete workspaces[i]; }
+    return result;
 }
 
 int main( int ac, char** av )
@@ -197,6 +347,8 @@ int main( int ac, char** av )
     {
         comma::command_line_options options( ac, av, usage );
         verbose = options.exists( "--verbose,-v" );
+        a_star = options.exists( "--a-star" );
+        bidirectional = options.exists( "--bidirectional" );
         comma::csv::options node_csv = comma::name_value::parser( "filename", ';' ).get< comma::csv::options >( options.value< std::string >( "--vertices,--nodes" ) );
         comma::csv::options edge_csv = comma::name_value::parser( "filename", ';' ).get< comma::csv::options >( options.value< std::string >( "--edges" ) );
         if( node_csv.fields.empty() ) { node_csv.fields = "value/position/x,value/position/y,value/position/z,id"; }
@@ -208,9 +360,11 @@ int main( int ac, char** av )
         boost::optional< unsigned int > target_id = options.optional< unsigned int >( "--target,--target-id,--to,--destination" );
         if( source_id && !target_id ) { std::cerr << "graph-search: --source specified, thus, please specify --target" << std::endl; return 1; }
         if( !source_id && target_id ) { std::cerr << "graph-search: --target specified, thus, please specify --source" << std::endl; return 1; }
+        if( options.exists( "--batch" ) ) { return run_batches( options, node_csv ); }
+        workspace_t workspace( graph );
         if( source_id && target_id )
         {
-            const std::vector< vertex_descriptor >& p = best_path( *source_id, *target_id );
+            const std::vector< vertex_descriptor >& p = best_path( workspace, *source_id, *target_id );
             for( std::size_t i = 0; i < p.size(); ++i )
             {
                 const std::string& s = records[ graph[ p[i] ].id ];
@@ -231,7 +385,7 @@ int main( int ac, char** av )
                 if( !r ) { break; }
                 if( !last.empty() )
                 {
-                    const std::vector< vertex_descriptor >& p = best_path( last_id, r->id );
+                    const std::vector< vertex_descriptor >& p = best_path( workspace, last_id, r->id );
                     if( p.empty() ) { std::cerr << "graph-search: failed to find path from " << last_id << " to " << r->id << std::endl; return 1; }
                     for( std::size_t i = 0; i < p.size(); ++i )
                     {
@@ -0,0 +1,373 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SNARK_GRAPH_CSR_GRAPH_H_
+#define SNARK_GRAPH_CSR_GRAPH_H_
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#include <boost/graph/graph_traits.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/iterator/counting_iterator.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <comma/base/exception.h>
+#include <comma/base/types.h>
+
+namespace snark {
+
+namespace impl {
+
+/// edge descriptor of csr graph: index of edge in out-edge arrays
+struct csr_edge
+{
+    comma::uint32 index;
+    csr_edge() : index( 0 ) {}
+    explicit csr_edge( comma::uint32 index ) : index( index ) {}
+    bool operator==( const csr_edge& rhs ) const { return index == rhs.index; }
+    bool operator!=( const csr_edge& rhs ) const { return index != rhs.index; }
+    bool operator<( const csr_edge& rhs ) const { return index < rhs.index; }
+};
+
+/// iterator over consecutive edges, e.g. out-edges of a vertex
+class csr_edge_iterator : public boost::iterator_facade< csr_edge_iterator, csr_edge, boost::random_access_traversal_tag, csr_edge >
+{
+    public:
+        csr_edge_iterator() : index_( 0 ) {}
+        explicit csr_edge_iterator( comma::uint32 index ) : index_( index ) {}
+
+    private:
+        friend class boost::iterator_core_access;
+        comma::uint32 index_;
+        csr_edge dereference() const { return csr_edge( index_ ); }
+        bool equal( const csr_edge_iterator& rhs ) const { return index_ == rhs.index_; }
+        void increment() { ++index_; }
+        void decrement() { --index_; }
+        void advance( std::ptrdiff_t n ) { index_ += n; }
+        std::ptrdiff_t distance_to( const csr_edge_iterator& rhs ) const { return std::ptrdiff_t( rhs.index_ ) - std::ptrdiff_t( index_ ); }
+};
+
+/// iterator over edges listed by index, e.g. in-edges of a vertex
+class csr_edge_list_iterator : public boost::iterator_facade< csr_edge_list_iterator, csr_edge, boost::random_access_traversal_tag, csr_edge >
+{
+    public:
+        csr_edge_list_iterator() : index_( NULL ) {}
+        explicit csr_edge_list_iterator( const comma::uint32* index ) : index_( index ) {}
+
+    private:
+        friend class boost::iterator_core_access;
+        const comma::uint32* index_;
+        csr_edge dereference() const { return csr_edge( *index_ ); }
+        bool equal( const csr_edge_list_iterator& rhs ) const { return index_ == rhs.index_; }
+        void increment() { ++index_; }
+        void decrement() { --index_; }
+        void advance( std::ptrdiff_t n ) { index_ += n; }
+        std::ptrdiff_t distance_to( const csr_edge_list_iterator& rhs ) const { return rhs.index_ - index_; }
+};
+
+} // namespace impl {
+
+/// immutable directed graph in compressed sparse row format: out-edges and in-edges of each vertex
+/// are contiguous ranges of index arrays, vertex and edge payloads are kept in two plain arrays
+///
+/// all arrays live in one memory block with the same layout in memory and on disk, thus
+/// the graph written to a file can be memory-mapped instead of being parsed and built on startup
+///
+/// vertices are numbered 0 to num_vertices - 1 and can be used as dense indices; edges
+/// cannot be added or removed, but vertex and edge payloads can be changed, e.g. by forward_search
+///
+/// implements boost graph vertex list, edge list, incidence and bidirectional graph interfaces
+/// as free functions found by argument-dependent lookup, e.g. out_edges( v, graph )
+///
+/// V and E are copied and written byte by byte, thus they should not have pointers or
+/// heap-allocated members, e.g. std::string; file format is not portable across architectures
+template < typename V, typename E >
+class csr_graph : public boost::noncopyable
+{
+    public:
+        typedef comma::uint32 vertex_descriptor;
+        typedef impl::csr_edge edge_descriptor;
+        typedef impl::csr_edge_iterator out_edge_iterator;
+        typedef impl::csr_edge_list_iterator in_edge_iterator;
+        typedef impl::csr_edge_iterator edge_iterator;
+        typedef boost::counting_iterator< comma::uint32 > vertex_iterator;
+        typedef boost::bidirectional_tag directed_category;
+        typedef boost::allow_parallel_edge_tag edge_parallel_category;
+        struct traversal_category : public boost::vertex_list_graph_tag, public boost::edge_list_graph_tag, public boost::bidirectional_graph_tag {};
+        typedef comma::uint32 vertices_size_type;
+        typedef comma::uint32 edges_size_type;
+        typedef comma::uint32 degree_size_type;
+        typedef V vertex_bundled;
+        typedef V vertex_property_type;
+        typedef E edge_bundled;
+        typedef E edge_property_type;
+
+        /// file header
+        struct header
+        {
+            comma::uint64 magic;
+            comma::uint32 version;
+            comma::uint32 vertex_size; // sizeof( V )
+            comma::uint32 edge_size; // sizeof( E )
+            comma::uint32 vertices;
+            comma::uint32 edges;
+            comma::uint32 reserved;
+        };
+        enum { version = 1 };
+        static comma::uint64 magic() { return 0x7273636b72616e73ULL; } // "snarkcsr" in little-endian byte order
+
+        /// constructor, empty graph
+        csr_graph() { allocate_( 0, 0 ); }
+
+        /// constructor, copy of boost graph, e.g. boost::adjacency_list; vertices are numbered
+        /// in the order of boost::vertices( graph ), out-edges in the order of boost::out_edges
+        template < typename G >
+        explicit csr_graph( const G& graph );
+
+        /// write graph to stream, e.g. to memory-map it later
+        void write( std::ostream& os ) const;
+
+        /// write graph to file
+        void write( const std::string& filename ) const;
+
+        /// memory-map graph from file written by write(); changes of vertex or edge payloads are not written back
+        void map( const std::string& filename );
+
+        /// read graph from file written by write() into memory
+        void read( const std::string& filename );
+
+        /// return null vertex
+        static vertex_descriptor null_vertex() { return vertex_descriptor( -1 ); }
+
+        friend comma::uint32 num_vertices( const csr_graph& g ) { return g.header_->vertices; }
+        friend comma::uint32 num_edges( const csr_graph& g ) { return g.header_->edges; }
+        friend comma::uint32 out_degree( vertex_descriptor v, const csr_graph& g ) { return g.offsets_[ v + 1 ] - g.offsets_[v]; }
+        friend comma::uint32 in_degree( vertex_descriptor v, const csr_graph& g ) { return g.in_offsets_[ v + 1 ] - g.in_offsets_[v]; }
+        friend comma::uint32 degree( vertex_descriptor v, const csr_graph& g ) { return out_degree( v, g ) + in_degree( v, g ); }
+        friend std::pair< out_edge_iterator, out_edge_iterator > out_edges( vertex_descriptor v, const csr_graph& g ) { return std::make_pair( out_edge_iterator( g.offsets_[v] ), out_edge_iterator( g.offsets_[ v + 1 ] ) ); }
+        friend std::pair< in_edge_iterator, in_edge_iterator > in_edges( vertex_descriptor v, const csr_graph& g ) { return std::make_pair( in_edge_iterator( g.in_edges_ + g.in_offsets_[v] ), in_edge_iterator( g.in_edges_ + g.in_offsets_[ v + 1 ] ) ); }
+        friend std::pair< vertex_iterator, vertex_iterator > vertices( const csr_graph& g ) { return std::make_pair( vertex_iterator( 0 ), vertex_iterator( g.header_->vertices ) ); }
+        friend std::pair< edge_iterator, edge_iterator > edges( const csr_graph& g ) { return std::make_pair( edge_iterator( 0 ), edge_iterator( g.header_->edges ) ); }
+        friend vertex_descriptor source( const edge_descriptor& e, const csr_graph& g ) { return g.sources_[ e.index ]; }
+        friend vertex_descriptor target( const edge_descriptor& e, const csr_graph& g ) { return g.targets_[ e.index ]; }
+
+        V& operator[]( vertex_descriptor v ) { return vertex_values_[v]; }
+        const V& operator[]( vertex_descriptor v ) const { return vertex_values_[v]; }
+        E& operator[]( const edge_descriptor& e ) { return edge_values_[ e.index ]; }
+        const E& operator[]( const edge_descriptor& e ) const { return edge_values_[ e.index ]; }
+
+    private:
+        std::vector< comma::uint64 > buffer_; // 8-byte aligned
+        boost::scoped_ptr< boost::interprocess::mapped_region > region_;
+        const char* data_;
+        std::size_t size_;
+        const header* header_;
+        const comma::uint32* offsets_;
+        const comma::uint32* targets_;
+        const comma::uint32* sources_;
+        const comma::uint32* in_offsets_;
+        const comma::uint32* in_edges_;
+        V* vertex_values_;
+        E* edge_values_;
+
+        struct layout
+        {
+            std::size_t offsets;
+            std::size_t targets;
+            std::size_t sources;
+            std::size_t in_offsets;
+            std::size_t in_edges;
+            std::size_t vertices;
+            std::size_t edges;
+            std::size_t size;
+            layout( comma::uint32 n, comma::uint32 m )
+            {
+                std::size_t s = sizeof( header );
+                offsets = align_( s ); s = offsets + ( std::size_t( n ) + 1 ) * sizeof( comma::uint32 );
+                targets = align_( s ); s = targets + std::size_t( m ) * sizeof( comma::uint32 );
+                sources = align_( s ); s = sources + std::size_t( m ) * sizeof( comma::uint32 );
+                in_offsets = align_( s ); s = in_offsets + ( std::size_t( n ) + 1 ) * sizeof( comma::uint32 );
+                in_edges = align_( s ); s = in_edges + std::size_t( m ) * sizeof( comma::uint32 );
+                vertices = align_( s ); s = vertices + std::size_t( n ) * sizeof( V );
+                edges = align_( s ); s = edges + std::size_t( m ) * sizeof( E );
+                size = align_( s );
+            }
+            static std::size_t align_( std::size_t s ) { return ( s + 15 ) & ~std::size_t( 15 ); }
+        };
+
+        char* allocate_( comma::uint32 n, comma::uint32 m );
+        void attach_( const char* data, std::size_t size );
+        void check_( const header& h, std::size_t size, const std::string& filename ) const;
+};
+
+template < typename V, typename E >
+template < typename G >
+inline csr_graph< V, E >::csr_graph( const G& graph )
+{
+    typedef boost::graph_traits< G > traits_t;
+    typedef typename traits_t::vertex_descriptor descriptor_t;
+    std::size_t vertex_count = num_vertices( graph );
+    std::size_t edge_count = num_edges( graph );
+    if( vertex_count >= null_vertex() || edge_count >= null_vertex() ) { COMMA_THROW( comma::exception, "expected less than " << null_vertex() << " vertices and edges; got " << vertex_count << " vertices and " << edge_count << " edges" ); }
+    comma::uint32 n = vertex_count;
+    comma::uint32 m = edge_count;
+    char* data = allocate_( n, m );
+    layout l( n, m );
+    comma::uint32* offsets = reinterpret_cast< comma::uint32* >( data + l.offsets );
+    comma::uint32* targets = reinterpret_cast< comma::uint32* >( data + l.targets );
+    comma::uint32* sources = reinterpret_cast< comma::uint32* >( data + l.sources );
+    comma::uint32* in_offsets = reinterpret_cast< comma::uint32* >( data + l.in_offsets );
+    comma::uint32* in_edges = reinterpret_cast< comma::uint32* >( data + l.in_edges );
+    boost::unordered_map< descriptor_t, comma::uint32 > indices;
+    std::vector< descriptor_t > descriptors;
+    descriptors.reserve( n );
+    for( std::pair< typename traits_t::vertex_iterator, typename traits_t::vertex_iterator > d = vertices( graph ); d.first != d.second; ++d.first )
+    {
+        indices[ *d.first ] = descriptors.size();
+        new ( vertex_values_ + descriptors.size() ) V( graph[ *d.first ] );
+        descriptors.push_back( *d.first );
+    }
+    comma::uint32 e = 0;
+    for( comma::uint32 i = 0; i < n; ++i )
+    {
+        offsets[i] = e;
+        for( std::pair< typename traits_t::out_edge_iterator, typename traits_t::out_edge_iterator > d = out_edges( descriptors[i], graph ); d.first != d.second; ++d.first, ++e )
+        {
+            sources[e] = i;
+            targets[e] = indices[ target( *d.first, graph ) ];
+            new ( edge_values_ + e ) E( graph[ *d.first ] );
+            ++in_offsets[ targets[e] + 1 ];
+        }
+    }
+    offsets[n] = e;
+    for( comma::uint32 i = 0; i < n; ++i ) { in_offsets[ i + 1 ] += in_offsets[i]; }
+    std::vector< comma::uint32 > positions( in_offsets, in_offsets + n );
+    for( comma::uint32 i = 0; i < m; ++i ) { in_edges[ positions[ targets[i] ]++ ] = i; } // in-edges of each vertex in the order of their sources
+}
+
+template < typename V, typename E >
+inline char* csr_graph< V, E >::allocate_( comma::uint32 n, comma::uint32 m )
+{
+    layout l( n, m );
+    buffer_.assign( l.size / sizeof( comma::uint64 ), 0 );
+    char* data = reinterpret_cast< char* >( &buffer_[0] );
+    header* h = reinterpret_cast< header* >( data );
+    h->magic = magic();
+    h->version = version;
+    h->vertex_size = sizeof( V );
+    h->edge_size = sizeof( E );
+    h->vertices = n;
+    h->edges = m;
+    attach_( data, l.size );
+    return data;
+}
+
+template < typename V, typename E >
+inline void csr_graph< V, E >::attach_( const char* data, std::size_t size )
+{
+    data_ = data;
+    size_ = size;
+    header_ = reinterpret_cast< const header* >( data );
+    layout l( header_->vertices, header_->edges );
+    offsets_ = reinterpret_cast< const comma::uint32* >( data + l.offsets );
+    targets_ = reinterpret_cast< const comma::uint32* >( data + l.targets );
+    sources_ = reinterpret_cast< const comma::uint32* >( data + l.sources );
+    in_offsets_ = reinterpret_cast< const comma::uint32* >( data + l.in_offsets );
+    in_edges_ = reinterpret_cast< const comma::uint32* >( data + l.in_edges );
+    vertex_values_ = reinterpret_cast< V* >( const_cast< char* >( data ) + l.vertices ); // quick and dirty: payloads are writable, arrays are not
+    edge_values_ = reinterpret_cast< E* >( const_cast< char* >( data ) + l.edges );
+}
+
+template < typename V, typename E >
+inline void csr_graph< V, E >::check_( const header& h, std::size_t size, const std::string& filename ) const
+{
+    if( size < sizeof( header ) ) { COMMA_THROW( comma::exception, "expected csr graph in \"" << filename << "\", got file of size " << size ); }
+    if( h.magic != magic() ) { COMMA_THROW( comma::exception, "expected csr graph in \"" << filename << "\", got wrong file signature" ); }
+    if( h.version != version ) { COMMA_THROW( comma::exception, "expected csr graph version " << version << " in \"" << filename << "\", got " << h.version ); }
+    if( h.vertex_size != sizeof( V ) || h.edge_size != sizeof( E ) ) { COMMA_THROW( comma::exception, "expected vertex and edge sizes " << sizeof( V ) << " and " << sizeof( E ) << " in \"" << filename << "\", got " << h.vertex_size << " and " << h.edge_size ); }
+    if( size != layout( h.vertices, h.edges ).size ) { COMMA_THROW( comma::exception, "expected file size " << layout( h.vertices, h.edges ).size << " for " << h.vertices << " vertices and " << h.edges << " edges in \"" << filename << "\", got " << size ); }
+}
+
+template < typename V, typename E >
+inline void csr_graph< V, E >::write( std::ostream& os ) const
+{
+    os.write( data_, size_ );
+    if( !os.good() ) { COMMA_THROW( comma::exception, "failed to write csr graph" ); }
+}
+
+template < typename V, typename E >
+inline void csr_graph< V, E >::write( const std::string& filename ) const
+{
+    std::ofstream ofs( filename.c_str(), std::ios::binary );
+    if( !ofs.is_open() ) { COMMA_THROW( comma::exception, "failed to open \"" << filename << "\"" ); }
+    write( ofs );
+}
+
+template < typename V, typename E >
+inline void csr_graph< V, E >::map( const std::string& filename )
+{
+    boost::interprocess::file_mapping mapping( filename.c_str(), boost::interprocess::read_only );
+    boost::scoped_ptr< boost::interprocess::mapped_region > region( new boost::interprocess::mapped_region( mapping, boost::interprocess::copy_on_write ) );
+    check_( *static_cast< const header* >( region->get_address() ), region->get_size(), filename );
+    region_.swap( region );
+    buffer_.clear();
+    attach_( static_cast< const char* >( region_->get_address() ), region_->get_size() );
+}
+
+template < typename V, typename E >
+inline void csr_graph< V, E >::read( const std::string& filename )
+{
+    std::ifstream ifs( filename.c_str(), std::ios::binary );
+    if( !ifs.is_open() ) { COMMA_THROW( comma::exception, "failed to open \"" << filename << "\"" ); }
+    ifs.seekg( 0, std::ios::end );
+    std::size_t size = ifs.tellg();
+    ifs.seekg( 0, std::ios::beg );
+    header h;
+    std::memset( &h, 0, sizeof( header ) );
+    ifs.read( reinterpret_cast< char* >( &h ), sizeof( header ) );
+    check_( h, size, filename );
+    std::vector< comma::uint64 > buffer( size / sizeof( comma::uint64 ) );
+    std::memcpy( &buffer[0], &h, sizeof( header ) );
+    ifs.read( reinterpret_cast< char* >( &buffer[0] ) + sizeof( header ), size - sizeof( header ) );
+    if( !ifs.good() ) { COMMA_THROW( comma::exception, "failed to read csr graph from \"" << filename << "\"" ); }
+    buffer_.swap( buffer );
+    region_.reset();
+    attach_( reinterpret_cast< const char* >( &buffer_[0] ), size );
+}
+
+} // namespace snark {
+
+#endif // SNARK_GRAPH_CSR_GRAPH_H_
@@ -0,0 +1,156 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SNARK_GRAPH_INDEXED_HEAP_H_
+#define SNARK_GRAPH_INDEXED_HEAP_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <comma/base/exception.h>
+
+namespace snark {
+
+/// d-ary min-heap of items with dense integer indices and their keys
+///
+/// positions of items in the heap are kept in a vector indexed by item,
+/// thus the key of an item in the heap can be changed in logarithmic time
+/// without erasing and reinserting it
+template < typename K, unsigned int Arity = 4 >
+class indexed_heap
+{
+    public:
+        /// key type
+        typedef K key_type;
+
+        /// return true, if heap is empty
+        bool empty() const { return heap_.empty(); }
+
+        /// return number of items in heap
+        std::size_t size() const { return heap_.size(); }
+
+        /// return true, if item is in heap
+        bool contains( std::size_t item ) const { return item < positions_.size() && positions_[item] != std::size_t( -1 ); }
+
+        /// insert item or change its key, if item is already in heap
+        void push( std::size_t item, const K& key );
+
+        /// return item with the smallest key
+        std::size_t top() const { return heap_[0].second; }
+
+        /// return the smallest key
+        const K& top_key() const { return heap_[0].first; }
+
+        /// return key of item in heap
+        const K& key( std::size_t item ) const { return heap_[ positions_[item] ].first; }
+
+        /// remove item with the smallest key
+        void pop();
+
+        /// remove all items, keep allocated memory
+        void clear();
+
+    private:
+        std::vector< std::pair< K, std::size_t > > heap_;
+        std::vector< std::size_t > positions_;
+        void up_( std::size_t i );
+        void down_( std::size_t i );
+        void place_( std::size_t i, const std::pair< K, std::size_t >& entry ) { heap_[i] = entry; positions_[ entry.second ] = i; }
+};
+
+template < typename K, unsigned int Arity >
+inline void indexed_heap< K, Arity >::push( std::size_t item, const K& key )
+{
+    if( item >= positions_.size() ) { positions_.resize( item + 1, std::size_t( -1 ) ); }
+    std::size_t i = positions_[item];
+    if( i == std::size_t( -1 ) )
+    {
+        heap_.push_back( std::make_pair( key, item ) );
+        positions_[item] = heap_.size() - 1;
+        up_( heap_.size() - 1 );
+        return;
+    }
+    bool decreased = key < heap_[i].first;
+    heap_[i].first = key;
+    if( decreased ) { up_( i ); } else { down_( i ); }
+}
+
+template < typename K, unsigned int Arity >
+inline void indexed_heap< K, Arity >::pop()
+{
+    if( heap_.empty() ) { COMMA_THROW( comma::exception, "pop from empty heap" ); }
+    positions_[ heap_[0].second ] = std::size_t( -1 );
+    if( heap_.size() > 1 ) { place_( 0, heap_.back() ); }
+    heap_.pop_back();
+    if( !heap_.empty() ) { down_( 0 ); }
+}
+
+template < typename K, unsigned int Arity >
+inline void indexed_heap< K, Arity >::clear()
+{
+    for( std::size_t i = 0; i < heap_.size(); ++i ) { positions_[ heap_[i].second ] = std::size_t( -1 ); }
+    heap_.clear();
+}
+
+template < typename K, unsigned int Arity >
+inline void indexed_heap< K, Arity >::up_( std::size_t i )
+{
+    std::pair< K, std::size_t > entry = heap_[i];
+    while( i > 0 )
+    {
+        std::size_t parent = ( i - 1 ) / Arity;
+        if( !( entry.first < heap_[parent].first ) ) { break; }
+        place_( i, heap_[parent] );
+        i = parent;
+    }
+    place_( i, entry );
+}
+
+template < typename K, unsigned int Arity >
+inline void indexed_heap< K, Arity >::down_( std::size_t i )
+{
+    std::pair< K, std::size_t > entry = heap_[i];
+    while( true )
+    {
+        std::size_t first = i * Arity + 1;
+        if( first >= heap_.size() ) { break; }
+        std::size_t last = std::min( first + Arity, heap_.size() );
+        std::size_t best = first;
+        for( std::size_t c = first + 1; c < last; ++c ) { if( heap_[c].first < heap_[best].first ) { best = c; } }
+        if( !( heap_[best].first < entry.first ) ) { break; }
+        place_( i, heap_[best] );
+        i = best;
+    }
+    place_( i, entry );
+}
+
+} // namespace snark {
+
+#endif // SNARK_GRAPH_INDEXED_HEAP_H_
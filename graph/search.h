@@ -33,22 +33,62 @@
 #ifndef SNARK_GRAPH_SEARCH_H_
 #define SNARK_GRAPH_SEARCH_H_
 
-#include <queue>
+#include <algorithm>
+#include <limits>
+#include <vector>
 #include <boost/graph/adjacency_list.hpp>
+#include <boost/functional/hash.hpp>
 #include <boost/graph/graph_traits.hpp>
 #include <boost/optional.hpp>
+#include <boost/type_traits/is_integral.hpp>
 #include <boost/unordered_map.hpp>
 #include <boost/unordered_set.hpp>
 #include <comma/base/exception.h>
+#include <comma/base/types.h>
 #include <comma/math/compare.h>
+#include <snark/graph/indexed_heap.h>
 
 namespace snark {
 
+/// graph functions, e.g. out_edges(), are called unqualified, thus found by argument-dependent lookup
+/// for boost graphs as well as for snark::csr_graph
+
 /// forward search
+/// @return number of expanded vertices
+template < typename G, typename D, typename A, typename O, typename V >
+std::size_t forward_search( G& graph, const D& start, const A& advance, const O& objective_function, const V& valid );
+
+/// a-star search: forward search from start, expanding vertices in order of objective plus heuristic, until goal is expanded
+/// @param heuristic for a search node, return an upper bound of the change of objective from the node to goal,
+///                  e.g. minus euclidean distance to goal, if objective is minus distance travelled; it has to be consistent
+/// @return number of expanded vertices
+template < typename G, typename D, typename A, typename O, typename V, typename H >
+std::size_t a_star_search( G& graph, const D& start, const D& goal, const A& advance, const O& objective_function, const V& valid, const H& heuristic );
+
+/// bidirectional a-star search for the shortest path from start to goal over non-negative edge costs
+/// forward from start over out-edges and backward from goal over in-edges with average potentials;
+/// search state is kept aside, node values and best parents in the graph are not changed
+/// @param cost for source and target search nodes of an edge, return boost::optional< double > cost, empty, if edge cannot be traversed
+/// @param heuristic for two search nodes, return a lower bound of the cost from the first to the second, it has to be consistent
+/// @param expanded if not null, number of expanded vertices
+/// @return best path descriptors from start to goal or empty, if goal cannot be reached
+template < typename G, typename D, typename C, typename H >
+std::vector< D > bidirectional_search( const G& graph, const D& start, const D& goal, const C& cost, const H& heuristic, std::size_t* expanded = NULL );
+
+template < typename G > class search_workspace;
+
+/// forward search with search state kept in workspace instead of graph nodes, graph is not changed
+/// @return number of expanded vertices
 template < typename G, typename D, typename A, typename O, typename V >
-void forward_search( G& graph, const D& start, const A& advance, const O& objective_function, const V& valid );
+std::size_t forward_search( search_workspace< G >& workspace, const D& start, const A& advance, const O& objective_function, const V& valid );
 
-/// pull the best path from the graph
+/// a-star search with search state kept in workspace instead of graph nodes, graph is not changed
+/// @return number of expanded vertices
+template < typename G, typename D, typename A, typename O, typename V, typename H >
+std::size_t a_star_search( search_workspace< G >& workspace, const D& start, const D& goal, const A& advance, const O& objective_function, const V& valid, const H& heuristic );
+
+/// pull the best path from the graph, finding each parent by id among in-edges of a vertex;
+/// search_workspace keeps parent edges and extracts paths in time linear in their length
 /// @return best path descriptors
 template < typename Graph >
 std::vector< typename boost::graph_traits< Graph >::vertex_descriptor > best_path( const Graph& graph
@@ -73,9 +113,9 @@ inline std::vector< typename boost::graph_traits< Graph >::vertex_descriptor > b
         const node_t& node = graph[target];
         if( !node.best_parent ) { return std::vector< typename traits_t::vertex_descriptor >(); }
         std::pair< typename traits_t::in_edge_iterator, typename traits_t::in_edge_iterator > it;
-        for( it = boost::in_edges( target, graph ); it.first != it.second; ++it.first )
+        for( it = in_edges( target, graph ); it.first != it.second; ++it.first )
         {
-            target = boost::source( *it.first, graph );
+            target = source( *it.first, graph );
             if( graph[target].id == *node.best_parent ) { best.push_back( target ); break; } // todo: quick and dirty, may be suboptimal
         }
         if( it.first == it.second ) { COMMA_THROW( comma::exception, "node with " << graph[target].id << " has best parent with id " << *node.best_parent << ", but the edge from the best parent to the node not found" ); }
@@ -84,62 +124,434 @@ inline std::vector< typename boost::graph_traits< Graph >::vertex_descriptor > b
     return best;
 }
 
-template < typename G, typename D, typename A, typename O, typename V >
-inline void forward_search( G& graph, const boost::unordered_set< D >& start, const A& advance, const O& objective_function, const V& valid )
+namespace impl {
+
+/// dense indices of vertices: vertex descriptors themselves, if integral, e.g. for vecS vertex storage
+template < typename D, bool Integral = boost::is_integral< D >::value >
+struct vertex_indices
+{
+    vertex_indices( std::size_t ) {}
+    std::size_t operator()( const D& d ) { return d; }
+    std::size_t find( const D& d ) const { return d; }
+    D vertex( std::size_t i ) const { return D( i ); }
+};
+
+/// dense indices of vertices: assigned in the order vertices are discovered, e.g. for setS vertex storage
+/// kept in open-addressing hash table to avoid allocation per vertex
+template < typename D >
+struct vertex_indices< D, false >
+{
+    std::vector< std::pair< D, std::size_t > > table;
+    std::vector< D > vertices;
+    vertex_indices( std::size_t size ) { std::size_t n = 1024; while( n < size * 2 ) { n *= 2; } table.resize( n, std::make_pair( D(), std::size_t( -1 ) ) ); vertices.reserve( size ); }
+    std::size_t operator()( const D& d )
+    {
+        if( ( vertices.size() + 1 ) * 2 > table.size() ) { grow_(); }
+        std::pair< D, std::size_t >& e = probe_( d );
+        if( e.second == std::size_t( -1 ) ) { e.first = d; e.second = vertices.size(); vertices.push_back( d ); }
+        return e.second;
+    }
+    std::size_t find( const D& d ) const { return table[ slot_( d ) ].second; }
+    const D& vertex( std::size_t i ) const { return vertices[i]; }
+
+    private:
+        std::size_t slot_( const D& d ) const
+        {
+            std::size_t mask = table.size() - 1;
+            std::size_t i = boost::hash< D >()( d );
+            i ^= i >> 17; // pointers are aligned, thus mix high bits into low ones
+            i *= 0x9E3779B97F4A7C15ULL;
+            for( i = ( i ^ ( i >> 31 ) ) & mask; table[i].second != std::size_t( -1 ) && !( table[i].first == d ); i = ( i + 1 ) & mask );
+            return i;
+        }
+        std::pair< D, std::size_t >& probe_( const D& d ) { return table[ slot_( d ) ]; }
+        void grow_()
+        {
+            table.assign( table.size() * 2, std::make_pair( D(), std::size_t( -1 ) ) );
+            for( std::size_t i = 0; i < vertices.size(); ++i ) { std::pair< D, std::size_t >& e = probe_( vertices[i] ); e.first = vertices[i]; e.second = i; }
+        }
+};
+
+/// search queue key: objective and sequence number, which breaks ties in the order vertices were queued
+struct search_key
+{
+    double objective;
+    comma::uint64 sequence;
+    search_key( double objective, comma::uint64 sequence ) : objective( objective ), sequence( sequence ) {}
+    bool operator<( const search_key& rhs ) const { return objective > rhs.objective || ( objective == rhs.objective && sequence < rhs.sequence ); }
+};
+
+/// relax edge in bidirectional search: d = 0: forward from vertex i to u, d = 1: backward from vertex i to u
+template < typename I, typename G, typename D, typename H >
+inline void relax_( I& indices
+                  , const G& graph
+                  , const D& start
+                  , const D& goal
+                  , const H& heuristic
+                  , std::vector< double >& potential
+                  , std::vector< double >* distance
+                  , std::vector< std::size_t >* parent
+                  , std::vector< bool >* settled
+                  , indexed_heap< double >* queue
+                  , unsigned int d
+                  , std::size_t i
+                  , const D& u
+                  , double cost
+                  , double& best
+                  , std::size_t& meeting )
+{
+    std::size_t j = indices( u );
+    if( j >= potential.size() )
+    {
+        potential.resize( j + 1, std::numeric_limits< double >::quiet_NaN() );
+        for( unsigned int k = 0; k < 2; ++k ) { distance[k].resize( j + 1, std::numeric_limits< double >::infinity() ); parent[k].resize( j + 1, std::size_t( -1 ) ); settled[k].resize( j + 1, false ); }
+    }
+    if( potential[j] != potential[j] ) { potential[j] = ( heuristic( graph[u], graph[goal] ) - heuristic( graph[start], graph[u] ) ) / 2; } // not computed yet
+    if( settled[d][j] ) { return; }
+    double t = distance[d][i] + cost;
+    if( !( t < distance[d][j] ) ) { return; }
+    distance[d][j] = t;
+    parent[d][j] = i;
+    queue[d].push( j, d == 0 ? t + potential[j] : t - potential[j] );
+    double through = t + distance[ 1 - d ][j];
+    if( through < best ) { best = through; meeting = j; }
+}
+
+/// zero heuristic, i.e. uniform cost search
+struct no_heuristic
+{
+    template < typename N > double operator()( const N& ) const { return 0; }
+    template < typename N > double operator()( const N&, const N& ) const { return 0; }
+};
+
+/// search state kept in graph nodes: values and ids of best parents
+template < typename G, typename D >
+class node_state
+{
+    public:
+        #ifdef BOOST_GRAPH_NO_BUNDLED_PROPERTIES
+        typedef typename G::vertex_property_type node_t;
+        #else // BOOST_GRAPH_NO_BUNDLED_PROPERTIES
+        typedef typename G::vertex_bundled node_t;
+        #endif // BOOST_GRAPH_NO_BUNDLED_PROPERTIES
+        typedef typename node_t::value_type value_type;
+        node_state( G& graph ) : graph_( graph ), indices_( num_vertices( graph ) ) {}
+        std::size_t index( const D& v ) { return indices_( v ); }
+        D vertex( std::size_t i ) const { return indices_.vertex( i ); }
+        value_type& value( std::size_t, const D& v ) { return graph_[v].value; }
+        bool has_parent( std::size_t, const D& v ) const { return graph_[v].best_parent; }
+        bool is_parent( std::size_t, const D& v, std::size_t, const D& parent ) const { return *graph_[v].best_parent == graph_[parent].id; }
+        template < typename E > void set_parent( std::size_t, const D& v, std::size_t, const D& parent, const E& ) { graph_[v].best_parent = graph_[parent].id; }
+
+    private:
+        G& graph_;
+        vertex_indices< D > indices_;
+};
+
+/// forward search with search state kept in state S, see node_state for its interface
+template < typename G, typename S, typename D, typename A, typename O, typename V, typename H >
+inline std::size_t forward_search_( G& graph, S& state, const boost::unordered_set< D >& start, const D* goal, const A& advance, const O& objective_function, const V& valid, const H& heuristic )
 {
     typedef boost::graph_traits< G > traits_t;
-    #ifdef BOOST_GRAPH_NO_BUNDLED_PROPERTIES
-    typedef typename G::vertex_property_type node_t;
-    #else // BOOST_GRAPH_NO_BUNDLED_PROPERTIES
-    typedef typename G::vertex_bundled node_t;
-    #endif // BOOST_GRAPH_NO_BUNDLED_PROPERTIES
+    typedef typename S::value_type value_type;
     typedef boost::unordered_set< D > set_t;
-    typedef D vertex_desc;
-    typedef std::multimap< double, vertex_desc > map_t;
-    typedef boost::unordered_map< vertex_desc, typename map_t::iterator > vertex_map_t;
-    vertex_map_t vertex_map;
-    map_t vertex_queue;
+    indexed_heap< impl::search_key > vertex_queue;
+    comma::uint64 sequence = 0;
     for( typename set_t::const_iterator it = start.begin(); it != start.end(); ++it )
     {
-        vertex_map[ *it ] = vertex_queue.insert( std::make_pair( -objective_function( graph[ *it ].value ), *it ) );
+        std::size_t i = state.index( *it );
+        vertex_queue.push( i, impl::search_key( objective_function( state.value( i, *it ) ) + heuristic( graph[ *it ] ), sequence++ ) );
     }
+    std::size_t expanded = 0;
     while( !vertex_queue.empty() )
     {
-        D v = vertex_queue.begin()->second;
-        vertex_queue.erase( vertex_queue.begin() );
-        vertex_map.erase( v );
-        const node_t& source = graph[v];
-        if( !valid( source.value ) ) { continue; }
+        std::size_t i = vertex_queue.top();
+        D v = state.vertex( i );
+        vertex_queue.pop();
+        if( goal && v == *goal ) { break; }
+        const value_type& source = state.value( i, v );
+        if( !valid( source ) ) { continue; }
+        ++expanded;
+        bool source_has_parent = state.has_parent( i, v );
         typedef std::pair< typename traits_t::out_edge_iterator, typename traits_t::out_edge_iterator > edge_iterator;
-        for( edge_iterator out_edges = boost::out_edges( v, graph ); out_edges.first != out_edges.second; ++out_edges.first )
+        for( edge_iterator e = out_edges( v, graph ); e.first != e.second; ++e.first )
         {
-            vertex_desc target_desc = boost::target( *out_edges.first, graph ); // extract vertex at the other end of edge
-            node_t& target = graph[target_desc];
-            if( source.best_parent && target.id == *( source.best_parent ) ) { continue; } 
-            if( target.best_parent && objective_function( source.value ) < objective_function( target.value ) ) { continue; } // objective can only decrease or (in special cases equal) in forward prop
-            const boost::optional< typename node_t::value_type >& node = advance( source.value, target.value );
+            D u = target( *e.first, graph ); // extract vertex at the other end of edge
+            std::size_t j = state.index( u );
+            if( source_has_parent && state.is_parent( i, v, j, u ) ) { continue; }
+            value_type& target = state.value( j, u );
+            bool reached = state.has_parent( j, u );
+            if( reached && objective_function( source ) < objective_function( target ) ) { continue; } // objective can only decrease or (in special cases equal) in forward prop
+            const boost::optional< value_type >& node = advance( source, target );
             if( !node || !valid( *node ) ) { continue; }
             double objective = objective_function( *node );
-            if( target.best_parent )
+            if( reached )
             {
-                if( *( target.best_parent ) == source.id && comma::math::equal( objective, objective_function( target.value ) ) ) { continue; }
-                if( objective <= objective_function( target.value ) ) { continue; }
+                if( state.is_parent( j, u, i, v ) && comma::math::equal( objective, objective_function( target ) ) ) { continue; }
+                if( objective <= objective_function( target ) ) { continue; }
             }
-            target.value = *node;
-            target.best_parent = source.id;
-            typename vertex_map_t::iterator it = vertex_map.find( target_desc );
-            if( it != vertex_map.end() ) { vertex_queue.erase( it->second ); }
-            vertex_map[target_desc] = vertex_queue.insert( std::make_pair( -objective, target_desc ) );
+            target = *node;
+            state.set_parent( j, u, i, v, *e.first );
+            vertex_queue.push( j, impl::search_key( objective + heuristic( graph[u] ), sequence++ ) );
         }
     }
+    return expanded;
 }
 
+template < typename G, typename D, typename A, typename O, typename V, typename H >
+inline std::size_t forward_search_( G& graph, const boost::unordered_set< D >& start, const D* goal, const A& advance, const O& objective_function, const V& valid, const H& heuristic )
+{
+    node_state< G, D > state( graph );
+    return forward_search_( graph, state, start, goal, advance, objective_function, valid, heuristic );
+}
+
+} // namespace impl {
+
 template < typename G, typename D, typename A, typename O, typename V >
-inline void forward_search( G& graph, const D& start, const A& advance, const O& objective_function, const V& valid )
+inline std::size_t forward_search( G& graph, const boost::unordered_set< D >& start, const A& advance, const O& objective_function, const V& valid )
+{
+    return impl::forward_search_( graph, start, ( const D* )( NULL ), advance, objective_function, valid, impl::no_heuristic() );
+}
+
+template < typename G, typename D, typename A, typename O, typename V >
+inline std::size_t forward_search( G& graph, const D& start, const A& advance, const O& objective_function, const V& valid )
+{
+    boost::unordered_set< D > s;
+    s.insert( start );
+    return forward_search( graph, s, advance, objective_function, valid );
+}
+
+template < typename G, typename D, typename A, typename O, typename V, typename H >
+inline std::size_t a_star_search( G& graph, const D& start, const D& goal, const A& advance, const O& objective_function, const V& valid, const H& heuristic )
+{
+    boost::unordered_set< D > s;
+    s.insert( start );
+    return impl::forward_search_( graph, s, &goal, advance, objective_function, valid, heuristic );
+}
+
+template < typename G, typename D, typename C, typename H >
+inline std::vector< D > bidirectional_search( const G& graph, const D& start, const D& goal, const C& cost, const H& heuristic, std::size_t* expanded )
+{
+    typedef boost::graph_traits< G > traits_t;
+    static const double infinity = std::numeric_limits< double >::infinity();
+    impl::vertex_indices< D > indices( num_vertices( graph ) );
+    std::vector< double > distance[2]; // from start and to goal
+    std::vector< std::size_t > parent[2];
+    std::vector< bool > settled[2];
+    std::vector< double > potential; // average of forward and backward potentials, consistent both ways
+    indexed_heap< double > queue[2];
+    const D ends[2] = { start, goal };
+    double best = infinity;
+    std::size_t meeting = std::size_t( -1 );
+    std::size_t count = 0;
+    for( unsigned int d = 0; d < 2; ++d )
+    {
+        std::size_t i = indices( ends[d] );
+        if( i >= potential.size() )
+        {
+            potential.resize( i + 1, std::numeric_limits< double >::quiet_NaN() );
+            for( unsigned int k = 0; k < 2; ++k ) { distance[k].resize( i + 1, infinity ); parent[k].resize( i + 1, std::size_t( -1 ) ); settled[k].resize( i + 1, false ); }
+        }
+        potential[i] = ( heuristic( graph[ ends[d] ], graph[goal] ) - heuristic( graph[start], graph[ ends[d] ] ) ) / 2;
+        distance[d][i] = 0;
+        queue[d].push( i, d == 0 ? potential[i] : -potential[i] );
+    }
+    if( start == goal ) { best = 0; meeting = indices( start ); }
+    while( !queue[0].empty() && !queue[1].empty() && queue[0].top_key() + queue[1].top_key() < best )
+    {
+        unsigned int d = queue[0].top_key() <= queue[1].top_key() ? 0 : 1;
+        std::size_t i = queue[d].top();
+        queue[d].pop();
+        settled[d][i] = true;
+        ++count;
+        D v = indices.vertex( i );
+        if( d == 0 )
+        {
+            for( std::pair< typename traits_t::out_edge_iterator, typename traits_t::out_edge_iterator > e = out_edges( v, graph ); e.first != e.second; ++e.first )
+            {
+                D u = target( *e.first, graph );
+                const boost::optional< double >& c = cost( graph[v], graph[u] );
+                if( !c ) { continue; }
+                impl::relax_( indices, graph, start, goal, heuristic, potential, distance, parent, settled, queue, 0, i, u, *c, best, meeting );
+            }
+        }
+        else
+        {
+            for( std::pair< typename traits_t::in_edge_iterator, typename traits_t::in_edge_iterator > e = in_edges( v, graph ); e.first != e.second; ++e.first )
+            {
+                D u = source( *e.first, graph );
+                const boost::optional< double >& c = cost( graph[u], graph[v] );
+                if( !c ) { continue; }
+                impl::relax_( indices, graph, start, goal, heuristic, potential, distance, parent, settled, queue, 1, i, u, *c, best, meeting );
+            }
+        }
+    }
+    if( expanded ) { *expanded = count; }
+    std::vector< D > path;
+    if( meeting == std::size_t( -1 ) ) { return path; }
+    for( std::size_t i = meeting; i != std::size_t( -1 ); i = parent[0][i] ) { path.push_back( indices.vertex( i ) ); }
+    std::reverse( path.begin(), path.end() );
+    for( std::size_t i = parent[1][meeting]; i != std::size_t( -1 ); i = parent[1][i] ) { path.push_back( indices.vertex( i ) ); }
+    return path;
+}
+
+/// search state kept aside of the graph for repeated searches on the same graph, e.g. one workspace per thread
+///
+/// node values and best parents are stamped with search generation, thus a new search
+/// does not need to reset state of all nodes; the graph is not changed by the search
+template < typename G >
+class search_workspace
+{
+    public:
+        /// vertex descriptor type
+        typedef typename boost::graph_traits< G >::vertex_descriptor vertex_descriptor;
+
+        /// edge descriptor type
+        typedef typename boost::graph_traits< G >::edge_descriptor edge_descriptor;
+
+        /// search node type
+        #ifdef BOOST_GRAPH_NO_BUNDLED_PROPERTIES
+        typedef typename G::vertex_property_type node_type;
+        #else // BOOST_GRAPH_NO_BUNDLED_PROPERTIES
+        typedef typename G::vertex_bundled node_type;
+        #endif // BOOST_GRAPH_NO_BUNDLED_PROPERTIES
+
+        /// search node value type
+        typedef typename node_type::value_type value_type;
+
+        /// path: vertices and edges, edges[k] leading from vertices[k] to vertices[k+1]
+        struct path
+        {
+            std::vector< vertex_descriptor > vertices;
+            std::vector< edge_descriptor > edges;
+            bool empty() const { return vertices.empty(); }
+            void clear() { vertices.clear(); edges.clear(); }
+        };
+
+        /// constructor, graph vertices should not be added or removed while workspace is used
+        search_workspace( const G& graph );
+
+        /// return graph
+        const G& graph() const { return graph_; }
+
+        /// start new search
+        void clear();
+
+        /// return true, if vertex has been reached from other vertex in the last search
+        bool reached( const vertex_descriptor& v ) const { std::size_t i = indices_.find( v ); return generations_[i] == generation_ && states_[i].parent != std::size_t( -1 ); }
+
+        /// return node value of vertex in the last search or as in the graph, if vertex has not been visited
+        const value_type& value( const vertex_descriptor& v ) const { std::size_t i = indices_.find( v ); return generations_[i] == generation_ ? states_[i].value : graph_[v].value; }
+
+        /// return best path from start to goal found in the last search or empty, if goal has not been reached
+        std::vector< vertex_descriptor > best_path( const vertex_descriptor& start, const vertex_descriptor& goal ) const;
+
+        /// get best path from start to goal found in the last search, following parent edges
+        /// @return false and empty path, if goal has not been reached
+        bool best_path( const vertex_descriptor& start, const vertex_descriptor& goal, path& p ) const;
+
+        /// return best paths from start to each of goals in the tree of the last search, empty paths for goals not reached
+        std::vector< path > best_paths( const vertex_descriptor& start, const std::vector< vertex_descriptor >& goals ) const;
+
+        /// search state interface, see impl::node_state
+        std::size_t index( const vertex_descriptor& v ) const { return indices_.find( v ); }
+        vertex_descriptor vertex( std::size_t i ) const { return indices_.vertex( i ); }
+        value_type& value( std::size_t i, const vertex_descriptor& v ) { touch_( i, v ); return states_[i].value; }
+        bool has_parent( std::size_t i, const vertex_descriptor& ) const { return generations_[i] == generation_ && states_[i].parent != std::size_t( -1 ); }
+        bool is_parent( std::size_t i, const vertex_descriptor&, std::size_t parent, const vertex_descriptor& ) const { return states_[i].parent == parent; }
+        void set_parent( std::size_t i, const vertex_descriptor& v, std::size_t parent, const vertex_descriptor&, const edge_descriptor& e ) { touch_( i, v ); states_[i].parent = parent; states_[i].edge = e; }
+
+    private:
+        struct state
+        {
+            value_type value;
+            std::size_t parent;
+            edge_descriptor edge; // from parent
+        };
+        const G& graph_;
+        impl::vertex_indices< vertex_descriptor > indices_;
+        std::vector< state > states_;
+        std::vector< comma::uint32 > generations_;
+        comma::uint32 generation_;
+
+        void touch_( std::size_t i, const vertex_descriptor& v )
+        {
+            if( generations_[i] == generation_ ) { return; }
+            generations_[i] = generation_;
+            states_[i].value = graph_[v].value;
+            states_[i].parent = std::size_t( -1 );
+        }
+};
+
+template < typename G >
+inline search_workspace< G >::search_workspace( const G& graph )
+    : graph_( graph )
+    , indices_( num_vertices( graph ) )
+    , states_( num_vertices( graph ) )
+    , generations_( num_vertices( graph ), 0 )
+    , generation_( 1 )
+{
+    typedef typename boost::graph_traits< G >::vertex_iterator iterator;
+    for( std::pair< iterator, iterator > d = vertices( graph ); d.first != d.second; ++d.first ) { indices_( *d.first ); }
+}
+
+template < typename G >
+inline void search_workspace< G >::clear()
+{
+    if( ++generation_ != 0 ) { return; }
+    std::fill( generations_.begin(), generations_.end(), 0 );
+    generation_ = 1;
+}
+
+template < typename G >
+inline std::vector< typename search_workspace< G >::vertex_descriptor > search_workspace< G >::best_path( const vertex_descriptor& start, const vertex_descriptor& goal ) const
+{
+    path p;
+    best_path( start, goal, p );
+    return p.vertices;
+}
+
+template < typename G >
+inline bool search_workspace< G >::best_path( const vertex_descriptor& start, const vertex_descriptor& goal, path& p ) const
+{
+    p.clear();
+    std::size_t s = indices_.find( start );
+    for( std::size_t i = indices_.find( goal ); i != s; i = states_[i].parent )
+    {
+        if( generations_[i] != generation_ || states_[i].parent == std::size_t( -1 ) ) { p.clear(); return false; }
+        p.vertices.push_back( indices_.vertex( i ) );
+        p.edges.push_back( states_[i].edge );
+    }
+    p.vertices.push_back( start );
+    std::reverse( p.vertices.begin(), p.vertices.end() );
+    std::reverse( p.edges.begin(), p.edges.end() );
+    return true;
+}
+
+template < typename G >
+inline std::vector< typename search_workspace< G >::path > search_workspace< G >::best_paths( const vertex_descriptor& start, const std::vector< vertex_descriptor >& goals ) const
+{
+    std::vector< path > paths( goals.size() );
+    for( std::size_t k = 0; k < goals.size(); ++k ) { best_path( start, goals[k], paths[k] ); }
+    return paths;
+}
+
+template < typename G, typename D, typename A, typename O, typename V >
+inline std::size_t forward_search( search_workspace< G >& workspace, const D& start, const A& advance, const O& objective_function, const V& valid )
+{
+    workspace.clear();
+    boost::unordered_set< D > s;
+    s.insert( start );
+    return impl::forward_search_( workspace.graph(), workspace, s, ( const D* )( NULL ), advance, objective_function, valid, impl::no_heuristic() );
+}
+
+template < typename G, typename D, typename A, typename O, typename V, typename H >
+inline std::size_t a_star_search( search_workspace< G >& workspace, const D& start, const D& goal, const A& advance, const O& objective_function, const V& valid, const H& heuristic )
 {
+    workspace.clear();
     boost::unordered_set< D > s;
     s.insert( start );
-    forward_search( graph, s, advance, objective_function, valid );
+    return impl::forward_search_( workspace.graph(), workspace, s, &goal, advance, objective_function, valid, heuristic );
 }
 
 } // namespace snark {
@@ -0,0 +1,59 @@
+/// time point-to-point queries and count expanded vertices for uniform, a-star, and bidirectional search on generated grid and random geometric graphs
+
+#include <iostream>
+#include <string>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/lexical_cast.hpp>
+#include <snark/graph/search.h>
+#include "generated_graphs.h"
+
+static double seconds_since( const boost::posix_time::ptime& start ) { return double( ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() ) / 1e6; }
+
+template < typename G >
+static void run( const std::string& name, G& graph, const std::vector< typename boost::graph_traits< G >::vertex_descriptor >& vertices, unsigned int queries )
+{
+    using namespace snark::test;
+    double seconds[4] = { 0, 0, 0, 0 };
+    std::size_t expanded[4] = { 0, 0, 0, 0 };
+    double worst = 0;
+    for( unsigned int i = 0; i < queries; ++i )
+    {
+        typename boost::graph_traits< G >::vertex_descriptor start = vertices[ ( i * 7919 ) % vertices.size() ];
+        typename boost::graph_traits< G >::vertex_descriptor goal = vertices[ ( i * 104729 + 13 ) % vertices.size() ];
+        reset( graph );
+        boost::posix_time::ptime t = boost::posix_time::microsec_clock::universal_time();
+        expanded[0] += snark::forward_search( graph, start, &advance, &objective_function, &valid );
+        seconds[0] += seconds_since( t );
+        double uniform = graph[goal].value.distance;
+        reset( graph );
+        t = boost::posix_time::microsec_clock::universal_time();
+        expanded[1] += snark::a_star_search( graph, start, goal, &advance, &objective_function, &valid, euclidean_heuristic( graph[goal].value.position ) );
+        seconds[1] += seconds_since( t );
+        worst = std::max( worst, std::abs( graph[goal].value.distance - uniform ) );
+        std::size_t e = 0;
+        t = boost::posix_time::microsec_clock::universal_time();
+        snark::bidirectional_search( graph, start, goal, edge_length(), snark::impl::no_heuristic(), &e );
+        seconds[2] += seconds_since( t );
+        expanded[2] += e;
+        t = boost::posix_time::microsec_clock::universal_time();
+        snark::bidirectional_search( graph, start, goal, edge_length(), euclidean_distance(), &e );
+        seconds[3] += seconds_since( t );
+        expanded[3] += e;
+    }
+    static const char* names[] = { "uniform", "a-star", "bidirectional uniform", "bidirectional a-star" };
+    std::cout << name << ": " << boost::num_vertices( graph ) << " vertices, " << boost::num_edges( graph ) << " edges; a-star cost error: " << worst << std::endl;
+    for( unsigned int k = 0; k < 4; ++k ) { std::cout << "    " << names[k] << ": " << seconds[k] / queries << " seconds; " << expanded[k] / queries << " expanded vertices per query" << std::endl; }
+}
+
+int main( int argc, char** argv )
+{
+    using namespace snark::test;
+    unsigned int size = argc > 1 ? boost::lexical_cast< unsigned int >( argv[1] ) : 1000000;
+    unsigned int queries = argc > 2 ? boost::lexical_cast< unsigned int >( argv[2] ) : 10;
+    std::cerr << "usage: graph-a-star-benchmark [<number of vertices>] [<number of queries>]; running with " << size << " vertices, " << queries << " queries" << std::endl;
+    unsigned int side = std::sqrt( double( size ) );
+    double radius = std::sqrt( 6.0 / ( M_PI * size ) ); // about 6 neighbours per vertex
+    { std::srand( 1 ); graph_type g; std::vector< graph_type::vertex_descriptor > v = make_grid( g, side ); run( "grid", g, v, queries ); }
+    { std::srand( 1 ); graph_type g; std::vector< graph_type::vertex_descriptor > v = make_random_geometric( g, size, radius ); run( "random geometric", g, v, queries ); }
+    return 0;
+}
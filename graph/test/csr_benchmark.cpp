@@ -0,0 +1,83 @@
+/// time loading a graph as boost adjacency list as graph-search does and as memory-mapped csr graph
+/// and forward search on both
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/unordered_map.hpp>
+#include <snark/graph/csr_graph.h>
+#include <snark/graph/search.h>
+#include "generated_graphs.h"
+
+typedef snark::csr_graph< snark::search_node< snark::test::node, snark::test::edge >, snark::test::edge > csr_type;
+
+static double seconds_since( const boost::posix_time::ptime& start ) { return double( ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() ) / 1e6; }
+
+/// build adjacency list from vertex and edge records the way read_vertices() and read_edges() do, without csv parsing
+static void load( snark::test::graph_type& graph, const std::vector< snark::search_node< snark::test::node, snark::test::edge > >& vertices, const std::vector< std::pair< comma::uint32, comma::uint32 > >& edges )
+{
+    typedef boost::unordered_map< comma::uint32, snark::test::graph_type::vertex_descriptor > map_t;
+    map_t descriptors;
+    for( std::size_t i = 0; i < vertices.size(); ++i ) { descriptors[ vertices[i].id ] = boost::add_vertex( vertices[i], graph ); }
+    for( std::size_t i = 0; i < edges.size(); ++i ) { boost::add_edge( descriptors.find( edges[i].first )->second, descriptors.find( edges[i].second )->second, graph ); }
+}
+
+template < typename G >
+static double search( G& graph, const std::vector< typename boost::graph_traits< G >::vertex_descriptor >& sources, std::vector< double >& distances )
+{
+    double seconds = 0;
+    for( std::size_t i = 0; i < sources.size(); ++i )
+    {
+        snark::test::reset( graph );
+        boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+        snark::forward_search( graph, sources[i], &snark::test::advance, &snark::test::objective_function, &snark::test::valid );
+        seconds += seconds_since( start );
+    }
+    typedef typename boost::graph_traits< G >::vertex_iterator iterator;
+    distances.resize( num_vertices( graph ) );
+    for( std::pair< iterator, iterator > d = vertices( graph ); d.first != d.second; ++d.first ) { distances[ graph[ *d.first ].id ] = graph[ *d.first ].value.distance; }
+    return seconds / sources.size();
+}
+
+int main( int argc, char** argv )
+{
+    using namespace snark::test;
+    unsigned int size = argc > 1 ? boost::lexical_cast< unsigned int >( argv[1] ) : 1000000;
+    unsigned int queries = argc > 2 ? boost::lexical_cast< unsigned int >( argv[2] ) : 3;
+    std::string filename = argc > 3 ? argv[3] : "graph-csr-benchmark.bin";
+    std::cerr << "usage: graph-csr-benchmark [<number of vertices>] [<number of searches>] [<temporary file>]; running with " << size << " vertices, " << queries << " searches, " << filename << std::endl;
+    std::vector< snark::search_node< node, edge > > vertex_records;
+    std::vector< std::pair< comma::uint32, comma::uint32 > > edge_records;
+    {
+        std::srand( 1 );
+        vector_graph_type g;
+        make_random_geometric( g, size, std::sqrt( 6.0 / ( M_PI * size ) ) ); // about 6 neighbours per vertex
+        for( std::size_t i = 0; i < boost::num_vertices( g ); ++i ) { vertex_records.push_back( g[i] ); }
+        for( std::pair< vector_graph_type::edge_iterator, vector_graph_type::edge_iterator > e = boost::edges( g ); e.first != e.second; ++e.first ) { edge_records.push_back( std::make_pair( g[ boost::source( *e.first, g ) ].id, g[ boost::target( *e.first, g ) ].id ) ); }
+        csr_type( g ).write( filename );
+    }
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    graph_type graph;
+    load( graph, vertex_records, edge_records );
+    double adjacency_list_load = seconds_since( start );
+    start = boost::posix_time::microsec_clock::universal_time();
+    csr_type csr;
+    csr.map( filename );
+    double csr_load = seconds_since( start );
+    std::cout << "load: " << num_vertices( csr ) << " vertices, " << num_edges( csr ) << " edges: adjacency list: " << adjacency_list_load << " seconds; memory-mapped csr: " << csr_load << " seconds" << std::endl;
+    std::vector< graph_type::vertex_descriptor > descriptors( size );
+    for( std::pair< graph_type::vertex_iterator, graph_type::vertex_iterator > d = boost::vertices( graph ); d.first != d.second; ++d.first ) { descriptors[ graph[ *d.first ].id ] = *d.first; }
+    std::vector< graph_type::vertex_descriptor > sources;
+    std::vector< csr_type::vertex_descriptor > csr_sources;
+    for( unsigned int i = 0; i < queries; ++i ) { sources.push_back( descriptors[ ( i * 7919 ) % size ] ); csr_sources.push_back( ( i * 7919 ) % size ); }
+    std::vector< double > distances;
+    std::vector< double > csr_distances;
+    double adjacency_list_search = search( graph, sources, distances );
+    double csr_search = search( csr, csr_sources, csr_distances );
+    std::cout << "search: adjacency list: " << adjacency_list_search << " seconds; csr: " << csr_search << " seconds per search; same results: " << ( distances == csr_distances ? "yes" : "no" ) << std::endl;
+    std::remove( filename.c_str() );
+    return 0;
+}
@@ -0,0 +1,152 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstdio>
+#include <unistd.h>
+#include <gtest/gtest.h>
+#include <snark/graph/csr_graph.h>
+#include <snark/graph/search.h>
+#include "generated_graphs.h"
+
+namespace snark { namespace test {
+
+typedef csr_graph< search_node< node, edge >, edge > csr_type;
+
+static void expect_same_structure( const vector_graph_type& graph, const csr_type& csr )
+{
+    ASSERT_EQ( boost::num_vertices( graph ), num_vertices( csr ) );
+    ASSERT_EQ( boost::num_edges( graph ), num_edges( csr ) );
+    for( std::size_t v = 0; v < boost::num_vertices( graph ); ++v )
+    {
+        EXPECT_EQ( graph[v].id, csr[v].id );
+        EXPECT_EQ( graph[v].value.position, csr[v].value.position );
+        ASSERT_EQ( boost::out_degree( v, graph ), out_degree( v, csr ) );
+        ASSERT_EQ( boost::in_degree( v, graph ), in_degree( v, csr ) );
+        vector_graph_type::out_edge_iterator e = boost::out_edges( v, graph ).first;
+        for( std::pair< csr_type::out_edge_iterator, csr_type::out_edge_iterator > c = out_edges( v, csr ); c.first != c.second; ++c.first, ++e )
+        {
+            EXPECT_EQ( v, source( *c.first, csr ) );
+            EXPECT_EQ( boost::target( *e, graph ), target( *c.first, csr ) );
+        }
+        std::vector< std::size_t > sources;
+        for( vector_graph_type::in_edge_iterator i = boost::in_edges( v, graph ).first; i != boost::in_edges( v, graph ).second; ++i ) { sources.push_back( boost::source( *i, graph ) ); }
+        std::vector< std::size_t > csr_sources;
+        for( std::pair< csr_type::in_edge_iterator, csr_type::in_edge_iterator > c = in_edges( v, csr ); c.first != c.second; ++c.first )
+        {
+            EXPECT_EQ( v, target( *c.first, csr ) );
+            csr_sources.push_back( source( *c.first, csr ) );
+        }
+        std::sort( sources.begin(), sources.end() );
+        EXPECT_EQ( sources, csr_sources );
+    }
+}
+
+static void expect_same_search( vector_graph_type& graph, csr_type& csr, std::size_t source )
+{
+    reset( graph );
+    reset( csr );
+    forward_search( graph, source, &advance, &objective_function, &valid );
+    forward_search( csr, csr_type::vertex_descriptor( source ), &advance, &objective_function, &valid );
+    for( std::size_t i = 0; i < boost::num_vertices( graph ); ++i )
+    {
+        EXPECT_EQ( graph[i].value.distance, csr[i].value.distance );
+        std::vector< vector_graph_type::vertex_descriptor > p = best_path( graph, source, i );
+        std::vector< csr_type::vertex_descriptor > q = best_path( csr, csr_type::vertex_descriptor( source ), csr_type::vertex_descriptor( i ) );
+        ASSERT_EQ( p.size(), q.size() );
+        for( std::size_t k = 0; k < p.size(); ++k ) { EXPECT_EQ( p[k], q[k] ); }
+    }
+}
+
+TEST( csr_graph, structure )
+{
+    std::srand( 1 );
+    vector_graph_type graph;
+    make_random_geometric( graph, 500, 0.08 );
+    csr_type csr( graph );
+    expect_same_structure( graph, csr );
+    csr_type empty;
+    EXPECT_EQ( 0u, num_vertices( empty ) );
+    EXPECT_EQ( 0u, num_edges( empty ) );
+}
+
+TEST( csr_graph, search )
+{
+    std::srand( 1 );
+    vector_graph_type graph;
+    make_random_geometric( graph, 500, 0.08 );
+    csr_type csr( graph );
+    for( std::size_t source = 0; source < 500; source += 97 ) { expect_same_search( graph, csr, source ); }
+    reset( csr );
+    std::size_t expanded = 0;
+    std::vector< csr_type::vertex_descriptor > path = bidirectional_search( csr, csr_type::vertex_descriptor( 3 ), csr_type::vertex_descriptor( 400 ), edge_length(), euclidean_distance(), &expanded );
+    std::vector< vector_graph_type::vertex_descriptor > expected = bidirectional_search( graph, vector_graph_type::vertex_descriptor( 3 ), vector_graph_type::vertex_descriptor( 400 ), edge_length(), euclidean_distance() );
+    ASSERT_EQ( expected.size(), path.size() );
+    for( std::size_t k = 0; k < path.size(); ++k ) { EXPECT_EQ( expected[k], path[k] ); }
+    a_star_search( csr, csr_type::vertex_descriptor( 3 ), csr_type::vertex_descriptor( 400 ), &advance, &objective_function, &valid, euclidean_heuristic( csr[400].value.position ) );
+    reset( graph );
+    forward_search( graph, vector_graph_type::vertex_descriptor( 3 ), &advance, &objective_function, &valid );
+    EXPECT_NEAR( graph[400].value.distance, csr[400].value.distance, 1e-12 );
+    search_workspace< csr_type > workspace( csr );
+    reset( csr );
+    forward_search( workspace, csr_type::vertex_descriptor( 3 ), &advance, &objective_function, &valid );
+    for( std::size_t i = 0; i < 500; ++i ) { EXPECT_EQ( graph[i].value.distance, workspace.value( i ).distance ); EXPECT_EQ( 0, csr[i].value.distance ); }
+}
+
+TEST( csr_graph, file )
+{
+    std::srand( 1 );
+    vector_graph_type graph;
+    make_random_geometric( graph, 500, 0.08 );
+    char filename[] = "/tmp/csr-graph-test.XXXXXX";
+    int fd = ::mkstemp( filename );
+    ASSERT_NE( -1, fd );
+    ::close( fd );
+    csr_type( graph ).write( std::string( filename ) );
+    {
+        csr_type mapped;
+        mapped.map( filename );
+        expect_same_structure( graph, mapped );
+        expect_same_search( graph, mapped, 42 );
+        csr_type read;
+        read.read( filename );
+        expect_same_structure( graph, read );
+        expect_same_search( graph, read, 42 );
+    }
+    {
+        csr_type mapped;
+        mapped.map( filename );
+        EXPECT_EQ( 0, mapped[42].value.distance ); // changes of mapped graph are not written to file
+    }
+    csr_graph< search_node< node, edge >, double > other;
+    EXPECT_THROW( other.map( filename ), comma::exception );
+    EXPECT_THROW( other.read( filename ), comma::exception );
+    std::remove( filename );
+}
+
+} } // namespace snark { namespace test {
@@ -0,0 +1,103 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// forward search on std::multimap as it was before indexed heap, for testing and benchmarking
+
+#ifndef SNARK_GRAPH_TEST_FORWARD_SEARCH_REFERENCE_H_
+#define SNARK_GRAPH_TEST_FORWARD_SEARCH_REFERENCE_H_
+
+#include <map>
+#include <boost/graph/graph_traits.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+#include <comma/math/compare.h>
+
+namespace snark {
+
+template < typename G, typename D, typename A, typename O, typename V >
+inline void forward_search_reference( G& graph, const boost::unordered_set< D >& start, const A& advance, const O& objective_function, const V& valid )
+{
+    typedef boost::graph_traits< G > traits_t;
+    #ifdef BOOST_GRAPH_NO_BUNDLED_PROPERTIES
+    typedef typename G::vertex_property_type node_t;
+    #else // BOOST_GRAPH_NO_BUNDLED_PROPERTIES
+    typedef typename G::vertex_bundled node_t;
+    #endif // BOOST_GRAPH_NO_BUNDLED_PROPERTIES
+    typedef boost::unordered_set< D > set_t;
+    typedef D vertex_desc;
+    typedef std::multimap< double, vertex_desc > map_t;
+    typedef boost::unordered_map< vertex_desc, typename map_t::iterator > vertex_map_t;
+    vertex_map_t vertex_map;
+    map_t vertex_queue;
+    for( typename set_t::const_iterator it = start.begin(); it != start.end(); ++it )
+    {
+        vertex_map[ *it ] = vertex_queue.insert( std::make_pair( -objective_function( graph[ *it ].value ), *it ) );
+    }
+    while( !vertex_queue.empty() )
+    {
+        D v = vertex_queue.begin()->second;
+        vertex_queue.erase( vertex_queue.begin() );
+        vertex_map.erase( v );
+        const node_t& source = graph[v];
+        if( !valid( source.value ) ) { continue; }
+        typedef std::pair< typename traits_t::out_edge_iterator, typename traits_t::out_edge_iterator > edge_iterator;
+        for( edge_iterator out_edges = boost::out_edges( v, graph ); out_edges.first != out_edges.second; ++out_edges.first )
+        {
+            vertex_desc target_desc = boost::target( *out_edges.first, graph ); // extract vertex at the other end of edge
+            node_t& target = graph[target_desc];
+            if( source.best_parent && target.id == *( source.best_parent ) ) { continue; } 
+            if( target.best_parent && objective_function( source.value ) < objective_function( target.value ) ) { continue; } // objective can only decrease or (in special cases equal) in forward prop
+            const boost::optional< typename node_t::value_type >& node = advance( source.value, target.value );
+            if( !node || !valid( *node ) ) { continue; }
+            double objective = objective_function( *node );
+            if( target.best_parent )
+            {
+                if( *( target.best_parent ) == source.id && comma::math::equal( objective, objective_function( target.value ) ) ) { continue; }
+                if( objective <= objective_function( target.value ) ) { continue; }
+            }
+            target.value = *node;
+            target.best_parent = source.id;
+            typename vertex_map_t::iterator it = vertex_map.find( target_desc );
+            if( it != vertex_map.end() ) { vertex_queue.erase( it->second ); }
+            vertex_map[target_desc] = vertex_queue.insert( std::make_pair( -objective, target_desc ) );
+        }
+    }
+}
+
+template < typename G, typename D, typename A, typename O, typename V >
+inline void forward_search_reference( G& graph, const D& start, const A& advance, const O& objective_function, const V& valid )
+{
+    boost::unordered_set< D > s;
+    s.insert( start );
+    forward_search_reference( graph, s, advance, objective_function, valid );
+}
+
+} // namespace snark {
+
+#endif // SNARK_GRAPH_TEST_FORWARD_SEARCH_REFERENCE_H_
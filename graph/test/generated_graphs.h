@@ -0,0 +1,155 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/// grid and random geometric graphs of points for testing and benchmarking searches
+
+#ifndef SNARK_GRAPH_TEST_GENERATED_GRAPHS_H_
+#define SNARK_GRAPH_TEST_GENERATED_GRAPHS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include <boost/graph/adjacency_list.hpp>
+#include <boost/optional.hpp>
+#include <Eigen/Core>
+#include <snark/graph/search_graph.h>
+
+namespace snark { namespace test {
+
+/// node as in graph-search: position and distance travelled
+struct node
+{
+    Eigen::Vector3d position;
+    double distance;
+    node() : position( 0, 0, 0 ), distance( 0 ) {}
+    node( const Eigen::Vector3d& position, double distance = 0 ) : position( position ), distance( distance ) {}
+};
+
+struct edge {};
+
+inline double objective_function( const node& n ) { return -n.distance; }
+
+inline boost::optional< node > advance( const node& from, const node& to ) { return node( to.position, from.distance + ( to.position - from.position ).norm() ); }
+
+inline bool valid( const node& ) { return true; }
+
+/// a-star heuristic: minus euclidean distance to goal
+struct euclidean_heuristic
+{
+    Eigen::Vector3d goal;
+    euclidean_heuristic( const Eigen::Vector3d& goal ) : goal( goal ) {}
+    double operator()( const search_node< node, edge >& n ) const { return -( n.value.position - goal ).norm(); }
+};
+
+/// bidirectional search heuristic: euclidean distance between nodes
+struct euclidean_distance
+{
+    double operator()( const search_node< node, edge >& a, const search_node< node, edge >& b ) const { return ( a.value.position - b.value.position ).norm(); }
+};
+
+/// bidirectional search edge cost: euclidean length, as distance travelled in advance()
+struct edge_length
+{
+    boost::optional< double > operator()( const search_node< node, edge >& from, const search_node< node, edge >& to ) const { return ( to.value.position - from.value.position ).norm(); }
+};
+
+typedef search_graph< node, edge >::type graph_type; // as in graph-search
+typedef boost::adjacency_list< boost::vecS, boost::vecS, boost::bidirectionalS, search_node< node, edge >, edge > vector_graph_type; // vertex descriptors are dense indices
+
+/// add vertices with ids 0 to n-1 at given positions
+template < typename G >
+inline std::vector< typename boost::graph_traits< G >::vertex_descriptor > add_vertices( G& graph, const std::vector< Eigen::Vector3d >& positions )
+{
+    std::vector< typename boost::graph_traits< G >::vertex_descriptor > vertices( positions.size() );
+    for( std::size_t i = 0; i < positions.size(); ++i ) { vertices[i] = boost::add_vertex( search_node< node, edge >( i, node( positions[i] ) ), graph ); }
+    return vertices;
+}
+
+/// grid of size by size vertices with edges both ways between 4-neighbours, positions slightly jittered to avoid ties
+template < typename G >
+inline std::vector< typename boost::graph_traits< G >::vertex_descriptor > make_grid( G& graph, unsigned int size, bool jitter = true )
+{
+    std::vector< Eigen::Vector3d > positions;
+    for( unsigned int i = 0; i < size; ++i )
+    {
+        for( unsigned int j = 0; j < size; ++j ) { positions.push_back( Eigen::Vector3d( i + ( jitter ? 0.3 * std::rand() / RAND_MAX : 0 ), j + ( jitter ? 0.3 * std::rand() / RAND_MAX : 0 ), 0 ) ); }
+    }
+    std::vector< typename boost::graph_traits< G >::vertex_descriptor > vertices = add_vertices( graph, positions );
+    for( unsigned int i = 0; i < size; ++i )
+    {
+        for( unsigned int j = 0; j < size; ++j )
+        {
+            if( i + 1 < size ) { boost::add_edge( vertices[ i * size + j ], vertices[ ( i + 1 ) * size + j ], graph ); boost::add_edge( vertices[ ( i + 1 ) * size + j ], vertices[ i * size + j ], graph ); }
+            if( j + 1 < size ) { boost::add_edge( vertices[ i * size + j ], vertices[ i * size + j + 1 ], graph ); boost::add_edge( vertices[ i * size + j + 1 ], vertices[ i * size + j ], graph ); }
+        }
+    }
+    return vertices;
+}
+
+/// random geometric graph: size random points in unit square, edges both ways between points closer than radius
+template < typename G >
+inline std::vector< typename boost::graph_traits< G >::vertex_descriptor > make_random_geometric( G& graph, unsigned int size, double radius )
+{
+    std::vector< Eigen::Vector3d > positions( size );
+    for( unsigned int i = 0; i < size; ++i ) { positions[i] = Eigen::Vector3d( double( std::rand() ) / RAND_MAX, double( std::rand() ) / RAND_MAX, 0 ); }
+    std::vector< typename boost::graph_traits< G >::vertex_descriptor > vertices = add_vertices( graph, positions );
+    unsigned int cells = std::max( 1, int( 1 / radius ) );
+    std::vector< std::vector< unsigned int > > grid( cells * cells );
+    for( unsigned int i = 0; i < size; ++i ) { grid[ std::min( cells - 1, unsigned( positions[i].x() * cells ) ) * cells + std::min( cells - 1, unsigned( positions[i].y() * cells ) ) ].push_back( i ); }
+    for( unsigned int i = 0; i < size; ++i )
+    {
+        int x = std::min( cells - 1, unsigned( positions[i].x() * cells ) );
+        int y = std::min( cells - 1, unsigned( positions[i].y() * cells ) );
+        for( int a = std::max( 0, x - 1 ); a <= std::min( int( cells ) - 1, x + 1 ); ++a )
+        {
+            for( int b = std::max( 0, y - 1 ); b <= std::min( int( cells ) - 1, y + 1 ); ++b )
+            {
+                const std::vector< unsigned int >& cell = grid[ a * cells + b ];
+                for( std::size_t k = 0; k < cell.size(); ++k )
+                {
+                    if( cell[k] != i && ( positions[i] - positions[ cell[k] ] ).norm() < radius ) { boost::add_edge( vertices[i], vertices[ cell[k] ], graph ); }
+                }
+            }
+        }
+    }
+    return vertices;
+}
+
+/// reset search state of all nodes
+template < typename G >
+inline void reset( G& graph )
+{
+    typedef typename boost::graph_traits< G >::vertex_iterator iterator;
+    for( std::pair< iterator, iterator > d = vertices( graph ); d.first != d.second; ++d.first ) { graph[ *d.first ].best_parent.reset(); graph[ *d.first ].value.distance = 0; }
+}
+
+} } // namespace snark { namespace test {
+
+#endif // SNARK_GRAPH_TEST_GENERATED_GRAPHS_H_
@@ -0,0 +1,51 @@
+/// time forward search with indexed heap against forward search with std::multimap on generated grid and random geometric graphs
+
+#include <iostream>
+#include <string>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/lexical_cast.hpp>
+#include <snark/graph/search.h>
+#include "forward_search_reference.h"
+#include "generated_graphs.h"
+
+static double seconds_since( const boost::posix_time::ptime& start ) { return double( ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() ) / 1e6; }
+
+template < typename G >
+static void run( const std::string& name, G& graph, const std::vector< typename boost::graph_traits< G >::vertex_descriptor >& vertices, unsigned int queries )
+{
+    using namespace snark::test;
+    double heap = 0;
+    double multimap = 0;
+    bool same = true;
+    for( unsigned int i = 0; i < queries; ++i )
+    {
+        typename boost::graph_traits< G >::vertex_descriptor source = vertices[ ( i * 7919 ) % vertices.size() ];
+        reset( graph );
+        boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+        snark::forward_search_reference( graph, source, &advance, &objective_function, &valid );
+        multimap += seconds_since( start );
+        std::vector< double > distances( vertices.size() );
+        for( std::size_t k = 0; k < vertices.size(); ++k ) { distances[k] = graph[ vertices[k] ].value.distance; }
+        reset( graph );
+        start = boost::posix_time::microsec_clock::universal_time();
+        snark::forward_search( graph, source, &advance, &objective_function, &valid );
+        heap += seconds_since( start );
+        for( std::size_t k = 0; k < vertices.size(); ++k ) { same = same && distances[k] == graph[ vertices[k] ].value.distance; }
+    }
+    std::cout << name << ": " << boost::num_vertices( graph ) << " vertices, " << boost::num_edges( graph ) << " edges: multimap: " << multimap / queries << " seconds; indexed heap: " << heap / queries << " seconds per search; same results: " << ( same ? "yes" : "no" ) << std::endl;
+}
+
+int main( int argc, char** argv )
+{
+    using namespace snark::test;
+    unsigned int size = argc > 1 ? boost::lexical_cast< unsigned int >( argv[1] ) : 1000000;
+    unsigned int queries = argc > 2 ? boost::lexical_cast< unsigned int >( argv[2] ) : 3;
+    std::cerr << "usage: graph-search-benchmark [<number of vertices>] [<number of searches>]; running with " << size << " vertices, " << queries << " searches" << std::endl;
+    unsigned int side = std::sqrt( double( size ) );
+    double radius = std::sqrt( 6.0 / ( M_PI * size ) ); // about 6 neighbours per vertex
+    { std::srand( 1 ); graph_type g; std::vector< graph_type::vertex_descriptor > v = make_grid( g, side ); run( "grid, setS", g, v, queries ); }
+    { std::srand( 1 ); vector_graph_type g; std::vector< vector_graph_type::vertex_descriptor > v = make_grid( g, side ); run( "grid, vecS", g, v, queries ); }
+    { std::srand( 1 ); graph_type g; std::vector< graph_type::vertex_descriptor > v = make_random_geometric( g, size, radius ); run( "random geometric, setS", g, v, queries ); }
+    { std::srand( 1 ); vector_graph_type g; std::vector< vector_graph_type::vertex_descriptor > v = make_random_geometric( g, size, radius ); run( "random geometric, vecS", g, v, queries ); }
+    return 0;
+}
@@ -0,0 +1,254 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <gtest/gtest.h>
+#include <boost/type_traits/is_integral.hpp>
+#include <snark/graph/search.h>
+#include "forward_search_reference.h"
+#include "generated_graphs.h"
+
+namespace snark { namespace test {
+
+template < typename G >
+static void expect_same_search( G& graph, G& reference, const std::vector< typename boost::graph_traits< G >::vertex_descriptor >& vertices, const std::vector< typename boost::graph_traits< G >::vertex_descriptor >& reference_vertices, std::size_t source )
+{
+    reset( graph );
+    reset( reference );
+    forward_search( graph, vertices[source], &advance, &objective_function, &valid );
+    forward_search_reference( reference, reference_vertices[source], &advance, &objective_function, &valid );
+    for( std::size_t i = 0; i < vertices.size(); ++i )
+    {
+        const search_node< node, edge >& n = graph[ vertices[i] ];
+        const search_node< node, edge >& r = reference[ reference_vertices[i] ];
+        ASSERT_EQ( bool( r.best_parent ), bool( n.best_parent ) );
+        if( r.best_parent ) { EXPECT_EQ( *r.best_parent, *n.best_parent ); }
+        EXPECT_EQ( r.value.distance, n.value.distance );
+        std::vector< typename boost::graph_traits< G >::vertex_descriptor > p = best_path( graph, vertices[source], vertices[i] );
+        std::vector< typename boost::graph_traits< G >::vertex_descriptor > q = best_path( reference, reference_vertices[source], reference_vertices[i] );
+        ASSERT_EQ( q.size(), p.size() );
+        for( std::size_t k = 0; k < p.size(); ++k ) { EXPECT_EQ( reference[ q[k] ].id, graph[ p[k] ].id ); }
+    }
+}
+
+template < typename G >
+static void test_same_paths()
+{
+    for( unsigned int jitter = 0; jitter < 2; ++jitter ) // without jitter, many paths are equally short
+    {
+        if( !jitter && !boost::is_integral< typename boost::graph_traits< G >::vertex_descriptor >::value ) { continue; } // for setS, ties are broken in the order of vertex addresses, which differ between the graphs
+        G graph;
+        G reference;
+        std::srand( 1 );
+        std::vector< typename boost::graph_traits< G >::vertex_descriptor > vertices = make_grid( graph, 20, jitter );
+        std::srand( 1 );
+        std::vector< typename boost::graph_traits< G >::vertex_descriptor > reference_vertices = make_grid( reference, 20, jitter );
+        for( std::size_t source = 0; source < vertices.size(); source += 37 ) { expect_same_search( graph, reference, vertices, reference_vertices, source ); }
+    }
+    G graph;
+    G reference;
+    std::srand( 2 );
+    std::vector< typename boost::graph_traits< G >::vertex_descriptor > vertices = make_random_geometric( graph, 500, 0.08 );
+    std::srand( 2 );
+    std::vector< typename boost::graph_traits< G >::vertex_descriptor > reference_vertices = make_random_geometric( reference, 500, 0.08 );
+    for( std::size_t source = 0; source < vertices.size(); source += 53 ) { expect_same_search( graph, reference, vertices, reference_vertices, source ); }
+}
+
+TEST( search, same_paths_as_multimap_search )
+{
+    test_same_paths< graph_type >();
+    test_same_paths< vector_graph_type >();
+}
+
+TEST( search, indexed_heap )
+{
+    indexed_heap< int > heap;
+    std::vector< int > keys( 100 );
+    std::srand( 3 );
+    for( std::size_t i = 0; i < keys.size(); ++i ) { keys[i] = std::rand() % 1000; heap.push( i, keys[i] ); }
+    for( std::size_t i = 0; i < keys.size(); i += 3 ) { keys[i] -= std::rand() % 500; heap.push( i, keys[i] ); } // decrease
+    for( std::size_t i = 1; i < keys.size(); i += 7 ) { keys[i] += std::rand() % 500; heap.push( i, keys[i] ); } // increase
+    EXPECT_EQ( keys.size(), heap.size() );
+    int last = -1000;
+    std::vector< bool > popped( keys.size(), false );
+    while( !heap.empty() )
+    {
+        EXPECT_EQ( keys[ heap.top() ], heap.top_key() );
+        EXPECT_LE( last, heap.top_key() );
+        last = heap.top_key();
+        EXPECT_FALSE( popped[ heap.top() ] );
+        popped[ heap.top() ] = true;
+        std::size_t top = heap.top();
+        heap.pop();
+        EXPECT_FALSE( heap.contains( top ) );
+    }
+    for( std::size_t i = 0; i < popped.size(); ++i ) { EXPECT_TRUE( popped[i] ); }
+}
+
+template < typename G >
+static double length( const G& graph, const std::vector< typename boost::graph_traits< G >::vertex_descriptor >& path )
+{
+    double d = 0;
+    for( std::size_t i = 1; i < path.size(); ++i )
+    {
+        EXPECT_TRUE( boost::edge( path[ i - 1 ], path[i], graph ).second );
+        d += ( graph[ path[i] ].value.position - graph[ path[ i - 1 ] ].value.position ).norm();
+    }
+    return d;
+}
+
+template < typename G >
+static void test_a_star( G& graph, const std::vector< typename boost::graph_traits< G >::vertex_descriptor >& vertices )
+{
+    for( std::size_t k = 0; k < 40; ++k )
+    {
+        typename boost::graph_traits< G >::vertex_descriptor start = vertices[ ( k * 7919 ) % vertices.size() ];
+        typename boost::graph_traits< G >::vertex_descriptor goal = vertices[ ( k * 104729 + 13 ) % vertices.size() ];
+        if( k == 0 ) { goal = start; }
+        reset( graph );
+        std::size_t uniform_expanded = forward_search( graph, start, &advance, &objective_function, &valid );
+        bool reachable = graph[goal].best_parent || goal == start;
+        double uniform = graph[goal].value.distance;
+        reset( graph );
+        std::size_t a_star_expanded = a_star_search( graph, start, goal, &advance, &objective_function, &valid, euclidean_heuristic( graph[goal].value.position ) );
+        EXPECT_EQ( reachable, graph[goal].best_parent || goal == start );
+        EXPECT_NEAR( uniform, graph[goal].value.distance, 1e-9 );
+        EXPECT_LE( a_star_expanded, uniform_expanded );
+        if( reachable ) { EXPECT_NEAR( uniform, length( graph, best_path( graph, start, goal ) ), 1e-9 ); }
+        for( unsigned int h = 0; h < 2; ++h )
+        {
+            std::size_t expanded;
+            std::vector< typename boost::graph_traits< G >::vertex_descriptor > path = h == 0 ? bidirectional_search( graph, start, goal, edge_length(), euclidean_distance(), &expanded )
+                                                                                          : bidirectional_search( graph, start, goal, edge_length(), impl::no_heuristic(), &expanded );
+            ASSERT_EQ( reachable, !path.empty() );
+            if( !reachable ) { continue; }
+            EXPECT_TRUE( path.front() == start );
+            EXPECT_TRUE( path.back() == goal );
+            EXPECT_NEAR( uniform, length( graph, path ), 1e-9 );
+        }
+    }
+}
+
+TEST( search, a_star_same_cost_as_uniform_search )
+{
+    {
+        std::srand( 1 );
+        graph_type graph;
+        std::vector< graph_type::vertex_descriptor > vertices = make_grid( graph, 30 );
+        test_a_star( graph, vertices );
+    }
+    {
+        std::srand( 1 );
+        vector_graph_type graph;
+        std::vector< vector_graph_type::vertex_descriptor > vertices = make_random_geometric( graph, 1000, 0.05 ); // may be disconnected
+        test_a_star( graph, vertices );
+    }
+}
+
+TEST( search, a_star_one_way )
+{
+    vector_graph_type graph;
+    std::vector< Eigen::Vector3d > positions;
+    for( unsigned int i = 0; i < 5; ++i ) { positions.push_back( Eigen::Vector3d( i, 0, 0 ) ); }
+    std::vector< vector_graph_type::vertex_descriptor > v = add_vertices( graph, positions );
+    for( unsigned int i = 0; i + 1 < v.size(); ++i ) { boost::add_edge( v[i], v[ i + 1 ], graph ); }
+    boost::add_edge( v[0], v[4], graph ); // long way round is shorter, when it is the only way
+    boost::add_edge( v[4], v[3], graph );
+    a_star_search( graph, v[0], v[3], &advance, &objective_function, &valid, euclidean_heuristic( positions[3] ) );
+    EXPECT_NEAR( 3, graph[ v[3] ].value.distance, 1e-12 );
+    EXPECT_EQ( 4u, bidirectional_search( graph, v[0], v[3], edge_length(), euclidean_distance() ).size() );
+    EXPECT_TRUE( bidirectional_search( graph, v[4], v[0], edge_length(), euclidean_distance() ).empty() );
+    reset( graph );
+    a_star_search( graph, v[4], v[0], &advance, &objective_function, &valid, euclidean_heuristic( positions[0] ) );
+    EXPECT_FALSE( graph[ v[0] ].best_parent );
+}
+
+template < typename G >
+static void test_workspace( G& graph, const std::vector< typename boost::graph_traits< G >::vertex_descriptor >& vertices )
+{
+    reset( graph );
+    const G& g = graph;
+    search_workspace< G > workspace( g );
+    for( std::size_t k = 0; k < 10; ++k )
+    {
+        typename boost::graph_traits< G >::vertex_descriptor start = vertices[ ( k * 7919 ) % vertices.size() ];
+        std::size_t expanded = forward_search( workspace, start, &advance, &objective_function, &valid );
+        G copy = graph;
+        std::vector< typename boost::graph_traits< G >::vertex_descriptor > copy_vertices( boost::num_vertices( copy ) );
+        typedef typename boost::graph_traits< G >::vertex_iterator iterator;
+        for( std::pair< iterator, iterator > d = boost::vertices( copy ); d.first != d.second; ++d.first ) { copy_vertices[ copy[ *d.first ].id ] = *d.first; }
+        EXPECT_EQ( expanded, forward_search( copy, copy_vertices[ graph[start].id ], &advance, &objective_function, &valid ) );
+        for( std::size_t i = 0; i < vertices.size(); ++i )
+        {
+            EXPECT_EQ( bool( copy[ copy_vertices[i] ].best_parent ), workspace.reached( vertices[i] ) );
+            EXPECT_EQ( copy[ copy_vertices[i] ].value.distance, workspace.value( vertices[i] ).distance );
+            EXPECT_FALSE( graph[ vertices[i] ].best_parent ); // graph not changed
+            const std::vector< typename boost::graph_traits< G >::vertex_descriptor >& p = workspace.best_path( start, vertices[i] );
+            const std::vector< typename boost::graph_traits< G >::vertex_descriptor >& q = best_path( copy, copy_vertices[ graph[start].id ], copy_vertices[i] );
+            ASSERT_EQ( q.size(), p.size() );
+            for( std::size_t m = 0; m < p.size(); ++m ) { EXPECT_EQ( copy[ q[m] ].id, graph[ p[m] ].id ); }
+        }
+        const std::vector< typename search_workspace< G >::path >& paths = workspace.best_paths( start, vertices );
+        ASSERT_EQ( vertices.size(), paths.size() );
+        for( std::size_t i = 0; i < vertices.size(); ++i )
+        {
+            const typename search_workspace< G >::path& p = paths[i];
+            EXPECT_EQ( workspace.best_path( start, vertices[i] ), p.vertices );
+            if( p.empty() ) { EXPECT_TRUE( p.edges.empty() ); continue; }
+            ASSERT_EQ( p.vertices.size(), p.edges.size() + 1 );
+            for( std::size_t m = 0; m < p.edges.size(); ++m )
+            {
+                EXPECT_EQ( p.vertices[m], source( p.edges[m], g ) );
+                EXPECT_EQ( p.vertices[ m + 1 ], target( p.edges[m], g ) );
+            }
+        }
+        typename boost::graph_traits< G >::vertex_descriptor goal = vertices[ ( k * 104729 ) % vertices.size() ];
+        a_star_search( workspace, start, goal, &advance, &objective_function, &valid, euclidean_heuristic( graph[goal].value.position ) );
+        EXPECT_EQ( bool( copy[ copy_vertices[ graph[goal].id ] ].best_parent ), workspace.reached( goal ) );
+        EXPECT_NEAR( copy[ copy_vertices[ graph[goal].id ] ].value.distance, workspace.value( goal ).distance, 1e-9 );
+        EXPECT_FALSE( graph[goal].best_parent );
+    }
+}
+
+TEST( search, workspace )
+{
+    {
+        std::srand( 1 );
+        graph_type graph;
+        std::vector< graph_type::vertex_descriptor > vertices = make_grid( graph, 20 );
+        test_workspace( graph, vertices );
+    }
+    {
+        std::srand( 1 );
+        vector_graph_type graph;
+        std::vector< vector_graph_type::vertex_descriptor > vertices = make_random_geometric( graph, 500, 0.06 );
+        test_workspace( graph, vertices );
+    }
+}
+
+} } // namespace snark { namespace test {
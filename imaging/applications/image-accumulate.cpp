@@ -31,10 +31,12 @@
 #ifdef WIN32
 #include <winsock2.h>
 #endif
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <limits>
 #include <map>
+#include <vector>
 #include <boost/array.hpp>
 #include <boost/bind.hpp>
 #include <boost/date_time/posix_time/ptime.hpp>
@@ -88,6 +90,8 @@ void usage()
     std::cerr << "        default: block,row,values" << std::endl;
     std::cerr << "    --fps=<value>: if present, update image <value> frames per second" << std::endl;
     std::cerr << "                   if absent, update on every new revolution (then revolution and sweep fields have to be present)" << std::endl;
+    std::cerr << "                   output to stderr once a second the rendered frame rate and the number of dropped rows," << std::endl;
+    std::cerr << "                   i.e. rows overwritten or cleaned before they made it into any output frame" << std::endl;
     std::cerr << "    --id=<id>[,<options>]: if id field present, channel id to output, e.g: --id=1 --id=\"3;scale=1,5\" --id=4" << std::endl;
     std::cerr << "        options: scale=<min>,<max>: see --scale" << std::endl;
     std::cerr << "                 colourmap=<value>: see --colourmap" << std::endl;
@@ -106,6 +110,11 @@ void usage()
     std::cerr << "    --verbose,-v: more output" << std::endl;
     std::cerr << "    --z=<value>: 'up' or 'down': in polar direction of z axis; default: up" << std::endl;
     std::cerr << std::endl;
+    std::cerr << "binary input" << std::endl;
+    std::cerr << "    if input is binary and values are of the same type and contiguous (e.g. --binary=t,3ui,640f)," << std::endl;
+    std::cerr << "    values are converted to pixels directly from the input record through a precomputed lookup table" << std::endl;
+    std::cerr << "    instead of being deserialized field by field" << std::endl;
+    std::cerr << std::endl;
     std::cerr << "examples" << std::endl;
     std::cerr << "    accumulate and visualise the last 100 frames from the output of a slit-scan camera with 640 pixels of 8-bit gray-scale values:" << std::endl;
     std::cerr << "        cat slit-scan.bin | image-accumulate --fields=,,,,values --binary=t,3ui,640ub --size=100,640 --output=\"type=ub\" | cv-cat \"view;null\"" << std::endl;
@@ -176,6 +185,12 @@ class scaled // quick and dirty
             return to_.first + ( v - from_.first ) * factor_;
         } 
         
+        const std::pair< double, double >& from() const { return from_; }
+        
+        const std::pair< double, double >& to() const { return to_; }
+        
+        double factor() const { return factor_; }
+        
     private:
         std::pair< double, double > from_;
         std::pair< double, double > to_;
@@ -279,7 +294,7 @@ static bool has_angle;
 static input in;
 static std::pair< double, double > scale;
 static boost::optional< double > fps;
-static std::vector< std::pair< double, double > > sin_cos;
+static std::vector< unsigned int > polar_index; // pixel index in polar image for each row and column of a channel
 static cv::Mat image;
 typedef std::map< unsigned int, unsigned int > Ids;
 static Ids ids;
@@ -290,11 +305,14 @@ static comma::signal_flag is_shutdown;
 static snark::cv_mat::serialization::options output_options;
 static unsigned int pixel_size;
 static unsigned int offset_from_center; // quick and dirty
+static boost::optional< comma::csv::format::types_enum > values_type; // if set, values are read directly from binary input
+static boost::mutex statistics_mutex;
+static std::vector< unsigned char > pending_rows; // for each channel and row: 1, if row drawn since last output frame
+static comma::uint64 dropped_rows = 0;
 
 static std::vector< std::pair< double, double > > precomputed_sin_cos_()
 {
-    if( !polar ) { return std::vector< std::pair< double, double > >(); }
-    std::vector< std::pair< double, double > > v( block_size ); // todo: quick and dirty; apparently easy to optimize
+    std::vector< std::pair< double, double > > v( block_size );
     double step = ( M_PI * 2 ) / block_size;
     double angle = 0;
     for( std::size_t i = 0; i < v.size(); ++i, angle += step )
@@ -305,32 +323,58 @@ static std::vector< std::pair< double, double > > precomputed_sin_cos_()
     return v;
 }
 
+static unsigned int polar_size() { return ( row_size + offset_from_center ) * 2 + 1; }
+
+static std::vector< unsigned int > precomputed_polar_index_()
+{
+    if( !polar ) { return std::vector< unsigned int >(); }
+    const std::vector< std::pair< double, double > >& sin_cos = precomputed_sin_cos_();
+    const unsigned int cols = polar_size() * ids.size();
+    std::vector< unsigned int > v( block_size * row_size );
+    for( unsigned int row = 0; row < block_size; ++row )
+    {
+        double x_step = sin_cos[row].second; 
+        double y_step = sin_cos[row].first * sign;
+        double x = row_size + offset_from_center; 
+        double y = row_size + offset_from_center;
+        x += sin_cos[row].second * offset_from_center;
+        y += sin_cos[row].first * sign * offset_from_center;
+        for( unsigned int column = 0; column < row_size; ++column, x += x_step, y += y_step )
+        {
+            v[ row * row_size + column ] = int( y ) * cols + int( x );
+        }
+    }
+    return v;
+}
+
 static void output_once_( const boost::posix_time::ptime& t )
 {
     std::pair< boost::posix_time::ptime, cv::Mat > output;
     if( polar )
     {
-        static unsigned int polar_size = ( row_size + offset_from_center ) * 2 + 1;
+        static unsigned int size = polar_size();
         static unsigned int type = output_options.get_header().type;
-        static cv::Mat polar_image( polar_size, polar_size * ids.size(), type );
+        static cv::Mat polar_image( size, size * ids.size(), type );
         ::memset( polar_image.datastart, 0, polar_image.dataend - polar_image.datastart );
         for( unsigned int i = 0; i < ids.size(); ++i )
         {
-            unsigned int offset = row_size * i;
-            unsigned int polar_offset = polar_size * i;
+            const unsigned int offset = row_size * i;
+            unsigned char* destination = polar_image.datastart + size * i * pixel_size;
             for( unsigned int row = 0; row < block_size; ++row )
             {
-                double x_step = sin_cos[row].second; 
-                double y_step = sin_cos[row].first * sign;
-                double x = row_size + offset_from_center + polar_offset; 
-                double y = row_size + offset_from_center;
-                x += sin_cos[row].second * offset_from_center;
-                y += sin_cos[row].first * sign * offset_from_center;
-                for( unsigned int column = 0; column < row_size; ++column, x += x_step, y += y_step )
+                const unsigned int* index = &polar_index[ row * row_size ];
+                const unsigned char* source = image.datastart + ( row * image.cols + offset ) * pixel_size;
+                if( pixel_size == 1 )
+                {
+                    for( unsigned int column = 0; column < row_size; ++column ) { destination[ index[column] ] = source[column]; }
+                }
+                else
                 {
-                    ::memcpy( polar_image.datastart + ( int( y ) * ( polar_image.cols ) + int( x ) ) * pixel_size
-                            , image.datastart + ( int( row ) * image.cols + offset + column ) * pixel_size
-                            , pixel_size );
+                    for( unsigned int column = 0; column < row_size; ++column, source += 3 )
+                    {
+                        unsigned char* d = destination + index[column] * 3;
+                        d[0] = source[0]; d[1] = source[1]; d[2] = source[2];
+                    }
                 }
             }
         }
@@ -348,7 +392,11 @@ static void output_()
 {
     static const boost::posix_time::time_duration period = boost::posix_time::milliseconds( 1000.0 / *fps );
     static const boost::posix_time::time_duration timeout = boost::posix_time::milliseconds( 10 );
+    static const boost::posix_time::time_duration statistics_period = boost::posix_time::seconds( 1 );
     boost::posix_time::ptime time_to_output = boost::posix_time::microsec_clock::universal_time() + period;    
+    boost::posix_time::ptime statistics_start = boost::posix_time::microsec_clock::universal_time();
+    unsigned int frames = 0;
+    comma::uint64 dropped_rows_reported = 0;
     while( !is_shutdown && !done && std::cout.good() )
     {
         boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
@@ -356,11 +404,125 @@ static void output_()
         {
             time_to_output = now + period;
             output_once_( now );
+            ++frames;
+            boost::mutex::scoped_lock lock( statistics_mutex );
+            std::fill( pending_rows.begin(), pending_rows.end(), 0 );
+        }
+        if( statistics_start + statistics_period <= now )
+        {
+            double seconds = double( ( now - statistics_start ).total_microseconds() ) / 1000000;
+            boost::mutex::scoped_lock lock( statistics_mutex );
+            std::cerr << "image-accumulate: rendered " << ( frames / seconds ) << " frames/s; dropped " << ( dropped_rows - dropped_rows_reported ) << " row(s); total dropped: " << dropped_rows << std::endl;
+            dropped_rows_reported = dropped_rows;
+            frames = 0;
+            statistics_start = now;
         }
         boost::thread::sleep( now + timeout );
     }
+    boost::mutex::scoped_lock lock( statistics_mutex );
+    std::cerr << "image-accumulate: total dropped: " << dropped_rows << " row(s)" << std::endl;
 }
 
+class row_renderer // quick and dirty; converts binary values directly to pixels, avoiding deserialization
+{
+    public:
+        row_renderer( comma::csv::format::types_enum type, const scaled< unsigned char >& scaled, const color_map::values& colourmap )
+            : type_( type )
+            , scaled_( scaled )
+            , colourmap_( colourmap )
+            , indices_( row_size )
+        {
+            switch( type_ )
+            {
+                case comma::csv::format::char_t:
+                case comma::csv::format::int8:
+                    for( unsigned int i = 0; i < 256; ++i ) { byte_lut_[i] = scaled_( static_cast< signed char >( i ) ); }
+                    break;
+                case comma::csv::format::uint8:
+                    for( unsigned int i = 0; i < 256; ++i ) { byte_lut_[i] = scaled_( i ); }
+                    break;
+                case comma::csv::format::int16:
+                case comma::csv::format::uint16:
+                case comma::csv::format::int32:
+                case comma::csv::format::uint32:
+                case comma::csv::format::int64:
+                case comma::csv::format::uint64:
+                case comma::csv::format::float_t:
+                case comma::csv::format::double_t:
+                    break;
+                default:
+                    COMMA_THROW( comma::exception, "image-accumulate: expected numeric values, got type " << type_ );
+            }
+        }
+        
+        static bool supports( comma::csv::format::types_enum type )
+        {
+            switch( type )
+            {
+                case comma::csv::format::time:
+                case comma::csv::format::long_time:
+                case comma::csv::format::fixed_string:
+                    return false;
+                default:
+                    return true;
+            }
+        }
+        
+        void operator()( const char* values, unsigned char* pixels )
+        {
+            switch( type_ )
+            {
+                case comma::csv::format::char_t:
+                case comma::csv::format::int8:
+                case comma::csv::format::uint8:
+                {
+                    const unsigned char* v = reinterpret_cast< const unsigned char* >( values );
+                    for( unsigned int i = 0; i < row_size; ++i ) { indices_[i] = byte_lut_[ v[i] ]; }
+                    break;
+                }
+                case comma::csv::format::int16: scale_< comma::int16 >( values ); break;
+                case comma::csv::format::uint16: scale_< comma::uint16 >( values ); break;
+                case comma::csv::format::int32: scale_< comma::int32 >( values ); break;
+                case comma::csv::format::uint32: scale_< comma::uint32 >( values ); break;
+                case comma::csv::format::int64: scale_< comma::int64 >( values ); break;
+                case comma::csv::format::uint64: scale_< comma::uint64 >( values ); break;
+                case comma::csv::format::float_t: scale_< float >( values ); break;
+                case comma::csv::format::double_t: scale_< double >( values ); break;
+                default: break; // never here
+            }
+            if( pixel_size == 1 ) { ::memcpy( pixels, &indices_[0], row_size ); return; }
+            for( unsigned int i = 0; i < row_size; ++i, pixels += 3 )
+            {
+                const color_map::pixel& colour = colourmap_[ indices_[i] ];
+                pixels[0] = colour[0]; pixels[1] = colour[1]; pixels[2] = colour[2];
+            }
+        }
+        
+    private:
+        comma::csv::format::types_enum type_;
+        const scaled< unsigned char >& scaled_;
+        const color_map::values& colourmap_;
+        boost::array< unsigned char, 256 > byte_lut_;
+        std::vector< unsigned char > indices_;
+        
+        template < typename T > void scale_( const char* values ) // branch-free clamping, so that the loop vectorizes
+        {
+            const double from = scaled_.from().first;
+            const double factor = scaled_.factor();
+            const double to_first = scaled_.to().first;
+            const double to_second = scaled_.to().second;
+            for( unsigned int i = 0; i < row_size; ++i )
+            {
+                T t;
+                ::memcpy( &t, values + i * sizeof( T ), sizeof( T ) ); // values may be unaligned
+                double v = to_first + ( double( t ) - from ) * factor;
+                v = v < to_first ? to_first : v;
+                v = v > to_second ? to_second : v;
+                indices_[i] = static_cast< unsigned char >( v );
+            }
+        }
+};
+
 class channel
 {
     public:
@@ -413,9 +575,11 @@ class channel
                 if( v.size() != 3 ) { COMMA_THROW( comma::exception, "image-accumulate: expected colour, got '" << options.dial_colour << "'" ); }
                 dial_colour_ = cv::Scalar( boost::lexical_cast< unsigned int >( v[2] ), boost::lexical_cast< unsigned int >( v[1] ), boost::lexical_cast< unsigned int >( v[0] ) );
             }
+            if( values_type ) { renderer_.reset( new row_renderer( *values_type, scaled_, colourmap_ ) ); }
         }
 
-        bool draw( const input* p )
+        /// @param values if not null, points to row values in binary input record
+        bool draw( const input* p, const char* values = NULL )
         {
             if( !fps )
             {   
@@ -456,7 +620,8 @@ class channel
                 row_ = row_count_;
             }
             ++row_count_;
-            draw_line_( p, row_() );
+            if( fps ) { drawn_( row_() ); }
+            draw_line_( p, values, row_() );
             draw_dial_();
             return true;
         }
@@ -471,6 +636,7 @@ class channel
         unsigned int row_count_;
         double angle_step_;
         options options_;
+        boost::scoped_ptr< row_renderer > renderer_;
         
         void draw_dial_()
         {
@@ -484,18 +650,49 @@ class channel
         
         void clean_( unsigned int to, unsigned int increment )
         {
-            if( options_.do_not_clean ) { return; }
-            comma::math::cyclic< unsigned int > r( row_ );
+            if( options_.do_not_clean || row_() == to ) { return; }
+            // clean rows strictly between the current row and the new one, i.e. cyclic range [begin, begin + size)
+            unsigned int begin = increment == 1 ? row_() + 1 : to + 1;
+            unsigned int size = ( increment == 1 ? to + block_size - row_() : row_() + block_size - to ) % block_size - 1;
+            if( begin == block_size ) { begin = 0; }
+            unsigned int end = begin + size;
+            if( end > block_size ) { clean_rows_( begin, block_size ); clean_rows_( 0, end - block_size ); }
+            else { clean_rows_( begin, end ); }
+        }
+        
+        /// count row as dropped, if it was drawn, but not output yet
+        void drawn_( unsigned int row )
+        {
+            boost::mutex::scoped_lock lock( statistics_mutex );
+            unsigned char& pending = pending_rows[ index_ * block_size + row ];
+            dropped_rows += pending;
+            pending = 1;
+        }
+
+        void clean_rows_( unsigned int begin, unsigned int end )
+        {
+            if( fps ) // cleaned rows not output yet are dropped
+            {
+                boost::mutex::scoped_lock lock( statistics_mutex );
+                unsigned char* pending = &pending_rows[ index_ * block_size ];
+                for( unsigned int r = begin; r < end; ++r ) { dropped_rows += pending[r]; pending[r] = 0; }
+            }
+            if( ids.size() == 1 ) // rows are contiguous
+            {
+                ::memset( image.datastart + image.cols * begin * pixel_size, 0, image.cols * ( end - begin ) * pixel_size );
+                return;
+            }
             unsigned int offset = index_ * row_size * pixel_size;
-            for( r += increment; row_() != to && r() != to; r += increment )
+            for( unsigned int r = begin; r < end; ++r )
             {
-                ::memset( image.datastart + offset + image.cols * r() * pixel_size, 0, row_size * pixel_size );
+                ::memset( image.datastart + offset + image.cols * r * pixel_size, 0, row_size * pixel_size );
             }
         }
         
-        void draw_line_( const input* p, unsigned int row )
+        void draw_line_( const input* p, const char* values, unsigned int row )
         {
             unsigned int offset = ( image.cols * row + index_ * row_size ) * pixel_size;
+            if( values ) { ( *renderer_ )( values, image.datastart + offset ); return; }
             if( pixel_size == 1 ) // quick and dirty
             {
                 for( unsigned int i = 0; i < row_size; ++i )
@@ -532,6 +729,25 @@ template <> struct traits< channel::options >
     
 } } // namespace comma { namespace visiting {
 
+/// @return offset of values in binary record, if values are contiguous and of the same numeric type
+static boost::optional< std::size_t > binary_values_offset_( const comma::csv::options& csv )
+{
+    if( !csv.binary() ) { return boost::none; }
+    const std::vector< std::string >& fields = comma::split( csv.fields, ',' );
+    unsigned int index = 0;
+    for( ; index < fields.size() && fields[index] != "values"; ++index );
+    if( index == fields.size() || index + row_size > csv.format().count() ) { return boost::none; }
+    const comma::csv::format::element& first = csv.format().offset( index );
+    if( !row_renderer::supports( first.type ) ) { return boost::none; }
+    for( unsigned int i = 1; i < row_size; ++i )
+    {
+        const comma::csv::format::element& e = csv.format().offset( index + i );
+        if( e.type != first.type || e.offset != first.offset + i * first.size ) { return boost::none; }
+    }
+    values_type = first.type;
+    return first.offset;
+}
+
 int main( int ac, char** av )
 {
     int result = 0;
@@ -558,7 +774,6 @@ int main( int ac, char** av )
         scale = comma::csv::ascii< std::pair< double, double > >().get( options.value< std::string >( "--scale", "0,255" ) );
         scaled< unsigned char > scaled( scale );
         fps = options.optional< double >( "--fps" );
-        sin_cos = precomputed_sin_cos_();
         channel::options default_channel_options( options );
         std::vector< channel::options > channel_options;
         if( csv.has_field( "id" ) )
@@ -576,12 +791,22 @@ int main( int ac, char** av )
             ids[0] = 0;
             channel_options.push_back( default_channel_options );
         }
+        polar_index = precomputed_polar_index_();
         in.values.resize( row_size );
         has_block = csv.has_field( "block" );
         has_row = csv.has_field( "row" );
         has_angle = csv.has_field( "angle" );
         if( has_row && has_angle ) { std::cerr << "image-accumulate: in input fields, expected either 'row' or 'angle'; got both" << std::endl; return 1; }
-        comma::csv::input_stream< input > istream( std::cin, csv, in ); // todo: watch performance!
+        boost::optional< std::size_t > values_offset = binary_values_offset_( csv );
+        comma::csv::options input_csv = csv;
+        if( values_offset ) // values will be converted to pixels straight from the input record; deserialize the rest only
+        {
+            std::vector< std::string > fields = comma::split( csv.fields, ',' );
+            for( unsigned int i = 0; i < fields.size(); ++i ) { if( fields[i] == "values" ) { fields[i] = ""; } }
+            input_csv.fields = comma::join( fields, ',' );
+            if( verbose ) { std::cerr << "image-accumulate: reading values directly from binary input" << std::endl; }
+        }
+        comma::csv::input_stream< input > istream( std::cin, input_csv, in );
         std::string default_output_options = "no-header;rows=" + boost::lexical_cast< std::string >( polar ? row_size * 2 + 1 : block_size ) + ";cols=" + boost::lexical_cast< std::string >( polar ? ( row_size * 2 + 1 ) * ids.size() : row_size * ids.size() ) + ";type=3ub";
         std::string output_options_string = options.value( "--output", default_output_options );
         output_options = comma::name_value::parser( ';', '=' ).get< snark::cv_mat::serialization::options >( output_options_string );
@@ -591,7 +816,7 @@ int main( int ac, char** av )
         pixel_size = output_options.get_header().type == CV_8UC3 ? 3 : 1; // quick and dirty
         boost::ptr_vector< channel > channels;
         for( unsigned int i = 0; i < ids.size(); ++i ) { channels.push_back( new channel( i, channel_options[i] ) ); }
-        if( fps ) { output_thread.reset( new boost::thread( &output_ ) ); }
+        if( fps ) { pending_rows.resize( block_size * ids.size(), 0 ); output_thread.reset( new boost::thread( &output_ ) ); }
         while( !is_shutdown && std::cin.good() && !std::cin.eof() )
         {
             const input* p = istream.read();
@@ -599,7 +824,7 @@ int main( int ac, char** av )
             {
                 Ids::const_iterator it = ids.find( p->id );
                 if( it == ids.end() ) { continue; }
-                if( !channels[ it->second ].draw( p ) ) { break; }
+                if( !channels[ it->second ].draw( p, values_offset ? istream.binary().last() + *values_offset : NULL ) ) { break; }
             }
             else
             {
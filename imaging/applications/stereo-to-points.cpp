@@ -43,7 +43,7 @@ cv::StereoSGBM sgbm;
 
 template< typename T >
 void run( const snark::imaging::camera_parser& left_parameters, const snark::imaging::camera_parser& right_parameters,
-          unsigned int width, unsigned int height, const comma::csv::options& csv, const cv::Mat& left, const cv::Mat& right, bool input_rectified = false )
+          unsigned int width, unsigned int height, const comma::csv::options& csv, const cv::Mat& left, const cv::Mat& right, snark::imaging::point_cloud& cloud, bool input_rectified = false )
 {
     if( left_parameters.has_map() )
     {
@@ -51,18 +51,18 @@ void run( const snark::imaging::camera_parser& left_parameters, const snark::ima
                           left_parameters.map_x(), left_parameters.map_y(),
                           right_parameters.map_x(), right_parameters.map_y(),
                           csv, input_rectified );
-        stereoPipeline.process( left, right, sgbm );
+        stereoPipeline.process( left, right, cloud );
     }
     else
     {
         T stereoPipeline( left_parameters, right_parameters, width, height, csv, input_rectified );
-        stereoPipeline.process( left, right, sgbm );
+        stereoPipeline.process( left, right, cloud );
     }
 }
 
 template< typename T >
 void run_stream( const snark::imaging::camera_parser& left_parameters, const snark::imaging::camera_parser& right_parameters,
-          const boost::array< unsigned int, 6 > roi, const comma::csv::options& input_csv, const comma::csv::options& output_csv, bool input_rectified = false )
+          const boost::array< unsigned int, 6 > roi, const comma::csv::options& input_csv, const comma::csv::options& output_csv, snark::imaging::point_cloud& cloud, bool input_rectified = false )
 {
     if( left_parameters.has_map() )
     {
@@ -72,7 +72,7 @@ void run_stream( const snark::imaging::camera_parser& left_parameters, const sna
                           input_csv, output_csv, input_rectified );
         while( std::cin.good() && !std::cin.eof() )
         {
-            stream.read( sgbm );
+            stream.read( cloud );
         }
     }
     else
@@ -80,7 +80,7 @@ void run_stream( const snark::imaging::camera_parser& left_parameters, const sna
         snark::imaging::stereo_stream< T > stream( left_parameters, right_parameters, roi, input_csv, output_csv, input_rectified );
         while( std::cin.good() && !std::cin.eof() )
         {
-            stream.read( sgbm );
+            stream.read( cloud );
         }
     }
 }
@@ -101,6 +101,10 @@ int main( int argc, char** argv )
         std::string leftImage;
         std::string rightImage;
         std::string roi;
+        unsigned int bands;
+        unsigned int band_overlap;
+        std::string region;
+        unsigned int stride;
         
         description.add_options()
             ( "help,h", "display help message" )
@@ -122,8 +126,12 @@ int main( int argc, char** argv )
             ( "speckle-range,r", boost::program_options::value< int >( &sgbm.speckleRange )->default_value(16), "sgbm speckleRange" )
             ( "disp12-max", boost::program_options::value< int >( &sgbm.disp12MaxDiff )->default_value(1), "sgbm disp12MaxDiff" )
             ( "pre-filter-cap", boost::program_options::value< int >( &sgbm.preFilterCap )->default_value(63), "sgbm preFilterCap" )
-            ( "full-dp,f", "use fullDP, uses a lot of memory" );
-        description.add( comma::csv::program_options::description( "t,x,y,z,r,g,b,block" ) );
+            ( "full-dp,f", "use fullDP, uses a lot of memory" )
+            ( "bands", boost::program_options::value< unsigned int >( &bands )->default_value(1), "compute disparity in given number of horizontal bands in parallel, at most one per image row; results may slightly differ from a single band at the band borders" )
+            ( "band-overlap", boost::program_options::value< unsigned int >( &band_overlap ), "number of rows by which neighbouring bands overlap; default: num-disparity" )
+            ( "region", boost::program_options::value< std::string >( &region ), "output points only for pixels of rectified left image in given region, arg=<x,y,width,height>" )
+            ( "stride", boost::program_options::value< unsigned int >( &stride )->default_value(1), "output points only for every n-th row and column, e.g. --stride=4" );
+        description.add( comma::csv::program_options::description( "t,x,y,z,r,g,b,block" ) ); // also: row,column
         boost::program_options::variables_map vm;
         boost::program_options::store( boost::program_options::parse_command_line( argc, argv, description), vm );
         boost::program_options::parsed_options parsed = boost::program_options::command_line_parser(argc, argv).options( description ).allow_unregistered().run();
@@ -134,6 +142,8 @@ int main( int argc, char** argv )
             std::cerr << description << std::endl;
             std::cerr << std::endl;
             std::cerr << "output format: t,x,y,z,r,g,b,block for point cloud " << std::endl;
+            std::cerr << "               additional point cloud fields: row,column: pixel in rectified left image" << std::endl;
+            std::cerr << "               only valid points are output, in binary written in batches" << std::endl;
             std::cerr << "               t,rows,cols,type for disparity image or rectified image pair " << std::endl;
             std::cerr << std::endl;
             std::cerr << "example config file with pre-computed rectify maps (eg. with the bumblebee camera factory calibration):\n" << std::endl;
@@ -196,12 +206,28 @@ int main( int argc, char** argv )
             std::cerr << "    find left -name '*.ppm' | sort | parallel  'stereo-to-points --left left/{/} --right right/{/} --config bumblebee.config \\" << std::endl;;
             std::cerr << "    --left-path left --right-path right --binary t,3d,3ub,ui --full-dp > cloud-{/.}.bin" << std::endl;
             std::cerr << std::endl;
+            std::cerr << "  output every 4th pixel of the lower half of 1280x960 images with pixel coordinates, without colour: " << std::endl;
+            std::cerr << "    stereo-to-points --left left.bmp --right right.bmp --config bumblebee.config --left-path left --right-path right \\" << std::endl;
+            std::cerr << "    --region 0,480,1280,480 --stride 4 --fields t,x,y,z,row,column --binary t,3d,2ui > cloud.bin" << std::endl;
+            std::cerr << std::endl;
+            std::cerr << "  compute disparity of large images in 4 horizontal bands in parallel: " << std::endl;
+            std::cerr << "    stereo-to-points --left left.bmp --right right.bmp --config bumblebee.config --left-path left --right-path right --binary t,3d,3ub,ui --bands 4 > cloud.bin" << std::endl;
+            std::cerr << std::endl;
             std::cerr << "  known bugs: point cloud doesn't seem to work with opencv 2.3 ( e.g. on shrimp ), works with opencv 2.4 " << std::endl;
             std::cerr << std::endl;
             return 1;
         }
 
         sgbm.fullDP = ( vm.count( "full-dp" ) );
+        snark::imaging::point_cloud cloud( sgbm, bands, vm.count( "band-overlap" ) ? band_overlap : sgbm.numberOfDisparities );
+        cv::Rect region_of_interest;
+        if( vm.count( "region" ) )
+        {
+            std::vector< std::string > v = comma::split( region, ',' );
+            if( v.size() != 4 ) { std::cerr << argv[0] << ": please specify --region as <x,y,width,height>" << std::endl; return 1; }
+            region_of_interest = cv::Rect( boost::lexical_cast< int >( v[0] ), boost::lexical_cast< int >( v[1] ), boost::lexical_cast< int >( v[2] ), boost::lexical_cast< int >( v[3] ) );
+        }
+        cloud.set_sampling( region_of_interest, stride );
         
         if( !vm.count( "config" ) )
         {
@@ -241,14 +267,14 @@ int main( int argc, char** argv )
             }
             if( vm.count( "disparity" ) == 0 && vm.count( "output-rectified" ) == 0 )
             {
-                run< snark::imaging::stereo >( leftParameters, rightParameters, left.cols, left.rows, csv, left, right, vm.count( "input-rectified" ) );
+                run< snark::imaging::stereo >( leftParameters, rightParameters, left.cols, left.rows, csv, left, right, cloud, vm.count( "input-rectified" ) );
             }
             else
             {
                 if( vm.count( "disparity" ) )
-                    run< snark::imaging::disparity >( leftParameters, rightParameters, left.cols, left.rows, csv, left, right, vm.count( "input-rectified" ) );
+                    run< snark::imaging::disparity >( leftParameters, rightParameters, left.cols, left.rows, csv, left, right, cloud, vm.count( "input-rectified" ) );
                 if( vm.count( "output-rectified" ) )
-                    run< snark::imaging::rectified >( leftParameters, rightParameters, left.cols, left.rows, csv, left, right, vm.count( "input-rectified" ) );
+                    run< snark::imaging::rectified >( leftParameters, rightParameters, left.cols, left.rows, csv, left, right, cloud, vm.count( "input-rectified" ) );
             }
         }
         else
@@ -275,14 +301,14 @@ int main( int argc, char** argv )
             input_csv.format( "t,3ui" );
             if( vm.count( "disparity" ) == 0 && vm.count( "output-rectified" ) == 0 )
             {
-                run_stream< snark::imaging::stereo >( leftParameters, rightParameters, roiArray, input_csv, csv, vm.count( "input-rectified" ) );
+                run_stream< snark::imaging::stereo >( leftParameters, rightParameters, roiArray, input_csv, csv, cloud, vm.count( "input-rectified" ) );
             }
             else
             {
                 if( vm.count( "disparity" ) )
-                    run_stream< snark::imaging::disparity >( leftParameters, rightParameters, roiArray, input_csv, csv, vm.count( "input-rectified" ) );
+                    run_stream< snark::imaging::disparity >( leftParameters, rightParameters, roiArray, input_csv, csv, cloud, vm.count( "input-rectified" ) );
                 if( vm.count( "output-rectified" ) )
-                    run_stream< snark::imaging::rectified >( leftParameters, rightParameters, roiArray, input_csv, csv, vm.count( "input-rectified" ) );
+                    run_stream< snark::imaging::rectified >( leftParameters, rightParameters, roiArray, input_csv, csv, cloud, vm.count( "input-rectified" ) );
             }
         }
 
@@ -55,10 +55,8 @@ disparity::disparity ( const camera_parser& left, const camera_parser& right,
     
 }
 
-void disparity::process( const cv::Mat& left, const cv::Mat& right, const cv::StereoSGBM& sgbm, boost::posix_time::ptime time )
+void disparity::process( const cv::Mat& left, const cv::Mat& right, point_cloud& cloud, boost::posix_time::ptime time )
 {
-    snark::imaging::point_cloud cloud( sgbm );
-
     cv::Mat disparity;
     if (!m_input_rectified)
     {
@@ -47,7 +47,7 @@ public:
             const cv::Mat& left_x, const cv::Mat& left_y, const cv::Mat& right_x, const cv::Mat& right_y,
             const comma::csv::options& csv, bool input_rectified );
 
-    void process( const cv::Mat& left, const cv::Mat& right, const cv::StereoSGBM& sgbm, boost::posix_time::ptime time = boost::posix_time::ptime() );
+    void process( const cv::Mat& left, const cv::Mat& right, point_cloud& cloud, boost::posix_time::ptime time = boost::posix_time::ptime() );
 private:
     Eigen::Matrix3d m_rotation;
     Eigen::Vector3d m_translation;
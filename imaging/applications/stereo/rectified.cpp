@@ -56,10 +56,8 @@ cv::Mat rectified::concatenate( const cv::Mat& left, const cv::Mat& right )
     return concatenated;
 }
 
-void rectified::process( const cv::Mat& left, const cv::Mat& right, const cv::StereoSGBM& sgbm, boost::posix_time::ptime time )
+void rectified::process( const cv::Mat& left, const cv::Mat& right, point_cloud& cloud, boost::posix_time::ptime time )
 {
-    snark::imaging::point_cloud cloud( sgbm );
-
     if (!m_input_rectified)
     {
         cv::Mat leftRectified = m_rectify.remap_left( left );
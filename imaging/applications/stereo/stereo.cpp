@@ -33,17 +33,20 @@
 
 namespace snark { namespace imaging {
 
+static const std::size_t batch_size = 4096; // number of points written at once in binary
+
 stereo::stereo ( const snark::imaging::camera_parser& left, const snark::imaging::camera_parser& right, unsigned int width, unsigned int height, const comma::csv::options& csv, bool input_rectified ):
     m_rotation( right.rotation() * left.rotation().transpose() ),
     m_translation( right.translation() - left.translation() ),
     m_rectify( left.camera(), left.distortion(), right.camera(), right.distortion(), width, height, m_rotation, m_translation, input_rectified ),
     m_input_rectified( input_rectified ),
+    m_output_size( 0 ),
     m_frame_counter( 0 )
 {
     if( csv.binary() )
     {
         m_binary.reset( new comma::csv::binary< colored_point >( csv ) );
-        m_output.resize( csv.format().size() );
+        m_output.resize( csv.format().size() * batch_size );
     }
     else
     {
@@ -58,12 +61,13 @@ stereo::stereo ( const camera_parser& left, const camera_parser& right,
     m_translation( right.translation() - left.translation() ),
     m_rectify( left.camera(), right.camera(), m_translation, left_x, left_y, right_x, right_y, input_rectified ),
     m_input_rectified( input_rectified ),
+    m_output_size( 0 ),
     m_frame_counter( 0 )
 {
     if( csv.binary() )
     {
         m_binary.reset( new comma::csv::binary< colored_point >( csv ) );
-        m_output.resize( csv.format().size() );
+        m_output.resize( csv.format().size() * batch_size );
     }
     else
     {
@@ -72,57 +76,79 @@ stereo::stereo ( const camera_parser& left, const camera_parser& right,
 }
 
 
-void stereo::process( const cv::Mat& left, const cv::Mat& right, const cv::StereoSGBM& sgbm, boost::posix_time::ptime time )
+void stereo::process( const cv::Mat& left, const cv::Mat& right, point_cloud& cloud, boost::posix_time::ptime time )
 {
-    snark::imaging::point_cloud cloud( sgbm );
-
-    cv::Mat points;
     cv::Mat leftRectified, rightRectified;
     if (!m_input_rectified)
     {
         leftRectified = m_rectify.remap_left( left );
         rightRectified = m_rectify.remap_right( right );
-        points = cloud.get( m_rectify.Q(), leftRectified, rightRectified );
     }
     else
     {
         leftRectified = left;
         rightRectified = right;
-        points = cloud.get( m_rectify.Q(), left, right );
     }
-
-    for( int i = 0; i < points.rows; i++ )
+    const cv::Mat& disparity = cloud.get_disparity( m_rectify.Q(), leftRectified, rightRectified );
+    const cv::Rect roi = cloud.roi( disparity.rows, disparity.cols );
+    const int stride = cloud.stride();
+    colored_point point_color;
+    point_color.time = time;
+    point_color.block = m_frame_counter;
+    for( int i = roi.y; i < roi.y + roi.height; i += stride )
     {
-       for( int j = 0; j < points.cols; j++ )
+       const short* d = disparity.ptr< short >( i );
+       const cv::Vec3b* colors = leftRectified.ptr< cv::Vec3b >( i );
+       for( int j = roi.x; j < roi.x + roi.width; j += stride )
        {
-            cv::Point3f point = points.at< cv::Point3f >( i, j );
-
-            if( std::fabs( point.z ) < 10000 ) // CV uses 10,000 as invalid. TODO config max distance ?
-            {
-                point *= 16.0; // disparity has a factor 16
-                cv::Vec3b color = leftRectified.at< cv::Vec3b >( i, j );
-                colored_point point_color( point.x, point.y, point.z, color[2], color[1], color[0] );
-                point_color.time = time;
-                point_color.block = m_frame_counter;
-                if( m_binary )
-                {
-                    m_binary->put( point_color, &m_output[0] );
-                    std::cout.write( &m_output[0], m_output.size() );
-                    std::cout.flush();
-                }
-                else
-                {
-                    std::string line;
-                    m_ascii->put( point_color, line );
-                    std::cout << line << std::endl;
-                }
-            }
+            cv::Point3f point;
+            if( !cloud.reproject( i, j, d[j], point ) ) { continue; } // TODO config max distance ?
+            point_color.x = point.x;
+            point_color.y = point.y;
+            point_color.z = point.z;
+            point_color.red = colors[j][2];
+            point_color.green = colors[j][1];
+            point_color.blue = colors[j][0];
+            point_color.row = i;
+            point_color.column = j;
+            write_( point_color );
         }
     }
+    flush_();
     m_frame_counter++;
 }
 
 
-} }
+void stereo::write_( const colored_point& point )
+{
+    if( m_binary )
+    {
+        m_binary->put( point, &m_output[ m_output_size ] );
+        m_output_size += m_output.size() / batch_size;
+        if( m_output_size == m_output.size() ) { std::cout.write( &m_output[0], m_output_size ); m_output_size = 0; }
+    }
+    else
+    {
+        std::string line;
+        m_ascii->put( point, line );
+        m_ascii_output += line;
+        m_ascii_output += '\n';
+    }
+}
 
+void stereo::flush_()
+{
+    if( m_binary )
+    {
+        std::cout.write( &m_output[0], m_output_size );
+        m_output_size = 0;
+    }
+    else
+    {
+        std::cout << m_ascii_output;
+        m_ascii_output.clear();
+    }
+    std::cout.flush();
+}
 
+} }
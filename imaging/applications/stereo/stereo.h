@@ -40,8 +40,8 @@ namespace snark { namespace imaging {
 
 struct colored_point
 {
-    colored_point() : x( 0 ), y( 0 ), z( 0 ), red( 0 ), green( 0 ), blue( 0 ), block( 0 ) {}
-    colored_point( double xx, double yy, double zz, unsigned char r, unsigned char g, unsigned char b ) : x( xx ), y( yy ), z( zz ), red( r ), green( g ), blue( b ), block( 0 ) {}
+    colored_point() : x( 0 ), y( 0 ), z( 0 ), red( 0 ), green( 0 ), blue( 0 ), block( 0 ), row( 0 ), column( 0 ) {}
+    colored_point( double xx, double yy, double zz, unsigned char r, unsigned char g, unsigned char b ) : x( xx ), y( yy ), z( zz ), red( r ), green( g ), blue( b ), block( 0 ), row( 0 ), column( 0 ) {}
     boost::posix_time::ptime time;
     double x;
     double y;
@@ -50,6 +50,8 @@ struct colored_point
     unsigned char green;
     unsigned char blue;
     unsigned int block;
+    unsigned int row; // pixel row in rectified left image
+    unsigned int column; // pixel column in rectified left image
 };
 
 /// output point cloud to stdout from stereo pair
@@ -61,7 +63,7 @@ public:
             const cv::Mat& left_x, const cv::Mat& left_y, const cv::Mat& right_x, const cv::Mat& right_y,
             const comma::csv::options& csv, bool input_rectified );
 
-    void process( const cv::Mat& left, const cv::Mat& right, const cv::StereoSGBM& sgbm, boost::posix_time::ptime time = boost::posix_time::ptime() );
+    void process( const cv::Mat& left, const cv::Mat& right, point_cloud& cloud, boost::posix_time::ptime time = boost::posix_time::ptime() );
 private:
     
     Eigen::Matrix3d m_rotation;
@@ -71,7 +73,12 @@ private:
     boost::scoped_ptr< comma::csv::ascii< colored_point > > m_ascii;
     boost::scoped_ptr< comma::csv::binary< colored_point > > m_binary;
     std::vector< char > m_output;
+    std::size_t m_output_size;
+    std::string m_ascii_output;
     unsigned int m_frame_counter;
+    
+    void write_( const colored_point& point );
+    void flush_();
 };
 
 } }
@@ -91,6 +98,8 @@ template <> struct traits< snark::imaging::colored_point >
         v.apply( "g", p.green );
         v.apply( "b", p.blue );
         v.apply( "block", p.block );
+        v.apply( "row", p.row );
+        v.apply( "column", p.column );
     }
 
     template < typename Key, class Visitor >
@@ -104,6 +113,8 @@ template <> struct traits< snark::imaging::colored_point >
         v.apply( "g", p.green );
         v.apply( "b", p.blue );
         v.apply( "block", p.block );
+        v.apply( "row", p.row );
+        v.apply( "column", p.column );
     }
 };
 
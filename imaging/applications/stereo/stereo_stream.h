@@ -48,7 +48,7 @@ public:
             const cv::Mat& left_x, const cv::Mat& left_y, const cv::Mat& right_x, const cv::Mat& right_y,
             const comma::csv::options& input_csv, const comma::csv::options& output_csv, bool input_rectified = false );
 
-    void read( const cv::StereoSGBM& sgbm );
+    void read( point_cloud& cloud );
 private:
     cv::Rect m_left;
     cv::Rect m_right;
@@ -82,10 +82,10 @@ inline stereo_stream< T >::stereo_stream ( const camera_parser& left, const came
 }
 
 template< typename T >
-inline void stereo_stream< T >::read( const cv::StereoSGBM& sgbm )
+inline void stereo_stream< T >::read( point_cloud& cloud )
 {
     std::pair< boost::posix_time::ptime, cv::Mat > image = m_input.read( std::cin );
-    m_stereo.process( image.second( m_left ), image.second( m_right ), sgbm, image.first );
+    m_stereo.process( image.second( m_left ), image.second( m_right ), cloud, image.first );
 }
 
 
@@ -0,0 +1,203 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <comma/base/exception.h>
+#include <snark/imaging/connected_components.h>
+
+namespace snark{ namespace imaging {
+
+void connected_components::component::add( const connected_components::run& r )
+{
+    double n = r.end - r.begin;
+    double y = r.row;
+    double a = r.begin - 1;
+    double b = r.end - 1;
+    double sum_x = ( r.begin + b ) * n / 2;
+    double sum_xx = ( b * ( b + 1 ) * ( 2 * b + 1 ) - a * ( a + 1 ) * ( 2 * a + 1 ) ) / 6;
+    m00 += n;
+    m10 += sum_x;
+    m01 += y * n;
+    m20 += sum_xx;
+    m11 += y * sum_x;
+    m02 += y * y * n;
+    cv::Rect rect( r.begin, r.row, r.end - r.begin, 1 );
+    bounding_box = bounding_box.area() == 0 ? rect : ( bounding_box | rect );
+}
+
+static unsigned int find_( std::vector< unsigned int >& parent, unsigned int i )
+{
+    while( parent[i] != i ) { parent[i] = parent[ parent[i] ]; i = parent[i]; } // path halving
+    return i;
+}
+
+static void unite_( std::vector< unsigned int >& parent, unsigned int i, unsigned int j )
+{
+    i = find_( parent, i );
+    j = find_( parent, j );
+    if( i < j ) { parent[j] = i; } else if( j < i ) { parent[i] = j; } // root is always the first run in scan order
+}
+
+/// unite overlapping runs of two consecutive rows, runs in each row sorted by begin
+static void unite_rows_( const std::vector< connected_components::run >& runs
+                       , std::vector< unsigned int >& parent
+                       , unsigned int previous_begin, unsigned int previous_end
+                       , unsigned int current_begin, unsigned int current_end
+                       , int diagonal )
+{
+    unsigned int j = previous_begin;
+    for( unsigned int i = current_begin; i < current_end; ++i )
+    {
+        const connected_components::run& r = runs[i];
+        while( j < previous_end && runs[j].end + diagonal <= r.begin ) { ++j; }
+        for( unsigned int k = j; k < previous_end && runs[k].begin < r.end + diagonal; ++k ) { unite_( parent, i, k ); }
+    }
+}
+
+struct band
+{
+    int begin;
+    int end;
+    std::vector< connected_components::run > runs;
+    std::vector< unsigned int > parent;
+};
+
+class label_bands
+{
+public:
+    label_bands( const cv::Mat& image, int diagonal, std::vector< band >& bands ) : m_image( image ), m_diagonal( diagonal ), m_bands( bands ) {}
+    
+    void operator()( const tbb::blocked_range< std::size_t >& range ) const
+    {
+        for( std::size_t i = range.begin(); i < range.end(); ++i ) { label( m_bands[i] ); }
+    }
+    
+private:
+    const cv::Mat& m_image;
+    int m_diagonal;
+    std::vector< band >& m_bands;
+    
+    void label( band& b ) const
+    {
+        unsigned int previous_begin = 0;
+        unsigned int previous_end = 0;
+        for( int row = b.begin; row < b.end; ++row )
+        {
+            const unsigned char* p = m_image.ptr< unsigned char >( row );
+            unsigned int current_begin = b.runs.size();
+            for( int col = 0; col < m_image.cols; )
+            {
+                if( p[col] == 0 ) { ++col; continue; }
+                int begin = col;
+                for( ++col; col < m_image.cols && p[col] != 0; ++col );
+                b.parent.push_back( b.runs.size() );
+                b.runs.push_back( connected_components::run( row, begin, col ) );
+            }
+            unsigned int current_end = b.runs.size();
+            unite_rows_( b.runs, b.parent, previous_begin, previous_end, current_begin, current_end, m_diagonal );
+            previous_begin = current_begin;
+            previous_end = current_end;
+        }
+    }
+};
+
+connected_components::connected_components( const cv::Mat& image, connected_components::connectivity_type connectivity, unsigned int bands )
+    : m_connectivity( connectivity )
+{
+    if( image.type() != CV_8UC1 ) { COMMA_THROW( comma::exception, "expected 8-bit single channel image, got image of type " << image.type() ); }
+    if( connectivity != four && connectivity != eight ) { COMMA_THROW( comma::exception, "expected connectivity 4 or 8, got " << connectivity ); }
+    if( bands == 0 ) { bands = 1; }
+    if( bands > unsigned( image.rows ) ) { bands = image.rows > 0 ? image.rows : 1; }
+    int diagonal = connectivity == eight ? 1 : 0;
+    std::vector< band > v( bands );
+    for( unsigned int i = 0; i < bands; ++i )
+    {
+        v[i].begin = ( image.rows * i ) / bands;
+        v[i].end = ( image.rows * ( i + 1 ) ) / bands;
+    }
+    label_bands label( image, diagonal, v );
+    if( bands == 1 ) { label( tbb::blocked_range< std::size_t >( 0, 1 ) ); }
+    else { tbb::parallel_for( tbb::blocked_range< std::size_t >( 0, bands, 1 ), label ); }
+    std::size_t size = 0;
+    for( unsigned int i = 0; i < bands; ++i ) { size += v[i].runs.size(); }
+    m_runs.reserve( size );
+    std::vector< unsigned int > parent;
+    parent.reserve( size );
+    unsigned int previous_begin = 0; // last row of the previous band
+    unsigned int previous_end = 0;
+    for( unsigned int i = 0; i < bands; ++i )
+    {
+        unsigned int offset = m_runs.size();
+        m_runs.insert( m_runs.end(), v[i].runs.begin(), v[i].runs.end() );
+        for( unsigned int k = 0; k < v[i].parent.size(); ++k ) { parent.push_back( v[i].parent[k] + offset ); }
+        unsigned int current_end = offset;
+        while( current_end < m_runs.size() && m_runs[ current_end ].row == v[i].begin ) { ++current_end; }
+        if( i > 0 && previous_end > previous_begin && m_runs[ previous_begin ].row + 1 == v[i].begin )
+        {
+            unite_rows_( m_runs, parent, previous_begin, previous_end, offset, current_end, diagonal );
+        }
+        if( m_runs.size() > offset ) // find runs of the last row of the band
+        {
+            previous_end = m_runs.size();
+            previous_begin = previous_end;
+            while( previous_begin > offset && m_runs[ previous_begin - 1 ].row == v[i].end - 1 ) { --previous_begin; }
+        }
+        else
+        {
+            previous_begin = previous_end = offset;
+        }
+        std::vector< run >().swap( v[i].runs );
+        std::vector< unsigned int >().swap( v[i].parent );
+    }
+    m_labels.resize( m_runs.size() );
+    for( unsigned int i = 0; i < m_runs.size(); ++i )
+    {
+        unsigned int root = find_( parent, i );
+        if( root == i ) { m_labels[i] = m_components.size(); m_components.push_back( component() ); } // root is always the first run of the component
+        else { m_labels[i] = m_labels[ root ]; }
+        component& c = m_components[ m_labels[i] ];
+        c.add( m_runs[i] );
+        c.runs.push_back( i );
+    }
+}
+
+cv::Mat connected_components::label_image( const cv::Size& size ) const
+{
+    cv::Mat image = cv::Mat::zeros( size, CV_32SC1 );
+    for( unsigned int i = 0; i < m_runs.size(); ++i )
+    {
+        int* p = image.ptr< int >( m_runs[i].row );
+        for( int col = m_runs[i].begin; col < m_runs[i].end; ++col ) { p[col] = m_labels[i] + 1; }
+    }
+    return image;
+}
+
+} } 
@@ -0,0 +1,104 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SNARK_IMAGING_CONNECTED_COMPONENTS_H
+#define SNARK_IMAGING_CONNECTED_COMPONENTS_H
+
+#include <vector>
+#include <opencv2/core/core.hpp>
+
+namespace snark{ namespace imaging {
+
+/// single-pass connected components labelling of a binary image
+/// runs of non-zero pixels in each row are merged with overlapping runs of the previous row
+/// using union-find, and image moments are accumulated per run, thus no per-component image processing
+/// rows can be split in horizontal bands labelled in parallel and merged on band borders
+class connected_components
+{
+public:
+    enum connectivity_type { four = 4, eight = 8 };
+    
+    /// run of non-zero pixels in a row
+    struct run
+    {
+        int row;
+        int begin;
+        int end; // exclusive
+        run() {}
+        run( int row, int begin, int end ) : row( row ), begin( begin ), end( end ) {}
+    };
+    
+    /// moments and bounding box of a component
+    struct component
+    {
+        double m00;
+        double m10;
+        double m01;
+        double m20;
+        double m11;
+        double m02;
+        cv::Rect bounding_box;
+        std::vector< unsigned int > runs; // indices of runs
+        
+        component() : m00( 0 ), m10( 0 ), m01( 0 ), m20( 0 ), m11( 0 ), m02( 0 ) {}
+        double area() const { return m00; }
+        cv::Point2d centroid() const { return cv::Point2d( m10 / m00, m01 / m00 ); }
+        /// normalized central moments
+        double nu20() const { return ( m20 - m10 * m10 / m00 ) / ( m00 * m00 ); }
+        double nu11() const { return ( m11 - m10 * m01 / m00 ) / ( m00 * m00 ); }
+        double nu02() const { return ( m02 - m01 * m01 / m00 ) / ( m00 * m00 ); }
+        void add( const run& r );
+    };
+    
+    /// @param image binary image ( all non-zero pixels are 1 ), 8-bit single channel
+    /// @param connectivity 4 or 8
+    /// @param bands number of horizontal bands to label in parallel
+    connected_components( const cv::Mat& image, connectivity_type connectivity = eight, unsigned int bands = 1 );
+    
+    const std::vector< component >& components() const { return m_components; }
+    
+    const std::vector< run >& runs() const { return m_runs; }
+    
+    /// @return component index for each run
+    const std::vector< unsigned int >& labels() const { return m_labels; }
+    
+    /// @return image of component labels, 0 for background, component index + 1 otherwise
+    cv::Mat label_image( const cv::Size& size ) const;
+    
+private:
+    connectivity_type m_connectivity;
+    std::vector< run > m_runs;
+    std::vector< unsigned int > m_labels;
+    std::vector< component > m_components;
+};
+
+} } 
+
+#endif // SNARK_IMAGING_CONNECTED_COMPONENTS_H
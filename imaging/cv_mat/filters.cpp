@@ -27,12 +27,15 @@
 // OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
 // IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <deque>
 #include <fstream>
 #include <queue>
 #include <sstream>
 #include <boost/array.hpp>
 #include <boost/bind.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/unordered_map.hpp>
 #include <boost/static_assert.hpp>
 #include <boost/type_traits.hpp>
@@ -49,6 +52,8 @@
 #include <opencv2/imgproc/imgproc_c.h>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/highgui/highgui_c.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 #include "filters.h"
 
 struct map_input_t
@@ -246,11 +251,108 @@ static filters::value_type flip_impl_( filters::value_type m, int how )
     return n;
 }
 
-static filters::value_type resize_impl_( filters::value_type m, unsigned int width, unsigned int height, double w, double h )
+/// image pyramids of the most recent frames, so that resize filters following
+/// the pyramid filter resample from the nearest pyramid level rather than from the full-size image
+class pyramid_cache_
+{
+    public:
+        pyramid_cache_( unsigned int number_of_levels, int interpolation, unsigned int size = 16 ) : number_of_levels_( number_of_levels ), interpolation_( interpolation ), size_( size ) {}
+
+        void build( const cv::Mat& image )
+        {
+            pyramid_ptr p;
+            {
+                boost::mutex::scoped_lock lock( mutex_ );
+                if( !pool_.empty() ) { p = pool_.back(); pool_.pop_back(); } // reuse level buffers of pyramids no longer in use
+            }
+            if( !p ) { p.reset( new pyramid ); }
+            p->image = image;
+            p->levels.resize( number_of_levels_ );
+            const cv::Mat* previous = &image;
+            for( unsigned int i = 0; i < number_of_levels_; ++i )
+            {
+                if( previous->rows < 2 || previous->cols < 2 ) { p->levels.resize( i ); break; }
+                p->levels[i].create( previous->rows / 2, previous->cols / 2, image.type() );
+                tbb::parallel_for( tbb::blocked_range< int >( 0, p->levels[i].rows, 32 ), halve_( *previous, p->levels[i], interpolation_ ) );
+                previous = &p->levels[i];
+            }
+            boost::mutex::scoped_lock lock( mutex_ );
+            pyramids_.push_back( p );
+            if( pyramids_.size() > size_ )
+            {
+                if( pyramids_.front().unique() ) { pyramids_.front()->image = cv::Mat(); pool_.push_back( pyramids_.front() ); }
+                pyramids_.pop_front();
+            }
+        }
+
+        /// resize image, using the smallest level of its pyramid not smaller than the requested size, if any
+        void resize( const cv::Mat& image, cv::Mat& resized, const cv::Size& size ) const
+        {
+            pyramid_ptr p = find_( image );
+            const cv::Mat* source = &image;
+            if( p )
+            {
+                for( unsigned int i = 0; i < p->levels.size() && p->levels[i].cols >= size.width && p->levels[i].rows >= size.height; source = &p->levels[i++] );
+            }
+            int interpolation = source->cols > size.width || source->rows > size.height ? cv::INTER_AREA : cv::INTER_LINEAR;
+            cv::resize( *source, resized, size, 0, 0, source == &image ? cv::INTER_LINEAR : interpolation );
+        }
+
+    private:
+        struct pyramid
+        {
+            cv::Mat image;
+            std::vector< cv::Mat > levels; // each level half the size of the previous one
+        };
+        typedef boost::shared_ptr< pyramid > pyramid_ptr;
+        
+        class halve_ // downsample rows [2*begin,2*end) into [begin,end); parallel strips give the same result as a single one
+        {
+            public:
+                halve_( const cv::Mat& from, cv::Mat& to, int interpolation ) : from_( from ), to_( to ), interpolation_( interpolation ) {}
+                void operator()( const tbb::blocked_range< int >& r ) const
+                {
+                    cv::Mat to = to_.rowRange( r.begin(), r.end() );
+                    cv::resize( from_.rowRange( r.begin() * 2, r.end() * 2 ), to, to.size(), 0, 0, interpolation_ );
+                }
+            private:
+                const cv::Mat& from_;
+                cv::Mat& to_;
+                int interpolation_;
+        };
+        
+        unsigned int number_of_levels_;
+        int interpolation_;
+        unsigned int size_;
+        mutable boost::mutex mutex_;
+        std::deque< pyramid_ptr > pyramids_;
+        std::vector< pyramid_ptr > pool_;
+        
+        pyramid_ptr find_( const cv::Mat& image ) const
+        {
+            boost::mutex::scoped_lock lock( mutex_ );
+            for( std::deque< pyramid_ptr >::const_reverse_iterator it = pyramids_.rbegin(); it != pyramids_.rend(); ++it )
+            {
+                // the cache holds the image, thus its data cannot be reallocated to another image while cached
+                if( ( *it )->image.data == image.data && ( *it )->image.size() == image.size() && ( *it )->image.type() == image.type() ) { return *it; }
+            }
+            return pyramid_ptr();
+        }
+};
+
+static filters::value_type pyramid_impl_( filters::value_type m, boost::shared_ptr< pyramid_cache_ > pyramid )
+{
+    pyramid->build( m.second );
+    return m;
+}
+
+static filters::value_type resize_impl_( filters::value_type m, unsigned int width, unsigned int height, double w, double h, boost::shared_ptr< pyramid_cache_ > pyramid )
 {
     filters::value_type n;
     n.first = m.first;
-    cv::resize( m.second, n.second, cv::Size( width ? width : m.second.cols * w, height ? height : m.second.rows * h ) );
+    cv::Size size( width ? width : m.second.cols * w, height ? height : m.second.rows * h );
+    if( pyramid ) { pyramid->resize( m.second, n.second, size ); }
+    else { cv::resize( m.second, n.second, size ); }
     return n;
 }
 
@@ -353,12 +455,13 @@ static filters::value_type view_impl_( filters::value_type m, std::string name,
     return m;
 }
 
-static filters::value_type thumb_impl_( filters::value_type m, std::string name, unsigned int cols = 100, unsigned int delay = 1 )
+static filters::value_type thumb_impl_( filters::value_type m, std::string name, unsigned int cols, unsigned int delay, boost::shared_ptr< pyramid_cache_ > pyramid )
 {
     cv::Mat n;
     unsigned int rows = m.second.rows * ( double( cols ) / m.second.cols );
     if( rows == 0 ) { rows = 1; }
-    cv::resize( m.second, n, cv::Size( cols, rows ) );
+    if( pyramid ) { pyramid->resize( m.second, n, cv::Size( cols, rows ) ); }
+    else { cv::resize( m.second, n, cv::Size( cols, rows ) ); }
     cv::imshow( &name[0], n );
     char c = cv::waitKey( delay );
     return c == 27 ? filters::value_type() : m; // HACK to notify application to exit
@@ -688,6 +791,7 @@ std::vector< filter > filters::make( const std::string& how, unsigned int defaul
     std::string name;
     bool modified = false;
     bool last = false;
+    boost::shared_ptr< pyramid_cache_ > pyramid; // pyramid of the current image, if any
     for( std::size_t i = 0; i < v.size(); name += ( i > 0 ? ";" : "" ) + v[i], ++i )
     {
         if( last )
@@ -864,7 +968,25 @@ std::vector< filter > filters::make( const std::string& how, unsigned int defaul
                 default:
                     COMMA_THROW( comma::exception, "expected resize=<width>,<height>, got: \"" << e[1] << "\"" );
             }
-            f.push_back( filter( boost::bind( &resize_impl_, _1, width, height, w, h ) ) );
+            f.push_back( filter( boost::bind( &resize_impl_, _1, width, height, w, h, pyramid ) ) );
+        }
+        else if( e[0] == "pyramid" )
+        {
+            unsigned int number_of_levels = 4;
+            int interpolation = cv::INTER_AREA;
+            if( e.size() > 1 )
+            {
+                std::vector< std::string > w = comma::split( e[1], ',' );
+                if( !w[0].empty() ) { number_of_levels = boost::lexical_cast< unsigned int >( w[0] ); }
+                if( w.size() > 1 )
+                {
+                    if( w[1] == "area" ) { interpolation = cv::INTER_AREA; }
+                    else if( w[1] == "linear" ) { interpolation = cv::INTER_LINEAR; }
+                    else { COMMA_THROW( comma::exception, "pyramid: expected interpolation 'area' or 'linear', got: \"" << w[1] << "\"" ); }
+                }
+            }
+            pyramid.reset( new pyramid_cache_( number_of_levels, interpolation ) );
+            f.push_back( filter( boost::bind( &pyramid_impl_, _1, pyramid ) ) );
         }
         else if( e[0] == "max" ) // todo: remove this filter; not thread-safe, should be run with --threads=1
         {
@@ -916,7 +1038,7 @@ std::vector< filter > filters::make( const std::string& how, unsigned int defaul
                 if( v.size() >= 1 ) { cols = boost::lexical_cast< unsigned int >( v[0] ); }
                 if( v.size() >= 2 ) { delay = boost::lexical_cast< unsigned int >( v[1] ); }
             }   
-            f.push_back( filter( boost::bind( &thumb_impl_, _1, name, cols, delay ), false ) );
+            f.push_back( filter( boost::bind( &thumb_impl_, _1, name, cols, delay, pyramid ), false ) );
         }
         else if( e[0] == "encode" )
         {
@@ -964,6 +1086,7 @@ std::vector< filter > filters::make( const std::string& how, unsigned int defaul
             COMMA_THROW( comma::exception, "expected filter, got \"" << v[i] << "\"" );
         }
         modified = ( v[i] != "view" && v[i] != "thumb" && v[i] != "split" );
+        if( e[0] != "pyramid" && e[0] != "resize" && e[0] != "thumb" && e[0] != "view" ) { pyramid.reset(); } // image may have been modified in place; view only shows the image, thus keeps the pyramid for the following filters
     }
     return f;
 }
@@ -1012,6 +1135,13 @@ static std::string usage_impl_()
     oss << "             example: \"map=map.bin&fields=,key,value&binary=2ui,d\"" << std::endl;
     oss << "        merge=<n>: split an image into n horizontal bands of equal height and merge them into an n-channel image (the number of rows must be a multiple of n)" << std::endl;
     oss << "        null: same as linux /dev/null (since windows does not have it)" << std::endl;
+    oss << "        pyramid[=<levels>[,<interpolation>]]: build image pyramid once per frame, each level half the size of the previous one" << std::endl;
+    oss << "            the following resize and thumb filters resample from the smallest pyramid level not smaller than the requested size" << std::endl;
+    oss << "            (area interpolation for downsampling, linear for upsampling), which may slightly differ from resizing the full-size image" << std::endl;
+    oss << "            <levels>: number of levels; default: 4" << std::endl;
+    oss << "            <interpolation>: interpolation used to build levels: area or linear; default: area" << std::endl;
+    oss << "            view shows the image as is, i.e. full-size, if not resized" << std::endl;
+    oss << "            example: cv-cat \"pyramid;thumb=320;resize=0.2\"" << std::endl;
     oss << "        resize=<width>,<height>: e.g:" << std::endl;
     oss << "            resize=512,1024 : resize to 512x1024 pixels" << std::endl;
     oss << "            resize=0.2,0.4 : resize to 20% of width and 40% of height" << std::endl;
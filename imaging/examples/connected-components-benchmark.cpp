@@ -0,0 +1,82 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cstdlib>
+#include <iostream>
+#include <boost/lexical_cast.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <snark/imaging/connected_components.h>
+#include <snark/imaging/region_properties.h>
+
+// compare contour-based region properties with single-pass connected components on synthetic images with varying blob density
+
+static cv::Mat make_image( int rows, int cols, unsigned int blobs, int radius )
+{
+    cv::Mat image = cv::Mat::zeros( rows, cols, CV_8UC1 );
+    for( unsigned int i = 0; i < blobs; ++i )
+    {
+        cv::Point centre( std::rand() % cols, std::rand() % rows );
+        cv::Size axes( 1 + std::rand() % radius, 1 + std::rand() % radius );
+        cv::ellipse( image, centre, axes, std::rand() % 180, 0, 360, cv::Scalar( 255 ), CV_FILLED );
+    }
+    return image;
+}
+
+static double elapsed( const boost::posix_time::ptime& start ) { return double( ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() ) / 1000; }
+
+int main( int ac, char** av )
+{
+    if( ac > 1 && ( std::string( av[1] ) == "-h" || std::string( av[1] ) == "--help" ) )
+    {
+        std::cerr << "usage: " << av[0] << " [<rows>] [<cols>] [<bands>]; default: 1024 1280 4" << std::endl;
+        std::cerr << "output: blobs,contours/ms,components/ms,components in bands/ms" << std::endl;
+        return 1;
+    }
+    int rows = ac > 1 ? boost::lexical_cast< int >( av[1] ) : 1024;
+    int cols = ac > 2 ? boost::lexical_cast< int >( av[2] ) : 1280;
+    unsigned int bands = ac > 3 ? boost::lexical_cast< unsigned int >( av[3] ) : 4;
+    std::srand( 0 );
+    for( unsigned int blobs = 10; blobs <= 100000; blobs *= 10 )
+    {
+        cv::Mat image = make_image( rows, cols, blobs, 8 );
+        boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+        snark::imaging::region_properties contours( image.clone() );
+        double contours_time = elapsed( start );
+        start = boost::posix_time::microsec_clock::universal_time();
+        snark::imaging::region_properties components( snark::imaging::connected_components( image ) );
+        double components_time = elapsed( start );
+        start = boost::posix_time::microsec_clock::universal_time();
+        snark::imaging::region_properties banded( snark::imaging::connected_components( image, snark::imaging::connected_components::eight, bands ) );
+        double banded_time = elapsed( start );
+        std::cout << components.blobs().size() << "," << contours_time << "," << components_time << "," << banded_time << std::endl;
+    }
+    return 0;
+}
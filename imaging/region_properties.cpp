@@ -65,6 +65,37 @@ void compute_area( const std::vector< cv::Point >& points, double& area, double&
     convexArea = boost::geometry::area( hull );
 }
 
+/// make blob from moments
+/// @param nu20, nu11, nu02 normalized central moments
+static region_properties::blob make_blob( double area, double nu20, double nu11, double nu02, const cv::Point& centroid, double polygonArea, double convexArea )
+{
+    // see wikipedia, image moments
+    double diff = nu20 - nu02;
+    double a = 0.5 * ( nu20 + nu02 );
+    double b = 0.5 * std::sqrt( 4 * nu11 * nu11 + diff * diff );
+    double minEigenValue = a - b;
+    double maxEigenValue = a + b;
+    double theta = 0.5 * std::atan2( 2 * nu11, diff );
+    double eccentricity = 1;
+    if( std::fabs( maxEigenValue ) > 1e-15 )
+    {
+        eccentricity = std::sqrt( 1 - minEigenValue / maxEigenValue );
+    }
+    region_properties::blob blob;
+    blob.majorAxis = 2 * std::sqrt( area * maxEigenValue );
+    blob.minorAxis = 2 * std::sqrt( area * minEigenValue );
+    blob.orientation = theta;
+    blob.centroid = centroid;
+    blob.area = area;
+    blob.eccentricity = eccentricity;
+    blob.solidity = 0;
+    if( std::fabs( convexArea ) > 1e-15 )
+    {
+        blob.solidity = polygonArea / convexArea;
+    }
+    return blob;
+}
+
 /// constructor
 /// @param image input image, is considered as a binary image ( all non-zero pixels are 1 )
 region_properties::region_properties ( const cv::Mat& image, double minArea ):
@@ -99,42 +130,42 @@ region_properties::region_properties ( const cv::Mat& image, double minArea ):
         double area = moments.m00; // cv::countNonZero( binary( rect ) )
         if( area > m_minArea )
         {
-            // see wikipedia, image moments
-            double diff = moments.nu20 - moments.nu02;
-            double a = 0.5 * ( moments.nu20 + moments.nu02 );
-            double b = 0.5 * std::sqrt( 4 * moments.nu11 * moments.nu11 + diff * diff );
-            double minEigenValue = a - b;
-            double maxEigenValue = a + b;
-    //         std::cerr << " min " << minEigenValue << " max " << maxEigenValue << std::endl;
-            double theta = 0.5 * std::atan2( 2 * moments.nu11, diff );
-            double eccentricity = 1;
-            if( std::fabs( maxEigenValue ) > 1e-15 )
-            {
-                eccentricity = std::sqrt( 1 - minEigenValue / maxEigenValue );
-            }
-
             double polygonArea;
             double convexArea;
             compute_area( contours[i], polygonArea, convexArea );
     //         std::cerr << " area " << area << " polygon " << polygonArea << " convex " << convexArea << std::endl;
-
-            blob blob;
-            blob.majorAxis = 2 * std::sqrt( moments.m00 * maxEigenValue );
-            blob.minorAxis = 2 * std::sqrt( moments.m00 * minEigenValue );
-            blob.orientation = theta;
-            blob.centroid = cv::Point( x + rect.x, y + rect.y );
-            blob.area = area;
-            blob.eccentricity = eccentricity;
-            blob.solidity = 0;
-            if( std::fabs( convexArea ) > 1e-15 )
-            {
-                blob.solidity = polygonArea / convexArea;
-            }
-            m_blobs.push_back( blob );
+            m_blobs.push_back( make_blob( area, moments.nu20, moments.nu11, moments.nu02, cv::Point( x + rect.x, y + rect.y ), polygonArea, convexArea ) );
         }
     }    
 }
 
+/// constructor
+/// @param components connected components
+/// @note solidity is computed as blob area over area of convex hull of its pixels
+region_properties::region_properties ( const connected_components& components, double minArea ):
+    m_minArea( minArea )
+{
+    std::vector< cv::Point > corners;
+    std::vector< cv::Point > hull;
+    for( unsigned int i = 0; i < components.components().size(); ++i )
+    {
+        const connected_components::component& c = components.components()[i];
+        if( c.area() <= m_minArea ) { continue; }
+        corners.clear();
+        for( unsigned int k = 0; k < c.runs.size(); ++k )
+        {
+            const connected_components::run& r = components.runs()[ c.runs[k] ];
+            corners.push_back( cv::Point( r.begin, r.row ) );
+            corners.push_back( cv::Point( r.end, r.row ) );
+            corners.push_back( cv::Point( r.begin, r.row + 1 ) );
+            corners.push_back( cv::Point( r.end, r.row + 1 ) );
+        }
+        cv::convexHull( corners, hull );
+        cv::Point2d centroid = c.centroid();
+        m_blobs.push_back( make_blob( c.area(), c.nu20(), c.nu11(), c.nu02(), cv::Point( centroid.x, centroid.y ), c.area(), cv::contourArea( hull ) ) );
+    }
+}
+
 /// draw debug information on the image
 void region_properties::show( cv::Mat& image, bool text )
 {
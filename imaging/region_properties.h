@@ -32,6 +32,7 @@
 #define SNARK_IMAGING_REGION_PROPERTIES_H
 
 #include <opencv2/core/core.hpp>
+#include <snark/imaging/connected_components.h>
 
 namespace snark{ namespace imaging {
 
@@ -52,6 +53,10 @@ public:
     };
     
     region_properties( const cv::Mat& image, double minArea = 1 );
+    
+    /// blobs from connected components labelled in a single pass, much faster for large number of blobs
+    /// @note unlike contour-based constructor, holes do not count towards blob area
+    region_properties( const connected_components& components, double minArea = 1 );
 
     void show( cv::Mat& image, bool text = true );
     const std::vector< blob >& blobs() const { return m_blobs; }
@@ -29,14 +29,23 @@
 
 
 #include <snark/imaging/stereo/point_cloud.h>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 
 namespace snark { namespace imaging {
 
 static const unsigned int numberOfDisparities = 80; // TODO config ?
 
 /// default constructor
-point_cloud::point_cloud ( unsigned int channels )
+point_cloud::point_cloud ( unsigned int channels ):
+    m_bands( 1 ),
+    m_overlap( 0 ),
+    m_cols( 0 ),
+    m_min_disparity( 0 ),
+    m_stride( 1 )
 {
     m_sgbm.SADWindowSize = 5; 
     m_sgbm.minDisparity = 0;
@@ -52,8 +61,13 @@ point_cloud::point_cloud ( unsigned int channels )
 }
 
 /// constructor from pre-configured sgbm struct
-point_cloud::point_cloud ( const cv::StereoSGBM& sgbm ):
-    m_sgbm( sgbm )
+point_cloud::point_cloud ( const cv::StereoSGBM& sgbm, unsigned int bands, unsigned int overlap ):
+    m_sgbm( sgbm ),
+    m_bands( bands == 0 ? 1 : bands ),
+    m_overlap( overlap ),
+    m_cols( 0 ),
+    m_min_disparity( 0 ),
+    m_stride( 1 )
 {
 
 }
@@ -70,6 +84,52 @@ cv::Mat point_cloud::get ( const cv::Mat& Q, const cv::Mat& left, const cv::Mat&
     return points;
 }
 
+/// @return new matcher with the same parameters as sgbm, but its own work buffer:
+/// a copy would share the buffer of sgbm, since cv::Mat copies are shallow
+static cv::StereoSGBM make_sgbm_( const cv::StereoSGBM& sgbm )
+{
+    return cv::StereoSGBM( sgbm.minDisparity, sgbm.numberOfDisparities, sgbm.SADWindowSize, sgbm.P1, sgbm.P2, sgbm.disp12MaxDiff, sgbm.preFilterCap, sgbm.uniquenessRatio, sgbm.speckleWindowSize, sgbm.speckleRange, sgbm.fullDP );
+}
+
+/// compute disparity for a horizontal band, dropping rows that overlap with neighbour bands
+class band_disparity
+{
+public:
+    band_disparity( const cv::StereoSGBM& sgbm, unsigned int bands, unsigned int overlap, const cv::Mat& left, const cv::Mat& right, cv::Mat& disparity ):
+        m_sgbm( sgbm ),
+        m_bands( bands ),
+        m_overlap( overlap ),
+        m_left( left ),
+        m_right( right ),
+        m_disparity( disparity )
+    {
+    }
+
+    void operator()( const tbb::blocked_range< unsigned int >& range ) const
+    {
+        cv::StereoSGBM sgbm = make_sgbm_( m_sgbm ); // sgbm keeps a work buffer, thus one per task
+        for( unsigned int band = range.begin(); band < range.end(); ++band )
+        {
+            int begin = ( m_left.rows * band ) / m_bands;
+            int end = ( m_left.rows * ( band + 1 ) ) / m_bands;
+            int from = std::max( 0, begin - int( m_overlap ) );
+            int to = std::min( m_left.rows, end + int( m_overlap ) );
+            cv::Mat disparity;
+            sgbm( m_left.rowRange( from, to ), m_right.rowRange( from, to ), disparity );
+            cv::Mat destination = m_disparity.rowRange( begin, end );
+            disparity.rowRange( begin - from, end - from ).copyTo( destination );
+        }
+    }
+
+private:
+    const cv::StereoSGBM& m_sgbm;
+    unsigned int m_bands;
+    unsigned int m_overlap;
+    const cv::Mat& m_left;
+    const cv::Mat& m_right;
+    cv::Mat& m_disparity;
+};
+
 /// compute disparity only
 /// @param left rectified left image
 /// @param right rectified right image
@@ -78,11 +138,47 @@ cv::Mat point_cloud::get_disparity ( const cv::Mat& left, const cv::Mat& right )
     cv::Mat disparity;
     m_sgbm.P1 = 8*left.channels()*m_sgbm.SADWindowSize*m_sgbm.SADWindowSize;
     m_sgbm.P2 = 32*left.channels()*m_sgbm.SADWindowSize*m_sgbm.SADWindowSize;
-    m_sgbm( left, right, disparity );
+    unsigned int bands = std::min( m_bands, unsigned( std::max( left.rows, 1 ) ) ); // no empty bands
+    if( bands < 2 )
+    {
+        m_sgbm( left, right, disparity );
+        return disparity;
+    }
+    disparity.create( left.rows, left.cols, CV_16S );
+    tbb::parallel_for( tbb::blocked_range< unsigned int >( 0, bands, 1 ), band_disparity( m_sgbm, bands, m_overlap, left, right, disparity ) );
     return disparity;
 }
 
+/// compute disparity and precompute rays for reproject()
+/// @param Q Q matrix computed with stereo recfity
+/// @param left rectified left image
+/// @param right rectified right image
+const cv::Mat& point_cloud::get_disparity ( const cv::Mat& Q, const cv::Mat& left, const cv::Mat& right )
+{
+    m_disparity = get_disparity( left, right );
+    prepare_rays( Q, left.rows, left.cols );
+    return m_disparity;
+}
 
+/// precompute Q * ( col, row, 0, 1 ) for each pixel, so that a point is ( ray + Q * ( 0, 0, disparity, 0 ) ) normalized
+void point_cloud::prepare_rays ( const cv::Mat& Q, int rows, int cols )
+{
+    cv::Mat q;
+    Q.convertTo( q, CV_64F );
+    if( int( m_rays.size() ) == rows * cols && m_cols == cols && !m_Q.empty() && std::memcmp( m_Q.data, q.data, 16 * sizeof( double ) ) == 0 ) { return; }
+    m_Q = q;
+    m_cols = cols;
+    m_rays.resize( rows * cols );
+    for( unsigned int i = 0; i < 4; ++i ) { m_ray_step[i] = q.at< double >( i, 2 ); }
+    for( int row = 0; row < rows; ++row )
+    {
+        for( int col = 0; col < cols; ++col )
+        {
+            cv::Vec4f& ray = m_rays[ row * cols + col ];
+            for( unsigned int i = 0; i < 4; ++i ) { ray[i] = q.at< double >( i, 0 ) * col + q.at< double >( i, 1 ) * row + q.at< double >( i, 3 ); }
+        }
+    }
+    m_min_disparity = ( m_sgbm.minDisparity - 1 ) * 16 + 1; // sgbm marks invalid disparity as ( minDisparity - 1 ) * 16
+}
 
 } }
-
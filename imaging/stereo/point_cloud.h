@@ -31,6 +31,8 @@
 #ifndef SNARK_IMAGING_STEREO_POINT_CLOUD_H
 #define SNARK_IMAGING_STEREO_POINT_CLOUD_H
 
+#include <cmath>
+#include <vector>
 #include <opencv2/calib3d/calib3d.hpp>
 
 namespace snark { namespace imaging {
@@ -40,19 +42,62 @@ class point_cloud
 {
 public:
     point_cloud( unsigned int channels = 3 );
-    point_cloud( const cv::StereoSGBM& sgbm );
+    
+    /// @param bands if greater than 1, compute disparity in horizontal bands in parallel, each with its own matcher; at most one band per image row
+    /// @param overlap number of rows by which bands overlap, to reduce artifacts on band borders
+    point_cloud( const cv::StereoSGBM& sgbm, unsigned int bands = 1, unsigned int overlap = 0 );
 
     cv::Mat get( const cv::Mat& Q, const cv::Mat& left, const cv::Mat& right );
     cv::Mat get_disparity( const cv::Mat& left, const cv::Mat& right );
     /// get disparity after computing the point cloud
     const cv::Mat& disparity() const { return m_disparity; }
     
+    /// compute disparity and precompute per-pixel rays for Q, if Q or image size changed; then use reproject()
+    const cv::Mat& get_disparity( const cv::Mat& Q, const cv::Mat& left, const cv::Mat& right );
+    
+    /// reproject pixel of disparity computed by get_disparity( Q, left, right ), same as cv::reprojectImageTo3D()
+    /// @return false, if disparity is invalid or point is too far
+    bool reproject( int row, int col, short disparity, cv::Point3f& point ) const;
+    
+    /// set pixels to reproject: every stride-th row and column in the region of interest; empty region means whole image
+    void set_sampling( const cv::Rect& roi, unsigned int stride = 1 ) { m_roi = roi; m_stride = stride == 0 ? 1 : stride; }
+    
+    /// @return region of interest clipped to image of given size
+    cv::Rect roi( int rows, int cols ) const { return m_roi.area() == 0 ? cv::Rect( 0, 0, cols, rows ) : m_roi & cv::Rect( 0, 0, cols, rows ); }
+    
+    unsigned int stride() const { return m_stride; }
+    
 private:
     cv::Mat m_Q;
     cv::StereoSGBM m_sgbm;
     cv::Mat m_disparity;
+    unsigned int m_bands;
+    unsigned int m_overlap;
+    std::vector< cv::Vec4f > m_rays;
+    cv::Vec4f m_ray_step;
+    int m_cols;
+    short m_min_disparity;
+    cv::Rect m_roi;
+    unsigned int m_stride;
+    
+    void prepare_rays( const cv::Mat& Q, int rows, int cols );
 };
 
+inline bool point_cloud::reproject( int row, int col, short disparity, cv::Point3f& point ) const
+{
+    if( disparity < m_min_disparity ) { return false; }
+    const cv::Vec4f& ray = m_rays[ row * m_cols + col ];
+    float w = ray[3] + m_ray_step[3] * disparity;
+    if( w == 0 ) { return false; }
+    w = 1.0 / w;
+    float z = ( ray[2] + m_ray_step[2] * disparity ) * w;
+    if( !( std::fabs( z ) < 10000 ) ) { return false; } // CV uses 10,000 as invalid
+    point.x = ( ray[0] + m_ray_step[0] * disparity ) * w * 16; // disparity has a factor 16
+    point.y = ( ray[1] + m_ray_step[1] * disparity ) * w * 16;
+    point.z = z * 16;
+    return true;
+}
+
 } }
 
 #endif // SNARK_IMAGING_STEREO_POINT_CLOUD_H
@@ -0,0 +1,182 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdlib>
+#include <snark/imaging/connected_components.h>
+#include <snark/imaging/region_properties.h>
+
+namespace snark { namespace imaging {
+
+static cv::Mat random_image( int rows, int cols, int density )
+{
+    cv::Mat image( rows, cols, CV_8UC1 );
+    for( int i = 0; i < rows; ++i )
+    {
+        for( int j = 0; j < cols; ++j ) { image.at< unsigned char >( i, j ) = std::rand() % 100 < density ? 255 : 0; }
+    }
+    return image;
+}
+
+/// brute-force flood fill, labels components in scan order starting from 1
+static unsigned int flood_fill( const cv::Mat& image, unsigned int connectivity, cv::Mat& labels )
+{
+    labels = cv::Mat::zeros( image.size(), CV_32SC1 );
+    unsigned int count = 0;
+    for( int i = 0; i < image.rows; ++i )
+    {
+        for( int j = 0; j < image.cols; ++j )
+        {
+            if( image.at< unsigned char >( i, j ) == 0 || labels.at< int >( i, j ) != 0 ) { continue; }
+            ++count;
+            std::vector< cv::Point > stack( 1, cv::Point( j, i ) );
+            labels.at< int >( i, j ) = count;
+            while( !stack.empty() )
+            {
+                cv::Point p = stack.back();
+                stack.pop_back();
+                for( int dy = -1; dy <= 1; ++dy )
+                {
+                    for( int dx = -1; dx <= 1; ++dx )
+                    {
+                        if( ( dx == 0 && dy == 0 ) || ( connectivity == 4 && dx != 0 && dy != 0 ) ) { continue; }
+                        cv::Point q( p.x + dx, p.y + dy );
+                        if( q.x < 0 || q.y < 0 || q.x >= image.cols || q.y >= image.rows ) { continue; }
+                        if( image.at< unsigned char >( q.y, q.x ) == 0 || labels.at< int >( q.y, q.x ) != 0 ) { continue; }
+                        labels.at< int >( q.y, q.x ) = count;
+                        stack.push_back( q );
+                    }
+                }
+            }
+        }
+    }
+    return count;
+}
+
+static void expect_same_as_flood_fill( const cv::Mat& image, connected_components::connectivity_type connectivity, unsigned int bands )
+{
+    cv::Mat expected;
+    unsigned int count = flood_fill( image, connectivity, expected );
+    connected_components components( image, connectivity, bands );
+    ASSERT_EQ( count, components.components().size() );
+    cv::Mat labels = components.label_image( image.size() );
+    for( int i = 0; i < image.rows; ++i )
+    {
+        for( int j = 0; j < image.cols; ++j ) { ASSERT_EQ( expected.at< int >( i, j ), labels.at< int >( i, j ) ); }
+    }
+    for( unsigned int k = 0; k < count; ++k )
+    {
+        double m00 = 0, m10 = 0, m01 = 0, m20 = 0, m11 = 0, m02 = 0;
+        cv::Rect box;
+        for( int i = 0; i < image.rows; ++i )
+        {
+            for( int j = 0; j < image.cols; ++j )
+            {
+                if( expected.at< int >( i, j ) != int( k + 1 ) ) { continue; }
+                m00 += 1; m10 += j; m01 += i; m20 += j * j; m11 += i * j; m02 += i * i;
+                box = box.area() == 0 ? cv::Rect( j, i, 1, 1 ) : ( box | cv::Rect( j, i, 1, 1 ) );
+            }
+        }
+        const connected_components::component& c = components.components()[k];
+        EXPECT_DOUBLE_EQ( m00, c.m00 );
+        EXPECT_DOUBLE_EQ( m10, c.m10 );
+        EXPECT_DOUBLE_EQ( m01, c.m01 );
+        EXPECT_DOUBLE_EQ( m20, c.m20 );
+        EXPECT_DOUBLE_EQ( m11, c.m11 );
+        EXPECT_DOUBLE_EQ( m02, c.m02 );
+        EXPECT_EQ( box, c.bounding_box );
+    }
+}
+
+TEST( connected_components, against_flood_fill )
+{
+    std::srand( 1 );
+    for( unsigned int i = 0; i < 50; ++i )
+    {
+        cv::Mat image = random_image( 1 + std::rand() % 60, 1 + std::rand() % 60, std::rand() % 100 );
+        expect_same_as_flood_fill( image, connected_components::four, 1 );
+        expect_same_as_flood_fill( image, connected_components::eight, 1 );
+    }
+}
+
+TEST( connected_components, bands )
+{
+    std::srand( 2 );
+    for( unsigned int i = 0; i < 50; ++i )
+    {
+        cv::Mat image = random_image( 1 + std::rand() % 60, 1 + std::rand() % 60, std::rand() % 100 );
+        expect_same_as_flood_fill( image, connected_components::four, 1 + std::rand() % 8 );
+        expect_same_as_flood_fill( image, connected_components::eight, 1 + std::rand() % 8 );
+    }
+}
+
+TEST( connected_components, diagonal )
+{
+    cv::Mat image = cv::Mat::zeros( 4, 4, CV_8UC1 );
+    image.at< unsigned char >( 0, 0 ) = 1;
+    image.at< unsigned char >( 1, 1 ) = 1;
+    image.at< unsigned char >( 2, 2 ) = 1;
+    image.at< unsigned char >( 3, 3 ) = 1;
+    EXPECT_EQ( 4u, connected_components( image, connected_components::four ).components().size() );
+    EXPECT_EQ( 1u, connected_components( image, connected_components::eight ).components().size() );
+    EXPECT_EQ( 1u, connected_components( image, connected_components::eight, 4 ).components().size() );
+}
+
+TEST( connected_components, region_properties )
+{
+    cv::Mat image = cv::Mat::zeros( 100, 100, CV_8UC1 );
+    image( cv::Rect( 10, 20, 30, 10 ) ) = cv::Scalar( 255 );
+    image( cv::Rect( 60, 60, 10, 20 ) ) = cv::Scalar( 255 );
+    region_properties contours( image.clone() ); // contour-based region_properties modifies image
+    region_properties runs( connected_components( image ) );
+    ASSERT_EQ( 2u, runs.blobs().size() );
+    ASSERT_EQ( contours.blobs().size(), runs.blobs().size() );
+    const region_properties::blob& b = runs.blobs()[0];
+    EXPECT_DOUBLE_EQ( 300, b.area );
+    EXPECT_EQ( cv::Point( 24, 24 ), b.centroid );
+    EXPECT_NEAR( 0, b.orientation, 1e-9 );
+    EXPECT_NEAR( 1, b.solidity, 1e-9 );
+    for( unsigned int i = 0; i < runs.blobs().size(); ++i ) // contour-based blobs come in arbitrary order
+    {
+        bool found = false;
+        for( unsigned int k = 0; k < contours.blobs().size() && !found; ++k )
+        {
+            if( contours.blobs()[k].centroid != runs.blobs()[i].centroid ) { continue; }
+            found = true;
+            EXPECT_DOUBLE_EQ( contours.blobs()[k].area, runs.blobs()[i].area );
+            EXPECT_NEAR( contours.blobs()[k].majorAxis, runs.blobs()[i].majorAxis, 1e-6 );
+            EXPECT_NEAR( contours.blobs()[k].minorAxis, runs.blobs()[i].minorAxis, 1e-6 );
+            EXPECT_NEAR( contours.blobs()[k].eccentricity, runs.blobs()[i].eccentricity, 1e-6 );
+        }
+        EXPECT_TRUE( found );
+    }
+}
+
+} } // namespace snark { namespace imaging {
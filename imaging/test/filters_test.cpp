@@ -0,0 +1,110 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <snark/imaging/cv_mat/filters.h>
+
+namespace snark { namespace cv_mat {
+
+static cv::Mat smooth_image( int rows, int cols, double phase )
+{
+    cv::Mat image( rows, cols, CV_8UC3 );
+    for( int i = 0; i < rows; ++i )
+    {
+        for( int j = 0; j < cols; ++j )
+        {
+            double v = 128 + 100 * std::sin( j / 40.0 + phase ) * std::cos( i / 30.0 - phase );
+            image.at< cv::Vec3b >( i, j ) = cv::Vec3b( v, 255 - v, ( i + j ) / 4 % 256 );
+        }
+    }
+    return image;
+}
+
+static filters::value_type apply( const std::string& how, const cv::Mat& image )
+{
+    std::vector< filter > f = filters::make( how );
+    return filters::apply( f, filters::value_type( boost::posix_time::not_a_date_time, image ) );
+}
+
+static double max_difference( const cv::Mat& a, const cv::Mat& b ) { return cv::norm( a, b, cv::NORM_INF ); }
+
+static double mean_difference( const cv::Mat& a, const cv::Mat& b ) { return cv::norm( a, b, cv::NORM_L1 ) / ( a.total() * a.channels() ); }
+
+TEST( filters, pyramid_resize_same_as_full_size_resize )
+{
+    cv::Mat image = smooth_image( 384, 512, 0 );
+    cv::Mat expected;
+    cv::resize( image, expected, cv::Size( 128, 96 ), 0, 0, cv::INTER_AREA );
+    filters::value_type m = apply( "pyramid;resize=0.25", image );
+    ASSERT_EQ( expected.size(), m.second.size() );
+    ASSERT_EQ( expected.type(), m.second.type() );
+    EXPECT_GE( 2, max_difference( expected, m.second ) ); // level of exactly requested size: only rounding of intermediate levels differs
+    cv::resize( image, expected, cv::Size( 100, 75 ), 0, 0, cv::INTER_AREA );
+    m = apply( "pyramid;resize=100,75", image );
+    ASSERT_EQ( expected.size(), m.second.size() );
+    EXPECT_GE( 8, max_difference( expected, m.second ) );
+    EXPECT_GT( 1, mean_difference( expected, m.second ) );
+    cv::resize( image, expected, cv::Size( 20, 15 ), 0, 0, cv::INTER_AREA );
+    m = apply( "pyramid=2;resize=20,15", image ); // smaller than the smallest level
+    ASSERT_EQ( expected.size(), m.second.size() );
+    EXPECT_GE( 8, max_difference( expected, m.second ) );
+    cv::resize( image, expected, cv::Size( 1024, 768 ), 0, 0, cv::INTER_LINEAR );
+    m = apply( "pyramid;resize=2.0", image ); // upsampling uses the full-size image
+    EXPECT_EQ( 0, max_difference( expected, m.second ) );
+}
+
+TEST( filters, pyramid_new_frame )
+{
+    std::vector< filter > f = filters::make( "pyramid;resize=0.25" );
+    cv::Mat image = smooth_image( 384, 512, 0 );
+    for( unsigned int k = 0; k < 20; ++k ) // more frames than cached pyramids
+    {
+        smooth_image( 384, 512, k * 0.7 ).copyTo( image ); // same buffer, new content
+        const unsigned char* data = image.data;
+        filters::value_type m = filters::apply( f, filters::value_type( boost::posix_time::not_a_date_time, image ) );
+        ASSERT_TRUE( data == image.data );
+        cv::Mat expected;
+        cv::resize( image, expected, cv::Size( 128, 96 ), 0, 0, cv::INTER_AREA );
+        EXPECT_GE( 2, max_difference( expected, m.second ) );
+    }
+}
+
+TEST( filters, pyramid_dropped_after_modifying_filter )
+{
+    cv::Mat image = smooth_image( 384, 512, 0 );
+    cv::Mat inverted = cv::Scalar( 255, 255, 255 ) - image;
+    cv::Mat expected;
+    cv::resize( inverted, expected, cv::Size( 128, 96 ) );
+    filters::value_type m = apply( "pyramid;invert;resize=0.25", image.clone() ); // invert modifies the image in place, thus the pyramid of the original is stale
+    EXPECT_EQ( 0, max_difference( expected, m.second ) );
+}
+
+} } // namespace snark { namespace cv_mat {
@@ -0,0 +1,172 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <snark/imaging/stereo/point_cloud.h>
+
+namespace snark { namespace imaging {
+
+static const int shift = 8;
+
+static void make_stereo_pair( cv::Mat& left, cv::Mat& right, int rows = 240, int cols = 320 )
+{
+    cv::Mat noise( rows, cols, CV_8UC3 );
+    cv::randu( noise, cv::Scalar::all( 0 ), cv::Scalar::all( 255 ) );
+    cv::GaussianBlur( noise, left, cv::Size( 3, 3 ), 0 );
+    right = cv::Mat::zeros( rows, cols, CV_8UC3 );
+    cv::Mat destination = right.colRange( 0, cols - shift );
+    left.colRange( shift, cols ).copyTo( destination );
+}
+
+static cv::Mat make_q( double focal_length, double cx, double cy, double tx )
+{
+    cv::Mat q = cv::Mat::zeros( 4, 4, CV_64F );
+    q.at< double >( 0, 0 ) = 1;
+    q.at< double >( 0, 3 ) = -cx;
+    q.at< double >( 1, 1 ) = 1;
+    q.at< double >( 1, 3 ) = -cy;
+    q.at< double >( 2, 3 ) = focal_length;
+    q.at< double >( 3, 2 ) = -1 / tx;
+    return q;
+}
+
+static cv::StereoSGBM make_sgbm()
+{
+    cv::StereoSGBM sgbm;
+    sgbm.SADWindowSize = 5;
+    sgbm.minDisparity = 0;
+    sgbm.numberOfDisparities = 32;
+    sgbm.uniquenessRatio = 10;
+    sgbm.speckleWindowSize = 100;
+    sgbm.speckleRange = 16;
+    sgbm.disp12MaxDiff = 1;
+    sgbm.preFilterCap = 63;
+    sgbm.fullDP = false;
+    return sgbm;
+}
+
+TEST( point_cloud, tiled_disparity_matches_single_band )
+{
+    cv::Mat left, right;
+    make_stereo_pair( left, right );
+    point_cloud single( make_sgbm() );
+    point_cloud tiled( make_sgbm(), 4, 32 );
+    cv::Mat expected = single.get_disparity( left, right );
+    cv::Mat disparity = tiled.get_disparity( left, right );
+    ASSERT_EQ( expected.rows, disparity.rows );
+    ASSERT_EQ( expected.cols, disparity.cols );
+    ASSERT_EQ( expected.type(), disparity.type() );
+    unsigned int count = 0;
+    unsigned int matched = 0;
+    for( int i = 0; i < expected.rows; ++i )
+    {
+        for( int j = 32 + shift; j < expected.cols - shift; ++j )
+        {
+            ++count;
+            if( std::abs( expected.at< short >( i, j ) - disparity.at< short >( i, j ) ) <= 16 ) { ++matched; }
+        }
+    }
+    EXPECT_GT( double( matched ) / count, 0.99 );
+}
+
+TEST( point_cloud, tiled_disparity_finds_shift )
+{
+    cv::Mat left, right;
+    make_stereo_pair( left, right );
+    point_cloud tiled( make_sgbm(), 3, 16 );
+    cv::Mat disparity = tiled.get_disparity( left, right );
+    unsigned int count = 0;
+    unsigned int matched = 0;
+    for( int i = 0; i < disparity.rows; ++i )
+    {
+        for( int j = 32 + shift; j < disparity.cols - shift; ++j )
+        {
+            ++count;
+            if( std::abs( disparity.at< short >( i, j ) - shift * 16 ) <= 16 ) { ++matched; }
+        }
+    }
+    EXPECT_GT( double( matched ) / count, 0.95 );
+}
+
+TEST( point_cloud, reproject_matches_opencv )
+{
+    cv::Mat left, right;
+    make_stereo_pair( left, right );
+    cv::Mat q = make_q( 500, 160, 120, -0.1 );
+    point_cloud cloud( make_sgbm() );
+    cv::Mat points = cloud.get( q, left, right );
+    const cv::Mat& disparity = cloud.get_disparity( q, left, right );
+    unsigned int valid = 0;
+    for( int i = 0; i < disparity.rows; ++i )
+    {
+        for( int j = 0; j < disparity.cols; ++j )
+        {
+            cv::Point3f expected = points.at< cv::Point3f >( i, j );
+            cv::Point3f point;
+            bool is_valid = cloud.reproject( i, j, disparity.at< short >( i, j ), point );
+            EXPECT_EQ( std::fabs( expected.z ) < 10000, is_valid );
+            if( !is_valid ) { continue; }
+            ++valid;
+            expected *= 16.0;
+            EXPECT_NEAR( expected.x, point.x, 1e-3 );
+            EXPECT_NEAR( expected.y, point.y, 1e-3 );
+            EXPECT_NEAR( expected.z, point.z, 1e-3 );
+        }
+    }
+    EXPECT_GT( valid, 0u );
+}
+
+TEST( point_cloud, reproject_skips_invalid_disparity )
+{
+    cv::Mat left, right;
+    make_stereo_pair( left, right );
+    cv::Mat q = make_q( 500, 160, 120, -0.1 );
+    point_cloud cloud( make_sgbm() );
+    cloud.get_disparity( q, left, right );
+    cv::Point3f point;
+    EXPECT_FALSE( cloud.reproject( 10, 10, -16, point ) );
+    EXPECT_TRUE( cloud.reproject( 10, 10, shift * 16, point ) );
+    EXPECT_NEAR( 500 * 0.1 / shift, point.z, 1e-3 );
+}
+
+TEST( point_cloud, sampling_roi )
+{
+    point_cloud cloud( make_sgbm() );
+    EXPECT_EQ( cv::Rect( 0, 0, 320, 240 ), cloud.roi( 240, 320 ) );
+    EXPECT_EQ( 1u, cloud.stride() );
+    cloud.set_sampling( cv::Rect( 100, 200, 300, 100 ), 4 );
+    EXPECT_EQ( cv::Rect( 100, 200, 220, 40 ), cloud.roi( 240, 320 ) );
+    EXPECT_EQ( 4u, cloud.stride() );
+    cloud.set_sampling( cv::Rect(), 0 );
+    EXPECT_EQ( cv::Rect( 0, 0, 320, 240 ), cloud.roi( 240, 320 ) );
+    EXPECT_EQ( 1u, cloud.stride() );
+}
+
+} } // namespace snark { namespace imaging {
@@ -1,7 +1,10 @@
+#include <fstream>
 #include <iostream>
 #include <boost/optional.hpp>
 #include <comma/application/command_line_options.h>
 #include <comma/csv/stream.h>
+#include <comma/name_value/parser.h>
+#include <snark/math/kd_tree.h>
 #include <snark/visiting/eigen.h>
 #include <math.h>
 #include <comma/math/compare.h>
@@ -21,8 +24,10 @@ static void usage( bool more = false )
     std::cerr << "    cat points.csv | points-calc cumulative-distance > results.csv" << std::endl;
     std::cerr << "    cat points.csv | points-calc thin --resolution <resolution> > results.csv" << std::endl;
     std::cerr << "    cat points.csv | points-calc discretise --step <step> > results.csv" << std::endl;
+    std::cerr << "    cat points.csv | points-calc nearest --reference=reference.csv > results.csv" << std::endl;
+    std::cerr << "    cat points.csv | points-calc radius-count --radius=0.5 > results.csv" << std::endl;
     std::cerr << std::endl;
-    std::cerr << "operations: distance, cumulative-distance, thin, discretise, nearest" << std::endl;
+    std::cerr << "operations: distance, cumulative-distance, thin, discretise, nearest, k-nearest, radius-count" << std::endl;
     std::cerr << std::endl;
     std::cerr << "    distance: distance between subsequent points or, if input is pairs, between the points of the same record" << std::endl;
     std::cerr << std::endl;
@@ -33,12 +38,34 @@ static void usage( bool more = false )
     std::cerr << std::endl;
     std::cerr << "        input fields: " << comma::join( comma::csv::names< Eigen::Vector3d >( true ), ',' ) << std::endl;
     std::cerr << std::endl;
-    std::cerr << "    nearest: find point nearest to the given point" << std::endl;
+    std::cerr << "    nearest: if --point given, find point nearest to the given point" << std::endl;
+    std::cerr << "             if --reference given, for each point append nearest reference point record and distance to it" << std::endl;
     std::cerr << std::endl;
     std::cerr << "        input fields: " << comma::join( comma::csv::names< Eigen::Vector3d >( true ), ',' ) << std::endl;
     std::cerr << std::endl;
     std::cerr << "        options:" << std::endl;
     std::cerr << "            --point,--to=<x>,<y>,<z>" << std::endl;
+    std::cerr << "            --reference=<filename>[;<csv options>]: reference points; default fields: x,y,z" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "    k-nearest: for each point output --k records: point record, reference point record, distance; nearest first" << std::endl;
+    std::cerr << "               if there are less than k reference points, output them all" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "        input fields: " << comma::join( comma::csv::names< Eigen::Vector3d >( true ), ',' ) << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "        options:" << std::endl;
+    std::cerr << "            --k=<n>: number of nearest points" << std::endl;
+    std::cerr << "            --reference=<filename>[;<csv options>]: reference points; default: input points, including the point itself" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "    radius-count: for each point append number of reference points within --radius (binary: ui)" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "        input fields: " << comma::join( comma::csv::names< Eigen::Vector3d >( true ), ',' ) << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "        options:" << std::endl;
+    std::cerr << "            --radius=<radius>" << std::endl;
+    std::cerr << "            --reference=<filename>[;<csv options>]: reference points; default: input points, including the point itself" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "        nearest, k-nearest, radius-count: reference points are indexed in kd-tree, input points are read" << std::endl;
+    std::cerr << "        and queried in parallel in blocks of --block-size points; default: 10000" << std::endl;
     std::cerr << std::endl;
     std::cerr << "    thin: read input data and thin them down by the given --resolution" << std::endl;
     std::cerr << std::endl;
@@ -165,6 +192,108 @@ static void discretise( double step, double tolerance )
     output_points( *previous_point, *previous_point );
 }
 
+typedef snark::kd_tree< 3 > kd_tree_t;
+
+static void load_points( comma::csv::input_stream< Eigen::Vector3d >& istream, std::istream& is, const comma::csv::options& options, std::vector< Eigen::Vector3d >& points, std::vector< std::string >& records, std::size_t size = std::numeric_limits< std::size_t >::max() )
+{
+    while( points.size() < size && ( istream.ready() || ( is.good() && !is.eof() ) ) )
+    {
+        const Eigen::Vector3d* p = istream.read();
+        if( !p ) { break; }
+        points.push_back( *p );
+        records.push_back( options.binary() ? std::string( istream.binary().last(), options.format().size() ) : comma::join( istream.ascii().last(), options.delimiter ) );
+    }
+}
+
+static void output_neighbour( const std::string& record, const std::string& reference, double distance )
+{
+    if( csv.binary() )
+    {
+        std::cout.write( &record[0], record.size() );
+        std::cout.write( &reference[0], reference.size() );
+        std::cout.write( reinterpret_cast< const char* >( &distance ), sizeof( double ) );
+    }
+    else
+    {
+        std::cout << record << csv.delimiter << reference << csv.delimiter << distance << std::endl;
+    }
+}
+
+static void output_neighbours( const std::string& operation, const comma::command_line_options& options, const kd_tree_t& tree, const std::vector< std::string >& references, const std::vector< Eigen::Vector3d >& points, const std::vector< std::string >& records )
+{
+    if( operation == "nearest" )
+    {
+        std::vector< kd_tree_t::neighbour > neighbours;
+        tree.nearest( points, neighbours );
+        for( std::size_t i = 0; i < points.size(); ++i ) { output_neighbour( records[i], references[ neighbours[i].index ], neighbours[i].distance ); }
+    }
+    else if( operation == "k-nearest" )
+    {
+        std::vector< std::vector< kd_tree_t::neighbour > > neighbours;
+        tree.nearest( points, options.value< std::size_t >( "--k" ), neighbours );
+        for( std::size_t i = 0; i < points.size(); ++i ) { for( std::size_t k = 0; k < neighbours[i].size(); ++k ) { output_neighbour( records[i], references[ neighbours[i][k].index ], neighbours[i][k].distance ); } }
+    }
+    else
+    {
+        std::vector< std::size_t > counts;
+        tree.radius_count( points, options.value< double >( "--radius" ), counts );
+        for( std::size_t i = 0; i < points.size(); ++i )
+        {
+            if( csv.binary() )
+            {
+                comma::uint32 count = counts[i];
+                std::cout.write( &records[i][0], records[i].size() );
+                std::cout.write( reinterpret_cast< const char* >( &count ), sizeof( comma::uint32 ) );
+            }
+            else
+            {
+                std::cout << records[i] << csv.delimiter << counts[i] << std::endl;
+            }
+        }
+    }
+    if( csv.flush ) { std::cout.flush(); }
+}
+
+static void find_neighbours( const std::string& operation, const comma::command_line_options& options )
+{
+    if( operation == "k-nearest" && !options.exists( "--k" ) ) { std::cerr << "points-calc: k-nearest: please specify --k" << std::endl; exit( 1 ); }
+    if( operation == "radius-count" && !options.exists( "--radius" ) ) { std::cerr << "points-calc: radius-count: please specify --radius" << std::endl; exit( 1 ); }
+    if( operation == "nearest" && !options.exists( "--reference" ) ) { std::cerr << "points-calc: nearest: please specify --point or --reference" << std::endl; exit( 1 ); }
+    std::size_t block_size = options.value< std::size_t >( "--block-size", 10000 );
+    if( block_size == 0 ) { std::cerr << "points-calc: expected positive block size" << std::endl; exit( 1 ); }
+    std::vector< Eigen::Vector3d > reference_points;
+    std::vector< std::string > references;
+    std::vector< Eigen::Vector3d > points;
+    std::vector< std::string > records;
+    if( options.exists( "--reference" ) )
+    {
+        comma::csv::options reference_csv = comma::name_value::parser( "filename", ';' ).get< comma::csv::options >( options.value< std::string >( "--reference" ) );
+        if( reference_csv.fields.empty() ) { reference_csv.fields = "x,y,z"; }
+        reference_csv.full_xpath = true;
+        std::ifstream ifs( &reference_csv.filename[0], reference_csv.binary() ? std::ios::binary : std::ios::in );
+        if( !ifs.is_open() ) { std::cerr << "points-calc: failed to open " << reference_csv.filename << std::endl; exit( 1 ); }
+        comma::csv::input_stream< Eigen::Vector3d > ristream( ifs, reference_csv );
+        load_points( ristream, ifs, reference_csv, reference_points, references );
+    }
+    comma::csv::input_stream< Eigen::Vector3d > istream( std::cin, csv );
+    if( !options.exists( "--reference" ) ) // input points are reference points
+    {
+        load_points( istream, std::cin, csv, reference_points, references );
+        points = reference_points;
+        records = references;
+    }
+    kd_tree_t tree( reference_points.begin(), reference_points.end() );
+    if( operation == "nearest" && tree.size() == 0 ) { std::cerr << "points-calc: nearest: no reference points" << std::endl; exit( 1 ); }
+    if( !points.empty() ) { output_neighbours( operation, options, tree, references, points, records ); return; }
+    while( true )
+    {
+        points.clear();
+        records.clear();
+        load_points( istream, std::cin, csv, points, records, block_size );
+        if( points.empty() ) { return; }
+        output_neighbours( operation, options, tree, references, points, records );
+    }
+}
 
 int main( int ac, char** av )
 {
@@ -197,6 +326,11 @@ int main( int ac, char** av )
             calculate_distance( true );
             return 0;
         }
+        if( operation == "k-nearest" || operation == "radius-count" || ( operation == "nearest" && !options.exists( "--point,--to" ) ) )
+        {
+            find_neighbours( operation, options );
+            return 0;
+        }
         if( operation == "nearest" )
         {
             Eigen::Vector3d point = comma::csv::ascii< Eigen::Vector3d >().get( options.value< std::string >( "--point,--to" ) );
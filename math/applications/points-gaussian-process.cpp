@@ -0,0 +1,226 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <tbb/task_scheduler_init.h>
+#include <comma/application/command_line_options.h>
+#include <comma/application/signal_flag.h>
+#include <comma/csv/stream.h>
+#include <comma/name_value/parser.h>
+#include <comma/string/string.h>
+#include <comma/visiting/traits.h>
+#include <snark/math/gaussian_process/covariance.h>
+#include <snark/math/gaussian_process/tiled_gaussian_process.h>
+#include <snark/visiting/eigen.h>
+
+static void usage( bool long_help = false )
+{
+    std::cerr << std::endl;
+    std::cerr << "fit local gaussian processes on tiles of training points, e.g. terrain survey, read query points on stdin," << std::endl;
+    std::cerr << "append mean and variance of the value at each query point and output" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "usage: cat queries.csv | points-gaussian-process --training=<filename>[;<csv options>] [<options>] > queries.with-means.csv" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "options" << std::endl;
+    std::cerr << "    --training=<filename>[;<csv options>]: training points; fields: x,y,value; default: x,y,value" << std::endl;
+    std::cerr << "    --tile-size=<size>: tile side length; a gaussian process is fitted independently for each tile" << std::endl;
+    std::cerr << "    --margin=<size>: training points up to margin outside of a tile are used to fit it;" << std::endl;
+    std::cerr << "                     queries within margin / 2 of tile borders are blended between adjacent tiles; default: 0" << std::endl;
+    std::cerr << "    --kernel=<kernel>: squared-exponential, matern-1/2, matern-3/2, matern-5/2, rational-quadratic; default: squared-exponential" << std::endl;
+    std::cerr << "    --length-scale=<value>: kernel length scale; as in snark::squared_exponential_covariance for squared-exponential" << std::endl;
+    std::cerr << "    --signal-variance=<value>: default: 1" << std::endl;
+    std::cerr << "    --data-variance=<value>: variance of training values noise; default: 0.01" << std::endl;
+    std::cerr << "    --alpha=<value>: rational-quadratic only; default: 1" << std::endl;
+    std::cerr << "    --block-size=<n>: number of queries evaluated at once; fitted tiles are reused from block to block; default: 10000" << std::endl;
+    std::cerr << "    --threads=<n>: number of threads fitting and evaluating tiles; default: number of cores" << std::endl;
+    std::cerr << "    --precision,-p=<digits>: ascii output precision; default: 12" << std::endl;
+    std::cerr << "    --verbose,-v: more output to stderr" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "fields: x,y; default: x,y" << std::endl;
+    std::cerr << "output: query record with appended mean,variance; binary: appended as d,d" << std::endl;
+    std::cerr << "        queries without training points around them get nan mean and variance" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "example" << std::endl;
+    std::cerr << "    cat grid.bin | points-gaussian-process --binary=2d --training=\"survey.bin;binary=3d\" --tile-size=50 --margin=10 --length-scale=4 > elevation.bin" << std::endl;
+    if( long_help )
+    {
+        std::cerr << std::endl;
+        std::cerr << comma::csv::options::usage() << std::endl;
+    }
+    std::cerr << std::endl;
+    exit( 1 );
+}
+
+struct training_point
+{
+    double x;
+    double y;
+    double value;
+    training_point() : x( 0 ), y( 0 ), value( 0 ) {}
+};
+
+namespace comma { namespace visiting {
+
+template <> struct traits< training_point >
+{
+    template < typename K, typename V > static void visit( const K&, training_point& p, V& v )
+    {
+        v.apply( "x", p.x );
+        v.apply( "y", p.y );
+        v.apply( "value", p.value );
+    }
+
+    template < typename K, typename V > static void visit( const K&, const training_point& p, V& v )
+    {
+        v.apply( "x", p.x );
+        v.apply( "y", p.y );
+        v.apply( "value", p.value );
+    }
+};
+
+} } // namespace comma { namespace visiting {
+
+static bool verbose;
+
+static boost::shared_ptr< const snark::covariance_kernel > make_kernel( const comma::command_line_options& options )
+{
+    std::string name = options.value< std::string >( "--kernel", "squared-exponential" );
+    double length_scale = options.value< double >( "--length-scale" );
+    double signal_variance = options.value< double >( "--signal-variance", 1 );
+    double data_variance = options.value< double >( "--data-variance", 0.01 );
+    snark::covariance_kernel* k = NULL;
+    if( name == "squared-exponential" ) { k = new snark::squared_exponential_covariance( length_scale, signal_variance, data_variance ); }
+    else if( name == "matern-1/2" ) { k = new snark::matern_covariance( length_scale, signal_variance, data_variance, snark::matern_covariance::one_half ); }
+    else if( name == "matern-3/2" ) { k = new snark::matern_covariance( length_scale, signal_variance, data_variance, snark::matern_covariance::three_halves ); }
+    else if( name == "matern-5/2" ) { k = new snark::matern_covariance( length_scale, signal_variance, data_variance, snark::matern_covariance::five_halves ); }
+    else if( name == "rational-quadratic" ) { k = new snark::rational_quadratic_covariance( length_scale, options.value< double >( "--alpha", 1 ), signal_variance, data_variance ); }
+    else { std::cerr << "points-gaussian-process: expected kernel, got: \"" << name << "\"" << std::endl; exit( 1 ); }
+    return boost::shared_ptr< const snark::covariance_kernel >( k );
+}
+
+static void load_( const comma::csv::options& csv, Eigen::MatrixXd& domains, Eigen::VectorXd& targets )
+{
+    std::ifstream ifs( &csv.filename[0], csv.binary() ? std::ios::binary : std::ios::in );
+    if( !ifs.is_open() ) { std::cerr << "points-gaussian-process: failed to open " << csv.filename << std::endl; exit( 1 ); }
+    comma::csv::input_stream< training_point > stream( ifs, csv );
+    std::vector< training_point > points;
+    while( stream.ready() || ( ifs.good() && !ifs.eof() ) )
+    {
+        const training_point* p = stream.read();
+        if( !p ) { break; }
+        points.push_back( *p );
+    }
+    domains.resize( points.size(), 2 );
+    targets.resize( points.size() );
+    for( std::size_t i = 0; i < points.size(); ++i ) { domains( i, 0 ) = points[i].x; domains( i, 1 ) = points[i].y; targets( i ) = points[i].value; }
+}
+
+static void output_( snark::tiled_gaussian_process& process, const comma::csv::options& csv, const std::vector< Eigen::Vector2d >& queries, const std::vector< std::string >& records )
+{
+    if( queries.empty() ) { return; }
+    Eigen::MatrixXd domains( queries.size(), 2 );
+    for( std::size_t i = 0; i < queries.size(); ++i ) { domains.row( i ) = queries[i]; }
+    Eigen::VectorXd means;
+    Eigen::VectorXd variances;
+    process.evaluate( domains, means, variances );
+    for( std::size_t i = 0; i < queries.size(); ++i )
+    {
+        if( csv.binary() )
+        {
+            std::cout.write( &records[i][0], records[i].size() );
+            std::cout.write( reinterpret_cast< const char* >( &means( i ) ), sizeof( double ) );
+            std::cout.write( reinterpret_cast< const char* >( &variances( i ) ), sizeof( double ) );
+        }
+        else
+        {
+            std::cout << records[i] << csv.delimiter << means( i ) << csv.delimiter << variances( i ) << std::endl;
+        }
+    }
+    if( csv.flush ) { std::cout.flush(); }
+    if( verbose ) { std::cerr << "points-gaussian-process: evaluated " << queries.size() << " queries; fitted tiles: " << process.fitted() << " of " << process.size() << std::endl; }
+}
+
+int main( int ac, char** av )
+{
+    try
+    {
+        comma::command_line_options options( ac, av );
+        if( options.exists( "--help,-h" ) ) { usage(); }
+        if( options.exists( "--long-help" ) ) { usage( true ); }
+        verbose = options.exists( "--verbose,-v" );
+        comma::csv::options csv( options, "x,y" );
+        if( !csv.binary() ) { std::cout.precision( options.value( "--precision,-p", 12 ) ); }
+        comma::csv::options training_csv = comma::name_value::parser( "filename", ';' ).get< comma::csv::options >( options.value< std::string >( "--training" ) );
+        if( training_csv.fields.empty() ) { training_csv.fields = "x,y,value"; }
+        double tile_size = options.value< double >( "--tile-size" );
+        double margin = options.value< double >( "--margin", 0 );
+        std::size_t block_size = options.value< std::size_t >( "--block-size", 10000 );
+        if( block_size == 0 ) { std::cerr << "points-gaussian-process: expected positive block size" << std::endl; return 1; }
+        unsigned int threads = options.value< unsigned int >( "--threads", tbb::task_scheduler_init::default_num_threads() );
+        if( threads == 0 ) { std::cerr << "points-gaussian-process: expected positive number of threads" << std::endl; return 1; }
+        tbb::task_scheduler_init init( threads );
+        boost::shared_ptr< const snark::covariance_kernel > kernel = make_kernel( options );
+        Eigen::MatrixXd domains;
+        Eigen::VectorXd targets;
+        load_( training_csv, domains, targets );
+        if( domains.rows() == 0 ) { std::cerr << "points-gaussian-process: no training points in " << training_csv.filename << std::endl; return 1; }
+        snark::tiled_gaussian_process process( domains, targets, kernel, tile_size, margin );
+        if( verbose ) { std::cerr << "points-gaussian-process: loaded " << domains.rows() << " training points in " << process.size() << " tiles" << std::endl; }
+        comma::signal_flag is_shutdown;
+        comma::csv::input_stream< Eigen::Vector2d > istream( std::cin, csv );
+        std::vector< Eigen::Vector2d > queries;
+        std::vector< std::string > records;
+        while( !is_shutdown && ( istream.ready() || ( std::cin.good() && !std::cin.eof() ) ) )
+        {
+            const Eigen::Vector2d* p = istream.read();
+            if( !p ) { break; }
+            queries.push_back( *p );
+            records.push_back( csv.binary() ? std::string( istream.binary().last(), csv.format().size() ) : comma::join( istream.ascii().last(), csv.delimiter ) );
+            if( queries.size() < block_size ) { continue; }
+            output_( process, csv, queries, records );
+            queries.clear();
+            records.clear();
+        }
+        output_( process, csv, queries, records );
+        return 0;
+    }
+    catch( std::exception& ex )
+    {
+        std::cerr << "points-gaussian-process: " << ex.what() << std::endl;
+    }
+    catch( ... )
+    {
+        std::cerr << "points-gaussian-process: unknown exception" << std::endl;
+    }
+    return 1;
+}
@@ -0,0 +1,145 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SNARK_FILTER_BATCH_KALMAN_FILTER_H
+#define SNARK_FILTER_BATCH_KALMAN_FILTER_H
+
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/StdVector>
+#include <tbb/parallel_for.h>
+#include <comma/base/exception.h>
+#include <snark/math/filter/kalman_filter.h>
+
+namespace snark{ 
+
+/// kalman filter over many independent tracks of the same fixed-size model, e.g. constant_speed< 3 >:
+/// states are stored contiguously, all tracks are predicted or updated in one call,
+/// optionally in parallel; each track gives the same results as kalman_filter
+template< class State, class Model >
+class batch_kalman_filter
+{
+public:
+    typedef std::vector< State, Eigen::aligned_allocator< State > > states_type;
+
+    /// constructor
+    /// @param model motion model, copied per thread, if parallel
+    /// @param parallel predict and update tracks in parallel
+    batch_kalman_filter( Model& model, bool parallel = false ) : m_model( model ), m_parallel( parallel ) {}
+
+    /// add track, return its index
+    std::size_t push_back( const State& s ) { m_states.push_back( s ); return m_states.size() - 1; }
+
+    /// remove track; the last track takes its index
+    void erase( std::size_t i ) { m_states[i] = m_states.back(); m_states.pop_back(); }
+
+    /// predict step for all tracks
+    /// @param deltaT time in seconds since last prediction
+    void predict( double deltaT )
+    {
+        if( !m_parallel ) { for( std::size_t i = 0; i < m_states.size(); ++i ) { kalman_filter< State, Model >::predict( m_states[i], m_model, deltaT ); } return; }
+        tbb::parallel_for( tbb::blocked_range< std::size_t >( 0, m_states.size(), grain_size ), predict_( m_states, m_model, deltaT ) );
+    }
+
+    /// update step for all tracks
+    /// @param measurements measurement for each track
+    template< class Measurement, class Allocator >
+    void update( const std::vector< Measurement, Allocator >& measurements )
+    {
+        if( measurements.size() != m_states.size() ) { COMMA_THROW( comma::exception, "expected " << m_states.size() << " measurement(s), got " << measurements.size() ); }
+        if( !m_parallel ) { for( std::size_t i = 0; i < m_states.size(); ++i ) { kalman_filter< State, Model >::update( m_states[i], measurements[i] ); } return; }
+        tbb::parallel_for( tbb::blocked_range< std::size_t >( 0, m_states.size(), grain_size ), update_< std::vector< Measurement, Allocator > >( m_states, NULL, measurements ) );
+    }
+
+    /// update step for given tracks
+    /// @param indices tracks to update, each track at most once
+    /// @param measurements measurement for each of given tracks
+    template< class Measurement, class Allocator >
+    void update( const std::vector< std::size_t >& indices, const std::vector< Measurement, Allocator >& measurements )
+    {
+        if( measurements.size() != indices.size() ) { COMMA_THROW( comma::exception, "expected " << indices.size() << " measurement(s), got " << measurements.size() ); }
+        for( std::size_t i = 0; i < indices.size(); ++i ) { if( indices[i] >= m_states.size() ) { COMMA_THROW( comma::exception, "expected track index less than " << m_states.size() << ", got " << indices[i] ); } }
+        if( !m_parallel ) { for( std::size_t i = 0; i < indices.size(); ++i ) { kalman_filter< State, Model >::update( m_states[ indices[i] ], measurements[i] ); } return; }
+        tbb::parallel_for( tbb::blocked_range< std::size_t >( 0, indices.size(), grain_size ), update_< std::vector< Measurement, Allocator > >( m_states, &indices, measurements ) );
+    }
+
+    /// get state of track
+    const State& state( std::size_t i ) const { return m_states[i]; }
+
+    /// get states of all tracks
+    const states_type& states() const { return m_states; }
+
+    /// number of tracks
+    std::size_t size() const { return m_states.size(); }
+
+private:
+    enum { grain_size = 64 }; // tracks per parallel task: a single track is too little work
+
+    states_type m_states; /// states of all tracks
+    Model& m_model; /// process model
+    bool m_parallel;
+
+    class predict_
+    {
+    public:
+        predict_( states_type& states, const Model& model, double deltaT ) : m_states( states ), m_model( model ), m_deltaT( deltaT ) {}
+
+        void operator()( const tbb::blocked_range< std::size_t >& r ) const
+        {
+            Model model( m_model ); // models keep jacobian and noise as members, thus a copy per task
+            for( std::size_t i = r.begin(); i < r.end(); ++i ) { kalman_filter< State, Model >::predict( m_states[i], model, m_deltaT ); }
+        }
+
+    private:
+        states_type& m_states;
+        const Model& m_model;
+        double m_deltaT;
+    };
+
+    template< class Measurements >
+    class update_
+    {
+    public:
+        update_( states_type& states, const std::vector< std::size_t >* indices, const Measurements& measurements ) : m_states( states ), m_indices( indices ), m_measurements( measurements ) {}
+
+        void operator()( const tbb::blocked_range< std::size_t >& r ) const
+        {
+            for( std::size_t i = r.begin(); i < r.end(); ++i ) { kalman_filter< State, Model >::update( m_states[ m_indices ? ( *m_indices )[i] : i ], m_measurements[i] ); }
+        }
+
+    private:
+        states_type& m_states;
+        const std::vector< std::size_t >* m_indices;
+        const Measurements& m_measurements;
+    };
+};
+
+} 
+
+#endif // SNARK_FILTER_BATCH_KALMAN_FILTER_H
@@ -38,7 +38,7 @@ namespace constant_position {
     
 struct state
 {
-    state(): covariance( Eigen::Matrix< double, dimension, dimension >::Identity() ) {}
+    state(): position( Eigen::Vector3d::Zero() ), covariance( Eigen::Matrix< double, dimension, dimension >::Identity() ) {}
 
     void set_innovation( const Eigen::Vector3d& innovation )
     {
@@ -83,11 +83,11 @@ struct model
 struct position
 {
     static const int dimension = 3;
-    Eigen::Vector3d position;
+    Eigen::Vector3d position_vector;
     Eigen::Matrix3d covariance;
     Eigen::Matrix3d jacobian;
 
-    position(): position( Eigen::Vector3d::Zero() ),
+    position(): position_vector( Eigen::Vector3d::Zero() ),
                 covariance( Eigen::Matrix3d::Identity() ),
                 jacobian( Eigen::Matrix3d::Identity() )
     {
@@ -105,11 +105,11 @@ struct position
 
     const Eigen::Matrix< double, dimension, 1 > innovation( const state & state ) const
     {
-        return position;
+        return position_vector - state.position;
     }
 };
 
 
-} } }
+} }
 
 #endif // SNARK_FILTER_CONSTANT_POSITION_H
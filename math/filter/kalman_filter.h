@@ -48,27 +48,34 @@ public:
 
     /// predict step
     /// @param deltaT time in seconds since last prediction
-    void predict( double deltaT )
-    {
-        const Eigen::Matrix< double, State::dimension, State::dimension >& A = m_model.jacobian( m_state, deltaT );
-        m_state.covariance = A * m_state.covariance * A.transpose() + m_model.noise_covariance( deltaT );
-        m_model.update_state( m_state, deltaT );
-    }
+    void predict( double deltaT ) { predict( m_state, m_model, deltaT ); }
 
     /// update step
     /// @param m measurement model with jacobian and covariance
     template< class Measurement >
-    void update( const Measurement& m )
+    void update( const Measurement& m ) { update( m_state, m ); }
+
+    /// predict step on given state, as used by kalman_filter and batch_kalman_filter
+    static void predict( State& state, Model& model, double deltaT )
+    {
+        const Eigen::Matrix< double, State::dimension, State::dimension >& A = model.jacobian( state, deltaT );
+        state.covariance = A * state.covariance * A.transpose() + model.noise_covariance( deltaT );
+        model.update_state( state, deltaT );
+    }
+
+    /// update step on given state, as used by kalman_filter and batch_kalman_filter
+    template< class Measurement >
+    static void update( State& state, const Measurement& m )
     {
-        const Eigen::Matrix<double,Measurement::dimension,State::dimension>& H = m.measurement_jacobian( m_state );
-        const Eigen::Matrix<double,Measurement::dimension,Measurement::dimension>& R = m.measurement_covariance( m_state );
-        const Eigen::Matrix<double,Measurement::dimension,1>& innovation = m.innovation( m_state );
+        const Eigen::Matrix<double,Measurement::dimension,State::dimension>& H = m.measurement_jacobian( state );
+        const Eigen::Matrix<double,Measurement::dimension,Measurement::dimension>& R = m.measurement_covariance( state );
+        const Eigen::Matrix<double,Measurement::dimension,1>& innovation = m.innovation( state );
         
-        const Eigen::Matrix<double,State::dimension, Measurement::dimension> PHt = m_state.covariance * H.transpose();
+        const Eigen::Matrix<double,State::dimension, Measurement::dimension> PHt = state.covariance * H.transpose();
         const Eigen::LDLT< Eigen::Matrix<double,Measurement::dimension,Measurement::dimension> > S = ( H * PHt + R ).ldlt();
         
-        m_state.covariance -= PHt * S.solve( PHt.transpose() );
-        m_state.set_innovation( PHt * S.solve( innovation ) );
+        state.covariance -= PHt * S.solve( PHt.transpose() );
+        state.set_innovation( PHt * S.solve( innovation ) );
     }
 
     /// get state
@@ -0,0 +1,154 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstdlib>
+#include <vector>
+#include <gtest/gtest.h>
+#include <Eigen/StdVector>
+#include <tbb/task_scheduler_init.h>
+#include <snark/math/filter/batch_kalman_filter.h>
+#include <snark/math/filter/constant_position.h>
+#include <snark/math/filter/constant_speed.h>
+#include <snark/math/filter/kalman_filter.h>
+
+namespace snark { namespace test {
+
+static double random_( double scale ) { return scale * ( 2.0 * std::rand() / RAND_MAX - 1 ); }
+
+template < typename F, typename B >
+static void expect_same_states_( const std::vector< F* >& filters, const B& batch )
+{
+    ASSERT_EQ( filters.size(), batch.size() );
+    for( std::size_t i = 0; i < filters.size(); ++i )
+    {
+        EXPECT_TRUE( filters[i]->state().covariance == batch.state( i ).covariance );
+    }
+}
+
+static void test_constant_speed_( bool parallel )
+{
+    typedef constant_speed< 3 > model_t;
+    typedef kalman_filter< model_t::state, model_t::model > filter_t;
+    typedef std::vector< model_t::position, Eigen::aligned_allocator< model_t::position > > measurements_t;
+    model_t::model model( 0.2 );
+    model_t::model batch_model( 0.2 );
+    batch_kalman_filter< model_t::state, model_t::model > batch( batch_model, parallel );
+    std::vector< filter_t* > filters;
+    std::srand( 1 );
+    for( unsigned int i = 0; i < 500; ++i )
+    {
+        model_t::state_type s;
+        for( unsigned int k = 0; k < 6; ++k ) { s( k ) = random_( 10 ); }
+        model_t::state state( s );
+        state.covariance = model_t::covariance_type::Identity();
+        filters.push_back( new filter_t( state, model ) );
+        EXPECT_EQ( i, batch.push_back( state ) );
+    }
+    for( unsigned int step = 0; step < 20; ++step )
+    {
+        for( std::size_t i = 0; i < filters.size(); ++i ) { filters[i]->predict( 0.1 ); }
+        batch.predict( 0.1 );
+        measurements_t measurements;
+        for( std::size_t i = 0; i < filters.size(); ++i ) { measurements.push_back( model_t::position( filters[i]->state().state_vector.head< 3 >() + Eigen::Vector3d( random_( 1 ), random_( 1 ), random_( 1 ) ), 0.3 ) ); }
+        if( step % 2 == 0 )
+        {
+            for( std::size_t i = 0; i < filters.size(); ++i ) { filters[i]->update( measurements[i] ); }
+            batch.update( measurements );
+        }
+        else // only some tracks observed
+        {
+            std::vector< std::size_t > indices;
+            measurements_t some;
+            for( std::size_t i = step % 3; i < filters.size(); i += 3 ) { indices.push_back( i ); some.push_back( measurements[i] ); filters[i]->update( measurements[i] ); }
+            batch.update( indices, some );
+        }
+        expect_same_states_( filters, batch );
+        for( std::size_t i = 0; i < filters.size(); ++i ) { EXPECT_TRUE( filters[i]->state().state_vector == batch.state( i ).state_vector ); }
+    }
+    for( std::size_t i = 0; i < filters.size(); ++i ) { delete filters[i]; }
+}
+
+TEST( batch_kalman_filter, constant_speed )
+{
+    test_constant_speed_( false );
+}
+
+TEST( batch_kalman_filter, constant_speed_parallel )
+{
+    for( unsigned int threads = 1; threads <= 4; threads *= 2 )
+    {
+        tbb::task_scheduler_init init( threads );
+        test_constant_speed_( true );
+    }
+}
+
+TEST( batch_kalman_filter, constant_position )
+{
+    constant_position::model model;
+    constant_position::model batch_model;
+    typedef kalman_filter< constant_position::state, constant_position::model > filter_t;
+    batch_kalman_filter< constant_position::state, constant_position::model > batch( batch_model, true );
+    std::vector< filter_t* > filters;
+    std::srand( 1 );
+    for( unsigned int i = 0; i < 300; ++i )
+    {
+        constant_position::state state;
+        state.position = Eigen::Vector3d( random_( 10 ), random_( 10 ), random_( 10 ) );
+        filters.push_back( new filter_t( state, model ) );
+        batch.push_back( state );
+    }
+    Eigen::Vector3d target( 1, 2, 3 );
+    for( unsigned int step = 0; step < 20; ++step )
+    {
+        for( std::size_t i = 0; i < filters.size(); ++i ) { filters[i]->predict( 0.1 ); }
+        batch.predict( 0.1 );
+        std::vector< constant_position::position > measurements( filters.size() );
+        for( std::size_t i = 0; i < filters.size(); ++i ) { measurements[i].position_vector = target + Eigen::Vector3d( random_( 0.1 ), random_( 0.1 ), random_( 0.1 ) ); filters[i]->update( measurements[i] ); }
+        batch.update( measurements );
+        expect_same_states_( filters, batch );
+        for( std::size_t i = 0; i < filters.size(); ++i ) { EXPECT_TRUE( filters[i]->state().position == batch.state( i ).position ); }
+    }
+    for( std::size_t i = 0; i < filters.size(); ++i ) { EXPECT_NEAR( 0, ( batch.state( i ).position - target ).norm(), 0.1 ); delete filters[i]; } // converged to measurements
+}
+
+TEST( batch_kalman_filter, erase )
+{
+    constant_position::model model;
+    batch_kalman_filter< constant_position::state, constant_position::model > batch( model );
+    constant_position::state state;
+    for( unsigned int i = 0; i < 3; ++i ) { state.position = Eigen::Vector3d::Constant( i ); batch.push_back( state ); }
+    batch.erase( 0 );
+    ASSERT_EQ( 2u, batch.size() );
+    EXPECT_EQ( 2, batch.state( 0 ).position.x() );
+    EXPECT_EQ( 1, batch.state( 1 ).position.x() );
+    EXPECT_THROW( batch.update( std::vector< constant_position::position >( 3 ) ), comma::exception );
+    EXPECT_THROW( batch.update( std::vector< std::size_t >( 1, 2 ), std::vector< constant_position::position >( 1 ) ), comma::exception );
+}
+
+} } 
@@ -30,10 +30,48 @@
 
 #include <cmath>
 #include <Eigen/Eigen>
+#include <comma/base/exception.h>
 #include "covariance.h"
 
 namespace snark{ 
 
+/// squared distances between rows of a and rows of b as |a|^2 + |b|^2 - 2 * a.b, i.e. one matrix product
+static void squared_distances( const Eigen::MatrixXd& a, const Eigen::MatrixXd& b, Eigen::MatrixXd& d )
+{
+    if( a.cols() != b.cols() ) { COMMA_THROW( comma::exception, "expected domains of the same dimension, got " << a.cols() << " and " << b.cols() ); }
+    d.noalias() = -2 * a * b.transpose();
+    d.colwise() += a.rowwise().squaredNorm();
+    d.rowwise() += b.rowwise().squaredNorm().transpose();
+    d = d.cwiseMax( 0 ); // rounding errors for close domains
+}
+
+pairwise_covariance::pairwise_covariance( const pairwise_covariance::function& covariance, double self_covariance )
+    : covariance_( covariance )
+    , self_covariance_( self_covariance )
+{
+}
+
+void pairwise_covariance::covariances( const Eigen::MatrixXd& a, const Eigen::MatrixXd& b, Eigen::MatrixXd& k ) const
+{
+    k.resize( a.rows(), b.rows() );
+    std::vector< Eigen::VectorXd > rows( b.rows() );
+    for( std::size_t c = 0; c < std::size_t( b.rows() ); ++c ) { rows[c] = b.row( c ); }
+    for( std::size_t r = 0; r < std::size_t( a.rows() ); ++r )
+    {
+        const Eigen::VectorXd& row = a.row( r );
+        if( &a != &b ) { for( std::size_t c = 0; c < rows.size(); ++c ) { k( r, c ) = covariance_( row, rows[c] ); } continue; }
+        for( std::size_t c = r; c < rows.size(); ++c ) { k( c, r ) = k( r, c ) = covariance_( row, rows[c] ); } // symmetric
+    }
+}
+
+void pairwise_covariance::diagonal( const Eigen::MatrixXd& a, Eigen::VectorXd& d ) const
+{
+    d.resize( a.rows() );
+    for( std::size_t r = 0; r < std::size_t( a.rows() ); ++r ) { const Eigen::VectorXd& row = a.row( r ); d( r ) = covariance_( row, row ); }
+}
+
+double pairwise_covariance::self_covariance() const { return self_covariance_; }
+
 squared_exponential_covariance::squared_exponential_covariance( double length_scale
                                                               , double signal_variance
                                                               , double data_variance )
@@ -50,6 +88,80 @@ double squared_exponential_covariance::covariance( const Eigen::VectorXd& v, con
     return signal_variance_ * std::exp( factor_ * diff.dot( diff ) );
 }
 
+void squared_exponential_covariance::covariances( const Eigen::MatrixXd& a, const Eigen::MatrixXd& b, Eigen::MatrixXd& k ) const
+{
+    squared_distances( a, b, k );
+    k = signal_variance_ * ( k * factor_ ).array().exp();
+}
+
+void squared_exponential_covariance::diagonal( const Eigen::MatrixXd& a, Eigen::VectorXd& d ) const { d = Eigen::VectorXd::Constant( a.rows(), signal_variance_ ); }
+
 double squared_exponential_covariance::self_covariance() const { return self_covariance_; }
 
-} // namespace snark{ { namespace Robotics {
+matern_covariance::matern_covariance( double length_scale
+                                    , double signal_variance
+                                    , double data_variance
+                                    , matern_covariance::smoothness nu )
+    : length_scale_( length_scale )
+    , signal_variance_( signal_variance )
+    , data_variance_( data_variance )
+    , nu_( nu )
+{
+    if( !( length_scale > 0 ) ) { COMMA_THROW( comma::exception, "expected positive length scale, got " << length_scale ); }
+}
+
+double matern_covariance::covariance_( double squared_distance ) const
+{
+    double r = std::sqrt( squared_distance ) / length_scale_;
+    switch( nu_ )
+    {
+        case one_half: return signal_variance_ * std::exp( -r );
+        case three_halves: { double s = std::sqrt( 3.0 ) * r; return signal_variance_ * ( 1 + s ) * std::exp( -s ); }
+        case five_halves: { double s = std::sqrt( 5.0 ) * r; return signal_variance_ * ( 1 + s + s * s / 3 ) * std::exp( -s ); }
+    }
+    return 0; // never here
+}
+
+double matern_covariance::covariance( const Eigen::VectorXd& v, const Eigen::VectorXd& w ) const { return covariance_( ( v - w ).squaredNorm() ); }
+
+void matern_covariance::covariances( const Eigen::MatrixXd& a, const Eigen::MatrixXd& b, Eigen::MatrixXd& k ) const
+{
+    squared_distances( a, b, k );
+    Eigen::ArrayXXd s = k.array().sqrt() / length_scale_;
+    switch( nu_ )
+    {
+        case one_half: k = signal_variance_ * ( -s ).exp(); break;
+        case three_halves: s *= std::sqrt( 3.0 ); k = signal_variance_ * ( 1 + s ) * ( -s ).exp(); break;
+        case five_halves: s *= std::sqrt( 5.0 ); k = signal_variance_ * ( 1 + s + s * s / 3 ) * ( -s ).exp(); break;
+    }
+}
+
+void matern_covariance::diagonal( const Eigen::MatrixXd& a, Eigen::VectorXd& d ) const { d = Eigen::VectorXd::Constant( a.rows(), signal_variance_ ); }
+
+double matern_covariance::self_covariance() const { return signal_variance_ + data_variance_; }
+
+rational_quadratic_covariance::rational_quadratic_covariance( double length_scale
+                                                            , double alpha
+                                                            , double signal_variance
+                                                            , double data_variance )
+    : alpha_( alpha )
+    , signal_variance_( signal_variance )
+    , data_variance_( data_variance )
+    , factor_( 1.0 / ( 2 * alpha * length_scale * length_scale ) )
+{
+    if( !( length_scale > 0 ) || !( alpha > 0 ) ) { COMMA_THROW( comma::exception, "expected positive length scale and alpha, got " << length_scale << " and " << alpha ); }
+}
+
+double rational_quadratic_covariance::covariance( const Eigen::VectorXd& v, const Eigen::VectorXd& w ) const { return signal_variance_ * std::pow( 1 + ( v - w ).squaredNorm() * factor_, -alpha_ ); }
+
+void rational_quadratic_covariance::covariances( const Eigen::MatrixXd& a, const Eigen::MatrixXd& b, Eigen::MatrixXd& k ) const
+{
+    squared_distances( a, b, k );
+    k = signal_variance_ * ( 1 + k.array() * factor_ ).pow( -alpha_ );
+}
+
+void rational_quadratic_covariance::diagonal( const Eigen::MatrixXd& a, Eigen::VectorXd& d ) const { d = Eigen::VectorXd::Constant( a.rows(), signal_variance_ ); }
+
+double rational_quadratic_covariance::self_covariance() const { return signal_variance_ + data_variance_; }
+
+} // namespace snark{
@@ -31,11 +31,48 @@
 #ifndef SNARK_GAUSSIAN_PROCESS_COVARIANCE_
 #define SNARK_GAUSSIAN_PROCESS_COVARIANCE_
 
+#include <boost/function.hpp>
 #include <Eigen/Core>
 
 namespace snark{ 
 
-class squared_exponential_covariance
+/// covariance kernel computing covariances of whole blocks of domains at once
+class covariance_kernel
+{
+    public:
+        virtual ~covariance_kernel() {}
+
+        /// covariance block: k( i, j ) is covariance of a.row( i ) and b.row( j )
+        virtual void covariances( const Eigen::MatrixXd& a, const Eigen::MatrixXd& b, Eigen::MatrixXd& k ) const = 0;
+
+        /// covariance of each row with itself: d( i ) is covariance of a.row( i ) and a.row( i )
+        virtual void diagonal( const Eigen::MatrixXd& a, Eigen::VectorXd& d ) const = 0;
+
+        /// covariance of domain with itself plus data variance
+        virtual double self_covariance() const = 0;
+};
+
+/// kernel calling covariance functor for each pair of domains
+class pairwise_covariance : public covariance_kernel
+{
+    public:
+        typedef boost::function< double ( const Eigen::VectorXd&, const Eigen::VectorXd& ) > function;
+
+        pairwise_covariance( const function& covariance, double self_covariance );
+
+        void covariances( const Eigen::MatrixXd& a, const Eigen::MatrixXd& b, Eigen::MatrixXd& k ) const;
+
+        void diagonal( const Eigen::MatrixXd& a, Eigen::VectorXd& d ) const;
+
+        double self_covariance() const;
+
+    private:
+        function covariance_;
+        double self_covariance_;
+};
+
+/// squared exponential covariance: signal_variance * exp( -|v - w|^2 / ( 2 * sqrt( length_scale ) ) )
+class squared_exponential_covariance : public covariance_kernel
 {
     public:
         squared_exponential_covariance( double length_scale
@@ -43,7 +80,12 @@ class squared_exponential_covariance
                                       , double data_variance );
 
         double covariance( const Eigen::VectorXd& v, const Eigen::VectorXd& w ) const;
-        
+
+        /// covariance block, squared distances computed as |v|^2 + |w|^2 - 2 * v.w
+        void covariances( const Eigen::MatrixXd& a, const Eigen::MatrixXd& b, Eigen::MatrixXd& k ) const;
+
+        void diagonal( const Eigen::MatrixXd& a, Eigen::VectorXd& d ) const;
+
         double self_covariance() const;
 
     private:
@@ -53,6 +95,61 @@ class squared_exponential_covariance
         double self_covariance_;
 };
 
+/// matern covariance of smoothness nu = 1/2, 3/2, or 5/2 for distance r = |v - w| / length_scale:
+/// nu = 1/2: signal_variance * exp( -r ), i.e. exponential covariance
+/// nu = 3/2: signal_variance * ( 1 + sqrt( 3 ) * r ) * exp( -sqrt( 3 ) * r )
+/// nu = 5/2: signal_variance * ( 1 + sqrt( 5 ) * r + 5 * r^2 / 3 ) * exp( -sqrt( 5 ) * r )
+class matern_covariance : public covariance_kernel
+{
+    public:
+        enum smoothness { one_half, three_halves, five_halves };
+
+        matern_covariance( double length_scale
+                         , double signal_variance
+                         , double data_variance
+                         , smoothness nu = three_halves );
+
+        double covariance( const Eigen::VectorXd& v, const Eigen::VectorXd& w ) const;
+
+        void covariances( const Eigen::MatrixXd& a, const Eigen::MatrixXd& b, Eigen::MatrixXd& k ) const;
+
+        void diagonal( const Eigen::MatrixXd& a, Eigen::VectorXd& d ) const;
+
+        double self_covariance() const;
+
+    private:
+        double length_scale_;
+        double signal_variance_;
+        double data_variance_;
+        smoothness nu_;
+        double covariance_( double squared_distance ) const;
+};
+
+/// rational quadratic covariance: signal_variance * ( 1 + |v - w|^2 / ( 2 * alpha * length_scale^2 ) )^-alpha,
+/// i.e. mixture of squared exponentials of different length scales, squared exponential as alpha goes to infinity
+class rational_quadratic_covariance : public covariance_kernel
+{
+    public:
+        rational_quadratic_covariance( double length_scale
+                                     , double alpha
+                                     , double signal_variance
+                                     , double data_variance );
+
+        double covariance( const Eigen::VectorXd& v, const Eigen::VectorXd& w ) const;
+
+        void covariances( const Eigen::MatrixXd& a, const Eigen::MatrixXd& b, Eigen::MatrixXd& k ) const;
+
+        void diagonal( const Eigen::MatrixXd& a, Eigen::VectorXd& d ) const;
+
+        double self_covariance() const;
+
+    private:
+        double alpha_;
+        double signal_variance_;
+        double data_variance_;
+        double factor_;
+};
+
 } // namespace snark{
 
 #endif // #ifndef SNARK_GAUSSIAN_PROCESS_COVARIANCE_
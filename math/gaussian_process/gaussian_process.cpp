@@ -28,7 +28,9 @@
 // IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
+#include <algorithm>
 #include <boost/noncopyable.hpp>
+#include <tbb/parallel_for.h>
 #include <comma/base/exception.h>
 #include <snark/math/gaussian_process/gaussian_process.h>
 
@@ -40,25 +42,30 @@ gaussian_process::gaussian_process( const Eigen::MatrixXd& domains
                                 , double self_covariance )
     : domains_( domains )
     , targets_( targets )
-    , covariance_( covariance )
+    , kernel_( new pairwise_covariance( covariance, self_covariance ) )
     , self_covariance_( self_covariance )
-    , offset_( targets.sum() / targets.rows() )
-    , K_( domains.rows(), domains.rows() )
 {
-    if( domains.rows() != targets.rows() ) { COMMA_THROW( comma::exception, "expected " << domains.rows() << " row(s) in targets, got " << targets.rows() << " row(s)" ); }
+    init_();
+}
+
+gaussian_process::gaussian_process( const Eigen::MatrixXd& domains
+                                , const Eigen::VectorXd& targets
+                                , const boost::shared_ptr< const covariance_kernel >& kernel )
+    : domains_( domains )
+    , targets_( targets )
+    , kernel_( kernel )
+    , self_covariance_( kernel->self_covariance() )
+{
+    init_();
+}
+
+void gaussian_process::init_()
+{
+    if( domains_.rows() != targets_.rows() ) { COMMA_THROW( comma::exception, "expected " << domains_.rows() << " row(s) in targets, got " << targets_.rows() << " row(s)" ); }
+    offset_ = targets_.sum() / targets_.rows();
     targets_.array() -= offset_; // normalise
-    //use m_K as Kxx + variance*I, then invert it
-    //fill Kxx with values from covariance function
-    //for elements r,c in upper triangle
-    for( std::size_t r = 0; r < std::size_t( domains.rows() ); ++r )
-    {
-        K_( r, r ) = self_covariance_;
-        const Eigen::VectorXd& row = domains.row( r );
-        for( std::size_t c = r + 1; c < std::size_t( domains.rows() ); ++c )
-        {
-            K_( c, r ) = K_( r, c ) = covariance_( row, domains.row( c ) );
-        }
-    }
+    kernel_->covariances( domains_, domains_, K_ ); // Kxx
+    K_.diagonal().setConstant( self_covariance_ ); // Kxx + variance * I
     L_.compute( K_ ); // invert Kxx + variance * I to become (by definition) B
     alpha_ = L_.solve( targets_ );
 }
@@ -72,30 +79,43 @@ std::pair< double, double > gaussian_process::evaluate( const Eigen::MatrixXd& d
     return std::make_pair( means( 0 ), variances( 0 ) );
 }
 
-void gaussian_process::evaluate( const Eigen::MatrixXd& domains, Eigen::VectorXd& means, Eigen::VectorXd& variances ) const
+class gaussian_process::evaluate_tiles_
 {
-    if( domains.cols() != domains_.cols() ) { COMMA_THROW( comma::exception, "expected " << domains_.cols() << " column(s) in domains, got " << domains.cols() << std::endl ); }
-    Eigen::MatrixXd Kxsx = Eigen::MatrixXd::Zero( domains.rows(), domains_.rows() );
-    for( std::size_t r = 0; r < std::size_t( domains.rows() ); ++r )
-    {
-        const Eigen::VectorXd& row = domains.row( r );
-        for( std::size_t c = 0; c < std::size_t( domains_.rows() ); ++c )
+    public:
+        evaluate_tiles_( const gaussian_process& p, const Eigen::MatrixXd& domains, Eigen::VectorXd& means, Eigen::VectorXd& variances, std::size_t tile_size )
+            : p_( p ), domains_( domains ), means_( means ), variances_( variances ), tile_size_( tile_size ) {}
+
+        void operator()( const tbb::blocked_range< std::size_t >& r ) const
         {
-            Kxsx( r, c ) = covariance_( row, domains_.row( c ) );
+            Eigen::MatrixXd Kxxs;
+            for( std::size_t t = r.begin(); t < r.end(); ++t )
+            {
+                std::size_t begin = t * tile_size_;
+                std::size_t size = std::min( std::size_t( domains_.rows() ), begin + tile_size_ ) - begin;
+                p_.kernel_->covariances( p_.domains_, domains_.middleRows( begin, size ), Kxxs );
+                means_.segment( begin, size ).noalias() = Kxxs.transpose() * p_.alpha_;
+                p_.L_.matrixL().solveInPlace( Kxxs );
+                variances_.segment( begin, size ) = ( -Kxxs.colwise().squaredNorm().transpose() ).array() + p_.self_covariance_;
+            }
         }
-    }
-    means = Kxsx * alpha_;
+
+    private:
+        const gaussian_process& p_;
+        const Eigen::MatrixXd& domains_;
+        Eigen::VectorXd& means_;
+        Eigen::VectorXd& variances_;
+        std::size_t tile_size_;
+};
+
+void gaussian_process::evaluate( const Eigen::MatrixXd& domains, Eigen::VectorXd& means, Eigen::VectorXd& variances, std::size_t tile_size ) const
+{
+    if( domains.cols() != domains_.cols() ) { COMMA_THROW( comma::exception, "expected " << domains_.cols() << " column(s) in domains, got " << domains.cols() << std::endl ); }
+    if( tile_size == 0 ) { COMMA_THROW( comma::exception, "expected positive tile size" ); }
+    means.resize( domains.rows() );
+    variances.resize( domains.rows() );
+    std::size_t tiles = ( domains.rows() + tile_size - 1 ) / tile_size;
+    tbb::parallel_for( tbb::blocked_range< std::size_t >( 0, tiles, 1 ), evaluate_tiles_( *this, domains, means, variances, tile_size ) );
     means.array() += offset_;
-    Eigen::MatrixXd Kxxs = Kxsx.transpose();
-    L_.matrixL().solveInPlace( Kxxs );
-    Eigen::MatrixXd& variance = Kxxs;
-    variance = variance.array() * variance.array();
-    variances = variance.colwise().sum();
-    // for each diagonal variance, set v(r) = -v(r,r) + Kxsxs
-    for( std::size_t r = 0; r < std::size_t( domains.rows() ); ++r )
-    {
-        variances( r ) = -variances( r ) + self_covariance_;
-    }
 }
 
 }  // namespace snark{ 
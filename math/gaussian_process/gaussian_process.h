@@ -32,8 +32,10 @@
 #define SNARK_GAUSSIAN_PROCESS_
 
 #include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
 #include <Eigen/Core>
 #include <Eigen/Eigen>
+#include <snark/math/gaussian_process/covariance.h>
 
 namespace snark{ 
 
@@ -50,10 +52,17 @@ class gaussian_process
                        , const gaussian_process::covariance& covariance
                        , double self_covariance = 0 );
 
-        /// evaluate
+        /// constructor, covariances computed in blocks by kernel
+        gaussian_process( const Eigen::MatrixXd& domains
+                       , const Eigen::VectorXd& targets
+                       , const boost::shared_ptr< const covariance_kernel >& kernel );
+
+        /// evaluate in tiles of given number of domains, tiles evaluated in parallel
+        /// memory: O( n * tile_size ) per thread for n training domains
         void evaluate( const Eigen::MatrixXd& domains
                      , Eigen::VectorXd& means
-                     , Eigen::VectorXd& variances ) const;
+                     , Eigen::VectorXd& variances
+                     , std::size_t tile_size = 256 ) const;
 
         /// evaluate a single domain, return mean-variance pair
         std::pair< double, double > evaluate( const Eigen::MatrixXd& domain ) const;
@@ -61,12 +70,14 @@ class gaussian_process
     private:
         Eigen::MatrixXd domains_; //!< domain locations corresponding to targets
         Eigen::VectorXd targets_; //!< targets
-        covariance covariance_;
+        boost::shared_ptr< const covariance_kernel > kernel_;
         double self_covariance_;
         double offset_;
         Eigen::MatrixXd K_; //!< the inverse of (Kxx + noiseVariance*I)
         Eigen::LLT< Eigen::MatrixXd  > L_; //!< cholesky factorization of the covariance Kxx
         Eigen::VectorXd alpha_;
+        class evaluate_tiles_;
+        void init_();
 };
 
 } // namespace snark{
@@ -0,0 +1,214 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <cmath>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int.hpp>
+#include <comma/base/exception.h>
+#include <tbb/parallel_for.h>
+#include <snark/math/gaussian_process/sparse_gaussian_process.h>
+
+namespace snark{ 
+
+static const std::size_t batch_size = 1024; // rows of training or query domains processed at once, to bound memory
+
+Eigen::MatrixXd sparse_gaussian_process::select( const Eigen::MatrixXd& domains, unsigned int size, sparse_gaussian_process::selection method, unsigned int iterations, unsigned int seed )
+{
+    std::size_t n = domains.rows();
+    if( size == 0 ) { COMMA_THROW( comma::exception, "expected positive number of inducing points" ); }
+    if( size >= n ) { return domains; }
+    Eigen::MatrixXd points( size, domains.cols() );
+    if( method == random || method == k_means )
+    {
+        std::vector< std::size_t > indices( n );
+        for( std::size_t i = 0; i < n; ++i ) { indices[i] = i; }
+        boost::mt19937 generator( seed );
+        for( unsigned int i = 0; i < size; ++i ) // partial fisher-yates shuffle
+        {
+            boost::uniform_int< std::size_t > distribution( i, n - 1 );
+            std::swap( indices[i], indices[ distribution( generator ) ] );
+            points.row( i ) = domains.row( indices[i] );
+        }
+        if( method == random ) { return points; }
+    }
+    else
+    {
+        for( unsigned int i = 0; i < size; ++i ) { points.row( i ) = domains.row( ( std::size_t( i ) * n ) / size ); }
+        return points;
+    }
+    std::vector< unsigned int > clusters( n, 0 );
+    for( unsigned int iteration = 0; iteration < iterations; ++iteration )
+    {
+        bool changed = false;
+        Eigen::VectorXd norms = points.rowwise().squaredNorm();
+        for( std::size_t begin = 0; begin < n; begin += batch_size )
+        {
+            std::size_t end = std::min( n, begin + batch_size );
+            Eigen::MatrixXd distances = ( -2 * points * domains.middleRows( begin, end - begin ).transpose() ).colwise() + norms; // squared distances up to squared norm of domain
+            for( std::size_t j = begin; j < end; ++j )
+            {
+                Eigen::MatrixXd::Index nearest;
+                distances.col( j - begin ).minCoeff( &nearest );
+                if( iteration > 0 && clusters[j] == unsigned( nearest ) ) { continue; }
+                clusters[j] = nearest;
+                changed = true;
+            }
+        }
+        if( !changed ) { break; }
+        Eigen::MatrixXd sums = Eigen::MatrixXd::Zero( size, domains.cols() );
+        std::vector< std::size_t > counts( size, 0 );
+        for( std::size_t j = 0; j < n; ++j ) { sums.row( clusters[j] ) += domains.row( j ); ++counts[ clusters[j] ]; }
+        for( unsigned int i = 0; i < size; ++i ) { if( counts[i] > 0 ) { points.row( i ) = sums.row( i ) / counts[i]; } } // empty cluster keeps its centroid
+    }
+    return points;
+}
+
+sparse_gaussian_process::sparse_gaussian_process( const Eigen::MatrixXd& domains
+                                                , const Eigen::VectorXd& targets
+                                                , const Eigen::MatrixXd& inducing_points
+                                                , const sparse_gaussian_process::covariance& covariance
+                                                , double self_covariance
+                                                , sparse_gaussian_process::approximation a )
+    : inducing_points_( inducing_points )
+    , kernel_( new pairwise_covariance( covariance, self_covariance ) )
+    , self_covariance_( self_covariance )
+    , approximation_( a )
+{
+    init_( domains, targets );
+}
+
+sparse_gaussian_process::sparse_gaussian_process( const Eigen::MatrixXd& domains
+                                                , const Eigen::VectorXd& targets
+                                                , const Eigen::MatrixXd& inducing_points
+                                                , const boost::shared_ptr< const covariance_kernel >& kernel
+                                                , sparse_gaussian_process::approximation a )
+    : inducing_points_( inducing_points )
+    , kernel_( kernel )
+    , self_covariance_( kernel->self_covariance() )
+    , approximation_( a )
+{
+    init_( domains, targets );
+}
+
+void sparse_gaussian_process::init_( const Eigen::MatrixXd& domains, const Eigen::VectorXd& targets )
+{
+    if( domains.rows() != targets.rows() ) { COMMA_THROW( comma::exception, "expected " << domains.rows() << " row(s) in targets, got " << targets.rows() << " row(s)" ); }
+    if( inducing_points_.rows() == 0 ) { COMMA_THROW( comma::exception, "expected at least one inducing point" ); }
+    if( inducing_points_.cols() != domains.cols() ) { COMMA_THROW( comma::exception, "expected " << domains.cols() << " column(s) in inducing points, got " << inducing_points_.cols() ); }
+    offset_ = targets.sum() / targets.rows();
+    std::size_t m = inducing_points_.rows();
+    Eigen::MatrixXd Kuu;
+    kernel_->covariances( inducing_points_, inducing_points_, Kuu );
+    Kuu.diagonal().array() += 1e-10 * Kuu.diagonal().maxCoeff(); // jitter: inducing points may be close to each other
+    L_.compute( Kuu );
+    if( L_.info() != Eigen::Success ) { COMMA_THROW( comma::exception, "covariance of inducing points is not positive definite; duplicate inducing points?" ); }
+    Eigen::MatrixXd A = Eigen::MatrixXd::Identity( m, m );
+    Eigen::VectorXd b = Eigen::VectorXd::Zero( m );
+    Eigen::MatrixXd V;
+    Eigen::VectorXd self;
+    for( std::size_t begin = 0; begin < std::size_t( domains.rows() ); begin += batch_size )
+    {
+        std::size_t end = std::min( std::size_t( domains.rows() ), begin + batch_size );
+        covariances_( domains, begin, end, V, self );
+        L_.matrixL().solveInPlace( V );
+        for( std::size_t j = 0; j < end - begin; ++j )
+        {
+            double data_variance = self_covariance_ - self( j );
+            double lambda = approximation_ == fitc ? self( j ) - V.col( j ).squaredNorm() + data_variance : data_variance;
+            if( !( lambda > 0 ) ) { COMMA_THROW( comma::exception, "expected self covariance greater than covariance of domain with itself, i.e. positive data variance; got: " << self_covariance_ << " and " << self( j ) ); }
+            double s = 1 / std::sqrt( lambda );
+            V.col( j ) *= s;
+            b += V.col( j ) * ( ( targets( begin + j ) - offset_ ) * s );
+        }
+        A.selfadjointView< Eigen::Lower >().rankUpdate( V );
+    }
+    A_.compute( A.selfadjointView< Eigen::Lower >() );
+    alpha_ = A_.solve( b );
+    L_.matrixU().solveInPlace( alpha_ );
+}
+
+void sparse_gaussian_process::covariances_( const Eigen::MatrixXd& domains, std::size_t begin, std::size_t end, Eigen::MatrixXd& k, Eigen::VectorXd& self ) const
+{
+    const Eigen::MatrixXd& batch = domains.middleRows( begin, end - begin );
+    kernel_->covariances( inducing_points_, batch, k );
+    kernel_->diagonal( batch, self );
+}
+
+std::pair< double, double > sparse_gaussian_process::evaluate( const Eigen::MatrixXd& domain ) const
+{
+    if( domain.rows() != 1 ) { COMMA_THROW( comma::exception, "expected 1 row in domain, got " << domain.rows() << " rows" ); }
+    Eigen::VectorXd means( 1 );
+    Eigen::VectorXd variances( 1 );
+    evaluate( domain, means, variances );
+    return std::make_pair( means( 0 ), variances( 0 ) );
+}
+
+class sparse_gaussian_process::evaluate_batches_
+{
+    public:
+        evaluate_batches_( const sparse_gaussian_process& p, const Eigen::MatrixXd& domains, Eigen::VectorXd& means, Eigen::VectorXd& variances )
+            : p_( p ), domains_( domains ), means_( means ), variances_( variances ) {}
+
+        void operator()( const tbb::blocked_range< std::size_t >& r ) const
+        {
+            Eigen::MatrixXd Kus;
+            Eigen::VectorXd self;
+            for( std::size_t t = r.begin(); t < r.end(); ++t )
+            {
+                std::size_t begin = t * batch_size;
+                std::size_t end = std::min( std::size_t( domains_.rows() ), begin + batch_size );
+                p_.covariances_( domains_, begin, end, Kus, self );
+                means_.segment( begin, end - begin ).noalias() = Kus.transpose() * p_.alpha_;
+                p_.L_.matrixL().solveInPlace( Kus );
+                Eigen::VectorXd q = Kus.colwise().squaredNorm(); // prior covariance through inducing points
+                p_.A_.matrixL().solveInPlace( Kus );
+                Eigen::VectorXd s = Kus.colwise().squaredNorm();
+                for( std::size_t j = 0; j < end - begin; ++j ) { variances_( begin + j ) = ( p_.approximation_ == fitc ? p_.self_covariance_ - q( j ) : p_.self_covariance_ - self( j ) ) + s( j ); }
+            }
+        }
+
+    private:
+        const sparse_gaussian_process& p_;
+        const Eigen::MatrixXd& domains_;
+        Eigen::VectorXd& means_;
+        Eigen::VectorXd& variances_;
+};
+
+void sparse_gaussian_process::evaluate( const Eigen::MatrixXd& domains, Eigen::VectorXd& means, Eigen::VectorXd& variances ) const
+{
+    if( domains.cols() != inducing_points_.cols() ) { COMMA_THROW( comma::exception, "expected " << inducing_points_.cols() << " column(s) in domains, got " << domains.cols() << std::endl ); }
+    means.resize( domains.rows() );
+    variances.resize( domains.rows() );
+    std::size_t batches = ( domains.rows() + batch_size - 1 ) / batch_size;
+    tbb::parallel_for( tbb::blocked_range< std::size_t >( 0, batches, 1 ), evaluate_batches_( *this, domains, means, variances ) );
+    means.array() += offset_;
+}
+
+}  // namespace snark{
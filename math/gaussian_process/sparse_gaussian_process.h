@@ -0,0 +1,116 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SNARK_SPARSE_GAUSSIAN_PROCESS_
+#define SNARK_SPARSE_GAUSSIAN_PROCESS_
+
+#include <boost/shared_ptr.hpp>
+#include <Eigen/Core>
+#include <Eigen/Eigen>
+#include <snark/math/gaussian_process/gaussian_process.h>
+
+namespace snark{ 
+
+/// gaussian process approximated through m inducing points: O(n m^2) time and O(n + m^2) memory for n training points
+///
+/// subset of regressors: degenerate gaussian process with covariance through inducing points;
+///                       predictive variances shrink to data variance away from inducing points
+/// fitc: fully independent training conditional: as subset of regressors, but with exact prior
+///       variances of training points and predictions, thus sensible predictive variances
+///
+/// with training points as inducing points, fitc is the same as gaussian_process, subset of
+/// regressors has the same means, but smaller variances away from training points; see e.g.
+/// Quinonero-Candela, Rasmussen: A unifying view of sparse approximate gaussian process regression, 2005
+class sparse_gaussian_process
+{
+    public:
+        /// covariance functor type
+        typedef gaussian_process::covariance covariance;
+
+        /// approximation
+        enum approximation { subset_of_regressors, fitc };
+
+        /// inducing point selection
+        /// stride: every (n/m)-th domain
+        /// random: random domains
+        /// k_means: centroids of k-means clustering of domains, starting from random selection
+        enum selection { stride, random, k_means };
+
+        /// select given number of inducing points from domains
+        static Eigen::MatrixXd select( const Eigen::MatrixXd& domains
+                                     , unsigned int size
+                                     , selection method = k_means
+                                     , unsigned int iterations = 10
+                                     , unsigned int seed = 0 );
+
+        /// constructor
+        /// @param self_covariance as in gaussian_process: covariance of domain with itself plus data variance
+        sparse_gaussian_process( const Eigen::MatrixXd& domains
+                               , const Eigen::VectorXd& targets
+                               , const Eigen::MatrixXd& inducing_points
+                               , const sparse_gaussian_process::covariance& covariance
+                               , double self_covariance
+                               , approximation a = fitc );
+
+        /// constructor, covariances computed in blocks by kernel
+        sparse_gaussian_process( const Eigen::MatrixXd& domains
+                               , const Eigen::VectorXd& targets
+                               , const Eigen::MatrixXd& inducing_points
+                               , const boost::shared_ptr< const covariance_kernel >& kernel
+                               , approximation a = fitc );
+
+        /// evaluate, queries are evaluated in batches of bounded size in parallel
+        void evaluate( const Eigen::MatrixXd& domains
+                     , Eigen::VectorXd& means
+                     , Eigen::VectorXd& variances ) const;
+
+        /// evaluate a single domain, return mean-variance pair
+        std::pair< double, double > evaluate( const Eigen::MatrixXd& domain ) const;
+
+        /// return inducing points
+        const Eigen::MatrixXd& inducing_points() const { return inducing_points_; }
+
+    private:
+        Eigen::MatrixXd inducing_points_;
+        boost::shared_ptr< const covariance_kernel > kernel_;
+        double self_covariance_;
+        approximation approximation_;
+        double offset_;
+        Eigen::LLT< Eigen::MatrixXd > L_; //!< cholesky factorization of covariance of inducing points Kuu
+        Eigen::LLT< Eigen::MatrixXd > A_; //!< cholesky factorization of I + V * inverse( Lambda ) * V', V = inverse( L ) * Kuf
+        Eigen::VectorXd alpha_;
+
+        class evaluate_batches_;
+        void init_( const Eigen::MatrixXd& domains, const Eigen::VectorXd& targets );
+        void covariances_( const Eigen::MatrixXd& domains, std::size_t begin, std::size_t end, Eigen::MatrixXd& k, Eigen::VectorXd& self ) const;
+};
+
+} // namespace snark{
+
+#endif // #ifndef SNARK_SPARSE_GAUSSIAN_PROCESS_
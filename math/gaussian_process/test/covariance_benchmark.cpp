@@ -0,0 +1,70 @@
+/// time covariances computed pairwise through functor and in blocks through kernel,
+/// exact gaussian process built with either and its tiled evaluation on 1 to 8 threads
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+#include <tbb/task_scheduler_init.h>
+#include <snark/math/gaussian_process/covariance.h>
+#include <snark/math/gaussian_process/gaussian_process.h>
+
+static double seconds_since( const boost::posix_time::ptime& start ) { return double( ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() ) / 1e6; }
+
+static void make_points( unsigned int size, Eigen::MatrixXd& domains, Eigen::VectorXd& targets )
+{
+    domains.resize( size, 2 );
+    targets.resize( size );
+    for( unsigned int i = 0; i < size; ++i )
+    {
+        domains( i, 0 ) = 40.0 * std::rand() / RAND_MAX;
+        domains( i, 1 ) = 40.0 * std::rand() / RAND_MAX;
+        targets( i ) = 2 * std::sin( domains( i, 0 ) / 7 ) + std::cos( domains( i, 1 ) / 5 );
+    }
+}
+
+int main( int argc, char** argv )
+{
+    unsigned int size = argc > 1 ? boost::lexical_cast< unsigned int >( argv[1] ) : 3000;
+    unsigned int queries = argc > 2 ? boost::lexical_cast< unsigned int >( argv[2] ) : 20000;
+    std::cerr << "usage: gaussian-process-covariance-benchmark [<number of training points>] [<number of queries>]; running with " << size << " training points, " << queries << " queries" << std::endl;
+    std::srand( 1 );
+    Eigen::MatrixXd domains;
+    Eigen::VectorXd targets;
+    make_points( size, domains, targets );
+    Eigen::MatrixXd query_domains;
+    Eigen::VectorXd truth;
+    make_points( queries, query_domains, truth );
+    snark::squared_exponential_covariance covariance( 16.0, 1.0, 0.01 );
+    Eigen::MatrixXd k;
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    snark::pairwise_covariance( boost::bind( &snark::squared_exponential_covariance::covariance, boost::ref( covariance ), _1, _2 ), covariance.self_covariance() ).covariances( domains, query_domains, k );
+    std::cout << "covariances: pairwise: " << seconds_since( start ) << " seconds";
+    start = boost::posix_time::microsec_clock::universal_time();
+    covariance.covariances( domains, query_domains, k );
+    std::cout << "; blocks: " << seconds_since( start ) << " seconds" << std::endl;
+    Eigen::VectorXd means;
+    Eigen::VectorXd variances;
+    start = boost::posix_time::microsec_clock::universal_time();
+    snark::gaussian_process pairwise( domains, targets, boost::bind( &snark::squared_exponential_covariance::covariance, boost::ref( covariance ), _1, _2 ), covariance.self_covariance() );
+    double build = seconds_since( start );
+    start = boost::posix_time::microsec_clock::universal_time();
+    pairwise.evaluate( query_domains, means, variances );
+    std::cout << "pairwise: build: " << build << " seconds; evaluate: " << seconds_since( start ) << " seconds" << std::endl;
+    start = boost::posix_time::microsec_clock::universal_time();
+    snark::gaussian_process blocks( domains, targets, boost::shared_ptr< const snark::covariance_kernel >( new snark::squared_exponential_covariance( covariance ) ) );
+    build = seconds_since( start );
+    Eigen::VectorXd block_means;
+    Eigen::VectorXd block_variances;
+    for( unsigned int threads = 1; threads <= 8; threads *= 2 )
+    {
+        tbb::task_scheduler_init init( threads );
+        start = boost::posix_time::microsec_clock::universal_time();
+        blocks.evaluate( query_domains, block_means, block_variances );
+        std::cout << "blocks: build: " << build << " seconds; evaluate: " << threads << " thread(s): " << seconds_since( start ) << " seconds; max difference from pairwise: " << ( block_means - means ).cwiseAbs().maxCoeff() << std::endl;
+    }
+    return 0;
+}
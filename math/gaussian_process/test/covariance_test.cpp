@@ -0,0 +1,95 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cmath>
+#include <gtest/gtest.h>
+#include <boost/bind.hpp>
+#include <Eigen/Core>
+#include <comma/base/exception.h>
+#include <snark/math/gaussian_process/covariance.h>
+
+template < typename K >
+static void expect_same_blocks( const K& kernel )
+{
+    Eigen::MatrixXd a = Eigen::MatrixXd::Random( 20, 3 ) * 5;
+    Eigen::MatrixXd b = Eigen::MatrixXd::Random( 30, 3 ) * 5;
+    b.row( 0 ) = a.row( 0 ); // zero distance
+    Eigen::MatrixXd k;
+    kernel.covariances( a, b, k );
+    ASSERT_EQ( 20, k.rows() );
+    ASSERT_EQ( 30, k.cols() );
+    snark::pairwise_covariance pairwise( boost::bind( &K::covariance, boost::cref( kernel ), _1, _2 ), kernel.self_covariance() );
+    Eigen::MatrixXd expected;
+    pairwise.covariances( a, b, expected );
+    for( int r = 0; r < k.rows(); ++r ) { for( int c = 0; c < k.cols(); ++c ) { EXPECT_NEAR( expected( r, c ), k( r, c ), 1e-10 ); } }
+    kernel.covariances( a, a, k );
+    pairwise.covariances( a, a, expected );
+    for( int r = 0; r < k.rows(); ++r ) { for( int c = 0; c < k.cols(); ++c ) { EXPECT_NEAR( expected( r, c ), k( r, c ), 1e-10 ); } }
+    Eigen::VectorXd d;
+    Eigen::VectorXd e;
+    kernel.diagonal( a, d );
+    pairwise.diagonal( a, e );
+    for( int r = 0; r < d.rows(); ++r ) { EXPECT_NEAR( e( r ), d( r ), 1e-10 ); }
+}
+
+TEST( covariance, squared_exponential )
+{
+    expect_same_blocks( snark::squared_exponential_covariance( 1.0, 3.0, 0.1 ) );
+    expect_same_blocks( snark::squared_exponential_covariance( 16.0, 0.5, 0.01 ) );
+    EXPECT_DOUBLE_EQ( 3.1, snark::squared_exponential_covariance( 1.0, 3.0, 0.1 ).self_covariance() );
+}
+
+TEST( covariance, matern )
+{
+    expect_same_blocks( snark::matern_covariance( 2.0, 1.5, 0.1, snark::matern_covariance::one_half ) );
+    expect_same_blocks( snark::matern_covariance( 2.0, 1.5, 0.1, snark::matern_covariance::three_halves ) );
+    expect_same_blocks( snark::matern_covariance( 2.0, 1.5, 0.1, snark::matern_covariance::five_halves ) );
+    Eigen::VectorXd v = Eigen::VectorXd::Zero( 2 );
+    Eigen::VectorXd w( 2 );
+    w << 3, 4; // distance 5
+    EXPECT_NEAR( 1.5 * std::exp( -2.5 ), snark::matern_covariance( 2.0, 1.5, 0.1, snark::matern_covariance::one_half ).covariance( v, w ), 1e-12 );
+    double s = std::sqrt( 3.0 ) * 2.5;
+    EXPECT_NEAR( 1.5 * ( 1 + s ) * std::exp( -s ), snark::matern_covariance( 2.0, 1.5, 0.1, snark::matern_covariance::three_halves ).covariance( v, w ), 1e-12 );
+    s = std::sqrt( 5.0 ) * 2.5;
+    EXPECT_NEAR( 1.5 * ( 1 + s + s * s / 3 ) * std::exp( -s ), snark::matern_covariance( 2.0, 1.5, 0.1, snark::matern_covariance::five_halves ).covariance( v, w ), 1e-12 );
+    EXPECT_DOUBLE_EQ( 1.6, snark::matern_covariance( 2.0, 1.5, 0.1 ).self_covariance() );
+    EXPECT_THROW( snark::matern_covariance( 0, 1.5, 0.1 ), comma::exception );
+}
+
+TEST( covariance, rational_quadratic )
+{
+    expect_same_blocks( snark::rational_quadratic_covariance( 2.0, 0.5, 1.5, 0.1 ) );
+    expect_same_blocks( snark::rational_quadratic_covariance( 2.0, 3.0, 1.5, 0.1 ) );
+    Eigen::VectorXd v = Eigen::VectorXd::Zero( 2 );
+    Eigen::VectorXd w( 2 );
+    w << 3, 4;
+    EXPECT_NEAR( 1.5 * std::pow( 1 + 25.0 / ( 2 * 3.0 * 4.0 ), -3.0 ), snark::rational_quadratic_covariance( 2.0, 3.0, 1.5, 0.1 ).covariance( v, w ), 1e-12 );
+    EXPECT_NEAR( 1.5 * std::exp( -25.0 / 8 ), snark::rational_quadratic_covariance( 2.0, 1e7, 1.5, 0.1 ).covariance( v, w ), 1e-5 ); // squared exponential as alpha goes to infinity
+    EXPECT_THROW( snark::rational_quadratic_covariance( 2.0, 0, 1.5, 0.1 ), comma::exception );
+}
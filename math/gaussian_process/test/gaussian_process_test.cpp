@@ -30,7 +30,9 @@
 
 #include <gtest/gtest.h>
 #include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
 #include <Eigen/Core>
+#include <tbb/task_scheduler_init.h>
 #include <snark/math/gaussian_process/covariance.h>
 #include <snark/math/gaussian_process/gaussian_process.h>
 
@@ -57,6 +59,13 @@ static void test_gaussian_process( const Eigen::MatrixXd& inputDomains
         EXPECT_NEAR( outputMeans(i), matlab_means[i], tolerance );
         EXPECT_NEAR( outputVariances(i), matlab_variances[i], tolerance );
     }
+    snark::gaussian_process blocks( inputDomains, inputTargets, boost::shared_ptr< const snark::covariance_kernel >( new snark::squared_exponential_covariance( 1.0, 3.0, 0.1 ) ) );
+    blocks.evaluate( outputDomains, outputMeans, outputVariances, 3 );
+    for( int i = 0; i < nTestPoints; ++i )
+    {
+        EXPECT_NEAR( outputMeans(i), matlab_means[i], tolerance );
+        EXPECT_NEAR( outputVariances(i), matlab_variances[i], tolerance );
+    }
 }
 
 // quick and dirty, just copied from qlib
@@ -217,3 +226,34 @@ int gaussian_processTest( int ac, char** av )
     ::testing::InitGoogleTest( &ac, av );
     return RUN_ALL_TESTS();
 }
+
+TEST( gaussian_process, tiles )
+{
+    Eigen::MatrixXd domains = Eigen::MatrixXd::Random( 300, 2 ) * 10;
+    Eigen::VectorXd targets( domains.rows() );
+    for( int i = 0; i < domains.rows(); ++i ) { targets( i ) = std::sin( domains( i, 0 ) ) + std::cos( domains( i, 1 ) ); }
+    Eigen::MatrixXd queries = Eigen::MatrixXd::Random( 1000, 2 ) * 10;
+    snark::gaussian_process gp( domains, targets, boost::shared_ptr< const snark::covariance_kernel >( new snark::matern_covariance( 2.0, 1.0, 0.1, snark::matern_covariance::five_halves ) ) );
+    Eigen::VectorXd means;
+    Eigen::VectorXd variances;
+    gp.evaluate( queries, means, variances, queries.rows() );
+    for( unsigned int threads = 1; threads <= 4; threads *= 2 )
+    {
+        tbb::task_scheduler_init init( threads );
+        static const std::size_t tile_sizes[] = { 1, 7, 256, 5000 };
+        for( unsigned int i = 0; i < 4; ++i )
+        {
+            Eigen::VectorXd m;
+            Eigen::VectorXd v;
+            gp.evaluate( queries, m, v, tile_sizes[i] );
+            ASSERT_EQ( means.rows(), m.rows() );
+            for( int j = 0; j < means.rows(); ++j ) { EXPECT_NEAR( means( j ), m( j ), tolerance ); EXPECT_NEAR( variances( j ), v( j ), tolerance ); }
+        }
+    }
+    snark::matern_covariance covariance( 2.0, 1.0, 0.1, snark::matern_covariance::five_halves );
+    snark::gaussian_process pairwise( domains, targets, boost::bind( &snark::matern_covariance::covariance, boost::ref( covariance ), _1, _2 ), covariance.self_covariance() );
+    Eigen::VectorXd m;
+    Eigen::VectorXd v;
+    pairwise.evaluate( queries, m, v );
+    for( int j = 0; j < means.rows(); ++j ) { EXPECT_NEAR( means( j ), m( j ), 1e-8 ); EXPECT_NEAR( variances( j ), v( j ), 1e-8 ); }
+}
@@ -0,0 +1,77 @@
+/// time exact and sparse gaussian process on synthetic terrain of growing size and compare their accuracy
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/lexical_cast.hpp>
+#include <snark/math/gaussian_process/covariance.h>
+#include <snark/math/gaussian_process/gaussian_process.h>
+#include <snark/math/gaussian_process/sparse_gaussian_process.h>
+
+static double seconds_since( const boost::posix_time::ptime& start ) { return double( ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() ) / 1e6; }
+
+static double terrain( double x, double y ) { return 2 * std::sin( x / 7 ) + std::cos( y / 5 ) + 0.5 * std::sin( ( x + y ) / 3 ); }
+
+static void make_points( unsigned int size, double extent, Eigen::MatrixXd& domains, Eigen::VectorXd& targets, double noise )
+{
+    domains.resize( size, 2 );
+    targets.resize( size );
+    for( unsigned int i = 0; i < size; ++i )
+    {
+        domains( i, 0 ) = extent * std::rand() / RAND_MAX;
+        domains( i, 1 ) = extent * std::rand() / RAND_MAX;
+        targets( i ) = terrain( domains( i, 0 ), domains( i, 1 ) ) + noise * ( 2.0 * std::rand() / RAND_MAX - 1 );
+    }
+}
+
+static double rms( const Eigen::VectorXd& v ) { return std::sqrt( v.squaredNorm() / v.rows() ); }
+
+int main( int argc, char** argv )
+{
+    unsigned int inducing = argc > 1 ? boost::lexical_cast< unsigned int >( argv[1] ) : 400;
+    unsigned int max_exact = argc > 2 ? boost::lexical_cast< unsigned int >( argv[2] ) : 4000;
+    unsigned int queries = argc > 3 ? boost::lexical_cast< unsigned int >( argv[3] ) : 10000;
+    std::cerr << "usage: gaussian-process-sparse-benchmark [<number of inducing points>] [<max number of training points for exact gaussian process>] [<number of queries>]; running with " << inducing << " inducing points, exact up to " << max_exact << " training points, " << queries << " queries" << std::endl;
+    snark::squared_exponential_covariance covariance( 16.0, 1.0, 0.01 );
+    snark::gaussian_process::covariance f = boost::bind( &snark::squared_exponential_covariance::covariance, boost::ref( covariance ), _1, _2 );
+    std::srand( 1 );
+    unsigned int sizes[] = { 1000, 2000, 4000, 10000, 30000, 100000, 300000 };
+    for( unsigned int k = 0; k < sizeof( sizes ) / sizeof( sizes[0] ); ++k )
+    {
+        unsigned int size = sizes[k];
+        Eigen::MatrixXd domains;
+        Eigen::VectorXd targets;
+        make_points( size, 40, domains, targets, 0.1 ); // the same 40x40 metres terrain surveyed ever denser
+        Eigen::MatrixXd query_domains;
+        Eigen::VectorXd truth;
+        make_points( queries, 40, query_domains, truth, 0 );
+        Eigen::VectorXd means;
+        Eigen::VectorXd variances;
+        std::cout << size << " training points:";
+        if( size <= max_exact )
+        {
+            boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+            snark::gaussian_process gp( domains, targets, f, covariance.self_covariance() );
+            double build = seconds_since( start );
+            start = boost::posix_time::microsec_clock::universal_time();
+            gp.evaluate( query_domains, means, variances );
+            std::cout << " exact: build: " << build << " seconds; evaluate: " << seconds_since( start ) << " seconds; rms error: " << rms( means - truth ) << ";";
+        }
+        boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+        Eigen::MatrixXd inducing_points = snark::sparse_gaussian_process::select( domains, inducing );
+        double select = seconds_since( start );
+        start = boost::posix_time::microsec_clock::universal_time();
+        snark::sparse_gaussian_process sparse( domains, targets, inducing_points, f, covariance.self_covariance() );
+        double build = seconds_since( start );
+        Eigen::VectorXd sparse_means;
+        Eigen::VectorXd sparse_variances;
+        start = boost::posix_time::microsec_clock::universal_time();
+        sparse.evaluate( query_domains, sparse_means, sparse_variances );
+        std::cout << " fitc: select: " << select << " seconds; build: " << build << " seconds; evaluate: " << seconds_since( start ) << " seconds; rms error: " << rms( sparse_means - truth );
+        if( size <= max_exact ) { std::cout << "; rms difference from exact: " << rms( sparse_means - means ); }
+        std::cout << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,157 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cmath>
+#include <set>
+#include <gtest/gtest.h>
+#include <boost/bind.hpp>
+#include <Eigen/Core>
+#include <snark/math/gaussian_process/covariance.h>
+#include <snark/math/gaussian_process/gaussian_process.h>
+#include <snark/math/gaussian_process/sparse_gaussian_process.h>
+
+namespace snark {
+
+static void make_training_data( unsigned int size, double step, Eigen::MatrixXd& domains, Eigen::VectorXd& targets )
+{
+    domains.resize( size, 2 );
+    targets.resize( size );
+    for( unsigned int i = 0; i < size; ++i )
+    {
+        domains( i, 0 ) = step * ( i % 20 );
+        domains( i, 1 ) = step * ( i / 20 );
+        targets( i ) = std::sin( domains( i, 0 ) / 2 ) + std::cos( domains( i, 1 ) / 3 );
+    }
+}
+
+static Eigen::MatrixXd make_queries( unsigned int size, double extent )
+{
+    Eigen::MatrixXd queries( size, 2 );
+    for( unsigned int i = 0; i < size; ++i ) { queries( i, 0 ) = extent * ( ( i * 7 ) % size ) / size; queries( i, 1 ) = extent * ( ( i * 13 ) % size ) / size - 1; }
+    return queries;
+}
+
+TEST( sparse_gaussian_process, same_as_exact_with_training_points_as_inducing_points )
+{
+    Eigen::MatrixXd domains;
+    Eigen::VectorXd targets;
+    make_training_data( 100, 1, domains, targets );
+    Eigen::MatrixXd queries = make_queries( 50, 20 );
+    squared_exponential_covariance covariance( 1.0, 3.0, 0.1 );
+    gaussian_process::covariance f = boost::bind( &squared_exponential_covariance::covariance, boost::ref( covariance ), _1, _2 );
+    gaussian_process exact( domains, targets, f, covariance.self_covariance() );
+    Eigen::VectorXd means;
+    Eigen::VectorXd variances;
+    exact.evaluate( queries, means, variances );
+    for( unsigned int a = 0; a < 2; ++a )
+    {
+        sparse_gaussian_process sparse( domains, targets, domains, f, covariance.self_covariance(), sparse_gaussian_process::approximation( a ) );
+        Eigen::VectorXd sparse_means;
+        Eigen::VectorXd sparse_variances;
+        sparse.evaluate( queries, sparse_means, sparse_variances );
+        for( unsigned int i = 0; i < queries.rows(); ++i )
+        {
+            EXPECT_NEAR( means( i ), sparse_means( i ), 1e-6 );
+            if( a == sparse_gaussian_process::fitc ) { EXPECT_NEAR( variances( i ), sparse_variances( i ), 1e-6 ); }
+            else { EXPECT_LE( sparse_variances( i ), variances( i ) + 1e-6 ); }
+        }
+    }
+}
+
+TEST( sparse_gaussian_process, close_to_exact_with_fewer_inducing_points )
+{
+    Eigen::MatrixXd domains;
+    Eigen::VectorXd targets;
+    make_training_data( 800, 0.5, domains, targets ); // 20x40 grid of 0.5 metres
+    Eigen::MatrixXd queries = make_queries( 200, 9.5 );
+    queries.col( 1 ).array() += 1; // inside of the grid
+    squared_exponential_covariance covariance( 16.0, 1.0, 0.01 );
+    gaussian_process::covariance f = boost::bind( &squared_exponential_covariance::covariance, boost::ref( covariance ), _1, _2 );
+    gaussian_process exact( domains, targets, f, covariance.self_covariance() );
+    Eigen::VectorXd means;
+    Eigen::VectorXd variances;
+    exact.evaluate( queries, means, variances );
+    sparse_gaussian_process::selection selections[] = { sparse_gaussian_process::random, sparse_gaussian_process::k_means };
+    for( unsigned int s = 0; s < 2; ++s ) // stride selection would pick only every 4th column of the grid
+    {
+        Eigen::MatrixXd inducing_points = sparse_gaussian_process::select( domains, 200, selections[s] );
+        ASSERT_EQ( 200, inducing_points.rows() );
+        sparse_gaussian_process sparse( domains, targets, inducing_points, f, covariance.self_covariance() );
+        Eigen::VectorXd sparse_means;
+        Eigen::VectorXd sparse_variances;
+        sparse.evaluate( queries, sparse_means, sparse_variances );
+        for( unsigned int i = 0; i < queries.rows(); ++i )
+        {
+            EXPECT_NEAR( means( i ), sparse_means( i ), 0.01 );
+            EXPECT_NEAR( variances( i ), sparse_variances( i ), 0.01 );
+        }
+    }
+}
+
+TEST( sparse_gaussian_process, batches )
+{
+    Eigen::MatrixXd domains;
+    Eigen::VectorXd targets;
+    make_training_data( 3000, 0.3, domains, targets );
+    Eigen::MatrixXd queries = make_queries( 2500, 5 );
+    squared_exponential_covariance covariance( 1.0, 1.0, 0.05 );
+    gaussian_process::covariance f = boost::bind( &squared_exponential_covariance::covariance, boost::ref( covariance ), _1, _2 );
+    sparse_gaussian_process sparse( domains, targets, sparse_gaussian_process::select( domains, 50, sparse_gaussian_process::stride ), f, covariance.self_covariance() );
+    Eigen::VectorXd means;
+    Eigen::VectorXd variances;
+    sparse.evaluate( queries, means, variances );
+    for( unsigned int i = 0; i < queries.rows(); i += 97 )
+    {
+        std::pair< double, double > p = sparse.evaluate( queries.row( i ) );
+        EXPECT_NEAR( means( i ), p.first, 1e-12 );
+        EXPECT_NEAR( variances( i ), p.second, 1e-12 );
+    }
+}
+
+TEST( sparse_gaussian_process, select )
+{
+    Eigen::MatrixXd domains( 1000, 2 );
+    for( unsigned int i = 0; i < 1000; ++i ) { domains( i, 0 ) = ( i % 2 ) * 10 + 0.001 * ( i % 7 ); domains( i, 1 ) = ( i % 2 ) * 10 - 0.001 * ( i % 5 ); }
+    Eigen::MatrixXd stride = sparse_gaussian_process::select( domains, 10, sparse_gaussian_process::stride );
+    for( unsigned int i = 0; i < 10; ++i ) { EXPECT_EQ( domains.row( i * 100 ), stride.row( i ) ); }
+    Eigen::MatrixXd random = sparse_gaussian_process::select( domains, 500, sparse_gaussian_process::random );
+    std::set< std::pair< double, double > > distinct;
+    for( unsigned int i = 0; i < 500; ++i ) { distinct.insert( std::make_pair( random( i, 0 ), random( i, 1 ) ) ); }
+    EXPECT_EQ( 70u, distinct.size() ); // all 70 distinct domains are likely to be drawn
+    domains.col( 0 ).array() += Eigen::ArrayXd::LinSpaced( 1000, 0, 0.01 );
+    Eigen::MatrixXd centroids = sparse_gaussian_process::select( domains, 2, sparse_gaussian_process::k_means );
+    ASSERT_EQ( 2, centroids.rows() );
+    Eigen::MatrixXd::Index i;
+    centroids.col( 0 ).minCoeff( &i );
+    EXPECT_NEAR( domains.col( 0 ).mean() - 5, centroids( i, 0 ), 1e-3 );
+    EXPECT_NEAR( domains.col( 0 ).mean() + 5, centroids( 1 - i, 0 ), 1e-3 );
+    EXPECT_EQ( 1000, sparse_gaussian_process::select( domains, 2000 ).rows() );
+}
+
+} // namespace snark {
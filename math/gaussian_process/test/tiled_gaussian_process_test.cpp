@@ -0,0 +1,150 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cmath>
+#include <gtest/gtest.h>
+#include <boost/shared_ptr.hpp>
+#include <Eigen/Core>
+#include <comma/base/exception.h>
+#include <snark/math/gaussian_process/covariance.h>
+#include <snark/math/gaussian_process/gaussian_process.h>
+#include <snark/math/gaussian_process/tiled_gaussian_process.h>
+
+static double terrain( double x, double y ) { return 2 * std::sin( x / 7 ) + std::cos( y / 5 ); }
+
+static void make_grid( double step, double extent, Eigen::MatrixXd& domains, Eigen::VectorXd& targets )
+{
+    unsigned int size = extent / step;
+    domains.resize( size * size, 2 );
+    targets.resize( size * size );
+    for( unsigned int i = 0; i < size; ++i )
+    {
+        for( unsigned int j = 0; j < size; ++j )
+        {
+            domains( i * size + j, 0 ) = i * step;
+            domains( i * size + j, 1 ) = j * step;
+            targets( i * size + j ) = terrain( i * step, j * step );
+        }
+    }
+}
+
+static boost::shared_ptr< const snark::covariance_kernel > kernel() { return boost::shared_ptr< const snark::covariance_kernel >( new snark::squared_exponential_covariance( 16.0, 1.0, 0.01 ) ); }
+
+TEST( tiled_gaussian_process, one_tile_same_as_exact )
+{
+    Eigen::MatrixXd domains;
+    Eigen::VectorXd targets;
+    make_grid( 1, 20, domains, targets );
+    Eigen::MatrixXd queries = ( Eigen::MatrixXd::Random( 100, 2 ).array() + 1 ) * 9.5;
+    snark::gaussian_process exact( domains, targets, kernel() );
+    snark::tiled_gaussian_process tiled( domains, targets, kernel(), 100, 0 );
+    EXPECT_EQ( 1u, tiled.size() );
+    Eigen::VectorXd means;
+    Eigen::VectorXd variances;
+    Eigen::VectorXd tiled_means;
+    Eigen::VectorXd tiled_variances;
+    exact.evaluate( queries, means, variances );
+    tiled.evaluate( queries, tiled_means, tiled_variances );
+    for( int i = 0; i < queries.rows(); ++i ) { EXPECT_NEAR( means( i ), tiled_means( i ), 1e-10 ); EXPECT_NEAR( variances( i ), tiled_variances( i ), 1e-10 ); }
+}
+
+TEST( tiled_gaussian_process, close_to_exact )
+{
+    Eigen::MatrixXd domains;
+    Eigen::VectorXd targets;
+    make_grid( 1, 40, domains, targets );
+    Eigen::MatrixXd queries = ( Eigen::MatrixXd::Random( 500, 2 ).array() + 1 ) * 19.5;
+    snark::gaussian_process exact( domains, targets, kernel() );
+    snark::tiled_gaussian_process tiled( domains, targets, kernel(), 10, 4 );
+    EXPECT_EQ( 36u, tiled.size() ); // 4x4 tiles and their neighbours reached by margin
+    Eigen::VectorXd means;
+    Eigen::VectorXd variances;
+    Eigen::VectorXd tiled_means;
+    Eigen::VectorXd tiled_variances;
+    exact.evaluate( queries, means, variances );
+    tiled.evaluate( queries, tiled_means, tiled_variances );
+    for( int i = 0; i < queries.rows(); ++i ) { EXPECT_NEAR( means( i ), tiled_means( i ), 0.02 ); EXPECT_NEAR( variances( i ), tiled_variances( i ), 0.01 ); }
+}
+
+TEST( tiled_gaussian_process, continuous_across_tile_borders )
+{
+    Eigen::MatrixXd domains;
+    Eigen::VectorXd targets;
+    make_grid( 2, 40, domains, targets );
+    targets += Eigen::VectorXd::Random( targets.rows() ) * 0.1; // noisy, so that tiles disagree a bit
+    snark::tiled_gaussian_process tiled( domains, targets, kernel(), 10, 4 );
+    Eigen::MatrixXd queries( 2000, 2 );
+    for( int i = 0; i < queries.rows(); ++i ) { queries( i, 0 ) = 5 + i * 0.01; queries( i, 1 ) = 15 + i * 0.007; } // crossing borders in x and y
+    Eigen::VectorXd means;
+    Eigen::VectorXd variances;
+    tiled.evaluate( queries, means, variances );
+    for( int i = 1; i < queries.rows(); ++i ) { EXPECT_NEAR( means( i - 1 ), means( i ), 0.01 ); }
+}
+
+TEST( tiled_gaussian_process, cache )
+{
+    Eigen::MatrixXd domains;
+    Eigen::VectorXd targets;
+    make_grid( 1, 40, domains, targets );
+    snark::tiled_gaussian_process tiled( domains, targets, kernel(), 10, 2 );
+    EXPECT_EQ( 0u, tiled.fitted() );
+    Eigen::MatrixXd queries( 1, 2 );
+    queries << 5, 5;
+    Eigen::VectorXd means;
+    Eigen::VectorXd variances;
+    tiled.evaluate( queries, means, variances );
+    EXPECT_EQ( 1u, tiled.fitted() );
+    queries << 10, 5; // on border of two tiles
+    tiled.evaluate( queries, means, variances );
+    EXPECT_EQ( 2u, tiled.fitted() );
+    Eigen::VectorXd cached_means;
+    Eigen::VectorXd cached_variances;
+    tiled.evaluate( queries, cached_means, cached_variances );
+    EXPECT_EQ( 2u, tiled.fitted() );
+    EXPECT_EQ( means( 0 ), cached_means( 0 ) );
+    EXPECT_EQ( variances( 0 ), cached_variances( 0 ) );
+    tiled.clear();
+    EXPECT_EQ( 0u, tiled.fitted() );
+    tiled.evaluate( queries, cached_means, cached_variances );
+    EXPECT_DOUBLE_EQ( means( 0 ), cached_means( 0 ) );
+    queries << 100, 100; // no training domains
+    tiled.evaluate( queries, means, variances );
+    EXPECT_TRUE( std::isnan( means( 0 ) ) );
+    EXPECT_TRUE( std::isnan( variances( 0 ) ) );
+}
+
+TEST( tiled_gaussian_process, invalid )
+{
+    Eigen::MatrixXd domains;
+    Eigen::VectorXd targets;
+    make_grid( 1, 10, domains, targets );
+    EXPECT_THROW( snark::tiled_gaussian_process( domains, targets, kernel(), 0, 0 ), comma::exception );
+    EXPECT_THROW( snark::tiled_gaussian_process( domains, targets, kernel(), 5, 6 ), comma::exception );
+    EXPECT_THROW( snark::tiled_gaussian_process( domains.leftCols( 1 ), targets, kernel(), 5, 1 ), comma::exception );
+}
@@ -0,0 +1,178 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <comma/base/exception.h>
+#include <tbb/parallel_for.h>
+#include <snark/math/gaussian_process/tiled_gaussian_process.h>
+
+namespace snark{ 
+
+tiled_gaussian_process::tiled_gaussian_process( const Eigen::MatrixXd& domains
+                                              , const Eigen::VectorXd& targets
+                                              , const boost::shared_ptr< const covariance_kernel >& kernel
+                                              , double tile_size
+                                              , double margin )
+    : domains_( domains )
+    , targets_( targets )
+    , kernel_( kernel )
+    , tile_size_( tile_size )
+    , margin_( margin )
+{
+    if( domains.rows() != targets.rows() ) { COMMA_THROW( comma::exception, "expected " << domains.rows() << " row(s) in targets, got " << targets.rows() << " row(s)" ); }
+    if( domains.cols() < 2 ) { COMMA_THROW( comma::exception, "expected at least 2 columns in domains, got " << domains.cols() ); }
+    if( !( tile_size > 0 ) ) { COMMA_THROW( comma::exception, "expected positive tile size, got " << tile_size ); }
+    if( margin < 0 || margin > tile_size ) { COMMA_THROW( comma::exception, "expected margin between 0 and tile size " << tile_size << ", got " << margin ); }
+    for( std::size_t i = 0; i < std::size_t( domains.rows() ); ++i )
+    {
+        double x = domains( i, 0 );
+        double y = domains( i, 1 );
+        index_type begin = {{ int( std::floor( ( x - margin ) / tile_size ) ), int( std::floor( ( y - margin ) / tile_size ) ) }};
+        index_type end = {{ int( std::floor( ( x + margin ) / tile_size ) ), int( std::floor( ( y + margin ) / tile_size ) ) }};
+        index_type t;
+        for( t[0] = begin[0]; t[0] <= end[0]; ++t[0] ) { for( t[1] = begin[1]; t[1] <= end[1]; ++t[1] ) { tiles_[t].indices.push_back( i ); } }
+    }
+}
+
+tiled_gaussian_process::index_type tiled_gaussian_process::index_of( const Eigen::VectorXd& domain ) const
+{
+    index_type i = {{ int( std::floor( domain( 0 ) / tile_size_ ) ), int( std::floor( domain( 1 ) / tile_size_ ) ) }};
+    return i;
+}
+
+std::size_t tiled_gaussian_process::fitted() const
+{
+    std::size_t size = 0;
+    for( tiles_type::const_iterator it = tiles_.begin(); it != tiles_.end(); ++it ) { if( it->second.process ) { ++size; } }
+    return size;
+}
+
+void tiled_gaussian_process::clear() { for( tiles_type::iterator it = tiles_.begin(); it != tiles_.end(); ++it ) { it->second.process.reset(); } }
+
+double tiled_gaussian_process::weight_( double d ) const // d: signed distance from the nearest tile border, positive inside the tile
+{
+    double h = margin_ / 2;
+    if( h == 0 ) { return d > 0 ? 1 : d < 0 ? 0 : 0.5; }
+    return std::max( 0.0, std::min( 1.0, 0.5 + d / ( 2 * h ) ) ); // linear ramp from 0 at -h to 1 at h; weights of adjacent tiles add up to 1
+}
+
+/// queries of one tile
+struct tiled_gaussian_process::job_
+{
+    job_() : t( NULL ) {}
+    tiled_gaussian_process::tile* t;
+    std::vector< std::size_t > queries;
+    std::vector< double > weights;
+    Eigen::VectorXd means;
+    Eigen::VectorXd variances;
+};
+
+class tiled_gaussian_process::evaluate_tiles_
+{
+    public:
+        evaluate_tiles_( const tiled_gaussian_process& p, const Eigen::MatrixXd& domains, std::vector< job_ >& jobs ) : p_( p ), domains_( domains ), jobs_( jobs ) {}
+
+        void operator()( const tbb::blocked_range< std::size_t >& r ) const
+        {
+            for( std::size_t j = r.begin(); j < r.end(); ++j )
+            {
+                job_& b = jobs_[j];
+                tile& t = *b.t;
+                if( !t.process ) // each tile is in one job only, thus fitting it here is safe
+                {
+                    Eigen::MatrixXd domains( t.indices.size(), p_.domains_.cols() );
+                    Eigen::VectorXd targets( t.indices.size() );
+                    for( std::size_t i = 0; i < t.indices.size(); ++i ) { domains.row( i ) = p_.domains_.row( t.indices[i] ); targets( i ) = p_.targets_( t.indices[i] ); }
+                    t.process.reset( new gaussian_process( domains, targets, p_.kernel_ ) );
+                }
+                Eigen::MatrixXd queries( b.queries.size(), domains_.cols() );
+                for( std::size_t i = 0; i < b.queries.size(); ++i ) { queries.row( i ) = domains_.row( b.queries[i] ); }
+                t.process->evaluate( queries, b.means, b.variances );
+            }
+        }
+
+    private:
+        const tiled_gaussian_process& p_;
+        const Eigen::MatrixXd& domains_;
+        std::vector< job_ >& jobs_;
+};
+
+void tiled_gaussian_process::evaluate( const Eigen::MatrixXd& domains, Eigen::VectorXd& means, Eigen::VectorXd& variances )
+{
+    if( domains.cols() != domains_.cols() ) { COMMA_THROW( comma::exception, "expected " << domains_.cols() << " column(s) in domains, got " << domains.cols() ); }
+    std::vector< job_ > jobs;
+    std::map< index_type, std::size_t > indices;
+    for( std::size_t i = 0; i < std::size_t( domains.rows() ); ++i )
+    {
+        double x = domains( i, 0 );
+        double y = domains( i, 1 );
+        index_type c = {{ int( std::floor( x / tile_size_ ) ), int( std::floor( y / tile_size_ ) ) }};
+        index_type t;
+        for( t[0] = c[0] - 1; t[0] <= c[0] + 1; ++t[0] )
+        {
+            double wx = weight_( std::min( x - t[0] * tile_size_, ( t[0] + 1 ) * tile_size_ - x ) );
+            if( wx == 0 ) { continue; }
+            for( t[1] = c[1] - 1; t[1] <= c[1] + 1; ++t[1] )
+            {
+                double w = wx * weight_( std::min( y - t[1] * tile_size_, ( t[1] + 1 ) * tile_size_ - y ) );
+                if( w == 0 ) { continue; }
+                tiles_type::iterator it = tiles_.find( t );
+                if( it == tiles_.end() ) { continue; }
+                std::map< index_type, std::size_t >::const_iterator j = indices.find( t );
+                if( j == indices.end() ) { j = indices.insert( std::make_pair( t, jobs.size() ) ).first; jobs.push_back( job_() ); jobs.back().t = &it->second; }
+                jobs[ j->second ].queries.push_back( i );
+                jobs[ j->second ].weights.push_back( w );
+            }
+        }
+    }
+    tbb::parallel_for( tbb::blocked_range< std::size_t >( 0, jobs.size(), 1 ), evaluate_tiles_( *this, domains, jobs ) );
+    means = Eigen::VectorXd::Zero( domains.rows() );
+    variances = Eigen::VectorXd::Zero( domains.rows() );
+    Eigen::VectorXd weights = Eigen::VectorXd::Zero( domains.rows() );
+    for( std::size_t j = 0; j < jobs.size(); ++j )
+    {
+        const job_& b = jobs[j];
+        for( std::size_t i = 0; i < b.queries.size(); ++i )
+        {
+            means( b.queries[i] ) += b.weights[i] * b.means( i );
+            variances( b.queries[i] ) += b.weights[i] * b.variances( i );
+            weights( b.queries[i] ) += b.weights[i];
+        }
+    }
+    for( std::size_t i = 0; i < std::size_t( domains.rows() ); ++i ) // weights add up to less than 1, if some neighbour tiles have no training domains
+    {
+        if( weights( i ) == 0 ) { means( i ) = variances( i ) = std::numeric_limits< double >::quiet_NaN(); continue; }
+        means( i ) /= weights( i );
+        variances( i ) /= weights( i );
+    }
+}
+
+} // namespace snark{
@@ -0,0 +1,99 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SNARK_TILED_GAUSSIAN_PROCESS_
+#define SNARK_TILED_GAUSSIAN_PROCESS_
+
+#include <map>
+#include <vector>
+#include <boost/array.hpp>
+#include <boost/shared_ptr.hpp>
+#include <Eigen/Core>
+#include <snark/math/gaussian_process/gaussian_process.h>
+
+namespace snark{ 
+
+/// local gaussian processes on square tiles in the plane of the first two coordinates of domains, e.g. x,y of terrain survey:
+/// each tile is fitted as an independent gaussian process on training domains inside the tile extended by margin,
+/// queries within margin / 2 of a tile border are blended linearly between the adjacent tiles, so that the surface is continuous
+///
+/// tiles are fitted lazily, in parallel, on the first evaluation touching them and then cached,
+/// so that evaluating new queries on the same training data reuses fitted tiles
+class tiled_gaussian_process
+{
+    public:
+        typedef boost::array< int, 2 > index_type;
+
+        /// constructor
+        /// @param tile_size tile side length
+        /// @param margin training domains up to margin outside of a tile are used to fit it; 0 <= margin <= tile_size
+        tiled_gaussian_process( const Eigen::MatrixXd& domains
+                              , const Eigen::VectorXd& targets
+                              , const boost::shared_ptr< const covariance_kernel >& kernel
+                              , double tile_size
+                              , double margin );
+
+        /// evaluate; queries in tiles without training domains get nan mean and variance
+        void evaluate( const Eigen::MatrixXd& domains
+                     , Eigen::VectorXd& means
+                     , Eigen::VectorXd& variances );
+
+        /// return number of tiles with training domains
+        std::size_t size() const { return tiles_.size(); }
+
+        /// return number of fitted tiles in cache
+        std::size_t fitted() const;
+
+        /// drop fitted tiles from cache
+        void clear();
+
+        /// return tile index of domain
+        index_type index_of( const Eigen::VectorXd& domain ) const;
+
+    private:
+        struct tile
+        {
+            std::vector< std::size_t > indices; //!< training domains of tile
+            boost::shared_ptr< gaussian_process > process;
+        };
+        typedef std::map< index_type, tile > tiles_type;
+        Eigen::MatrixXd domains_;
+        Eigen::VectorXd targets_;
+        boost::shared_ptr< const covariance_kernel > kernel_;
+        double tile_size_;
+        double margin_;
+        tiles_type tiles_;
+        struct job_;
+        class evaluate_tiles_;
+        double weight_( double d ) const;
+};
+
+} // namespace snark{
+
+#endif // #ifndef SNARK_TILED_GAUSSIAN_PROCESS_
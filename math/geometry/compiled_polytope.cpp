@@ -0,0 +1,168 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cmath>
+#include <limits>
+#include <Eigen/LU>
+#include <comma/base/exception.h>
+#include "compiled_polytope.h"
+
+namespace snark { namespace geometry {
+
+static compiled_polytope::box_type infinite_box_()
+{
+    static const double infinity = std::numeric_limits< double >::infinity();
+    return compiled_polytope::box_type( Eigen::Vector3d::Constant( -infinity ), Eigen::Vector3d::Constant( infinity ) );
+}
+
+compiled_polytope::compiled_polytope() : bounding_box_( infinite_box_() ) {}
+
+compiled_polytope::compiled_polytope( const Eigen::MatrixXd& normals, const Eigen::VectorXd& offsets ) : bounding_box_( infinite_box_() ) { set_( normals, offsets ); }
+
+compiled_polytope::compiled_polytope( const Eigen::MatrixXd& normals, const Eigen::VectorXd& offsets, const box_type& bounding_box ) : bounding_box_( bounding_box ) { set_( normals, offsets ); }
+
+compiled_polytope::compiled_polytope( const convex_polytope& polytope ) : bounding_box_( infinite_box_() ) { set_( polytope.normals(), polytope.offsets() ); }
+
+void compiled_polytope::set_( const Eigen::MatrixXd& normals, const Eigen::VectorXd& offsets )
+{
+    if( normals.cols() != 3 ) { COMMA_THROW( comma::exception, "expected 3d polytope, got dimension " << normals.cols() ); }
+    if( normals.rows() != offsets.rows() ) { COMMA_THROW( comma::exception, "normals and offsets should be of same size, got " << normals.rows() << " and " << offsets.rows() ); }
+    x_.resize( normals.rows() );
+    y_.resize( normals.rows() );
+    z_.resize( normals.rows() );
+    offsets_.resize( normals.rows() );
+    for( unsigned int i = 0; i < normals.rows(); ++i )
+    {
+        x_[i] = normals( i, 0 );
+        y_[i] = normals( i, 1 );
+        z_[i] = normals( i, 2 );
+        offsets_[i] = offsets( i );
+    }
+}
+
+compiled_polytope compiled_polytope::box( const Eigen::Vector3d& position, const Eigen::Matrix3d& rotation, double front, double back, double right, double left, double top, double bottom )
+{
+    Eigen::Matrix< double, 3, 6 > faces; // centres of front, back, right, left, top, bottom faces in box frame
+    faces << front, -back, 0, 0, 0, 0,
+             0, 0, right, -left, 0, 0,
+             0, 0, 0, 0, -top, bottom;
+    Eigen::MatrixXd normals( 6, 3 );
+    Eigen::VectorXd offsets( 6 );
+    for( unsigned int i = 0; i < 6; ++i )
+    {
+        Eigen::Vector3d f = rotation * faces.col( i ) + position;
+        Eigen::Vector3d n = position - f;
+        normals.row( i ) = n.transpose();
+        offsets( i ) = f.dot( n );
+    }
+    if( front <= 0 || back <= 0 || right <= 0 || left <= 0 || top <= 0 || bottom <= 0 ) { return compiled_polytope( normals, offsets ); } // degenerate or unbounded
+    box_type bounding_box;
+    for( unsigned int i = 0; i < 8; ++i ) { bounding_box.extend( rotation * Eigen::Vector3d( i & 1 ? front : -back, i & 2 ? right : -left, i & 4 ? bottom : -top ) + position ); }
+    // pad to make sure that points on the faces are not rejected due to rounding
+    Eigen::Vector3d padding = Eigen::Vector3d::Constant( 1e-9 ) + ( bounding_box.min().cwiseAbs().cwiseMax( bounding_box.max().cwiseAbs() ) * 1e-12 );
+    return compiled_polytope( normals, offsets, box_type( bounding_box.min() - padding, bounding_box.max() + padding ) );
+}
+
+static bool feasible_( const Eigen::MatrixXd& normals, const Eigen::VectorXd& offsets, const Eigen::Vector3d& x, double epsilon )
+{
+    for( unsigned int i = 0; i < normals.rows(); ++i ) { if( normals.row( i ).dot( x ) < offsets( i ) - epsilon * ( 1 + std::abs( offsets( i ) ) ) ) { return false; } }
+    return true;
+}
+
+compiled_polytope::box_type compiled_polytope::bounds( const Eigen::MatrixXd& normals, const Eigen::VectorXd& offsets )
+{
+    if( normals.cols() != 3 ) { COMMA_THROW( comma::exception, "expected 3d polytope, got dimension " << normals.cols() ); }
+    if( normals.rows() != offsets.rows() ) { COMMA_THROW( comma::exception, "normals and offsets should be of same size, got " << normals.rows() << " and " << offsets.rows() ); }
+    static const double epsilon = 1e-9;
+    const unsigned int size = normals.rows();
+    if( size < 4 ) { return infinite_box_(); } // at least 4 faces are needed to bound a 3d polytope
+    // the polytope is unbounded, if there is a direction d with normals * d >= 0;
+    // if normals span 3d, the cone of such directions has extreme rays along cross products of pairs of normals
+    if( Eigen::FullPivLU< Eigen::MatrixXd >( normals ).rank() < 3 ) { return infinite_box_(); }
+    for( unsigned int i = 0; i < size; ++i )
+    {
+        for( unsigned int j = i + 1; j < size; ++j )
+        {
+            Eigen::Vector3d d = Eigen::Vector3d( normals.row( i ) ).cross( Eigen::Vector3d( normals.row( j ) ) );
+            double norm = d.norm();
+            if( norm < epsilon ) { continue; }
+            d /= norm;
+            bool positive = true;
+            bool negative = true;
+            for( unsigned int k = 0; k < size && ( positive || negative ); ++k )
+            {
+                double t = normals.row( k ).dot( d );
+                double tolerance = epsilon * normals.row( k ).norm();
+                positive = positive && t >= -tolerance;
+                negative = negative && t <= tolerance;
+            }
+            if( positive || negative ) { return infinite_box_(); }
+        }
+    }
+    box_type bounding_box; // empty
+    for( unsigned int i = 0; i < size; ++i )
+    {
+        for( unsigned int j = i + 1; j < size; ++j )
+        {
+            for( unsigned int k = j + 1; k < size; ++k )
+            {
+                Eigen::Matrix3d a;
+                a << normals.row( i ), normals.row( j ), normals.row( k );
+                Eigen::FullPivLU< Eigen::Matrix3d > lu( a );
+                if( !lu.isInvertible() ) { continue; }
+                Eigen::Vector3d x = lu.solve( Eigen::Vector3d( offsets( i ), offsets( j ), offsets( k ) ) );
+                if( feasible_( normals, offsets, x, epsilon ) ) { bounding_box.extend( x ); }
+            }
+        }
+    }
+    if( bounding_box.isEmpty() ) { return bounding_box; }
+    // pad to make sure that points on the faces are not rejected due to rounding
+    Eigen::Vector3d padding = Eigen::Vector3d::Constant( 1e-9 ) + ( bounding_box.min().cwiseAbs().cwiseMax( bounding_box.max().cwiseAbs() ) * 1e-12 );
+    return box_type( bounding_box.min() - padding, bounding_box.max() + padding );
+}
+
+void compiled_polytope::has( const double* x, const double* y, const double* z, std::size_t size, unsigned char* inside ) const
+{
+    const Eigen::Vector3d& min = bounding_box_.min();
+    const Eigen::Vector3d& max = bounding_box_.max();
+    for( std::size_t k = 0; k < size; ++k )
+    {
+        inside[k] = ( x[k] >= min.x() ) & ( x[k] <= max.x() ) & ( y[k] >= min.y() ) & ( y[k] <= max.y() ) & ( z[k] >= min.z() ) & ( z[k] <= max.z() );
+    }
+    for( std::size_t i = 0; i < offsets_.size(); ++i ) // face by face, so that the inner loop over points has no branches and can be vectorised
+    {
+        const double a = x_[i];
+        const double b = y_[i];
+        const double c = z_[i];
+        const double d = offsets_[i];
+        for( std::size_t k = 0; k < size; ++k ) { inside[k] &= ( a * x[k] + b * y[k] + c * z[k] >= d ); }
+    }
+}
+
+} } // namespace snark { namespace geometry {
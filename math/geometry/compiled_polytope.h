@@ -0,0 +1,101 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SNARK_MATH_GEOMETRY_COMPILED_POLYTOPE_H_
+#define SNARK_MATH_GEOMETRY_COMPILED_POLYTOPE_H_
+
+#include <cstddef>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include "polytope.h"
+
+namespace snark { namespace geometry {
+
+/// 3d convex polytope prepared for testing many points against it:
+/// half-spaces normals * x >= offsets are stored per coordinate,
+/// and points outside of the axis-aligned bounding box are rejected without testing the faces
+class compiled_polytope
+{
+    public:
+        typedef Eigen::AlignedBox< double, 3 > box_type;
+
+        /// empty polytope, containing all points
+        compiled_polytope();
+
+        /// @param normals inward normals to the faces, one per row
+        /// @param offsets of the faces, same as for convex_polytope
+        /// @note bounding box is not computed, i.e. all points are tested against all the faces
+        compiled_polytope( const Eigen::MatrixXd& normals, const Eigen::VectorXd& offsets );
+
+        /// same as above, with a known bounding box
+        compiled_polytope( const Eigen::MatrixXd& normals, const Eigen::VectorXd& offsets, const box_type& bounding_box );
+
+        /// @param polytope 3d convex polytope
+        explicit compiled_polytope( const convex_polytope& polytope );
+
+        /// @return box with faces at given distances from the centre, the centre and box axes given by position and rotation
+        /// @note box axes: x front, y right, z down
+        static compiled_polytope box( const Eigen::Vector3d& position, const Eigen::Matrix3d& rotation, double front, double back, double right, double left, double top, double bottom );
+
+        /// @return bounding box of polytope given by faces, computed from its vertices, i.e. feasible intersections of triples of faces
+        /// @return infinite box, if the polytope is unbounded; empty box, if the polytope is empty
+        /// @note takes O(faces^4) operations, intended for polytopes with tens of faces
+        static box_type bounds( const Eigen::MatrixXd& normals, const Eigen::VectorXd& offsets );
+
+        /// @return true, if point is inside of the polytope
+        bool has( const Eigen::Vector3d& x ) const
+        {
+            if( !bounding_box_.contains( x ) ) { return false; }
+            for( std::size_t i = 0; i < offsets_.size(); ++i ) { if( x_[i] * x.x() + y_[i] * x.y() + z_[i] * x.z() < offsets_[i] ) { return false; } }
+            return true;
+        }
+
+        /// test a batch of points given as separate coordinate arrays
+        /// @param inside output: 1 for points inside of the polytope, 0 otherwise
+        void has( const double* x, const double* y, const double* z, std::size_t size, unsigned char* inside ) const;
+
+        /// @return bounding box; infinite, if not known
+        const box_type& bounding_box() const { return bounding_box_; }
+
+        /// @return number of faces
+        std::size_t size() const { return offsets_.size(); }
+
+    private:
+        std::vector< double > x_; // normal coordinates, face by face
+        std::vector< double > y_;
+        std::vector< double > z_;
+        std::vector< double > offsets_;
+        box_type bounding_box_;
+        void set_( const Eigen::MatrixXd& normals, const Eigen::VectorXd& offsets );
+};
+
+} } // namespace snark { namespace geometry {
+
+#endif // SNARK_MATH_GEOMETRY_COMPILED_POLYTOPE_H_
@@ -0,0 +1,132 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <cmath>
+#include <comma/base/exception.h>
+#include "polytope_index.h"
+
+namespace snark { namespace geometry {
+
+namespace {
+
+struct centre_less
+{
+    const std::vector< compiled_polytope >& polytopes;
+    unsigned int axis;
+    centre_less( const std::vector< compiled_polytope >& polytopes, unsigned int axis ) : polytopes( polytopes ), axis( axis ) {}
+    bool operator()( std::size_t i, std::size_t j ) const { return polytopes[i].bounding_box().center()[axis] < polytopes[j].bounding_box().center()[axis]; }
+};
+
+struct collect
+{
+    std::vector< std::size_t >& indices;
+    collect( std::vector< std::size_t >& indices ) : indices( indices ) {}
+    bool operator()( std::size_t i ) { indices.push_back( i ); return false; }
+};
+
+struct stop { bool operator()( std::size_t ) const { return true; } };
+
+} // namespace {
+
+polytope_index::polytope_index( const std::vector< compiled_polytope >& polytopes, unsigned int leaf_size )
+    : polytopes_( polytopes )
+    , leaf_size_( leaf_size )
+{
+    if( leaf_size == 0 ) { COMMA_THROW( comma::exception, "expected positive leaf size" ); }
+    for( std::size_t i = 0; i < polytopes_.size(); ++i )
+    {
+        const compiled_polytope::box_type& b = polytopes_[i].bounding_box();
+        bool bounded = true;
+        for( unsigned int k = 0; k < 3 && bounded; ++k ) { bounded = std::isfinite( b.min()[k] ) && std::isfinite( b.max()[k] ); }
+        ( bounded ? order_ : unbounded_ ).push_back( i );
+    }
+    if( !order_.empty() ) { nodes_.reserve( 2 * order_.size() / leaf_size_ + 1 ); build_( 0, order_.size() ); }
+}
+
+int polytope_index::build_( unsigned int begin, unsigned int end )
+{
+    int index = nodes_.size();
+    nodes_.push_back( node() );
+    compiled_polytope::box_type box;
+    compiled_polytope::box_type centres;
+    for( unsigned int i = begin; i < end; ++i )
+    {
+        box.extend( polytopes_[ order_[i] ].bounding_box() );
+        centres.extend( polytopes_[ order_[i] ].bounding_box().center() );
+    }
+    nodes_[index].box = box;
+    nodes_[index].begin = begin;
+    nodes_[index].end = end;
+    nodes_[index].left = -1;
+    nodes_[index].right = -1;
+    if( end - begin <= leaf_size_ ) { return index; }
+    unsigned int axis;
+    centres.sizes().maxCoeff( &axis ); // split at median along the longest extent of polytope centres
+    unsigned int middle = ( begin + end ) / 2;
+    std::nth_element( order_.begin() + begin, order_.begin() + middle, order_.begin() + end, centre_less( polytopes_, axis ) );
+    int left = build_( begin, middle );
+    int right = build_( middle, end );
+    nodes_[index].left = left; // nodes_ may have been reallocated, thus no references held across build_()
+    nodes_[index].right = right;
+    return index;
+}
+
+template < typename F > bool polytope_index::visit_( const Eigen::Vector3d& point, F& f ) const
+{
+    for( std::size_t i = 0; i < unbounded_.size(); ++i ) { if( polytopes_[ unbounded_[i] ].has( point ) && f( unbounded_[i] ) ) { return true; } }
+    if( nodes_.empty() ) { return false; }
+    int stack[128]; // tree is balanced, thus its depth is well below 64
+    unsigned int size = 0;
+    stack[ size++ ] = 0;
+    while( size > 0 )
+    {
+        const node& n = nodes_[ stack[ --size ] ];
+        if( !n.box.contains( point ) ) { continue; }
+        if( n.left >= 0 ) { stack[ size++ ] = n.right; stack[ size++ ] = n.left; continue; }
+        for( unsigned int i = n.begin; i < n.end; ++i ) { if( polytopes_[ order_[i] ].has( point ) && f( order_[i] ) ) { return true; } }
+    }
+    return false;
+}
+
+void polytope_index::find( const Eigen::Vector3d& point, std::vector< std::size_t >& indices ) const
+{
+    indices.clear();
+    collect c( indices );
+    visit_( point, c );
+    std::sort( indices.begin(), indices.end() );
+}
+
+bool polytope_index::has( const Eigen::Vector3d& point ) const
+{
+    stop s;
+    return visit_( point, s );
+}
+
+} } // namespace snark { namespace geometry {
@@ -0,0 +1,82 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SNARK_MATH_GEOMETRY_POLYTOPE_INDEX_H_
+#define SNARK_MATH_GEOMETRY_POLYTOPE_INDEX_H_
+
+#include <vector>
+#include "compiled_polytope.h"
+
+namespace snark { namespace geometry {
+
+/// bounding volume hierarchy over bounding boxes of many polytopes,
+/// for finding polytopes containing a point without testing each of them
+/// @note polytopes without a bounding box are tested for every point
+class polytope_index
+{
+    public:
+        /// @param polytopes polytopes to index
+        /// @param leaf_size maximum number of polytopes in a leaf
+        polytope_index( const std::vector< compiled_polytope >& polytopes, unsigned int leaf_size = 4 );
+
+        /// output indices of polytopes containing point, in ascending order
+        void find( const Eigen::Vector3d& point, std::vector< std::size_t >& indices ) const;
+
+        /// @return true, if any polytope contains point
+        bool has( const Eigen::Vector3d& point ) const;
+
+        /// @return number of polytopes
+        std::size_t size() const { return polytopes_.size(); }
+
+        /// @return number of polytopes without bounding box, i.e. tested for every point
+        std::size_t unbounded() const { return unbounded_.size(); }
+
+        const compiled_polytope& operator[]( std::size_t i ) const { return polytopes_[i]; }
+
+    private:
+        struct node
+        {
+            compiled_polytope::box_type box;
+            unsigned int begin; // range of leaf polytopes in order_
+            unsigned int end;
+            int left; // child nodes, -1 for a leaf
+            int right;
+        };
+        std::vector< compiled_polytope > polytopes_;
+        std::vector< std::size_t > order_;
+        std::vector< std::size_t > unbounded_;
+        std::vector< node > nodes_;
+        unsigned int leaf_size_;
+        int build_( unsigned int begin, unsigned int end );
+        template < typename F > bool visit_( const Eigen::Vector3d& point, F& f ) const;
+};
+
+} } // namespace snark { namespace geometry {
+
+#endif // SNARK_MATH_GEOMETRY_POLYTOPE_INDEX_H_
@@ -0,0 +1,65 @@
+/// compare per-point polytope construction, as points-grep used to do, with compiled_polytope
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/lexical_cast.hpp>
+#include <Eigen/Core>
+#include <snark/math/rotation_matrix.h>
+#include "../compiled_polytope.h"
+
+using namespace snark::geometry;
+
+static bool rebuilt_has( const Eigen::Vector3d& position, const Eigen::Vector3d& orientation, double d, const Eigen::Vector3d& x )
+{
+    Eigen::MatrixXd origins( 3, 7 );
+    origins << 0, d, -d, 0, 0, 0, 0,
+               0, 0, 0, d, -d, 0, 0,
+               0, 0, 0, 0, 0, -d, d;
+    Eigen::MatrixXd rotation = snark::rotation_matrix::rotation( orientation );
+    for( int i = 0; i < origins.cols(); ++i ) { origins.col( i ) = rotation * origins.col( i ) + position; }
+    Eigen::MatrixXd A( 6, 3 );
+    Eigen::VectorXd b( 6 );
+    for( int i = 1; i < origins.cols(); ++i )
+    {
+        A.row( i - 1 ) << origins.col( 0 ).transpose() - origins.col( i ).transpose();
+        b( i - 1 ) = origins.col( i ).transpose() * ( origins.col( 0 ) - origins.col( i ) );
+    }
+    return convex_polytope( A, b ).has( x );
+}
+
+static double seconds_since( const boost::posix_time::ptime& start ) { return double( ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() ) / 1e6; }
+
+int main( int argc, char** argv )
+{
+    unsigned int size = argc > 1 ? boost::lexical_cast< unsigned int >( argv[1] ) : 10000000;
+    unsigned int batch_size = argc > 2 ? boost::lexical_cast< unsigned int >( argv[2] ) : 4096;
+    std::cerr << "usage: compiled-polytope-benchmark [<number of points>] [<batch size>]; running with " << size << " points, batch size " << batch_size << std::endl;
+    std::vector< double > x( size ), y( size ), z( size );
+    std::srand( 1 );
+    for( unsigned int i = 0; i < size; ++i ) { x[i] = 20.0 * std::rand() / RAND_MAX - 10; y[i] = 20.0 * std::rand() / RAND_MAX - 10; z[i] = 20.0 * std::rand() / RAND_MAX - 10; }
+    Eigen::Vector3d position( 0.5, -0.5, 0.2 );
+    Eigen::Vector3d orientation( 0.1, 0.2, 0.3 );
+    double d = 3;
+    std::size_t count = 0;
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    for( unsigned int i = 0; i < size; ++i ) { count += rebuilt_has( position, orientation, d, Eigen::Vector3d( x[i], y[i], z[i] ) ); }
+    std::cout << "rebuilt per point: " << seconds_since( start ) << " seconds; " << count << " points inside" << std::endl;
+    compiled_polytope box = compiled_polytope::box( position, snark::rotation_matrix::rotation( orientation ), d, d, d, d, d, d );
+    count = 0;
+    start = boost::posix_time::microsec_clock::universal_time();
+    for( unsigned int i = 0; i < size; ++i ) { count += box.has( Eigen::Vector3d( x[i], y[i], z[i] ) ); }
+    std::cout << "compiled, point by point: " << seconds_since( start ) << " seconds; " << count << " points inside" << std::endl;
+    std::vector< unsigned char > inside( batch_size );
+    count = 0;
+    start = boost::posix_time::microsec_clock::universal_time();
+    for( unsigned int i = 0; i < size; i += batch_size )
+    {
+        unsigned int n = std::min( batch_size, size - i );
+        box.has( &x[i], &y[i], &z[i], n, &inside[0] );
+        for( unsigned int k = 0; k < n; count += inside[k++] );
+    }
+    std::cout << "compiled, batches: " << seconds_since( start ) << " seconds; " << count << " points inside" << std::endl;
+    return 0;
+}
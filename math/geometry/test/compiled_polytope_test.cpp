@@ -0,0 +1,117 @@
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include <gtest/gtest.h>
+#include <Eigen/Geometry>
+#include "../compiled_polytope.h"
+
+using namespace snark::geometry;
+
+namespace {
+
+// box as built by points-grep before compiled_polytope existed
+convex_polytope reference_box( const Eigen::Vector3d& position, const Eigen::Matrix3d& rotation, double front, double back, double right, double left, double top, double bottom )
+{
+    Eigen::MatrixXd origins( 3, 7 );
+    origins << 0, front, -back, 0, 0, 0, 0,
+               0, 0, 0, right, -left, 0, 0,
+               0, 0, 0, 0, 0, -top, bottom;
+    for( int i = 0; i < origins.cols(); ++i ) { origins.col( i ) = rotation * origins.col( i ) + position; }
+    Eigen::MatrixXd A( 6, 3 );
+    Eigen::VectorXd b( 6 );
+    for( int i = 1; i < origins.cols(); ++i )
+    {
+        A.row( i - 1 ) << origins.col( 0 ).transpose() - origins.col( i ).transpose();
+        b( i - 1 ) = origins.col( i ).transpose() * ( origins.col( 0 ) - origins.col( i ) );
+    }
+    return convex_polytope( A, b );
+}
+
+double random( double from, double to ) { return from + ( to - from ) * double( std::rand() ) / RAND_MAX; }
+
+} // namespace {
+
+TEST( geometry, compiled_polytope_box )
+{
+    std::srand( 1 );
+    for( unsigned int k = 0; k < 20; ++k )
+    {
+        Eigen::Vector3d position( random( -10, 10 ), random( -10, 10 ), random( -10, 10 ) );
+        Eigen::Matrix3d rotation = ( Eigen::AngleAxisd( random( -3, 3 ), Eigen::Vector3d::UnitZ() ) * Eigen::AngleAxisd( random( -1.5, 1.5 ), Eigen::Vector3d::UnitY() ) * Eigen::AngleAxisd( random( -3, 3 ), Eigen::Vector3d::UnitX() ) ).toRotationMatrix();
+        double front = random( 0.1, 3 ), back = random( 0.1, 3 ), right = random( 0.1, 3 ), left = random( 0.1, 3 ), top = random( 0.1, 3 ), bottom = random( 0.1, 3 );
+        convex_polytope reference = reference_box( position, rotation, front, back, right, left, top, bottom );
+        compiled_polytope box = compiled_polytope::box( position, rotation, front, back, right, left, top, bottom );
+        EXPECT_EQ( 6u, box.size() );
+        std::vector< double > x( 1000 ), y( 1000 ), z( 1000 );
+        for( unsigned int i = 0; i < x.size(); ++i ) { x[i] = position.x() + random( -4, 4 ); y[i] = position.y() + random( -4, 4 ); z[i] = position.z() + random( -4, 4 ); }
+        std::vector< unsigned char > inside( x.size() );
+        box.has( &x[0], &y[0], &z[0], x.size(), &inside[0] );
+        unsigned int count = 0;
+        for( unsigned int i = 0; i < x.size(); ++i )
+        {
+            Eigen::Vector3d p( x[i], y[i], z[i] );
+            bool expected = reference.has( p );
+            EXPECT_EQ( expected, box.has( p ) );
+            EXPECT_EQ( expected, bool( inside[i] ) );
+            if( expected ) { ++count; EXPECT_TRUE( box.bounding_box().contains( p ) ); }
+        }
+        EXPECT_LT( 0u, count );
+    }
+}
+
+TEST( geometry, compiled_polytope_faces )
+{
+    // points on the faces are inside, as for convex_polytope
+    compiled_polytope box = compiled_polytope::box( Eigen::Vector3d( 1, 2, 3 ), Eigen::Matrix3d::Identity(), 1, 2, 3, 4, 5, 6 );
+    EXPECT_TRUE( box.has( Eigen::Vector3d( 2, 2, 3 ) ) );
+    EXPECT_TRUE( box.has( Eigen::Vector3d( -1, 2, 3 ) ) );
+    EXPECT_TRUE( box.has( Eigen::Vector3d( 1, 5, 3 ) ) );
+    EXPECT_TRUE( box.has( Eigen::Vector3d( 1, -2, 3 ) ) );
+    EXPECT_TRUE( box.has( Eigen::Vector3d( 1, 2, -2 ) ) );
+    EXPECT_TRUE( box.has( Eigen::Vector3d( 1, 2, 9 ) ) );
+    EXPECT_FALSE( box.has( Eigen::Vector3d( 2.001, 2, 3 ) ) );
+    EXPECT_FALSE( box.has( Eigen::Vector3d( 1, 2, 9.001 ) ) );
+}
+
+TEST( geometry, compiled_polytope_unbounded )
+{
+    // degenerate box: zero right distance means no constraint on the right, as for convex_polytope
+    Eigen::Vector3d position( 0, 0, 0 );
+    compiled_polytope box = compiled_polytope::box( position, Eigen::Matrix3d::Identity(), 1, 1, 0, 1, 1, 1 );
+    convex_polytope reference = reference_box( position, Eigen::Matrix3d::Identity(), 1, 1, 0, 1, 1, 1 );
+    Eigen::Vector3d p( 0, 100, 0 );
+    EXPECT_EQ( reference.has( p ), box.has( p ) );
+    EXPECT_TRUE( box.has( p ) );
+    Eigen::MatrixXd A( 1, 3 );
+    Eigen::VectorXd b( 1 );
+    A << 1, 0, 0;
+    b << 1;
+    compiled_polytope half_space( ( convex_polytope( A, b ) ) );
+    EXPECT_TRUE( half_space.has( Eigen::Vector3d( 1e6, -1e6, 1e6 ) ) );
+    EXPECT_FALSE( half_space.has( Eigen::Vector3d( 0.5, 0, 0 ) ) );
+}
+
+TEST( geometry, compiled_polytope_bounds )
+{
+    Eigen::MatrixXd A( 6, 3 );
+    Eigen::VectorXd b( 6 );
+    A << 1, 0, 0,  -1, 0, 0,  0, 1, 0,  0, -1, 0,  0, 0, 1,  0, 0, -1;
+    b << -1, -2, -2, -5, -2, -9; // x in [-1,2], y in [-2,5], z in [-2,9]
+    compiled_polytope::box_type bounds = compiled_polytope::bounds( A, b );
+    EXPECT_NEAR( -1, bounds.min().x(), 1e-6 );
+    EXPECT_NEAR( -2, bounds.min().y(), 1e-6 );
+    EXPECT_NEAR( -2, bounds.min().z(), 1e-6 );
+    EXPECT_NEAR( 2, bounds.max().x(), 1e-6 );
+    EXPECT_NEAR( 5, bounds.max().y(), 1e-6 );
+    EXPECT_NEAR( 9, bounds.max().z(), 1e-6 );
+    EXPECT_TRUE( compiled_polytope( A, b, bounds ).has( Eigen::Vector3d( 2, 5, 9 ) ) ); // vertex
+    EXPECT_FALSE( std::isfinite( compiled_polytope::bounds( A.topRows( 5 ), b.topRows( 5 ) ).max().z() ) ); // open box
+    Eigen::MatrixXd C( 4, 3 );
+    Eigen::VectorXd d( 4 );
+    C << 1, 0, 0,  0, 1, 0,  0, 0, 1,  1, 1, 0;
+    d << 0, 0, 0, 1;
+    EXPECT_FALSE( std::isfinite( compiled_polytope::bounds( C, d ).max().x() ) ); // octant
+    C.row( 3 ) << -1, -1, -1;
+    d( 3 ) = 1; // x, y, z >= 0 and x + y + z <= -1
+    EXPECT_TRUE( compiled_polytope::bounds( C, d ).isEmpty() );
+}
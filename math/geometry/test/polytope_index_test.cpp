@@ -0,0 +1,129 @@
+#include <cstdlib>
+#include <vector>
+#include <gtest/gtest.h>
+#include <Eigen/Geometry>
+#include "../polytope_index.h"
+
+using namespace snark::geometry;
+
+namespace {
+
+double random( double from, double to ) { return from + ( to - from ) * double( std::rand() ) / RAND_MAX; }
+
+std::vector< compiled_polytope > random_boxes( unsigned int size, double extent )
+{
+    std::vector< compiled_polytope > boxes;
+    for( unsigned int i = 0; i < size; ++i )
+    {
+        Eigen::Vector3d position( random( -extent, extent ), random( -extent, extent ), random( -extent, extent ) );
+        Eigen::Matrix3d rotation = ( Eigen::AngleAxisd( random( -3, 3 ), Eigen::Vector3d::UnitZ() ) * Eigen::AngleAxisd( random( -1.5, 1.5 ), Eigen::Vector3d::UnitY() ) * Eigen::AngleAxisd( random( -3, 3 ), Eigen::Vector3d::UnitX() ) ).toRotationMatrix();
+        boxes.push_back( compiled_polytope::box( position, rotation, random( 0.1, 3 ), random( 0.1, 3 ), random( 0.1, 3 ), random( 0.1, 3 ), random( 0.1, 3 ), random( 0.1, 3 ) ) );
+    }
+    return boxes;
+}
+
+// random convex polytopes given by planes tangent to a ball at random directions, as loaded by points-grep shapes --planes
+void random_polytopes( unsigned int size, double extent, std::vector< compiled_polytope >& polytopes, std::vector< compiled_polytope >& references )
+{
+    for( unsigned int i = 0; i < size; ++i )
+    {
+        Eigen::Vector3d centre( random( -extent, extent ), random( -extent, extent ), random( -extent, extent ) );
+        unsigned int faces = 4 + std::rand() % 12;
+        Eigen::MatrixXd normals( faces, 3 );
+        Eigen::VectorXd offsets( faces );
+        Eigen::Matrix3d rotation = ( Eigen::AngleAxisd( random( -3, 3 ), Eigen::Vector3d::UnitZ() ) * Eigen::AngleAxisd( random( -1.5, 1.5 ), Eigen::Vector3d::UnitY() ) * Eigen::AngleAxisd( random( -3, 3 ), Eigen::Vector3d::UnitX() ) ).toRotationMatrix();
+        for( unsigned int k = 0; k < faces; ++k )
+        {
+            Eigen::Vector3d n = k < 4 ? Eigen::Vector3d( k == 1 || k == 2 ? -1 : 1, k == 2 || k == 3 ? -1 : 1, k == 1 || k == 3 ? -1 : 1 ) : Eigen::Vector3d( random( -1, 1 ), random( -1, 1 ), random( -1, 1 ) );
+            n = rotation * n.normalized(); // first four normals of a tetrahedron, so that the polytope is bounded
+            normals.row( k ) = n.transpose();
+            offsets( k ) = n.dot( centre ) - random( 0.2, 3 );
+        }
+        polytopes.push_back( compiled_polytope( normals, offsets, compiled_polytope::bounds( normals, offsets ) ) );
+        references.push_back( compiled_polytope( normals, offsets ) );
+    }
+}
+
+void compare_with_brute_force( const std::vector< compiled_polytope >& polytopes, unsigned int leaf_size, double extent )
+{
+    polytope_index index( polytopes, leaf_size );
+    EXPECT_EQ( polytopes.size(), index.size() );
+    std::vector< std::size_t > found;
+    unsigned int hits = 0;
+    for( unsigned int k = 0; k < 5000; ++k )
+    {
+        Eigen::Vector3d p( random( -extent, extent ), random( -extent, extent ), random( -extent, extent ) );
+        std::vector< std::size_t > expected;
+        for( std::size_t i = 0; i < polytopes.size(); ++i ) { if( polytopes[i].has( p ) ) { expected.push_back( i ); } }
+        index.find( p, found );
+        EXPECT_EQ( expected, found );
+        EXPECT_EQ( !expected.empty(), index.has( p ) );
+        hits += !expected.empty();
+    }
+    EXPECT_LT( 0u, hits );
+}
+
+} // namespace {
+
+TEST( geometry, polytope_index_empty )
+{
+    polytope_index index( ( std::vector< compiled_polytope >() ) );
+    std::vector< std::size_t > found( 1, 0 );
+    index.find( Eigen::Vector3d( 0, 0, 0 ), found );
+    EXPECT_TRUE( found.empty() );
+    EXPECT_FALSE( index.has( Eigen::Vector3d( 0, 0, 0 ) ) );
+}
+
+TEST( geometry, polytope_index_brute_force )
+{
+    std::srand( 1 );
+    compare_with_brute_force( random_boxes( 1, 2 ), 4, 4 );
+    compare_with_brute_force( random_boxes( 7, 5 ), 1, 6 );
+    compare_with_brute_force( random_boxes( 300, 20 ), 4, 22 );
+    compare_with_brute_force( random_boxes( 300, 20 ), 16, 22 );
+}
+
+TEST( geometry, polytope_index_unbounded )
+{
+    std::srand( 2 );
+    std::vector< compiled_polytope > polytopes = random_boxes( 50, 10 );
+    Eigen::MatrixXd A( 1, 3 );
+    Eigen::VectorXd b( 1 );
+    A << 0, 0, 1;
+    b << 5;
+    polytopes.insert( polytopes.begin() + 20, compiled_polytope( A, b ) ); // half-space z >= 5, without bounding box
+    compare_with_brute_force( polytopes, 4, 12 );
+    EXPECT_EQ( 1u, polytope_index( polytopes ).unbounded() );
+}
+
+TEST( geometry, polytope_index_planes )
+{
+    std::srand( 3 );
+    std::vector< compiled_polytope > polytopes;
+    std::vector< compiled_polytope > references;
+    random_polytopes( 500, 20, polytopes, references );
+    polytope_index index( polytopes );
+    EXPECT_EQ( 0u, index.unbounded() );
+    std::vector< std::size_t > found;
+    unsigned int hits = 0;
+    for( unsigned int k = 0; k < 20000; ++k )
+    {
+        Eigen::Vector3d p( random( -22, 22 ), random( -22, 22 ), random( -22, 22 ) );
+        std::vector< std::size_t > expected;
+        for( std::size_t i = 0; i < references.size(); ++i ) { if( references[i].has( p ) ) { expected.push_back( i ); } }
+        index.find( p, found );
+        EXPECT_EQ( expected, found );
+        EXPECT_EQ( !expected.empty(), index.has( p ) );
+        hits += !expected.empty();
+    }
+    EXPECT_LT( 100u, hits );
+    for( std::size_t i = 0; i < references.size(); ++i ) // points near the vertices
+    {
+        const compiled_polytope::box_type& box = polytopes[i].bounding_box();
+        for( unsigned int k = 0; k < 50; ++k )
+        {
+            Eigen::Vector3d p = box.min() + ( box.max() - box.min() ).cwiseProduct( Eigen::Vector3d( random( -0.05, 1.05 ), random( -0.05, 1.05 ), random( -0.05, 1.05 ) ) );
+            EXPECT_EQ( references[i].has( p ), polytopes[i].has( p ) );
+        }
+    }
+}
@@ -0,0 +1,345 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SNARK_MATH_KD_TREE_H_
+#define SNARK_MATH_KD_TREE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <Eigen/Core>
+#include <Eigen/StdVector>
+#include <tbb/parallel_for.h>
+#include <comma/base/exception.h>
+#include <comma/base/types.h>
+
+namespace snark {
+
+/// static kd-tree over points of dimension D, built in bulk, for nearest, k-nearest and radius queries;
+/// points are copied into the tree reordered leaf by leaf, thus queries scan leaves contiguously;
+/// batch queries run in parallel through tbb
+template < unsigned int D >
+class kd_tree : public boost::noncopyable
+{
+    public:
+        typedef Eigen::Matrix< double, D, 1 > point_type;
+
+        /// neighbour: index of point as given to constructor and distance to it
+        struct neighbour
+        {
+            std::size_t index;
+            double distance;
+            neighbour() : index( 0 ), distance( 0 ) {}
+            neighbour( std::size_t index, double distance ) : index( index ), distance( distance ) {}
+            bool operator<( const neighbour& rhs ) const { return distance < rhs.distance || ( distance == rhs.distance && index < rhs.index ); }
+        };
+
+        /// constructor
+        /// @param begin, end iterators over points, e.g. of std::vector< Eigen::Vector3d >
+        /// @param leaf_size maximum number of points in a leaf
+        template < typename It >
+        kd_tree( It begin, It end, unsigned int leaf_size = 16 );
+
+        /// return number of points
+        std::size_t size() const { return points_.size(); }
+
+        /// return nearest point; throw, if tree is empty
+        neighbour nearest( const point_type& p ) const;
+
+        /// get up to k nearest points, sorted by distance
+        void nearest( const point_type& p, std::size_t k, std::vector< neighbour >& neighbours ) const;
+
+        /// get all points within radius, sorted by distance
+        void radius( const point_type& p, double radius, std::vector< neighbour >& neighbours ) const;
+
+        /// return number of points within radius
+        std::size_t radius_count( const point_type& p, double radius ) const;
+
+        /// get nearest point for each query in parallel; queries: e.g. std::vector< Eigen::Vector3d >
+        template < typename Q >
+        void nearest( const Q& queries, std::vector< neighbour >& neighbours ) const;
+
+        /// get up to k nearest points for each query in parallel
+        template < typename Q >
+        void nearest( const Q& queries, std::size_t k, std::vector< std::vector< neighbour > >& neighbours ) const;
+
+        /// get number of points within radius for each query in parallel
+        template < typename Q >
+        void radius_count( const Q& queries, double radius, std::vector< std::size_t >& counts ) const;
+
+    private:
+        struct node
+        {
+            comma::uint32 begin; //!< first point of node
+            comma::uint32 end; //!< end of points of node
+            comma::uint32 right; //!< right child, left child follows node; 0 for leaf
+            comma::uint32 dimension; //!< split dimension
+            double split; //!< split value: left child points <= split <= right child points
+        };
+        std::vector< point_type, Eigen::aligned_allocator< point_type > > points_;
+        std::vector< std::size_t > indices_; //!< indices of reordered points as given to constructor
+        std::vector< node > nodes_;
+        unsigned int leaf_size_;
+
+        struct compare_;
+        void build_( std::size_t begin, std::size_t end );
+        template < typename V > void visit_( const point_type& p, std::size_t n, double d, V& visitor ) const;
+
+        struct best_visitor_;
+        struct nearest_visitor_;
+        struct radius_visitor_;
+        struct count_visitor_;
+        template < typename Q > class nearest_queries_;
+        template < typename Q > class k_nearest_queries_;
+        template < typename Q > class count_queries_;
+};
+
+template < unsigned int D >
+struct kd_tree< D >::compare_
+{
+    std::vector< point_type, Eigen::aligned_allocator< point_type > >& points;
+    unsigned int dimension;
+    compare_( std::vector< point_type, Eigen::aligned_allocator< point_type > >& points, unsigned int dimension ) : points( points ), dimension( dimension ) {}
+    bool operator()( std::size_t i, std::size_t j ) const { return points[i]( dimension ) < points[j]( dimension ); }
+};
+
+template < unsigned int D >
+template < typename It >
+inline kd_tree< D >::kd_tree( It begin, It end, unsigned int leaf_size ) : leaf_size_( std::max( leaf_size, 1u ) )
+{
+    for( It it = begin; it != end; ++it ) { points_.push_back( *it ); }
+    if( points_.size() > 0xffffffffUL ) { COMMA_THROW( comma::exception, "expected at most 4294967295 points, got " << points_.size() ); }
+    indices_.resize( points_.size() );
+    for( std::size_t i = 0; i < indices_.size(); ++i ) { indices_[i] = i; }
+    if( points_.empty() ) { return; }
+    nodes_.reserve( 2 * points_.size() / leaf_size_ + 1 );
+    build_( 0, points_.size() );
+    std::vector< point_type, Eigen::aligned_allocator< point_type > > points( points_.size() );
+    for( std::size_t i = 0; i < indices_.size(); ++i ) { points[i] = points_[ indices_[i] ]; }
+    points_.swap( points );
+}
+
+template < unsigned int D >
+inline void kd_tree< D >::build_( std::size_t begin, std::size_t end ) // quick and dirty: recursion depth is log( size / leaf_size )
+{
+    std::size_t n = nodes_.size();
+    nodes_.push_back( node() );
+    nodes_[n].begin = begin;
+    nodes_[n].end = end;
+    nodes_[n].right = 0;
+    nodes_[n].dimension = 0;
+    nodes_[n].split = 0;
+    if( end - begin <= leaf_size_ ) { return; }
+    point_type min = points_[ indices_[begin] ];
+    point_type max = min;
+    for( std::size_t i = begin + 1; i < end; ++i ) { min = min.cwiseMin( points_[ indices_[i] ] ); max = max.cwiseMax( points_[ indices_[i] ] ); }
+    Eigen::DenseIndex dimension;
+    ( max - min ).maxCoeff( &dimension ); // split widest dimension
+    if( max( dimension ) == min( dimension ) ) { return; } // all points the same: leaf
+    std::size_t middle = begin + ( end - begin ) / 2;
+    std::nth_element( indices_.begin() + begin, indices_.begin() + middle, indices_.begin() + end, compare_( points_, dimension ) );
+    nodes_[n].dimension = dimension;
+    nodes_[n].split = points_[ indices_[middle] ]( dimension );
+    build_( begin, middle );
+    nodes_[n].right = nodes_.size();
+    build_( middle, end );
+}
+
+template < unsigned int D >
+template < typename V >
+inline void kd_tree< D >::visit_( const point_type& p, std::size_t n, double d, V& visitor ) const // d: squared distance from p to node bounds along split planes
+{
+    if( d > visitor.bound() ) { return; }
+    const node& e = nodes_[n];
+    if( e.right == 0 )
+    {
+        for( std::size_t i = e.begin; i < e.end; ++i ) { visitor( i, ( points_[i] - p ).squaredNorm() ); }
+        return;
+    }
+    double offset = p( e.dimension ) - e.split;
+    std::size_t near = offset <= 0 ? n + 1 : e.right;
+    std::size_t far = offset <= 0 ? e.right : n + 1;
+    visit_( p, near, d, visitor );
+    visit_( p, far, std::max( d, offset * offset ), visitor );
+}
+
+template < unsigned int D >
+struct kd_tree< D >::best_visitor_
+{
+    std::size_t index;
+    double distance;
+    best_visitor_() : index( 0 ), distance( std::numeric_limits< double >::max() ) {}
+    double bound() const { return distance; }
+    void operator()( std::size_t i, double d ) { if( d < distance ) { index = i; distance = d; } }
+};
+
+template < unsigned int D >
+struct kd_tree< D >::nearest_visitor_ // keeps up to k nearest as max-heap of squared distances
+{
+    std::size_t k;
+    std::vector< neighbour >& heap;
+    nearest_visitor_( std::size_t k, std::vector< neighbour >& heap ) : k( k ), heap( heap ) { heap.clear(); }
+    double bound() const { return heap.size() < k ? std::numeric_limits< double >::max() : heap.front().distance; }
+    void operator()( std::size_t i, double d )
+    {
+        if( heap.size() == k ) { if( !( d < heap.front().distance ) ) { return; } std::pop_heap( heap.begin(), heap.end() ); heap.pop_back(); }
+        heap.push_back( neighbour( i, d ) );
+        std::push_heap( heap.begin(), heap.end() );
+    }
+};
+
+template < unsigned int D >
+struct kd_tree< D >::radius_visitor_
+{
+    double squared_radius;
+    std::vector< neighbour >& neighbours;
+    radius_visitor_( double radius, std::vector< neighbour >& neighbours ) : squared_radius( radius * radius ), neighbours( neighbours ) { neighbours.clear(); }
+    double bound() const { return squared_radius; }
+    void operator()( std::size_t i, double d ) { if( d <= squared_radius ) { neighbours.push_back( neighbour( i, d ) ); } }
+};
+
+template < unsigned int D >
+struct kd_tree< D >::count_visitor_
+{
+    double squared_radius;
+    std::size_t count;
+    count_visitor_( double radius ) : squared_radius( radius * radius ), count( 0 ) {}
+    double bound() const { return squared_radius; }
+    void operator()( std::size_t, double d ) { if( d <= squared_radius ) { ++count; } }
+};
+
+template < unsigned int D >
+inline typename kd_tree< D >::neighbour kd_tree< D >::nearest( const point_type& p ) const
+{
+    if( points_.empty() ) { COMMA_THROW( comma::exception, "nearest point requested from empty tree" ); }
+    best_visitor_ visitor;
+    visit_( p, 0, 0, visitor );
+    return neighbour( indices_[ visitor.index ], std::sqrt( visitor.distance ) );
+}
+
+template < unsigned int D >
+inline void kd_tree< D >::nearest( const point_type& p, std::size_t k, std::vector< neighbour >& neighbours ) const
+{
+    nearest_visitor_ visitor( k, neighbours );
+    if( k == 0 || points_.empty() ) { return; }
+    visit_( p, 0, 0, visitor );
+    for( std::size_t i = 0; i < neighbours.size(); ++i ) { neighbours[i].index = indices_[ neighbours[i].index ]; neighbours[i].distance = std::sqrt( neighbours[i].distance ); }
+    std::sort( neighbours.begin(), neighbours.end() );
+}
+
+template < unsigned int D >
+inline void kd_tree< D >::radius( const point_type& p, double radius, std::vector< neighbour >& neighbours ) const
+{
+    radius_visitor_ visitor( radius, neighbours );
+    if( points_.empty() || radius < 0 ) { return; }
+    visit_( p, 0, 0, visitor );
+    for( std::size_t i = 0; i < neighbours.size(); ++i ) { neighbours[i].index = indices_[ neighbours[i].index ]; neighbours[i].distance = std::sqrt( neighbours[i].distance ); }
+    std::sort( neighbours.begin(), neighbours.end() );
+}
+
+template < unsigned int D >
+inline std::size_t kd_tree< D >::radius_count( const point_type& p, double radius ) const
+{
+    count_visitor_ visitor( radius );
+    if( points_.empty() || radius < 0 ) { return 0; }
+    visit_( p, 0, 0, visitor );
+    return visitor.count;
+}
+
+template < unsigned int D >
+template < typename Q >
+class kd_tree< D >::nearest_queries_
+{
+    public:
+        nearest_queries_( const kd_tree& tree, const Q& queries, std::vector< neighbour >& neighbours ) : tree_( tree ), queries_( queries ), neighbours_( neighbours ) {}
+        void operator()( const tbb::blocked_range< std::size_t >& r ) const { for( std::size_t i = r.begin(); i < r.end(); ++i ) { neighbours_[i] = tree_.nearest( queries_[i] ); } }
+    private:
+        const kd_tree& tree_;
+        const Q& queries_;
+        std::vector< neighbour >& neighbours_;
+};
+
+template < unsigned int D >
+template < typename Q >
+class kd_tree< D >::k_nearest_queries_
+{
+    public:
+        k_nearest_queries_( const kd_tree& tree, const Q& queries, std::size_t k, std::vector< std::vector< neighbour > >& neighbours ) : tree_( tree ), queries_( queries ), k_( k ), neighbours_( neighbours ) {}
+        void operator()( const tbb::blocked_range< std::size_t >& r ) const { for( std::size_t i = r.begin(); i < r.end(); ++i ) { tree_.nearest( queries_[i], k_, neighbours_[i] ); } }
+    private:
+        const kd_tree& tree_;
+        const Q& queries_;
+        std::size_t k_;
+        std::vector< std::vector< neighbour > >& neighbours_;
+};
+
+template < unsigned int D >
+template < typename Q >
+class kd_tree< D >::count_queries_
+{
+    public:
+        count_queries_( const kd_tree& tree, const Q& queries, double radius, std::vector< std::size_t >& counts ) : tree_( tree ), queries_( queries ), radius_( radius ), counts_( counts ) {}
+        void operator()( const tbb::blocked_range< std::size_t >& r ) const { for( std::size_t i = r.begin(); i < r.end(); ++i ) { counts_[i] = tree_.radius_count( queries_[i], radius_ ); } }
+    private:
+        const kd_tree& tree_;
+        const Q& queries_;
+        double radius_;
+        std::vector< std::size_t >& counts_;
+};
+
+template < unsigned int D >
+template < typename Q >
+inline void kd_tree< D >::nearest( const Q& queries, std::vector< neighbour >& neighbours ) const
+{
+    if( points_.empty() && queries.size() > 0 ) { COMMA_THROW( comma::exception, "nearest point requested from empty tree" ); }
+    neighbours.resize( queries.size() );
+    tbb::parallel_for( tbb::blocked_range< std::size_t >( 0, queries.size(), 256 ), nearest_queries_< Q >( *this, queries, neighbours ) );
+}
+
+template < unsigned int D >
+template < typename Q >
+inline void kd_tree< D >::nearest( const Q& queries, std::size_t k, std::vector< std::vector< neighbour > >& neighbours ) const
+{
+    neighbours.resize( queries.size() );
+    tbb::parallel_for( tbb::blocked_range< std::size_t >( 0, queries.size(), 256 ), k_nearest_queries_< Q >( *this, queries, k, neighbours ) );
+}
+
+template < unsigned int D >
+template < typename Q >
+inline void kd_tree< D >::radius_count( const Q& queries, double radius, std::vector< std::size_t >& counts ) const
+{
+    counts.resize( queries.size() );
+    tbb::parallel_for( tbb::blocked_range< std::size_t >( 0, queries.size(), 256 ), count_queries_< Q >( *this, queries, radius, counts ) );
+}
+
+} // namespace snark {
+
+#endif // SNARK_MATH_KD_TREE_H_
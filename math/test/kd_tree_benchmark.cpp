@@ -0,0 +1,73 @@
+/// time building kd-tree and querying nearest, k-nearest and radius counts over growing point clouds
+/// against brute force scan, and parallel batch queries on 1 to 8 threads
+
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <iostream>
+#include <vector>
+#include <tbb/task_scheduler_init.h>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/lexical_cast.hpp>
+#include <snark/math/kd_tree.h>
+
+static double seconds_since( const boost::posix_time::ptime& start ) { return double( ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() ) / 1e6; }
+
+static void make_points( std::size_t size, std::vector< Eigen::Vector3d >& points ) // ground plane with scattered objects, 100x100 metres
+{
+    points.resize( size );
+    for( std::size_t i = 0; i < size; ++i )
+    {
+        points[i] = Eigen::Vector3d( 100.0 * std::rand() / RAND_MAX, 100.0 * std::rand() / RAND_MAX, 0.05 * std::rand() / RAND_MAX );
+        if( i % 4 == 0 ) { points[i].z() = 5.0 * std::rand() / RAND_MAX; }
+    }
+}
+
+int main( int argc, char** argv )
+{
+    std::size_t queries_size = argc > 1 ? boost::lexical_cast< std::size_t >( argv[1] ) : 100000;
+    std::size_t max_brute_force = argc > 2 ? boost::lexical_cast< std::size_t >( argv[2] ) : 100000;
+    std::cerr << "usage: math-kd-tree-benchmark [<number of queries>] [<max size for brute force>]; running with " << queries_size << " queries, brute force up to " << max_brute_force << " points" << std::endl;
+    std::srand( 1 );
+    std::vector< Eigen::Vector3d > queries;
+    make_points( queries_size, queries );
+    std::size_t sizes[] = { 10000, 100000, 1000000, 4000000 };
+    for( unsigned int s = 0; s < sizeof( sizes ) / sizeof( sizes[0] ); ++s )
+    {
+        std::vector< Eigen::Vector3d > points;
+        make_points( sizes[s], points );
+        boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+        snark::kd_tree< 3 > tree( points.begin(), points.end() );
+        std::cout << sizes[s] << " points: build: " << seconds_since( start ) << " seconds" << std::endl;
+        if( sizes[s] <= max_brute_force )
+        {
+            std::size_t brute_force_queries = std::min( queries.size(), std::size_t( 1000 ) );
+            start = boost::posix_time::microsec_clock::universal_time();
+            std::size_t mismatches = 0;
+            for( std::size_t i = 0; i < brute_force_queries; ++i )
+            {
+                double min = std::numeric_limits< double >::max();
+                for( std::size_t j = 0; j < points.size(); ++j ) { min = std::min( min, ( points[j] - queries[i] ).squaredNorm() ); }
+                if( std::sqrt( min ) != tree.nearest( queries[i] ).distance ) { ++mismatches; }
+            }
+            std::cout << "    brute force nearest: " << seconds_since( start ) / brute_force_queries * queries.size() << " seconds per " << queries.size() << " queries (extrapolated); mismatches with kd-tree: " << mismatches << std::endl;
+        }
+        for( unsigned int threads = 1; threads <= 8; threads *= 2 )
+        {
+            tbb::task_scheduler_init init( threads );
+            std::vector< snark::kd_tree< 3 >::neighbour > nearest;
+            start = boost::posix_time::microsec_clock::universal_time();
+            tree.nearest( queries, nearest );
+            double t = seconds_since( start );
+            std::vector< std::vector< snark::kd_tree< 3 >::neighbour > > k_nearest;
+            start = boost::posix_time::microsec_clock::universal_time();
+            tree.nearest( queries, 10, k_nearest );
+            double k = seconds_since( start );
+            std::vector< std::size_t > counts;
+            start = boost::posix_time::microsec_clock::universal_time();
+            tree.radius_count( queries, 0.5, counts );
+            std::cout << "    " << threads << " thread(s): nearest: " << t << " seconds; 10 nearest: " << k << " seconds; radius count: " << seconds_since( start ) << " seconds" << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,167 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+#include <gtest/gtest.h>
+#include <Eigen/StdVector>
+#include <snark/math/kd_tree.h>
+
+namespace snark { namespace test {
+
+typedef std::vector< Eigen::Vector3d > points_t;
+
+static points_t make_points_( std::size_t size, unsigned int seed )
+{
+    std::srand( seed );
+    points_t points( size );
+    for( std::size_t i = 0; i < size; ++i ) { points[i] = Eigen::Vector3d( 100.0 * std::rand() / RAND_MAX, 100.0 * std::rand() / RAND_MAX, 5.0 * std::rand() / RAND_MAX ); }
+    for( std::size_t i = 0; i < size / 10; ++i ) { points[ std::rand() % size ] = points[ std::rand() % size ]; } // duplicates
+    for( std::size_t i = 0; i < size / 10; ++i ) { points[i] = Eigen::Vector3d( 50, 50, 0 ) + Eigen::Vector3d::Random() * 0.01; } // dense cluster
+    return points;
+}
+
+static std::vector< double > brute_force_distances_( const points_t& points, const Eigen::Vector3d& p )
+{
+    std::vector< double > distances( points.size() );
+    for( std::size_t i = 0; i < points.size(); ++i ) { distances[i] = ( points[i] - p ).norm(); }
+    std::sort( distances.begin(), distances.end() );
+    return distances;
+}
+
+TEST( kd_tree, nearest )
+{
+    const points_t& points = make_points_( 5000, 1 );
+    const points_t& queries = make_points_( 300, 2 );
+    for( unsigned int leaf_size = 1; leaf_size <= 64; leaf_size *= 4 )
+    {
+        kd_tree< 3 > tree( points.begin(), points.end(), leaf_size );
+        EXPECT_EQ( points.size(), tree.size() );
+        for( std::size_t i = 0; i < queries.size(); ++i )
+        {
+            const std::vector< double >& distances = brute_force_distances_( points, queries[i] );
+            kd_tree< 3 >::neighbour n = tree.nearest( queries[i] );
+            EXPECT_DOUBLE_EQ( distances[0], n.distance );
+            EXPECT_DOUBLE_EQ( distances[0], ( points[ n.index ] - queries[i] ).norm() );
+            std::vector< kd_tree< 3 >::neighbour > neighbours;
+            tree.nearest( queries[i], 10, neighbours );
+            ASSERT_EQ( 10u, neighbours.size() );
+            for( std::size_t k = 0; k < neighbours.size(); ++k )
+            {
+                EXPECT_DOUBLE_EQ( distances[k], neighbours[k].distance );
+                EXPECT_DOUBLE_EQ( neighbours[k].distance, ( points[ neighbours[k].index ] - queries[i] ).norm() );
+            }
+        }
+    }
+}
+
+TEST( kd_tree, nearest_on_points_themselves )
+{
+    const points_t& points = make_points_( 2000, 3 );
+    kd_tree< 3 > tree( points.begin(), points.end() );
+    for( std::size_t i = 0; i < points.size(); ++i ) { EXPECT_EQ( 0, tree.nearest( points[i] ).distance ); }
+    std::vector< kd_tree< 3 >::neighbour > neighbours;
+    tree.nearest( points[0], points.size() + 10, neighbours );
+    EXPECT_EQ( points.size(), neighbours.size() );
+    std::vector< bool > found( points.size(), false );
+    for( std::size_t k = 0; k < neighbours.size(); ++k ) { found[ neighbours[k].index ] = true; }
+    EXPECT_TRUE( std::find( found.begin(), found.end(), false ) == found.end() );
+}
+
+TEST( kd_tree, radius )
+{
+    const points_t& points = make_points_( 5000, 4 );
+    const points_t& queries = make_points_( 300, 5 );
+    kd_tree< 3 > tree( points.begin(), points.end() );
+    double radii[] = { 0, 0.5, 3, 20 };
+    for( unsigned int r = 0; r < 4; ++r )
+    {
+        for( std::size_t i = 0; i < queries.size(); ++i )
+        {
+            std::vector< std::size_t > expected;
+            for( std::size_t j = 0; j < points.size(); ++j ) { if( ( points[j] - queries[i] ).squaredNorm() <= radii[r] * radii[r] ) { expected.push_back( j ); } }
+            EXPECT_EQ( expected.size(), tree.radius_count( queries[i], radii[r] ) );
+            std::vector< kd_tree< 3 >::neighbour > neighbours;
+            tree.radius( queries[i], radii[r], neighbours );
+            std::vector< std::size_t > indices;
+            for( std::size_t k = 0; k < neighbours.size(); ++k ) { indices.push_back( neighbours[k].index ); if( k > 0 ) { EXPECT_LE( neighbours[k - 1].distance, neighbours[k].distance ); } }
+            std::sort( indices.begin(), indices.end() );
+            EXPECT_TRUE( expected == indices );
+        }
+    }
+}
+
+TEST( kd_tree, batch )
+{
+    const points_t& points = make_points_( 5000, 6 );
+    const points_t& queries = make_points_( 3000, 7 );
+    kd_tree< 3 > tree( points.begin(), points.end() );
+    std::vector< kd_tree< 3 >::neighbour > nearest;
+    tree.nearest( queries, nearest );
+    std::vector< std::vector< kd_tree< 3 >::neighbour > > k_nearest;
+    tree.nearest( queries, 5, k_nearest );
+    std::vector< std::size_t > counts;
+    tree.radius_count( queries, 2.0, counts );
+    ASSERT_EQ( queries.size(), nearest.size() );
+    ASSERT_EQ( queries.size(), k_nearest.size() );
+    ASSERT_EQ( queries.size(), counts.size() );
+    for( std::size_t i = 0; i < queries.size(); ++i )
+    {
+        EXPECT_EQ( tree.nearest( queries[i] ).distance, nearest[i].distance );
+        std::vector< kd_tree< 3 >::neighbour > neighbours;
+        tree.nearest( queries[i], 5, neighbours );
+        ASSERT_EQ( neighbours.size(), k_nearest[i].size() );
+        for( std::size_t k = 0; k < neighbours.size(); ++k ) { EXPECT_EQ( neighbours[k].index, k_nearest[i][k].index ); }
+        EXPECT_EQ( tree.radius_count( queries[i], 2.0 ), counts[i] );
+    }
+}
+
+TEST( kd_tree, two_dimensions )
+{
+    std::vector< Eigen::Vector2d, Eigen::aligned_allocator< Eigen::Vector2d > > points;
+    for( int i = 0; i < 10; ++i ) { for( int j = 0; j < 10; ++j ) { points.push_back( Eigen::Vector2d( i, j ) ); } }
+    kd_tree< 2 > tree( points.begin(), points.end(), 4 );
+    EXPECT_EQ( 5u, tree.radius_count( Eigen::Vector2d( 5, 5 ), 1 ) );
+    EXPECT_EQ( 55u, tree.nearest( Eigen::Vector2d( 5.1, 4.9 ) ).index );
+}
+
+TEST( kd_tree, empty )
+{
+    points_t points;
+    kd_tree< 3 > tree( points.begin(), points.end() );
+    EXPECT_EQ( 0u, tree.size() );
+    EXPECT_EQ( 0u, tree.radius_count( Eigen::Vector3d::Zero(), 10 ) );
+    std::vector< kd_tree< 3 >::neighbour > neighbours;
+    tree.nearest( Eigen::Vector3d::Zero(), 3, neighbours );
+    EXPECT_TRUE( neighbours.empty() );
+    EXPECT_THROW( tree.nearest( Eigen::Vector3d::Zero() ), comma::exception );
+}
+
+} } // namespace snark { namespace test {
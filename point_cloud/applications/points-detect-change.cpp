@@ -36,19 +36,32 @@
 #include <fcntl.h>
 #include <io.h>
 #endif
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <ctime>
 #include <string.h>
 #include <fstream>
+#include <limits>
+#include <vector>
 #include <boost/array.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
 #include <boost/optional.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <comma/application/command_line_options.h>
 #include <comma/application/signal_flag.h>
+#include <comma/base/exception.h>
 #include <comma/base/types.h>
+#include <comma/csv/binary.h>
 #include <comma/csv/stream.h>
 #include <comma/math/compare.h>
 #include <comma/string/string.h>
 #include <comma/visiting/traits.h>
 #include <snark/math/range_bearing_elevation.h>
+#include <snark/point_cloud/spherical_grid.h>
 #include <snark/point_cloud/voxel_map.h>
 #include <snark/visiting/traits.h>
 //#include <google/profiler.h>
@@ -66,9 +79,20 @@ void usage( bool long_help = false )
     std::cerr << "    --range-threshold,-r=<value>: if present, output only the points" << std::endl;
     std::cerr << "                                  that have reference points nearer than range + range-threshold" << std::endl;
     std::cerr << "    --angle-threshold,-a=<value>: angular radius in radians" << std::endl;
+    std::cerr << "    --sparse: keep bearing/elevation cells in a hash map instead of a dense grid over bearing/elevation extents of the reference point cloud;" << std::endl;
+    std::cerr << "              by default, dense grid is used, unless it would have more cells than 9 times the number of reference points," << std::endl;
+    std::cerr << "              thus memory used in either case is proportional to the size of the reference point cloud" << std::endl;
+    std::cerr << "    --index=<filename>: binary only; memory-map reference point cloud instead of loading it" << std::endl;
+    std::cerr << "                        and use bearing/elevation index from <filename>, which is built and saved, if it does not exist" << std::endl;
+    std::cerr << "                        or does not match reference point cloud (size, modification time, checksum of sampled records)," << std::endl;
+    std::cerr << "                        fields, format or angle threshold;" << std::endl;
+    std::cerr << "                        memory-mapped index and reference point cloud are shared between processes" << std::endl;
     std::cerr << "    --verbose,-v: more debug output" << std::endl;
     std::cerr << std::endl;
     std::cerr << "fields: r,b,e: range, bearing, elevation; default: r,b,e" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "example" << std::endl;
+    std::cerr << "    cat points.bin | points-detect-change reference.bin --binary=3d --angle-threshold=0.01 --index=reference.index > changes.bin" << std::endl;
     if( long_help )
     {
         std::cerr << std::endl;
@@ -198,33 +222,38 @@ struct cell
     }
 
     const entry* trace( const point_t& p, double threshold, boost::optional< double > range_threshold ) const
+    {
+        return points.empty() ? NULL : trace( &points[0], &points[0] + points.size(), p, threshold, range_threshold );
+    }
+
+    static const entry* trace( const entry* begin, const entry* end, const point_t& p, double threshold, boost::optional< double > range_threshold )
     {
         const entry* e = NULL;
         static const double threshold_square = threshold * threshold; // static: quick and dirty
         boost::optional< point_t > min;
         boost::optional< point_t > max;
-        for( std::size_t i = 0; i < points.size(); ++i )
+        for( const entry* it = begin; it != end; ++it )
         {
-            double db = abs_bearing_distance_( p.bearing(), points[i].point.bearing() );
-            double de = p.elevation() - points[i].point.elevation();
+            double db = abs_bearing_distance_( p.bearing(), it->point.bearing() );
+            double de = p.elevation() - it->point.elevation();
             if( ( db * db + de * de ) > threshold_square ) { continue; }
-            if( range_threshold && points[i].point.range() < ( p.range() + *range_threshold ) ) { return NULL; }
+            if( range_threshold && it->point.range() < ( p.range() + *range_threshold ) ) { return NULL; }
             if( min ) // todo: quick and dirty, fix point_tRBE and use extents
             {
-                if( points[i].point.range() < min->range() )
+                if( it->point.range() < min->range() )
                 {
-                    min->range( points[i].point.range() );
-                    e = &points[i];
+                    min->range( it->point.range() );
+                    e = it;
                 }
-                min->bearing( bearing_min_( min->bearing(), points[i].point.bearing() ) );
-                min->elevation( std::min( min->elevation(), points[i].point.elevation() ) );
-                max->bearing( bearing_max_( max->bearing(), points[i].point.bearing() ) );
-                max->elevation( std::max( max->elevation(), points[i].point.elevation() ) );
+                min->bearing( bearing_min_( min->bearing(), it->point.bearing() ) );
+                min->elevation( std::min( min->elevation(), it->point.elevation() ) );
+                max->bearing( bearing_max_( max->bearing(), it->point.bearing() ) );
+                max->elevation( std::max( max->elevation(), it->point.elevation() ) );
             }
             else
             {
-                e = &points[i];
-                min = max = points[i].point;
+                e = it;
+                min = max = it->point;
             }
         }
         return    !min
@@ -234,6 +263,332 @@ struct cell
     }
 };
 
+typedef snark::voxel_map< cell, 2 > grid_t;
+
+/// point neighbourhood in which reference points get inserted; i, j: -1, 0, or 1
+static grid_t::point_type neighbour_( const point_t& p, double threshold, int i, int j )
+{
+    double bearing = p.bearing() + threshold * i;
+    if( bearing < -M_PI ) { bearing += ( M_PI * 2 ); }
+    else if( bearing >= M_PI ) { bearing -= ( M_PI * 2 ); }
+    return grid_t::point_type( bearing, p.elevation() + threshold * j );
+}
+
+static void add_to_sparse_grid_( grid_t& grid, const point_t& p, comma::uint64 index, double threshold )
+{
+    cell::entry entry( p, index );
+    for( int i = -1; i < 2; ++i ) { for( int j = -1; j < 2; ++j ) { grid.touch_at( neighbour_( p, threshold, i, j ) )->second.add( entry ); } }
+}
+
+/// dense bearing/elevation grid over the bearing and elevation extents of reference points
+/// with entries of all cells stored contiguously, cell by cell (compressed sparse row layout);
+/// built in passes: find extents, count entries per cell, then fill
+class dense_grid
+{
+    public:
+        dense_grid( double threshold )
+            : index_( threshold )
+            , threshold_( threshold )
+            , elevation_begin_( -M_PI / 2 - threshold )
+            , max_bearing_( std::max( std::size_t( M_PI * 2 / threshold ), std::size_t( 1 ) ) )
+            , bearing_begin_( 0 )
+            , elevation_offset_( 0 )
+            , bearings_( 0 )
+            , elevations_( 0 )
+        {
+        }
+
+        /// @return false and build nothing, if the grid would have more cells than entries,
+        ///         i.e. points are too sparse for a dense grid to pay off and a hash map should be used instead
+        bool build( const std::vector< point_t >& points )
+        {
+            std::size_t b, e;
+            std::size_t bearing_begin = max_bearing_, bearing_end = 0, elevation_begin = std::numeric_limits< std::size_t >::max(), elevation_end = 0;
+            for( std::size_t k = 0; k < points.size(); ++k )
+            {
+                for( int i = -1; i < 2; ++i )
+                {
+                    for( int j = -1; j < 2; ++j )
+                    {
+                        if( !absolute_( neighbour_( points[k], threshold_, i, j ), b, e ) ) { continue; }
+                        bearing_begin = std::min( bearing_begin, b );
+                        bearing_end = std::max( bearing_end, b + 1 );
+                        elevation_begin = std::min( elevation_begin, e );
+                        elevation_end = std::max( elevation_end, e + 1 );
+                    }
+                }
+            }
+            ends_.clear();
+            entries_.clear();
+            if( bearing_begin >= bearing_end ) { bearings_ = elevations_ = 0; return true; }
+            if( comma::uint64( bearing_end - bearing_begin ) * ( elevation_end - elevation_begin ) > comma::uint64( points.size() ) * 9 ) { return false; }
+            bearing_begin_ = bearing_begin;
+            elevation_offset_ = elevation_begin;
+            bearings_ = bearing_end - bearing_begin;
+            elevations_ = elevation_end - elevation_begin;
+            ends_.resize( bearings_ * elevations_, 0 );
+            comma::uint64* ends = &ends_[0];
+            std::size_t c;
+            for( std::size_t k = 0; k < points.size(); ++k )
+            {
+                for( int i = -1; i < 2; ++i ) { for( int j = -1; j < 2; ++j ) { if( cell_( neighbour_( points[k], threshold_, i, j ), c ) ) { ++ends[c]; } } }
+            }
+            comma::uint64 sum = 0;
+            for( std::size_t i = 0; i < ends_.size(); ++i ) { comma::uint64 count = ends[i]; ends[i] = sum; sum += count; } // ends are begins until filled
+            entries_.resize( sum );
+            for( std::size_t k = 0; k < points.size(); ++k )
+            {
+                cell::entry entry( points[k], k );
+                for( int i = -1; i < 2; ++i ) { for( int j = -1; j < 2; ++j ) { if( cell_( neighbour_( points[k], threshold_, i, j ), c ) ) { entries_[ ends[c]++ ] = entry; } } }
+            }
+            return true;
+        }
+
+        const cell::entry* trace( const point_t& p, boost::optional< double > range_threshold ) const
+        {
+            std::size_t c;
+            if( !cell_( grid_t::point_type( p.bearing(), p.elevation() ), c ) ) { return NULL; }
+            comma::uint64 begin = c == 0 ? 0 : ends_[ c - 1 ];
+            comma::uint64 end = ends_[c];
+            return begin == end ? NULL : cell::trace( &entries_[0] + begin, &entries_[0] + end, p, threshold_, range_threshold );
+        }
+
+        std::size_t size() const { return ends_.size(); }
+
+        /// @return approximate memory used in bytes
+        std::size_t memory() const { return ends_.capacity() * sizeof( comma::uint64 ) + entries_.capacity() * sizeof( cell::entry ); }
+
+    private:
+        snark::bearing_elevation_grid::index index_;
+        std::vector< comma::uint64 > ends_; // ends of cell entries, cells in row-major order
+        std::vector< cell::entry > entries_;
+        double threshold_;
+        double elevation_begin_;
+        std::size_t max_bearing_;
+        std::size_t bearing_begin_; // extents of cells covered by the grid
+        std::size_t elevation_offset_;
+        std::size_t bearings_;
+        std::size_t elevations_;
+
+        bool absolute_( const grid_t::point_type& p, std::size_t& b, std::size_t& e ) const // cell index on the full sphere
+        {
+            double de = ( p[1] - elevation_begin_ ) / threshold_; // elevation not normalised, since neighbour cells extend past the poles
+            if( de < 0 ) { return false; }
+            e = de;
+            b = index_( p[0], 0 )[0];
+            return b < max_bearing_;
+        }
+
+        bool cell_( const grid_t::point_type& p, std::size_t& c ) const
+        {
+            std::size_t b, e;
+            if( !absolute_( p, b, e ) || b < bearing_begin_ || e < elevation_offset_ ) { return false; }
+            b -= bearing_begin_;
+            e -= elevation_offset_;
+            if( b >= bearings_ || e >= elevations_ ) { return false; }
+            c = b * elevations_ + e;
+            return true;
+        }
+};
+
+/// persistent bearing/elevation index of a memory-mapped binary reference point cloud:
+/// header, cells with ranges of entries sorted by cell index, entries of all cells
+/// (each reference point is an entry in the 3x3 cells around it);
+/// cells are looked up by binary search directly in the mapped file, thus loading the index takes constant time
+struct index_file
+{
+    struct header
+    {
+        char magic[8];
+        comma::uint32 version;
+        comma::uint32 entry_size;
+        comma::uint64 reference_size;
+        comma::uint64 record_size;
+        double threshold;
+        comma::uint64 cells;
+        comma::uint64 entries;
+        comma::int64 reference_time; // last modification time of reference
+        comma::uint64 reference_checksum; // checksum of a sample of reference records, in case reference changed within the same second
+        char format[256]; // fields and binary format of reference, for validation
+    };
+
+    struct cell
+    {
+        boost::array< comma::int32, 2 > index;
+        comma::uint64 begin;
+        comma::uint64 end;
+        bool operator<( const cell& rhs ) const { return index < rhs.index; }
+    };
+
+    struct range
+    {
+        comma::uint64 begin;
+        comma::uint64 end;
+    };
+
+    static header make_header( const comma::csv::options& csv, const char* reference, comma::uint64 reference_size, std::time_t reference_time, double threshold )
+    {
+        header h;
+        ::memset( &h, 0, sizeof( header ) );
+        ::memcpy( h.magic, "pdcindex", 8 );
+        h.version = 2;
+        h.entry_size = sizeof( ::cell::entry );
+        h.reference_size = reference_size;
+        h.record_size = csv.format().size();
+        h.threshold = threshold;
+        h.reference_time = reference_time;
+        h.reference_checksum = checksum( reference, reference_size, h.record_size );
+        std::string format = csv.fields + ";" + csv.format().string();
+        ::strncpy( h.format, format.c_str(), sizeof( h.format ) - 1 );
+        return h;
+    }
+
+    static bool matches( const header& h, const header& expected )
+    {
+        return    ::memcmp( h.magic, expected.magic, 8 ) == 0
+               && h.version == expected.version
+               && h.entry_size == expected.entry_size
+               && h.reference_size == expected.reference_size
+               && h.record_size == expected.record_size
+               && h.threshold == expected.threshold
+               && h.reference_time == expected.reference_time
+               && h.reference_checksum == expected.reference_checksum
+               && ::strncmp( h.format, expected.format, sizeof( h.format ) ) == 0;
+    }
+
+    /// @return fnv-1a hash of up to 1024 evenly spaced reference records
+    static comma::uint64 checksum( const char* reference, comma::uint64 reference_size, comma::uint64 record_size )
+    {
+        comma::uint64 size = reference_size / record_size;
+        comma::uint64 step = size / 1024 + 1;
+        comma::uint64 hash = 14695981039346656037ULL;
+        for( comma::uint64 k = 0; k < size; k += step )
+        {
+            const char* record = reference + k * record_size;
+            for( comma::uint64 i = 0; i < record_size; ++i ) { hash = ( hash ^ static_cast< unsigned char >( record[i] ) ) * 1099511628211ULL; }
+        }
+        return hash;
+    }
+
+    /// @return range of entries of the cell with given index, empty if there is no such cell
+    static range find( const cell* cells, comma::uint64 size, const boost::array< comma::int32, 2 >& index )
+    {
+        cell c;
+        c.index = index;
+        const cell* it = std::lower_bound( cells, cells + size, c );
+        range r;
+        r.begin = 0;
+        r.end = 0;
+        if( it != cells + size && it->index == index ) { r.begin = it->begin; r.end = it->end; }
+        return r;
+    }
+
+    /// build index in two passes over the reference: count entries per cell, then write entries in place
+    static void build( const std::string& filename, const char* reference, header h, const comma::csv::options& csv )
+    {
+        comma::csv::binary< point_t > binary( csv );
+        comma::uint64 size = h.reference_size / h.record_size;
+        snark::voxel_map< range, 2 > ranges( grid_t::point_type( h.threshold, h.threshold ) );
+        point_t p;
+        for( comma::uint64 k = 0; k < size; ++k )
+        {
+            binary.get( p, reference + k * h.record_size );
+            for( int i = -1; i < 2; ++i ) { for( int j = -1; j < 2; ++j ) { ++ranges.touch_at( neighbour_( p, h.threshold, i, j ) )->second.end; } }
+        }
+        h.cells = ranges.size();
+        h.entries = 0;
+        for( snark::voxel_map< range, 2 >::iterator it = ranges.begin(); it != ranges.end(); ++it )
+        {
+            it->second.begin = h.entries;
+            h.entries += it->second.end;
+            it->second.end = it->second.begin; // from now on, end of entries written so far
+        }
+        std::string temporary = filename + ".tmp";
+        {
+            std::ofstream ofs( temporary.c_str(), std::ios::binary | std::ios::trunc );
+            if( !ofs.is_open() ) { COMMA_THROW( comma::exception, "failed to open \"" << temporary << "\"" ); }
+            ofs.write( reinterpret_cast< const char* >( &h ), sizeof( header ) );
+            std::vector< index_file::cell > cells;
+            cells.reserve( ranges.size() );
+            for( snark::voxel_map< range, 2 >::const_iterator it = ranges.begin(); it != ranges.end(); ++it )
+            {
+                index_file::cell c;
+                c.index = it->first;
+                c.begin = it->second.begin;
+                c.end = it->second.begin; // set once entries are written
+                cells.push_back( c );
+            }
+            std::sort( cells.begin(), cells.end() );
+            if( !cells.empty() ) { ofs.write( reinterpret_cast< const char* >( &cells[0] ), cells.size() * sizeof( index_file::cell ) ); }
+            ofs.seekp( sizeof( header ) + h.cells * sizeof( index_file::cell ) + h.entries * sizeof( ::cell::entry ) - 1 );
+            ofs.put( 0 );
+            if( !ofs.good() ) { COMMA_THROW( comma::exception, "failed to write \"" << temporary << "\"" ); }
+        }
+        boost::interprocess::file_mapping mapping( temporary.c_str(), boost::interprocess::read_write );
+        boost::interprocess::mapped_region region( mapping, boost::interprocess::read_write );
+        char* data = static_cast< char* >( region.get_address() );
+        index_file::cell* cells = reinterpret_cast< index_file::cell* >( data + sizeof( header ) );
+        ::cell::entry* entries = reinterpret_cast< ::cell::entry* >( data + sizeof( header ) + h.cells * sizeof( index_file::cell ) );
+        for( comma::uint64 k = 0; k < size; ++k )
+        {
+            binary.get( p, reference + k * h.record_size );
+            ::cell::entry entry( p, k );
+            for( int i = -1; i < 2; ++i ) { for( int j = -1; j < 2; ++j ) { entries[ ranges.find( neighbour_( p, h.threshold, i, j ) )->second.end++ ] = entry; } }
+        }
+        for( comma::uint64 i = 0; i < h.cells; ++i ) { cells[i].end = ranges.find( cells[i].index )->second.end; }
+        region.flush();
+        if( std::rename( temporary.c_str(), filename.c_str() ) != 0 ) { COMMA_THROW( comma::exception, "failed to rename \"" << temporary << "\" to \"" << filename << "\"" ); }
+    }
+};
+
+/// change detection against memory-mapped binary reference point cloud, using persistent index
+static int run_indexed( const std::string& reference_filename, const std::string& index_filename, const comma::csv::options& csv, double threshold, boost::optional< double > range_threshold, const comma::signal_flag& is_shutdown )
+{
+    if( !csv.binary() ) { std::cerr << "points-detect-change: --index: expected binary reference point cloud, please specify --binary" << std::endl; return 1; }
+    boost::interprocess::file_mapping reference_mapping( reference_filename.c_str(), boost::interprocess::read_only );
+    boost::interprocess::mapped_region reference_region( reference_mapping, boost::interprocess::read_only );
+    const char* reference = static_cast< const char* >( reference_region.get_address() );
+    index_file::header expected = index_file::make_header( csv, reference, reference_region.get_size(), boost::filesystem::last_write_time( reference_filename ), threshold );
+    bool valid = false;
+    if( boost::filesystem::exists( index_filename ) && boost::filesystem::file_size( index_filename ) >= sizeof( index_file::header ) )
+    {
+        index_file::header h;
+        std::ifstream ifs( index_filename.c_str(), std::ios::binary );
+        ifs.read( reinterpret_cast< char* >( &h ), sizeof( index_file::header ) );
+        valid = ifs.good() && index_file::matches( h, expected ) && boost::filesystem::file_size( index_filename ) == sizeof( index_file::header ) + h.cells * sizeof( index_file::cell ) + h.entries * sizeof( cell::entry );
+        if( verbose && !valid ) { std::cerr << "points-detect-change: index in \"" << index_filename << "\" does not match reference point cloud; rebuilding..." << std::endl; }
+    }
+    if( !valid )
+    {
+        if( verbose ) { std::cerr << "points-detect-change: building index of \"" << reference_filename << "\"..." << std::endl; }
+        index_file::build( index_filename, reference, expected, csv );
+    }
+    boost::interprocess::file_mapping index_mapping( index_filename.c_str(), boost::interprocess::read_only );
+    boost::interprocess::mapped_region index_region( index_mapping, boost::interprocess::read_only );
+    const char* data = static_cast< const char* >( index_region.get_address() );
+    const index_file::header& header = *reinterpret_cast< const index_file::header* >( data );
+    if( !index_file::matches( header, expected ) ) { std::cerr << "points-detect-change: index in \"" << index_filename << "\" changed while loading" << std::endl; return 1; }
+    const index_file::cell* cells = reinterpret_cast< const index_file::cell* >( data + sizeof( index_file::header ) );
+    const cell::entry* entries = reinterpret_cast< const cell::entry* >( data + sizeof( index_file::header ) + header.cells * sizeof( index_file::cell ) );
+    grid_t::point_type resolution( threshold, threshold );
+    if( verbose ) { std::cerr << "points-detect-change: mapped reference point cloud: " << header.reference_size / header.record_size << " points in a grid of size " << header.cells << " voxels" << std::endl; }
+    comma::csv::input_stream< point_t > istream( std::cin, csv );
+    unsigned int size = csv.format().size();
+    while( std::cin.good() && !std::cin.eof() && !is_shutdown )
+    {
+        const point_t* p = istream.read();
+        if( !p ) { break; }
+        index_file::range r = index_file::find( cells, header.cells, grid_t::index_of( grid_t::point_type( p->bearing(), p->elevation() ), resolution ) );
+        if( r.begin == r.end ) { continue; }
+        const cell::entry* q = cell::trace( entries + r.begin, entries + r.end, *p, threshold, range_threshold );
+        if( !q ) { continue; }
+        std::cout.write( istream.binary().last(), size );
+        std::cout.write( reference + q->index * header.record_size, header.record_size );
+    }
+    if( is_shutdown ) { std::cerr << "points-detect-change: caught signal" << std::endl; return 1; }
+    return 0;
+}
+
 int main( int argc, char** argv )
 {
     try
@@ -254,7 +609,7 @@ int main( int argc, char** argv )
         csv.full_xpath = false;
         double threshold = options.value< double >( "--angle-threshold,-a" );
         boost::optional< double > range_threshold = options.optional< double >( "--range-threshold,-r" );
-        std::vector< std::string > unnamed = options.unnamed( "--verbose,-v", "--binary,-b,--delimiter,-d,--fields,-f,--range-threshold,-r,--angle-threshold,-a" );
+        std::vector< std::string > unnamed = options.unnamed( "--verbose,-v,--sparse", "--binary,-b,--delimiter,-d,--fields,-f,--range-threshold,-r,--angle-threshold,-a,--index" );
         if( unnamed.empty() ) { std::cerr << "points-detect-change: please specify file with the reference point cloud" << std::endl; return 1; }
         if( unnamed.size() > 1 ) { std::cerr << "points-detect-change: expected file with the reference point cloud, got: " << comma::join( unnamed, ' ' ) << std::endl; return 1; }
         #ifdef WIN32
@@ -270,12 +625,17 @@ int main( int argc, char** argv )
             std::ifstream ifs( unnamed[0].c_str() );
         #endif
         if( !ifs.is_open() ) { std::cerr << "points-detect-change: failed to open \"" << unnamed[0] << "\"" << std::endl; return 1; }
+        comma::signal_flag is_shutdown;
+        if( options.exists( "--index" ) ) { return run_indexed( unnamed[0], options.value< std::string >( "--index" ), csv, threshold, range_threshold, is_shutdown ); }
+        bool sparse = options.exists( "--sparse" );
         comma::csv::input_stream< point_t > ifstream( ifs, csv );
-        typedef snark::voxel_map< cell, 2 > grid_t;
         resolution = grid_t::point_type( threshold, threshold );
         grid_t grid( resolution );
+        boost::scoped_ptr< dense_grid > dense;
+        if( !sparse ) { dense.reset( new dense_grid( threshold ) ); }
+        std::vector< point_t > points;
         if( verbose ) { std::cerr << "points-detect-change: loading reference point cloud..." << std::endl; }
-        comma::signal_flag is_shutdown;
+        boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
         comma::uint64 index = 0;
         //{ ProfilerStart( "points-detect-change.prof" );
         std::deque< std::vector< char > > buffers;
@@ -283,19 +643,8 @@ int main( int argc, char** argv )
         {
             const point_t* p = ifstream.read();
             if( !p ) { break; }
-            cell::entry entry( *p, index );
-            for( int i = -1; i < 2; ++i )
-            {
-                for( int j = -1; j < 2; ++j )
-                {
-                    double bearing = p->bearing() + threshold * i;
-                    if( bearing < -M_PI ) { bearing += ( M_PI * 2 ); }
-                    else if( bearing >= M_PI ) { bearing -= ( M_PI * 2 ); }
-                    double elevation = p->elevation() + threshold * j;
-                    grid_t::iterator it = grid.touch_at( grid_t::point_type( bearing, elevation ) );
-                    it->second.add( entry ); //it->second.add_to_grid( entry );
-                }
-            }
+            if( sparse ) { add_to_sparse_grid_( grid, *p, index, threshold ); }
+            else { points.push_back( *p ); }
             buffers.push_back( std::vector< char >() ); // todo: quick and dirty; use memory map instead?
             if( csv.binary() )
             {
@@ -311,15 +660,37 @@ int main( int argc, char** argv )
             }
             ++index;
         }
-        if( verbose ) { std::cerr << "points-detect-change: loaded reference point cloud: " << index << " points in a grid of size " << grid.size() << " voxels" << std::endl; }
+        if( dense && !dense->build( points ) )
+        {
+            if( verbose ) { std::cerr << "points-detect-change: reference point cloud too sparse for a dense grid, using sparse grid" << std::endl; }
+            dense.reset();
+            for( std::size_t k = 0; k < points.size(); ++k ) { add_to_sparse_grid_( grid, points[k], k, threshold ); }
+        }
+        std::vector< point_t >().swap( points );
+        if( verbose )
+        {
+            std::size_t memory = 0;
+            if( dense ) { memory = dense->memory(); }
+            else { for( grid_t::const_iterator it = grid.begin(); it != grid.end(); ++it ) { memory += sizeof( grid_t::value_type ) + it->second.points.capacity() * sizeof( cell::entry ); } }
+            std::cerr << "points-detect-change: loaded reference point cloud: " << index << " points in a " << ( dense ? "dense" : "sparse" ) << " grid of size " << ( dense ? dense->size() : grid.size() ) << " voxels" << std::endl;
+            std::cerr << "points-detect-change: loading and indexing took " << double( ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() ) / 1e6 << " seconds; grid uses about " << memory / 1048576 << "MB" << std::endl;
+        }
         comma::csv::input_stream< point_t > istream( std::cin, csv );
         while( std::cin.good() && !std::cin.eof() && !is_shutdown )
         {
             const point_t* p = istream.read();
             if( !p ) { break; }
-            grid_t::const_iterator it = grid.find( grid_t::point_type( p->bearing(), p->elevation() ) );
-            if( it == grid.end() ) { continue; }
-            const cell::entry* q = it->second.trace( *p, threshold, range_threshold );
+            const cell::entry* q = NULL;
+            if( dense )
+            {
+                q = dense->trace( *p, range_threshold );
+            }
+            else
+            {
+                grid_t::const_iterator it = grid.find( grid_t::point_type( p->bearing(), p->elevation() ) );
+                if( it == grid.end() ) { continue; }
+                q = it->second.trace( *p, threshold, range_threshold );
+            }
             if( !q ) { continue; }
             if( csv.binary() )
             {
@@ -7,13 +7,17 @@
 #include <comma/name_value/parser.h>
 #include <snark/visiting/eigen.h>
 #include <iostream>
+#include <map>
+#include <boost/optional.hpp>
 #include <boost/tokenizer.hpp>
 #include <boost/thread.hpp>
 #include <Eigen/Dense>
 #include <snark/math/rotation_matrix.h>
-#include <snark/math/geometry/polytope.h>
+#include <snark/math/geometry/compiled_polytope.h>
+#include <snark/math/geometry/polytope_index.h>
 #include <snark/math/applications/frame.h>
 #include <string>
+#include <vector>
 
 
 struct bounds_t
@@ -45,6 +49,22 @@ struct joined_point
     bounding_point bounding;
 };
 
+struct box_t
+{
+    box_t(): id(0) {}
+    comma::uint32 id;
+    snark::applications::position position;
+    bounds_t bounds;
+};
+
+struct plane_t
+{
+    plane_t(): id(0), normal( Eigen::Vector3d::Zero() ), offset(0) {}
+    comma::uint32 id;
+    Eigen::Vector3d normal;
+    double offset;
+};
+
 namespace comma
 {
     namespace visiting
@@ -105,6 +125,38 @@ namespace comma
                 v.apply( "bounding", p.bounding );
             }
         };
+
+        template <> struct traits< box_t >
+        {
+            template < typename K, typename V > static void visit( const K&, box_t& p, V& v )
+            {
+                v.apply( "id", p.id );
+                v.apply( "position", p.position );
+                v.apply( "bounds", p.bounds );
+            }
+            template < typename K, typename V > static void visit( const K&, const box_t& p, V& v )
+            {
+                v.apply( "id", p.id );
+                v.apply( "position", p.position );
+                v.apply( "bounds", p.bounds );
+            }
+        };
+
+        template <> struct traits< plane_t >
+        {
+            template < typename K, typename V > static void visit( const K&, plane_t& p, V& v )
+            {
+                v.apply( "id", p.id );
+                v.apply( "normal", p.normal );
+                v.apply( "offset", p.offset );
+            }
+            template < typename K, typename V > static void visit( const K&, const plane_t& p, V& v )
+            {
+                v.apply( "id", p.id );
+                v.apply( "normal", p.normal );
+                v.apply( "offset", p.offset );
+            }
+        };
     }
 }
 
@@ -134,14 +186,33 @@ static void usage()
     std::cerr << "                    or shorthand: bounded,bounding" << std::endl;
     std::cerr << std::endl;
     std::cerr << "  shape: points are assumed to be joined with the bounding stream" << std::endl;
+    std::cerr << "      consecutive points with the same bounding position are tested against the box in batches, which is faster for binary input" << std::endl;
     std::cerr << "      fields: " << comma::join( comma::csv::names< joined_point >( true ), ',' ) << std::endl;
     std::cerr << std::endl;
+    std::cerr << "  shapes <shapes>: points are tested against many boxes or polytopes loaded from file, e.g. regions of interest from a site map" << std::endl;
+    std::cerr << "      points inside of any shape are filtered, unless --inside is given" << std::endl;
+    std::cerr << "      shapes are indexed by a bounding volume hierarchy, thus the cost of testing a point grows logarithmically with the number of shapes" << std::endl;
+    std::cerr << std::endl;
+    std::cerr << "      <shapes>: boxes, one per record, example: \"boxes.csv;fields=id,x,y,z,roll,pitch,yaw,front,back,right,left,top,bottom\"" << std::endl;
+    std::cerr << "          fields: " << comma::join( comma::csv::names< box_t >( false ), ',' ) << "; default: x,y,z,roll,pitch,yaw,front,back,right,left,top,bottom" << std::endl;
+    std::cerr << "          if id is not given, shapes are numbered in the order of records" << std::endl;
+    std::cerr << "          --error-margin is added to the bounds of each box" << std::endl;
+    std::cerr << "          if --planes given: convex polytopes as planes x*<normal> >= <offset> with the normal pointing inside, one plane per record, planes with the same id form one polytope" << std::endl;
+    std::cerr << "          bounding boxes of polytopes are computed from their vertices at load time; unbounded polytopes are tested for every point" << std::endl;
+    std::cerr << "          fields: " << comma::join( comma::csv::names< plane_t >( false ), ',' ) << "; default: id,x,y,z,offset" << std::endl;
+    std::cerr << "      fields: as for stream" << std::endl;
+    std::cerr << std::endl;
     std::cerr << "<options>:" << std::endl;
     std::cerr << std::endl;
     std::cerr << "      --bounds=<front>,<back>,<right>,<left>,<top>,<bottom> the values represent the distances of the faces of the bounding box to the centre of the bounding stream in the bounding frame" << std::endl;
     std::cerr << "      --error-margin=<margin> error margin value added to bounds (for user convenience), default: 0.5" << std::endl;
     std::cerr << "      --output-all: output all points" << std::endl;
     std::cerr << std::endl;
+    std::cerr << "  shapes options" << std::endl;
+    std::cerr << "      --ids: output each point once for each shape containing it, with the shape id appended as ui; points outside of all shapes are not output" << std::endl;
+    std::cerr << "      --inside: filter points outside of all shapes instead of points inside of any shape" << std::endl;
+    std::cerr << "      --planes: shapes are given as planes, see above" << std::endl;
+    std::cerr << std::endl;
     std::cerr << "examples" << std::endl;
     std::cerr << "    cat points.csv | points-grep stream --fields=bounded \"nav.csv;fields=t,x,y,z,roll,pitch,yaw\" --bounds=1.0,2.0,1.0,2.0,1.0,2.0 --error-margin=0.1" << std::endl;
     std::cerr << "    cat points.csv | points-grep stream --fields=t,coordinates,block,flag \"nav.csv;fields=t,x,y,z,roll,pitch,yaw\" --bounds=1.0,2.0,1.0,2.0,1.0,2.0 --error-margin=0.1" << std::endl;
@@ -150,49 +221,124 @@ static void usage()
     std::cerr << "    cat points.csv | points-grep shape --fields=bounded,bounding --bounds=1.0,2.0,1.0,2.0,1.0,2.0" << std::endl;
     std::cerr << "    cat points.csv | points-grep shape --fields=bounded/t,bounded/coordinates,bounded/flag,bounding/t,bounding/x,bounding/y,bounding/z,bounding/roll,bounding/pitch,bounding/yaw --bounds=1.0,1.0,1.0,1.0,1.0,1.0 --error-margin=1.0" << std::endl;
     std::cerr << std::endl;
+    std::cerr << "    cat points.csv | points-grep shapes --fields=x,y,z \"boxes.csv;fields=id,x,y,z,yaw,front,back,right,left,top,bottom\" --error-margin=0 --inside" << std::endl;
+    std::cerr << "    cat points.csv | points-grep shapes --fields=x,y,z \"planes.csv;fields=id,x,y,z,offset\" --planes --ids" << std::endl;
+    std::cerr << std::endl;
     exit( 0 );
 }
 
 static double offset;
 static bounds_t bounds;
 
-void filter_point(joined_point& pq)
-{
-    //get polygon from bounds
-    Eigen::MatrixXd origins(3,7); //origin, front, back, right, left, top, bottom
+// the box is compiled once per distinct bounding position, since consecutive points usually share it
+static snark::geometry::compiled_polytope shape;
+static boost::optional< snark::applications::position > shape_position;
 
+static bool same_position( const snark::applications::position& p, const snark::applications::position& q ) { return p.coordinates == q.coordinates && p.orientation == q.orientation; }
 
-    origins<<0, bounds.front + offset, -bounds.back - offset, 0, 0, 0, 0,
-             0, 0, 0, bounds.right + offset, -bounds.left - offset, 0, 0,
-             0, 0, 0, 0, 0, -bounds.top - offset, bounds.bottom + offset;
+static void update_shape( const snark::applications::position& p )
+{
+    if( shape_position && same_position( *shape_position, p ) ) { return; }
+    shape = snark::geometry::compiled_polytope::box( p.coordinates, snark::rotation_matrix::rotation( p.orientation ), bounds.front + offset, bounds.back + offset, bounds.right + offset, bounds.left + offset, bounds.top + offset, bounds.bottom + offset );
+    shape_position = p;
+}
 
+void filter_point(joined_point& pq)
+{
+    update_shape( pq.bounding.value );
+    // use if statement not assignment because point might already be filtered
+    if( shape.has( pq.bounded.coordinates ) ) { pq.bounded.flag = 0; }
+}
 
-    //convert vehicle bounds to world coordinates
-    //get transformation
+/// consecutive joined points with the same bounding position, tested against the box face by face in one go
+struct batch
+{
+    std::vector< joined_point > points;
+    std::vector< std::string > records; // input records as read, binary or ascii joined by delimiter
+    std::vector< double > x;
+    std::vector< double > y;
+    std::vector< double > z;
+    std::vector< unsigned char > inside;
 
-    Eigen::MatrixXd rot_matrix = snark::rotation_matrix::rotation(pq.bounding.value.orientation);
+    bool accepts( const joined_point& p ) const { return points.empty() || same_position( points[0].bounding.value, p.bounding.value ); }
 
-    for(int cntr2=0; cntr2<origins.cols(); cntr2++)
+    void filter()
     {
-        origins.col(cntr2)=rot_matrix*origins.col(cntr2)+pq.bounding.value.coordinates;
+        if( points.empty() ) { return; }
+        update_shape( points[0].bounding.value );
+        x.resize( points.size() );
+        y.resize( points.size() );
+        z.resize( points.size() );
+        inside.resize( points.size() );
+        for( std::size_t i = 0; i < points.size(); ++i ) { x[i] = points[i].bounded.coordinates.x(); y[i] = points[i].bounded.coordinates.y(); z[i] = points[i].bounded.coordinates.z(); }
+        shape.has( &x[0], &y[0], &z[0], points.size(), &inside[0] );
+        for( std::size_t i = 0; i < points.size(); ++i ) { if( inside[i] ) { points[i].bounded.flag = 0; } } // point might already be filtered
     }
 
-    //get plane equations
-    Eigen::MatrixXd A(6,3);
-    Eigen::VectorXd b(6);
+    void clear() { points.clear(); records.clear(); }
+};
 
-    for(int cntr2=1; cntr2<origins.cols(); cntr2++)
+template < typename S > static void output_batch( batch& b, S& ostream, bool output_all, bool flag_exists )
+{
+    b.filter();
+    for( std::size_t i = 0; i < b.points.size(); ++i )
     {
-        A.row(cntr2-1)<<origins.col(0).transpose()-origins.col(cntr2).transpose();
-        b(cntr2-1)=origins.col(cntr2).transpose()*(origins.col(0)-origins.col(cntr2));
+        const joined_point& q = b.points[i];
+        if( !q.bounded.flag && !output_all ) { continue; }
+        if( flag_exists ) { ostream.write( q ); continue; }
+        //append flag
+        if( ostream.is_binary() )
+        {
+            ostream.write( q, &b.records[i][0] );
+            std::cout.write( reinterpret_cast< const char* >( &q.bounded.flag ), sizeof( comma::uint32 ) );
+        }
+        else
+        {
+            ostream.write( q, b.records[i] + "," + boost::lexical_cast< std::string >( q.bounded.flag ) );
+        }
     }
+    ostream.flush();
+    b.clear();
+}
 
-    //check polygon in 3d
-    // use if statement not assignment because point might already be filtered
-    if(snark::geometry::convex_polytope(A,b).has(pq.bounded.coordinates))
+static std::vector< snark::geometry::compiled_polytope > load_shapes( const std::string& source, bool planes, std::vector< comma::uint32 >& ids )
+{
+    comma::name_value::parser parser( "filename" );
+    comma::csv::options shapes_csv = parser.get< comma::csv::options >( source );
+    if( shapes_csv.fields.empty() ) { shapes_csv.fields = planes ? "id,x,y,z,offset" : "x,y,z,roll,pitch,yaw,front,back,right,left,top,bottom"; }
+    comma::io::istream is( comma::split( source, ';' )[0], shapes_csv.binary() ? comma::io::mode::binary : comma::io::mode::ascii );
+    std::vector< snark::geometry::compiled_polytope > shapes;
+    ids.clear();
+    if( planes )
+    {
+        comma::csv::input_stream< plane_t > istream( *is, shapes_csv );
+        std::map< comma::uint32, std::vector< plane_t > > polytopes;
+        while( istream.ready() || ( is->good() && !is->eof() ) )
+        {
+            const plane_t* p = istream.read();
+            if( !p ) { break; }
+            polytopes[ p->id ].push_back( *p );
+        }
+        for( std::map< comma::uint32, std::vector< plane_t > >::const_iterator it = polytopes.begin(); it != polytopes.end(); ++it )
+        {
+            Eigen::MatrixXd normals( it->second.size(), 3 );
+            Eigen::VectorXd offsets( it->second.size() );
+            for( unsigned int i = 0; i < it->second.size(); ++i ) { normals.row( i ) = it->second[i].normal.transpose(); offsets( i ) = it->second[i].offset; }
+            shapes.push_back( snark::geometry::compiled_polytope( normals, offsets, snark::geometry::compiled_polytope::bounds( normals, offsets ) ) ); // bounding box from vertices, so that the polytope gets indexed
+            ids.push_back( it->first );
+        }
+        return shapes;
+    }
+    comma::csv::input_stream< box_t > istream( *is, shapes_csv );
+    bool has_id = shapes_csv.has_field( "id" );
+    while( istream.ready() || ( is->good() && !is->eof() ) )
     {
-        pq.bounded.flag=0;
+        const box_t* b = istream.read();
+        if( !b ) { break; }
+        shapes.push_back( snark::geometry::compiled_polytope::box( b->position.coordinates, snark::rotation_matrix::rotation( b->position.orientation ), b->bounds.front + offset, b->bounds.back + offset, b->bounds.right + offset, b->bounds.left + offset, b->bounds.top + offset, b->bounds.bottom + offset ) );
+        ids.push_back( has_id ? b->id : ids.size() );
     }
+    return shapes;
 }
 
 int main( int argc, char** argv )
@@ -204,7 +350,9 @@ int main( int argc, char** argv )
     bounds=comma::csv::ascii<bounds_t>().get(options.value("--bounds",std::string("0,0,0,0,0,0")));
 
     bool output_all = options.exists( "--output-all");
-    std::vector<std::string> unnamed=options.unnamed("--output-all,--verbose,-v","-.*");
+    bool output_ids = options.exists( "--ids" );
+    bool inside = options.exists( "--inside" );
+    std::vector<std::string> unnamed=options.unnamed("--output-all,--ids,--inside,--planes,--verbose,-v","-.*");
 
     std::string operation=unnamed[0];
 
@@ -212,10 +360,10 @@ int main( int argc, char** argv )
     csv.full_xpath=true;
     bool flag_exists=false;
 
-    if( operation == "stream" )
+    if( operation == "stream" || operation == "shapes" )
     {
-        std::vector<std::string> fields=comma::split(csv.fields,csv.delimiter);
         if( csv.fields.empty() ) { csv.fields = "t,coordinates"; }
+        std::vector<std::string> fields=comma::split(csv.fields,csv.delimiter);
         flag_exists = csv.has_field( "flag" );
         std::string bounded_string("bounded/");
         for(unsigned int i=0; i<fields.size(); i++)
@@ -391,6 +539,27 @@ int main( int argc, char** argv )
     }
     else if(operation=="shape")
     {
+        static const std::size_t batch_size = 4096;
+        batch b;
+        while(!is_shutdown && ( istream.ready() || ( std::cin.good() && !std::cin.eof() ) ))
+        {
+            const joined_point* pq_ptr = istream.read();
+            if( !pq_ptr ) { break; }
+            if( !b.accepts( *pq_ptr ) || b.points.size() == batch_size ) { output_batch( b, ostream, output_all, flag_exists ); }
+            b.points.push_back( *pq_ptr );
+            if( istream.is_binary() ) { b.records.push_back( std::string( istream.binary().last(), csv.format().size() ) ); }
+            else { b.records.push_back( comma::join( istream.ascii().last(), csv.delimiter ) ); }
+            if( !istream.ready() ) { output_batch( b, ostream, output_all, flag_exists ); } // do not hold points back while waiting for input
+        }
+        output_batch( b, ostream, output_all, flag_exists );
+    }
+    else if(operation=="shapes")
+    {
+        if(unnamed.size()<2){ usage(); }
+        if( output_ids && output_all ) { std::cerr << "points-grep: shapes: --ids and --output-all are mutually exclusive" << std::endl; return 1; }
+        std::vector< comma::uint32 > ids;
+        snark::geometry::polytope_index index( load_shapes( unnamed[1], options.exists( "--planes" ), ids ) );
+        std::vector< std::size_t > found;
         while(!is_shutdown && ( istream.ready() || ( std::cin.good() && !std::cin.eof() ) ))
         {
             const joined_point* pq_ptr = istream.read();
@@ -399,8 +568,29 @@ int main( int argc, char** argv )
 
             pq=*pq_ptr;
 
-            //filter out object points
-            filter_point(pq);
+            if( output_ids )
+            {
+                index.find( pq.bounded.coordinates, found );
+                for( unsigned int i = 0; i < found.size(); ++i )
+                {
+                    if( ostream.is_binary() )
+                    {
+                        ostream.write(pq,istream.binary().last());
+                        std::cout.write( reinterpret_cast< const char* >( &ids[ found[i] ] ), sizeof( comma::uint32 ) );
+                    }
+                    else
+                    {
+                        std::string line=comma::join( istream.ascii().last(), csv.delimiter );
+                        line+=csv.delimiter+boost::lexical_cast<std::string>(ids[ found[i] ]);
+                        ostream.write(pq,line);
+                    }
+                }
+                if( !found.empty() ) { ostream.flush(); }
+                continue;
+            }
+
+            // use if statement not assignment because point might already be filtered
+            if( index.has( pq.bounded.coordinates ) != inside ) { pq.bounded.flag = 0; }
             if(!pq.bounded.flag && !output_all)
             {
                 continue;
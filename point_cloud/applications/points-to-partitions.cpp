@@ -78,6 +78,9 @@ static void usage()
     std::cerr << "        --min-voxels-per-partition <n>: min number of voxels in a partition; default: 1" << std::endl;
     std::cerr << "        --min-points-per-partition <n>: min number of points in a partition; default: 1" << std::endl;
     std::cerr << "        --resolution <resolution>: default: 0.2 metres" << std::endl;
+    std::cerr << "        --tiles <n>: if present, label partitions in <n> tiles in parallel and merge them on tile borders" << std::endl;
+    std::cerr << "                     same partitions as without --tiles, but partition ids are consecutive" << std::endl;
+    std::cerr << "                     in the order of voxel grid, i.e. do not depend on the number of tiles" << std::endl;
     std::cerr << "    data flow options:" << std::endl;
     std::cerr << "        --discard,-d: if present, partition as many points as possible, discard the rest" << std::endl;
     std::cerr << "        --output-all: output all points, even non-partitioned; the latter with id: max uint32" << std::endl;
@@ -114,6 +117,7 @@ static double min_density;
 static Eigen::Vector3d resolution;
 static comma::csv::options csv;
 static comma::uint32 min_id;
+static unsigned int tiles;
 static bool discard;
 static bool output_all;
 static boost::scoped_ptr< snark::partition > partition;
@@ -248,7 +252,8 @@ static block_t* partition_( block_t* block )
         block_t::pair_t& p = block->points->operator[]( i );
         if( p.first.flag ) { p.first.id = &block->partition->insert( p.first.point ); }
     }
-    block->partition->commit( min_voxels_per_partition, min_points_per_partition, min_id, min_density );
+    if( tiles ) { block->partition->commit( min_voxels_per_partition, min_points_per_partition, min_id, min_density, tiles ); }
+    else { block->partition->commit( min_voxels_per_partition, min_points_per_partition, min_id, min_density ); }
     return block;
 }
 
@@ -272,6 +277,7 @@ int main( int ac, char** av )
         resolution = Eigen::Vector3d( r, r, r );
         discard = options.exists( "--discard,-d" );
         min_id = options.value( "--min-id", 0 );
+        tiles = options.value( "--tiles", 0u );
         output_all = options.exists( "--output-all" );
         ::tbb::filter_t< block_t*, block_t* > partition_filter( ::tbb::filter::serial_in_order, &partition_ );
         ::tbb::filter_t< block_t*, void > write_filter( ::tbb::filter::serial_in_order, &write_block_ );
@@ -28,9 +28,16 @@
 // IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
+#include <algorithm>
+#include <deque>
+#include <vector>
 #include <boost/array.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/optional.hpp>
 #include <boost/program_options.hpp>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_scheduler_init.h>
 #include <comma/base/exception.h>
 #include <comma/application/command_line_options.h>
 #include <comma/application/signal_flag.h>
@@ -41,9 +48,12 @@
 #include <comma/visiting/traits.h>
 #include <snark/visiting/eigen.h>
 #include <snark/point_cloud/voxel_map.h>
+#include <snark/point_cloud/impl/flat_table.h>
+#include <snark/point_cloud/voxel_tiles.h>
 
 struct input_point
 {
+    boost::posix_time::ptime t;
     Eigen::Vector3d point;
     comma::uint32 block;
     
@@ -57,7 +67,7 @@ struct centroid
     comma::uint32 size;
     comma::uint32 block;
     
-    centroid() : size( 0 ), block( 0 ) {}
+    centroid() : mean( 0, 0, 0 ), size( 0 ), block( 0 ) {}
     
     void operator+=( const Eigen::Vector3d& point )
     {
@@ -72,12 +82,14 @@ template <> struct traits< input_point >
 {
     template < typename K, typename V > static void visit( const K&, input_point& p, V& v )
     {
+        v.apply( "t", p.t );
         v.apply( "point", p.point );
         v.apply( "block", p.block );
     }
 
     template < typename K, typename V > static void visit( const K&, const input_point& p, V& v )
     {
+        v.apply( "t", p.t );
         v.apply( "point", p.point );
         v.apply( "block", p.block );
     }
@@ -104,6 +116,126 @@ template <> struct traits< centroid >
 
 } } // namespace comma { namespace visiting {
 
+/// sliding window of points with running sums per voxel
+/// a point is added to its voxel on entering the window and subtracted on leaving it,
+/// empty voxels are dropped, thus memory is bounded by the voxels occupied by the window
+class window
+{
+    public:
+        window( const Eigen::Vector3d& origin, const Eigen::Vector3d& resolution, bool changed_only )
+            : origin_( origin )
+            , resolution_( resolution )
+            , changed_only_( changed_only )
+        {
+        }
+
+        void push( const input_point& p )
+        {
+            index_type index = snark::voxel_map< int, 3 >::index_of( p.point, origin_, resolution_ );
+            bool inserted;
+            comma::uint32 slot = table_.touch( index, free_.empty() ? voxels_.size() : free_.back(), inserted );
+            if( inserted )
+            {
+                if( free_.empty() ) { voxels_.push_back( voxel() ); } else { free_.pop_back(); }
+                voxels_[slot].index = index;
+            }
+            voxel& v = voxels_[slot];
+            v.sum += p.point;
+            ++v.size;
+            touch_( slot );
+            points_.push_back( entry( p.t, p.point, slot ) );
+        }
+
+        void pop()
+        {
+            const entry& p = points_.front();
+            voxel& v = voxels_[ p.slot ];
+            v.sum -= p.point;
+            --v.size;
+            touch_( p.slot );
+            if( v.size == 0 )
+            {
+                v.sum = Eigen::Vector3d::Zero(); // no rounding errors accumulated in empty voxels
+                if( !changed_only_ ) { erase_( p.slot ); } // otherwise, erase after output
+            }
+            points_.pop_front();
+        }
+
+        std::size_t size() const { return points_.size(); }
+
+        const boost::posix_time::ptime& oldest() const { return points_.front().t; }
+
+        /// output voxels: all non-empty or only changed since last output
+        void write( comma::csv::output_stream< centroid >& ostream, comma::uint32 block )
+        {
+            if( changed_only_ )
+            {
+                for( std::size_t i = 0; i < changed_.size(); ++i )
+                {
+                    voxel& v = voxels_[ changed_[i] ];
+                    write_( ostream, v, block );
+                    v.changed = false;
+                    if( v.size == 0 ) { erase_( changed_[i] ); }
+                }
+                changed_.clear();
+            }
+            else
+            {
+                for( std::size_t i = 0; i < voxels_.size(); ++i ) { if( voxels_[i].size > 0 ) { write_( ostream, voxels_[i], block ); } }
+            }
+        }
+
+    private:
+        typedef boost::array< comma::int32, 3 > index_type;
+        struct voxel
+        {
+            index_type index;
+            Eigen::Vector3d sum;
+            comma::uint32 size;
+            bool changed;
+            voxel() : sum( 0, 0, 0 ), size( 0 ), changed( false ) {}
+        };
+        struct entry
+        {
+            boost::posix_time::ptime t;
+            Eigen::Vector3d point;
+            comma::uint32 slot;
+            entry( const boost::posix_time::ptime& t, const Eigen::Vector3d& p, comma::uint32 slot ) : t( t ), point( p ), slot( slot ) {}
+        };
+        Eigen::Vector3d origin_;
+        Eigen::Vector3d resolution_;
+        bool changed_only_;
+        snark::impl::flat_table< index_type, snark::impl::voxel_index_hash > table_;
+        std::vector< voxel > voxels_;
+        std::vector< comma::uint32 > free_;
+        std::deque< entry > points_;
+        std::vector< comma::uint32 > changed_;
+
+        void touch_( comma::uint32 slot )
+        {
+            if( !changed_only_ || voxels_[slot].changed ) { return; }
+            voxels_[slot].changed = true;
+            changed_.push_back( slot );
+        }
+
+        void erase_( comma::uint32 slot )
+        {
+            table_.erase( voxels_[slot].index );
+            free_.push_back( slot );
+        }
+
+        void write_( comma::csv::output_stream< centroid >& ostream, const voxel& v, comma::uint32 block ) const
+        {
+            centroid c;
+            c.index = v.index;
+            c.size = v.size;
+            c.block = block;
+            if( c.size == 0 ) { for( unsigned int i = 0; i < 3; ++i ) { c.mean[i] = origin_[i] + resolution_[i] * ( v.index[i] + 0.5 ); } }
+            else { c.mean = v.sum / c.size; }
+            ostream.write( c );
+        }
+};
+
 template < typename T, std::size_t Size >
 std::ostream& operator<<( std::ostream& os, const boost::array< T, Size >& a )
 {
@@ -114,6 +246,83 @@ std::ostream& operator<<( std::ostream& os, const boost::array< T, Size >& a )
     return os;
 }
     
+/// output voxels of a block; voxels outside of tile, if given, are used only as neighbours
+template < typename S >
+static void write_voxels( snark::voxel_map< centroid, 3 >& voxels, comma::uint32 block, comma::uint32 neighbourhood_radius, S& ostream, const snark::voxel_tiles::tile* tile = NULL )
+{
+    for( snark::voxel_map< centroid, 3 >::iterator it = voxels.begin(); it != voxels.end(); ++it )
+    {
+        if( tile && !tile->contains( it->first ) ) { continue; }
+        it->second.block = block;
+        it->second.index = voxels.index_of( it->second.mean );
+        if( neighbourhood_radius == 0 )
+        {
+            ostream.write( it->second );
+        }
+        else
+        {
+            centroid c = it->second;
+            snark::voxel_map< centroid, 3 >::index_type index;
+            snark::voxel_map< centroid, 3 >::index_type begin = {{ it->first[0] - neighbourhood_radius, it->first[1] - neighbourhood_radius, it->first[2] - neighbourhood_radius }};
+            snark::voxel_map< centroid, 3 >::index_type end = {{ it->first[0] + neighbourhood_radius + 1, it->first[1] + neighbourhood_radius + 1, it->first[2] + neighbourhood_radius + 1 }};
+            for( index[0] = begin[0]; index[0] < end[0]; ++index[0] )
+            {
+                for( index[1] = begin[1]; index[1] < end[1]; ++index[1] )
+                {
+                    for( index[2] = begin[2]; index[2] < end[2]; ++index[2] )
+                    {
+                        snark::voxel_map< centroid, 3 >::const_iterator nit = voxels.find( index );
+                        if( nit == voxels.end() ) { continue; }
+                        c.size += nit->second.size;
+                        c.mean += ( nit->second.mean * nit->second.size );
+                    }
+                }
+            }
+            c.mean /= c.size;
+            ostream.write( c );
+        }
+    }
+}
+
+/// voxels of a tile, as output stream
+struct centroids
+{
+    std::vector< centroid > values;
+    void write( const centroid& c ) { values.push_back( c ); }
+};
+
+/// voxelise tiles in parallel, each with the points in its margin
+struct voxelise_tiles
+{
+    const snark::voxel_tiles& tiles;
+    std::size_t begin;
+    std::vector< centroids >& output;
+    Eigen::Vector3d origin;
+    Eigen::Vector3d resolution;
+    comma::uint32 neighbourhood_radius;
+
+    voxelise_tiles( const snark::voxel_tiles& tiles, std::size_t begin, std::vector< centroids >& output, const Eigen::Vector3d& origin, const Eigen::Vector3d& resolution, comma::uint32 neighbourhood_radius )
+        : tiles( tiles ), begin( begin ), output( output ), origin( origin ), resolution( resolution ), neighbourhood_radius( neighbourhood_radius )
+    {
+    }
+
+    void operator()( const tbb::blocked_range< std::size_t >& range ) const
+    {
+        std::vector< Eigen::Vector3d > points;
+        std::vector< Eigen::Vector3d > margin;
+        for( std::size_t i = range.begin(); i < range.end(); ++i )
+        {
+            const snark::voxel_tiles::tile& tile = tiles.tiles()[ begin + i ];
+            tiles.read( begin + i, points, margin );
+            snark::voxel_map< centroid, 3 > voxels( origin, resolution );
+            for( std::size_t j = 0; j < points.size(); ++j ) { voxels.touch_at( points[j] )->second += points[j]; }
+            for( std::size_t j = 0; j < margin.size(); ++j ) { voxels.touch_at( margin[j] )->second += margin[j]; }
+            output[i].values.clear();
+            write_voxels( voxels, tile.block, neighbourhood_radius, output[i], &tile );
+        }
+    }
+};
+
 int main( int argc, char** argv )
 {
     try
@@ -126,7 +335,15 @@ int main( int argc, char** argv )
             ( "help,h", "display help message" )
             ( "resolution", boost::program_options::value< std::string >( &resolution_string ), "voxel map resolution, e.g. \"0.2\" or \"0.2,0.2,0.5\"" )
             ( "origin", boost::program_options::value< std::string >( &origin_string )->default_value( "0,0,0" ), "voxel map origin" )
-            ( "neighbourhood-radius,r", boost::program_options::value< comma::uint32 >( &neighbourhood_radius )->default_value( 0 ), "calculate count of neighbours at given radius" );
+            ( "neighbourhood-radius,r", boost::program_options::value< comma::uint32 >( &neighbourhood_radius )->default_value( 0 ), "calculate count of neighbours at given radius" )
+            ( "window-size", boost::program_options::value< comma::uint32 >(), "streaming mode: sliding window of given number of latest points; field block is ignored" )
+            ( "window-duration", boost::program_options::value< double >(), "streaming mode: sliding window of points not older than the latest point by given number of seconds; requires field t; field block is ignored" )
+            ( "period", boost::program_options::value< double >(), "streaming mode: output voxels every given number of points for --window-size or seconds for --window-duration; default: window size or duration" )
+            ( "changed", "streaming mode: output only voxels changed since last output, voxels that became empty with weight 0" )
+            ( "out-of-core", boost::program_options::value< std::string >(), "out-of-core mode: spread points into tiles in a temporary subdirectory of given existing directory, then voxelise tile by tile" )
+            ( "tile-size", boost::program_options::value< comma::uint32 >()->default_value( 256 ), "out-of-core mode: tile size in voxels, rounded up to a power of 2; tiles with too many points get split" )
+            ( "memory-limit", boost::program_options::value< double >()->default_value( 1024 ), "out-of-core mode: approximate memory limit in megabytes" )
+            ( "threads", boost::program_options::value< unsigned int >()->default_value( 1 ), "out-of-core mode: number of tiles voxelised in parallel" );
         description.add( comma::csv::program_options::description( "x,y,z,block" ) );
         boost::program_options::variables_map vm;
         boost::program_options::store( boost::program_options::parse_command_line( argc, argv, description), vm );
@@ -141,6 +358,16 @@ int main( int argc, char** argv )
             std::cerr << "output: voxels with indices, centroids, and weights (number of points): i,j,k,x,y,z,weight[,neighbour count][,block]" << std::endl;
             std::cerr << "binary output format: 3ui,3d,ui[,ui][,ui]" << std::endl;
             std::cerr << std::endl;
+            std::cerr << "streaming mode: if --window-size or --window-duration given, keep voxel centroids of a sliding window" << std::endl;
+            std::cerr << "                of points updated as points enter and leave the window and output them periodically" << std::endl;
+            std::cerr << "                neighbour counts are not available, i.e. --neighbourhood-radius cannot be used" << std::endl;
+            std::cerr << "                output: i,j,k,x,y,z,weight,block, where block is the output number" << std::endl;
+            std::cerr << "                binary output format: 3ui,3d,ui,ui" << std::endl;
+            std::cerr << std::endl;
+            std::cerr << "out-of-core mode: if --out-of-core given, for point clouds larger than memory; same output as above, but" << std::endl;
+            std::cerr << "                  voxels of a block are output tile by tile and points of a block do not need to be contiguous" << std::endl;
+            std::cerr << "                  all input is read before any output" << std::endl;
+            std::cerr << std::endl;
             std::cerr << description << std::endl;
             std::cerr << std::endl;
             return 1;
@@ -155,6 +382,51 @@ int main( int argc, char** argv )
         comma::csv::input_stream< input_point > istream( std::cin, csv );
         comma::csv::options output_csv = csv;
         output_csv.full_xpath = true;
+        if( vm.count( "window-size" ) || vm.count( "window-duration" ) )
+        {
+            if( vm.count( "window-size" ) && vm.count( "window-duration" ) ) { COMMA_THROW( comma::exception, "please specify either --window-size or --window-duration" ); }
+            if( neighbourhood_radius > 0 ) { COMMA_THROW( comma::exception, "--neighbourhood-radius is not supported in streaming mode" ); }
+            bool by_time = vm.count( "window-duration" );
+            if( by_time && !csv.has_field( "t" ) ) { COMMA_THROW( comma::exception, "--window-duration requires field t" ); }
+            double size = by_time ? vm[ "window-duration" ].as< double >() : vm[ "window-size" ].as< comma::uint32 >();
+            if( !( size > 0 ) ) { COMMA_THROW( comma::exception, "expected positive window size or duration, got " << size ); }
+            double period = vm.count( "period" ) ? vm[ "period" ].as< double >() : size;
+            if( !( period > 0 ) ) { COMMA_THROW( comma::exception, "expected positive period, got " << period ); }
+            output_csv.fields = "index,mean,size,block";
+            if( csv.binary() ) { output_csv.format( "3ui,3d,ui,ui" ); }
+            comma::csv::output_stream< centroid > ostream( std::cout, output_csv );
+            comma::signal_flag is_shutdown;
+            window w( origin, resolution, vm.count( "changed" ) );
+            boost::posix_time::time_duration duration = boost::posix_time::microseconds( static_cast< long long >( size * 1e6 ) );
+            boost::posix_time::time_duration time_period = boost::posix_time::microseconds( static_cast< long long >( period * 1e6 ) );
+            boost::posix_time::ptime last_output;
+            std::size_t count = 0;
+            comma::uint32 block = 0;
+            while( !is_shutdown && !std::cin.eof() && std::cin.good() )
+            {
+                const input_point* p = istream.read();
+                if( !p ) { break; }
+                w.push( *p );
+                ++count;
+                if( by_time )
+                {
+                    while( p->t - w.oldest() > duration ) { w.pop(); }
+                    if( last_output.is_not_a_date_time() ) { last_output = p->t; }
+                    if( p->t - last_output < time_period ) { continue; }
+                    last_output = p->t;
+                }
+                else
+                {
+                    if( w.size() > size ) { w.pop(); }
+                    if( count < period ) { continue; }
+                }
+                w.write( ostream, block++ );
+                count = 0;
+            }
+            if( is_shutdown ) { std::cerr << "points-to-voxels: caught signal" << std::endl; return 1; }
+            if( count > 0 ) { w.write( ostream, block ); }
+            return 0;
+        }
         if( csv.has_field( "block" ) ) // todo: quick and dirty, make output fields configurable?
         {
             output_csv.fields = "index,mean,size,block";
@@ -167,6 +439,33 @@ int main( int argc, char** argv )
         }
         comma::csv::output_stream< centroid > ostream( std::cout, output_csv );
         comma::signal_flag is_shutdown;
+        if( vm.count( "out-of-core" ) )
+        {
+            static const double bytes_per_buffered_point = 2 * sizeof( Eigen::Vector3d ); // vector growth
+            static const double bytes_per_tile_point = 200; // quick and dirty: point, voxel map node, and output centroid
+            double memory_limit = vm[ "memory-limit" ].as< double >() * 1024 * 1024;
+            unsigned int threads = vm[ "threads" ].as< unsigned int >();
+            if( threads == 0 ) { COMMA_THROW( comma::exception, "expected positive number of threads" ); }
+            snark::voxel_tiles tiles( origin, resolution, vm[ "out-of-core" ].as< std::string >(), vm[ "tile-size" ].as< comma::uint32 >(), neighbourhood_radius, memory_limit / 2 / bytes_per_buffered_point );
+            while( !is_shutdown && !std::cin.eof() && std::cin.good() )
+            {
+                const input_point* p = istream.read();
+                if( !p ) { break; }
+                tiles.insert( p->point, p->block );
+            }
+            if( is_shutdown ) { std::cerr << "points-to-voxels: caught signal" << std::endl; return 1; }
+            tiles.commit( memory_limit / 2 / threads / bytes_per_tile_point );
+            tbb::task_scheduler_init init( threads );
+            std::vector< centroids > output( threads );
+            for( std::size_t i = 0; i < tiles.tiles().size() && !is_shutdown; i += threads )
+            {
+                std::size_t size = std::min( std::size_t( threads ), tiles.tiles().size() - i );
+                tbb::parallel_for( tbb::blocked_range< std::size_t >( 0, size, 1 ), voxelise_tiles( tiles, i, output, origin, resolution, neighbourhood_radius ) );
+                for( std::size_t j = 0; j < size; ++j ) { for( std::size_t k = 0; k < output[j].values.size(); ++k ) { ostream.write( output[j].values[k] ); } }
+            }
+            if( is_shutdown ) { std::cerr << "points-to-voxels: caught signal" << std::endl; return 1; }
+            return 0;
+        }
         unsigned int block = 0;
         const input_point* last = NULL;
         while( !is_shutdown && !std::cin.eof() && std::cin.good() )
@@ -213,37 +512,7 @@ int main( int argc, char** argv )
 //                 ostream.write( it->second );
 //             }
 
-            for( snark::voxel_map< centroid, 3 >::iterator it = voxels.begin(); it != voxels.end(); ++it )
-            {
-                it->second.block = block;
-                it->second.index = snark::voxel_map< centroid, 3 >::index_of( it->second.mean, origin, resolution );
-                if( neighbourhood_radius == 0 )
-                {
-                    ostream.write( it->second );
-                }
-                else
-                {
-                    centroid c = it->second;
-                    snark::voxel_map< centroid, 3 >::index_type index;
-                    snark::voxel_map< centroid, 3 >::index_type begin = {{ it->first[0] - neighbourhood_radius, it->first[1] - neighbourhood_radius, it->first[2] - neighbourhood_radius }};
-                    snark::voxel_map< centroid, 3 >::index_type end = {{ it->first[0] + neighbourhood_radius + 1, it->first[1] + neighbourhood_radius + 1, it->first[2] + neighbourhood_radius + 1 }};
-                    for( index[0] = begin[0]; index[0] < end[0]; ++index[0] )                        
-                    {
-                        for( index[1] = begin[1]; index[1] < end[1]; ++index[1] )
-                        {
-                            for( index[2] = begin[2]; index[2] < end[2]; ++index[2] )
-                            {
-                                snark::voxel_map< centroid, 3 >::const_iterator nit = voxels.find( index );
-                                if( nit == voxels.end() ) { continue; }
-                                c.size += nit->second.size;
-                                c.mean += ( nit->second.mean * nit->second.size );
-                            }
-                        }
-                    }
-                    c.mean /= c.size;
-                    ostream.write( c );
-                }
-            }
+            write_voxels( voxels, block, neighbourhood_radius, ostream );
             if( !last ) { break; }
             block = last->block;
         }
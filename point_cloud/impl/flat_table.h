@@ -0,0 +1,157 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SNARK_POINT_CLOUD_IMPL_FLAT_TABLE_H_
+#define SNARK_POINT_CLOUD_IMPL_FLAT_TABLE_H_
+
+#include <vector>
+#include <boost/array.hpp>
+#include <comma/base/types.h>
+
+namespace snark { namespace impl {
+
+/// hash of voxel index
+struct voxel_index_hash
+{
+    std::size_t operator()( const boost::array< comma::int32, 3 >& i ) const
+    {
+        comma::uint64 h = comma::uint64( comma::uint32( i[0] ) ) * 0x9E3779B97F4A7C15ULL;
+        h ^= comma::uint64( comma::uint32( i[1] ) ) * 0xC2B2AE3D27D4EB4FULL;
+        h ^= comma::uint64( comma::uint32( i[2] ) ) * 0x165667B19E3779F9ULL;
+        return std::size_t( h ^ ( h >> 29 ) );
+    }
+};
+
+/// hash of integer key
+struct uint64_hash
+{
+    std::size_t operator()( comma::uint64 i ) const
+    {
+        i *= 0x9E3779B97F4A7C15ULL;
+        return std::size_t( i ^ ( i >> 31 ) );
+    }
+};
+
+/// open-addressing hash table with linear probing mapping keys to uint32 values
+/// cleared in constant time, keeps its allocation from clear to clear
+template < typename K, typename H >
+class flat_table
+{
+    public:
+        flat_table() : size_( 0 ), generation_( 1 ) {}
+
+        /// return value for key, inserting given value, if key does not exist
+        comma::uint32& touch( const K& key, comma::uint32 value, bool& inserted )
+        {
+            if( ( size_ + 1 ) * 2 > entries_.size() ) { grow_(); }
+            entry* e = probe_( key );
+            inserted = e->generation != generation_;
+            if( inserted ) { e->key = key; e->value = value; e->generation = generation_; ++size_; }
+            return e->value;
+        }
+
+        /// return value for key or NULL, if key does not exist
+        const comma::uint32* find( const K& key ) const
+        {
+            if( entries_.empty() ) { return NULL; }
+            std::size_t mask = entries_.size() - 1;
+            for( std::size_t i = H()( key ) & mask; entries_[i].generation == generation_; i = ( i + 1 ) & mask )
+            {
+                if( entries_[i].key == key ) { return &entries_[i].value; }
+            }
+            return NULL;
+        }
+
+        /// erase key, if it exists
+        void erase( const K& key )
+        {
+            if( entries_.empty() ) { return; }
+            std::size_t mask = entries_.size() - 1;
+            std::size_t i = H()( key ) & mask;
+            for( ; entries_[i].generation == generation_; i = ( i + 1 ) & mask ) { if( entries_[i].key == key ) { break; } }
+            if( entries_[i].generation != generation_ ) { return; }
+            for( std::size_t j = ( i + 1 ) & mask; entries_[j].generation == generation_; j = ( j + 1 ) & mask ) // shift back entries that probed past i
+            {
+                std::size_t home = H()( entries_[j].key ) & mask;
+                if( ( ( j - home ) & mask ) < ( ( j - i ) & mask ) ) { continue; }
+                entries_[i] = entries_[j];
+                i = j;
+            }
+            entries_[i].generation = 0;
+            --size_;
+        }
+
+        std::size_t size() const { return size_; }
+
+        void clear()
+        {
+            size_ = 0;
+            if( ++generation_ != 0 ) { return; }
+            for( std::size_t i = 0; i < entries_.size(); ++i ) { entries_[i].generation = 0; }
+            generation_ = 1;
+        }
+
+    private:
+        struct entry
+        {
+            K key;
+            comma::uint32 value;
+            comma::uint32 generation;
+            entry() : value( 0 ), generation( 0 ) {}
+        };
+        std::vector< entry > entries_;
+        std::size_t size_;
+        comma::uint32 generation_;
+
+        entry* probe_( const K& key )
+        {
+            std::size_t mask = entries_.size() - 1;
+            std::size_t i = H()( key ) & mask;
+            while( entries_[i].generation == generation_ && !( entries_[i].key == key ) ) { i = ( i + 1 ) & mask; }
+            return &entries_[i];
+        }
+
+        void grow_()
+        {
+            std::vector< entry > entries( entries_.empty() ? 64 : entries_.size() * 2 );
+            entries.swap( entries_ );
+            for( std::size_t i = 0; i < entries.size(); ++i )
+            {
+                if( entries[i].generation != generation_ ) { continue; }
+                entry* e = probe_( entries[i].key );
+                *e = entries[i];
+            }
+        }
+};
+
+} // namespace impl {
+
+} // namespace snark {
+
+#endif // SNARK_POINT_CLOUD_IMPL_FLAT_TABLE_H_
@@ -31,17 +31,88 @@
 #ifndef SNARK_PERCEPTION_PIN_SCREEN_HEADER_GUARD_
 #define SNARK_PERCEPTION_PIN_SCREEN_HEADER_GUARD_
 
+#include <algorithm>
 #include <cassert>
 #include <map>
+#include <utility>
+#include <vector>
 #include <Eigen/Core>
 
 namespace snark {
 
+/// pin screen column stored as a contiguous vector of elements sorted by height
+/// drop-in alternative to std::map< std::size_t, T > as pin_screen column type:
+/// no allocation per element, lookups are binary searches over contiguous memory,
+/// insertion and erasure shift the elements above in the same column
+/// @note as with std::vector, inserting or erasing invalidates
+///       iterators and references to elements of the same column
+template < typename T >
+class flat_column
+{
+    public:
+        typedef std::size_t key_type;
+        typedef T mapped_type;
+        typedef std::pair< std::size_t, T > value_type;
+        typedef std::vector< value_type > values_type;
+        typedef typename values_type::size_type size_type;
+        typedef typename values_type::iterator iterator;
+        typedef typename values_type::const_iterator const_iterator;
+        typedef typename values_type::reverse_iterator reverse_iterator;
+        typedef typename values_type::const_reverse_iterator const_reverse_iterator;
+
+        iterator begin() { return values_.begin(); }
+        const_iterator begin() const { return values_.begin(); }
+        iterator end() { return values_.end(); }
+        const_iterator end() const { return values_.end(); }
+        reverse_iterator rbegin() { return values_.rbegin(); }
+        const_reverse_iterator rbegin() const { return values_.rbegin(); }
+        reverse_iterator rend() { return values_.rend(); }
+        const_reverse_iterator rend() const { return values_.rend(); }
+        bool empty() const { return values_.empty(); }
+        size_type size() const { return values_.size(); }
+        void clear() { values_.clear(); }
+        void reserve( size_type n ) { values_.reserve( n ); }
+
+        iterator lower_bound( std::size_t k ) { return std::lower_bound( values_.begin(), values_.end(), k, less_() ); }
+        const_iterator lower_bound( std::size_t k ) const { return std::lower_bound( values_.begin(), values_.end(), k, less_() ); }
+        iterator upper_bound( std::size_t k ) { return std::upper_bound( values_.begin(), values_.end(), k, less_() ); }
+        const_iterator upper_bound( std::size_t k ) const { return std::upper_bound( values_.begin(), values_.end(), k, less_() ); }
+        iterator find( std::size_t k ) { iterator it = lower_bound( k ); return it == values_.end() || it->first != k ? values_.end() : it; }
+        const_iterator find( std::size_t k ) const { const_iterator it = lower_bound( k ); return it == values_.end() || it->first != k ? values_.end() : it; }
+
+        /// return reference to element, create, if it does not exist
+        T& operator[]( std::size_t k )
+        {
+            if( values_.empty() || values_.back().first < k ) { values_.push_back( value_type( k, T() ) ); return values_.back().second; } // columns usually grow upwards
+            iterator it = lower_bound( k );
+            if( it == values_.end() || it->first != k ) { it = values_.insert( it, value_type( k, T() ) ); }
+            return it->second;
+        }
+
+        /// erase element, return number of erased elements
+        size_type erase( std::size_t k ) { iterator it = find( k ); if( it == values_.end() ) { return 0; } values_.erase( it ); return 1; }
+
+        /// erase element
+        void erase( iterator it ) { values_.erase( it ); }
+
+    private:
+        struct less_
+        {
+            bool operator()( const value_type& lhs, std::size_t rhs ) const { return lhs.first < rhs; }
+            bool operator()( std::size_t lhs, const value_type& rhs ) const { return lhs < rhs.first; }
+        };
+        values_type values_;
+};
+
 /// A 2D grid which stores in each cell a stl vector
 /// @todo this is a legacy code copy-pasted just to
 ///       make refactoring possible elsewhere
 ///       improve and refactor, once needed
-template < typename T >
+/// @param C column type: std::map< std::size_t, T > (default) keeps
+///          references to elements valid on insertion; flat_column< T >
+///          is faster and more compact, but insertion into a column
+///          invalidates references to its elements
+template < typename T, typename C = std::map< std::size_t, T > >
 class pin_screen
 {
     public:
@@ -55,7 +126,7 @@ class pin_screen
         typedef Eigen::Matrix< std::size_t, 1, 2 > size_type;
 
         /// column type
-        typedef std::map< std::size_t, T > column_type;
+        typedef C column_type;
 
         /// constructor
         pin_screen( std::size_t size1 , std::size_t size2 );
@@ -67,9 +138,11 @@ class pin_screen
         size_type size() const { return size_type( m_grid.rows(), m_grid.cols() ); }
 
         /// return column
-        /// @todo add non-const column()?
         const column_type& column( std::size_t i , std::size_t j ) const { return m_grid( i, j ); }
 
+        /// return column
+        column_type& column( std::size_t i , std::size_t j ) { return m_grid( i, j ); }
+
         /// return column height
         std::size_t height( std::size_t i , std::size_t j ) const;
 
@@ -150,18 +223,18 @@ class pin_screen
         GridType m_grid;
 };
 
-template < typename T >
-class pin_screen< T >::const_iterator
+template < typename T, typename C >
+class pin_screen< T, C >::const_iterator
 {
     public:
         /// value type
         typedef T value_type;
 
         /// index type
-        typedef typename pin_screen< T >::index_type index_type;
+        typedef typename pin_screen< T, C >::index_type index_type;
 
         /// size type
-        typedef typename pin_screen< T >::size_type size_type;
+        typedef typename pin_screen< T, C >::size_type size_type;
 
         /// dimensions
         enum { Dimensions = 3 };
@@ -209,26 +282,26 @@ class pin_screen< T >::const_iterator
         const_iterator() : m_column( 0, 0 ) {}
 
     protected:
-        friend class pin_screen< T >;
-        friend class pin_screen< T >::iterator;
+        friend class pin_screen< T, C >;
+        friend class pin_screen< T, C >::iterator;
         const GridType* m_grid;
         size_type m_column;
-        typename pin_screen< T >::column_type::const_iterator m_it;
+        typename pin_screen< T, C >::column_type::const_iterator m_it;
 };
 
 /// pin screen iterator
-template < typename T >
-class pin_screen< T >::iterator
+template < typename T, typename C >
+class pin_screen< T, C >::iterator
 {
     public:
         /// value type
         typedef T value_type;
 
         /// index type
-        typedef typename pin_screen< T >::index_type index_type;
+        typedef typename pin_screen< T, C >::index_type index_type;
 
         /// size type
-        typedef typename pin_screen< T >::size_type size_type;
+        typedef typename pin_screen< T, C >::size_type size_type;
 
         /// dimensions
         enum { Dimensions = 3 };
@@ -287,14 +360,14 @@ class pin_screen< T >::iterator
         iterator() : m_column( 0, 0 ) {}
 
     protected:
-        friend class pin_screen< T >;
+        friend class pin_screen< T, C >;
         GridType* m_grid;
         size_type m_column;
-        typename pin_screen< T >::column_type::iterator m_it;
+        typename pin_screen< T, C >::column_type::iterator m_it;
 };
 
-template < typename T >
-inline typename pin_screen< T >::iterator pin_screen< T >::begin()
+template < typename T, typename C >
+inline typename pin_screen< T, C >::iterator pin_screen< T, C >::begin()
 {
     iterator it;
     it.m_grid = &m_grid;
@@ -303,8 +376,8 @@ inline typename pin_screen< T >::iterator pin_screen< T >::begin()
     return it;
 }
 
-template < typename T >
-inline typename pin_screen< T >::const_iterator pin_screen< T >::begin() const
+template < typename T, typename C >
+inline typename pin_screen< T, C >::const_iterator pin_screen< T, C >::begin() const
 {
     const_iterator it;
     it.m_grid = &m_grid;
@@ -313,8 +386,8 @@ inline typename pin_screen< T >::const_iterator pin_screen< T >::begin() const
     return it;
 }
 
-template < typename T >
-inline typename pin_screen< T >::iterator pin_screen< T >::end()
+template < typename T, typename C >
+inline typename pin_screen< T, C >::iterator pin_screen< T, C >::end()
 {
     iterator it;
     it.m_grid = &m_grid;
@@ -323,8 +396,8 @@ inline typename pin_screen< T >::iterator pin_screen< T >::end()
     return it;
 }
 
-template < typename T >
-inline typename pin_screen< T >::const_iterator pin_screen< T >::end() const
+template < typename T, typename C >
+inline typename pin_screen< T, C >::const_iterator pin_screen< T, C >::end() const
 {
     const_iterator it;
     it.m_grid = &m_grid;
@@ -334,15 +407,15 @@ inline typename pin_screen< T >::const_iterator pin_screen< T >::end() const
 }
 
 /// matrix neighbourhood iterator
-template < typename T >
-class pin_screen< T >::neighbourhood_iterator : public pin_screen< T >::iterator
+template < typename T, typename C >
+class pin_screen< T, C >::neighbourhood_iterator : public pin_screen< T, C >::iterator
 {
     public:
         /// itself
-        typedef typename pin_screen< T >::neighbourhood_iterator iterator;
+        typedef typename pin_screen< T, C >::neighbourhood_iterator iterator;
         
         /// index type
-        typedef typename pin_screen< T >::iterator::index_type index_type;
+        typedef typename pin_screen< T, C >::iterator::index_type index_type;
 
         /// increment
         const neighbourhood_iterator& operator++();
@@ -351,24 +424,24 @@ class pin_screen< T >::neighbourhood_iterator : public pin_screen< T >::iterator
         //const iterator& Centre() const { return m_center; }
 
         /// return begin
-        static neighbourhood_iterator begin( const typename pin_screen< T >::iterator& center );
+        static neighbourhood_iterator begin( const typename pin_screen< T, C >::iterator& center );
 
         /// return end
-        static neighbourhood_iterator end( const typename pin_screen< T >::iterator& center );
+        static neighbourhood_iterator end( const typename pin_screen< T, C >::iterator& center );
 
     private:
         //iterator m_center;
         index_type m_center;
         index_type m_begin;
         index_type m_end;
-        using pin_screen< T >::iterator::m_grid;
-        using pin_screen< T >::iterator::m_column;
-        using pin_screen< T >::iterator::m_it;
-        void Init( const typename pin_screen< T >::iterator& center );
+        using pin_screen< T, C >::iterator::m_grid;
+        using pin_screen< T, C >::iterator::m_column;
+        using pin_screen< T, C >::iterator::m_it;
+        void Init( const typename pin_screen< T, C >::iterator& center );
 };
 
-template < typename T >
-inline void pin_screen< T >::neighbourhood_iterator::Init( const typename pin_screen< T >::iterator& center )
+template < typename T, typename C >
+inline void pin_screen< T, C >::neighbourhood_iterator::Init( const typename pin_screen< T, C >::iterator& center )
 {
     m_grid = center.m_grid;
     m_center = center();
@@ -380,8 +453,8 @@ inline void pin_screen< T >::neighbourhood_iterator::Init( const typename pin_sc
     m_end[2] = m_center[2] + 1 + 1; // pin screen can grow upwards without limits
 }
 
-template < typename T >
-inline const typename pin_screen< T >::neighbourhood_iterator& pin_screen< T >::neighbourhood_iterator::operator++()
+template < typename T, typename C >
+inline const typename pin_screen< T, C >::neighbourhood_iterator& pin_screen< T, C >::neighbourhood_iterator::operator++()
 {
     if( m_it != ( *m_grid )( m_column[0], m_column[1] ).end() && m_it->first < m_end[2] ) { ++m_it; }
     while( m_it == ( *m_grid )( m_column[0], m_column[1] ).end() || m_it->first >= m_end[2] || this->operator()() == m_center )
@@ -404,8 +477,8 @@ inline const typename pin_screen< T >::neighbourhood_iterator& pin_screen< T >::
     return *this;
 }
 
-template < typename T >
-inline typename pin_screen< T >::neighbourhood_iterator pin_screen< T >::neighbourhood_iterator::begin( const typename pin_screen< T >::iterator& center )
+template < typename T, typename C >
+inline typename pin_screen< T, C >::neighbourhood_iterator pin_screen< T, C >::neighbourhood_iterator::begin( const typename pin_screen< T, C >::iterator& center )
 {
     neighbourhood_iterator it;
     it.Init( center );
@@ -431,8 +504,8 @@ inline typename pin_screen< T >::neighbourhood_iterator pin_screen< T >::neighbo
     return it;
 }
 
-template < typename T >
-inline typename pin_screen< T >::neighbourhood_iterator pin_screen< T >::neighbourhood_iterator::end( const typename pin_screen< T >::iterator& center )
+template < typename T, typename C >
+inline typename pin_screen< T, C >::neighbourhood_iterator pin_screen< T, C >::neighbourhood_iterator::end( const typename pin_screen< T, C >::iterator& center )
 {
     neighbourhood_iterator it;
     it.Init( center );
@@ -442,64 +515,64 @@ inline typename pin_screen< T >::neighbourhood_iterator pin_screen< T >::neighbo
     return it;
 }
 
-template < typename T >
-inline pin_screen< T >::pin_screen( std::size_t size1 , std::size_t size2 )
+template < typename T, typename C >
+inline pin_screen< T, C >::pin_screen( std::size_t size1 , std::size_t size2 )
     : m_grid( size1, size2 )
 {
 }
 
-template < typename T >
-inline pin_screen< T >::pin_screen( typename pin_screen< T >::size_type size )
+template < typename T, typename C >
+inline pin_screen< T, C >::pin_screen( typename pin_screen< T, C >::size_type size )
     : m_grid( size[0], size[1] )
 {
 }
 
-template < typename T >
-inline std::size_t pin_screen< T >::height( std::size_t i , std::size_t j ) const
+template < typename T, typename C >
+inline std::size_t pin_screen< T, C >::height( std::size_t i , std::size_t j ) const
 {
     return m_grid( i, j ).empty() ? 0 : m_grid( i, j ).rbegin()->first;
 }
 
-template < typename T >
-inline bool pin_screen< T >::exists( std::size_t i , std::size_t j , std::size_t k ) const
+template < typename T, typename C >
+inline bool pin_screen< T, C >::exists( std::size_t i , std::size_t j , std::size_t k ) const
 {
     return m_grid( i, j ).find( k ) != m_grid( i, j ).end();
 }
 
-template < typename T >
-inline T* pin_screen< T >::find( std::size_t i , std::size_t j , std::size_t k )
+template < typename T, typename C >
+inline T* pin_screen< T, C >::find( std::size_t i , std::size_t j , std::size_t k )
 {
     typename column_type::iterator it( m_grid( i, j ).find( k ) );
     return it == m_grid( i, j ).end() ? NULL : &it->second;
 }
 
-template < typename T >
-inline const T* pin_screen< T >::find( std::size_t i, std::size_t j, std::size_t k ) const
+template < typename T, typename C >
+inline const T* pin_screen< T, C >::find( std::size_t i, std::size_t j, std::size_t k ) const
 {
     typename column_type::const_iterator it( m_grid( i, j ).find( k ) );
     return it == m_grid( i, j ).end() ? NULL : &it->second;
 }
 
-template < typename T >
-inline T& pin_screen< T >::operator() ( std::size_t i, std::size_t j, std::size_t k )
+template < typename T, typename C >
+inline T& pin_screen< T, C >::operator() ( std::size_t i, std::size_t j, std::size_t k )
 {
     return touch( i, j, k );
 }
 
-template < typename T >
-inline const T& pin_screen< T >::operator() ( std::size_t i, std::size_t j, std::size_t k ) const
+template < typename T, typename C >
+inline const T& pin_screen< T, C >::operator() ( std::size_t i, std::size_t j, std::size_t k ) const
 {
     return *find( i, j, k );
 }
 
-template< typename T >
-inline void pin_screen< T >::erase( std::size_t i, std::size_t j, std::size_t k )
+template < typename T, typename C >
+inline void pin_screen< T, C >::erase( std::size_t i, std::size_t j, std::size_t k )
 {
     m_grid( i, j ).erase( k );
 }
 
-template< typename T >
-inline void pin_screen< T >::clear()
+template < typename T, typename C >
+inline void pin_screen< T, C >::clear()
 {
     for( std::size_t i = 0; i < m_grid.rows(); ++i )
     {
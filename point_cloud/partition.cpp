@@ -30,12 +30,29 @@
 /// @author vsevolod vlaskine
 
 #include <cmath>
+#include <deque>
+#include <vector>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
 #include <snark/point_cloud/equivalence_classes.h>
 #include <snark/point_cloud/partition.h>
 #include <snark/point_cloud/voxel_grid.h>
 
 namespace snark {
 
+static comma::uint32 find_( std::vector< comma::uint32 >& parent, comma::uint32 i )
+{
+    while( parent[i] != i ) { parent[i] = parent[ parent[i] ]; i = parent[i]; } // path halving
+    return i;
+}
+
+static void unite_( std::vector< comma::uint32 >& parent, comma::uint32 i, comma::uint32 j )
+{
+    i = find_( parent, i );
+    j = find_( parent, j );
+    if( i < j ) { parent[j] = i; } else if( j < i ) { parent[i] = j; } // root is always the first voxel in grid order
+}
+
 class partition::impl_
 {
     public:
@@ -51,8 +68,9 @@ class partition::impl_
         {
             voxel_* voxel = voxels_.touch_at( point );
             if( voxel == NULL ) { return none_; }
+            if( voxel->id == NULL ) { ids_.push_back( boost::optional< comma::uint32 >() ); voxel->id = &ids_.back(); }
             ++voxel->count;
-            return voxel->id;
+            return *voxel->id;
         }
 
         void commit( std::size_t min_voxels_per_partition
@@ -80,32 +98,187 @@ class partition::impl_
                     for( Set::const_iterator j = it->second.begin(); j != it->second.end(); size += ( *j++ )->count );
                     remove = size < min_points_per_partition || ( double( size ) / it->second.size() ) < min_density;
                 }
-                if( remove ) { for( Set::const_iterator j = it->second.begin(); j != it->second.end(); ( *j++ )->id.reset() ); }
+                if( remove ) { for( Set::const_iterator j = it->second.begin(); j != it->second.end(); ( *j++ )->id->reset() ); }
             }
         }
 
+        void commit( std::size_t min_voxels_per_partition
+                   , std::size_t min_points_per_partition
+                   , comma::uint32 min_id
+                   , double min_density
+                   , unsigned int tiles )
+        {
+            std::size_t rows = voxels_.size()[0];
+            if( rows == 0 ) { return; }
+            if( tiles == 0 ) { tiles = 1; }
+            if( tiles > rows ) { tiles = rows; }
+            std::vector< tile_ > t( tiles );
+            for( unsigned int i = 0; i < tiles; ++i ) { t[i].begin = ( rows * i ) / tiles; t[i].end = ( rows * ( i + 1 ) ) / tiles; }
+            tbb::parallel_for( tbb::blocked_range< std::size_t >( 0, tiles, 1 ), count_tiles_( *this, t ) );
+            std::size_t size = 0;
+            for( unsigned int i = 0; i < tiles; ++i ) { t[i].offset = size; size += t[i].size; }
+            parent_.resize( size );
+            indexed_.resize( size );
+            tbb::parallel_for( tbb::blocked_range< std::size_t >( 0, tiles, 1 ), label_tiles_( *this, t ) );
+            for( unsigned int i = 1; i < tiles; ++i ) { stitch_( t[i].begin ); }
+            std::vector< comma::uint32 > sizes( size, 0 );
+            std::vector< std::size_t > points( size, 0 );
+            for( std::size_t i = 0; i < size; ++i ) // parent of a voxel always precedes it, thus its root is already final
+            {
+                parent_[i] = parent_[ parent_[i] ];
+                ++sizes[ parent_[i] ];
+                points[ parent_[i] ] += indexed_[i]->count;
+            }
+            bool check_points_per_partitions = min_density > 0 || ( min_points_per_partition > min_voxels_per_partition * min_points_per_voxel_ );
+            labels_.resize( size );
+            comma::uint32 id = min_id;
+            for( std::size_t i = 0; i < size; ++i )
+            {
+                if( parent_[i] != i ) { continue; }
+                bool remove = sizes[i] < min_voxels_per_partition
+                           || ( check_points_per_partitions && ( points[i] < min_points_per_partition || ( double( points[i] ) / sizes[i] ) < min_density ) );
+                labels_[i] = remove ? none_ : boost::optional< comma::uint32 >( id++ );
+            }
+            tbb::parallel_for( tbb::blocked_range< std::size_t >( 0, size ), assign_ids_( *this ) );
+        }
+
     private:
         struct voxel_ // quick and dirty
         {
-            mutable boost::optional< comma::uint32 > id; // quick and dirty
+            boost::optional< comma::uint32 >* id; // in ids_, since voxels move inside their columns on insertion, but insert() hands out references to ids
             std::size_t count;
             bool visited;
+            comma::uint32 index; // in grid order, for parallel commit
+
+            voxel_() : id( NULL ), count( 0 ), visited( false ), index( 0 ) {}
+        };
+
+        typedef flat_column< voxel_ > column_type_;
+        typedef voxel_grid< voxel_, Eigen::Vector3d, column_type_ > voxels_type_;
+
+        struct tile_
+        {
+            std::size_t begin;
+            std::size_t end;
+            std::size_t size;
+            std::size_t offset;
+            tile_() : begin( 0 ), end( 0 ), size( 0 ), offset( 0 ) {}
+        };
+
+        class count_tiles_
+        {
+            public:
+                count_tiles_( impl_& impl, std::vector< tile_ >& tiles ) : owner_( impl ), tiles_( tiles ) {}
+                void operator()( const tbb::blocked_range< std::size_t >& range ) const { for( std::size_t i = range.begin(); i < range.end(); ++i ) { count( tiles_[i] ); } }
 
-            voxel_() : count( 0 ), visited( false ) {}
+            private:
+                impl_& owner_;
+                std::vector< tile_ >& tiles_;
+                void count( tile_& t ) const
+                {
+                    for( std::size_t i = t.begin; i < t.end; ++i )
+                    {
+                        for( std::size_t j = 0; j < owner_.voxels_.size()[1]; ++j )
+                        {
+                            column_type_& c = owner_.voxels_.column( i, j );
+                            for( column_type_::iterator it = c.begin(); it != c.end(); ++it )
+                            {
+                                if( it->second.count < owner_.min_points_per_voxel_ ) { it->second.count = 0; } else { ++t.size; }
+                            }
+                        }
+                    }
+                }
         };
 
+        class label_tiles_
+        {
+            public:
+                label_tiles_( impl_& impl, std::vector< tile_ >& tiles ) : owner_( impl ), tiles_( tiles ) {}
+                void operator()( const tbb::blocked_range< std::size_t >& range ) const { for( std::size_t i = range.begin(); i < range.end(); ++i ) { label( tiles_[i] ); } }
+
+            private:
+                impl_& owner_;
+                std::vector< tile_ >& tiles_;
+                void label( const tile_& t ) const // neighbours preceding a voxel in grid order are already indexed
+                {
+                    comma::uint32 index = t.offset;
+                    std::size_t cols = owner_.voxels_.size()[1];
+                    for( std::size_t i = t.begin; i < t.end; ++i )
+                    {
+                        for( std::size_t j = 0; j < cols; ++j )
+                        {
+                            column_type_& c = owner_.voxels_.column( i, j );
+                            for( column_type_::iterator it = c.begin(); it != c.end(); ++it )
+                            {
+                                if( it->second.count == 0 ) { continue; }
+                                it->second.index = index;
+                                owner_.parent_[index] = index;
+                                owner_.indexed_[index] = &it->second;
+                                if( i > t.begin )
+                                {
+                                    for( std::size_t n = j > 0 ? j - 1 : 0; n < j + 2 && n < cols; ++n ) { owner_.unite_( index, owner_.voxels_.column( i - 1, n ), it->first, it->first + 2 ); }
+                                }
+                                if( j > 0 ) { owner_.unite_( index, owner_.voxels_.column( i, j - 1 ), it->first, it->first + 2 ); }
+                                owner_.unite_( index, c, it->first, it->first );
+                                ++index;
+                            }
+                        }
+                    }
+                }
+        };
+
+        class assign_ids_
+        {
+            public:
+                assign_ids_( impl_& impl ) : owner_( impl ) {}
+                void operator()( const tbb::blocked_range< std::size_t >& range ) const
+                {
+                    for( std::size_t i = range.begin(); i < range.end(); ++i ) { *owner_.indexed_[i]->id = owner_.labels_[ owner_.parent_[i] ]; }
+                }
+
+            private:
+                impl_& owner_;
+        };
+
+        /// unite voxel with non-empty voxels of a column in the height range [k - 1, end)
+        void unite_( comma::uint32 index, const column_type_& c, std::size_t k, std::size_t end )
+        {
+            for( column_type_::const_iterator it = c.lower_bound( k > 0 ? k - 1 : 0 ); it != c.end() && it->first < end; ++it )
+            {
+                if( it->second.count > 0 ) { snark::unite_( parent_, index, it->second.index ); }
+            }
+        }
+
+        /// unite voxels of a row with their neighbours in the previous row
+        void stitch_( std::size_t row )
+        {
+            std::size_t cols = voxels_.size()[1];
+            for( std::size_t j = 0; j < cols; ++j )
+            {
+                const column_type_& c = voxels_.column( row, j );
+                for( column_type_::const_iterator it = c.begin(); it != c.end(); ++it )
+                {
+                    if( it->second.count == 0 ) { continue; }
+                    for( std::size_t n = j > 0 ? j - 1 : 0; n < j + 2 && n < cols; ++n ) { unite_( it->second.index, voxels_.column( row - 1, n ), it->first, it->first + 2 ); }
+                }
+            }
+        }
+
         struct Methods_
         {
             static bool skip( const voxel_& e ) { return e.count == 0; }
             static bool same( const voxel_& lhs, const voxel_& rhs ) { return true; }
             static bool visited( const voxel_& e ) { return e.visited; }
             static void set_visited( voxel_& e, bool v ) { e.visited = v; }
-            static comma::uint32 id( const voxel_& e ) { return *e.id; }
-            static void set_id( voxel_& e, comma::uint32 id ) { e.id = id; }
+            static comma::uint32 id( const voxel_& e ) { return **e.id; }
+            static void set_id( voxel_& e, comma::uint32 id ) { *e.id = id; }
         };
 
-        typedef voxel_grid< voxel_ > voxels_type_;
         voxels_type_ voxels_;
+        std::deque< boost::optional< comma::uint32 > > ids_;
+        std::vector< comma::uint32 > parent_;
+        std::vector< voxel_* > indexed_;
+        std::vector< boost::optional< comma::uint32 > > labels_;
         boost::optional< comma::uint32 > none_;
         std::size_t min_points_per_voxel_;
 
@@ -145,4 +318,13 @@ void partition::commit( std::size_t min_voxels_per_partition
     pimpl_->commit( min_voxels_per_partition, min_points_per_partition, min_id, min_density );
 }
 
+void partition::commit( std::size_t min_voxels_per_partition
+                      , std::size_t min_points_per_partition
+                      , comma::uint32 min_id
+                      , double min_density
+                      , unsigned int tiles )
+{
+    pimpl_->commit( min_voxels_per_partition, min_points_per_partition, min_id, min_density, tiles );
+}
+
 } // namespace snark {
@@ -60,6 +60,19 @@ class partition
                    , comma::uint32 min_id = 0
                    , double min_density = 0 );
 
+        /// same as commit() above, but label the voxel grid in a number of tiles
+        /// (slabs along x) in parallel and then merge partitions across tile borders
+        /// @param tiles number of tiles; 1: single-threaded
+        /// @note partitions are the same as from the serial commit(), but ids are
+        ///       different: they are assigned consecutively from min_id in the grid
+        ///       order of the first voxel of each partition, thus they do not depend
+        ///       on the number of tiles
+        void commit( std::size_t min_voxels_per_partition
+                   , std::size_t min_points_per_partition
+                   , comma::uint32 min_id
+                   , double min_density
+                   , unsigned int tiles );
+
     private:
         class impl_;
         impl_* pimpl_;
@@ -0,0 +1,135 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <snark/point_cloud/partition_tracking.h>
+#include <snark/point_cloud/voxel_map.h>
+
+namespace snark {
+
+partition_tracking::partition_tracking( const Eigen::Vector3d& origin, const Eigen::Vector3d& resolution )
+    : origin_( origin )
+    , resolution_( resolution )
+    , vacant_( 0 )
+    , has_previous_( false )
+{
+}
+
+void partition_tracking::add( const Eigen::Vector3d& point, comma::uint32 id )
+{
+    index_type index = voxel_map< int, 3 >::index_of( point, origin_, resolution_ );
+    bool inserted;
+    comma::uint32 slot = voxel_table_.touch( index, voxels_.size(), inserted );
+    if( inserted )
+    {
+        voxel v;
+        v.index = index;
+        v.sum = Eigen::Vector3d::Zero();
+        v.id = 0;
+        v.count = 0;
+        v.partition = 0;
+        voxels_.push_back( v );
+    }
+    voxel& v = voxels_[slot];
+    comma::uint32& count = point_votes_.touch( ( comma::uint64( slot ) << 32 ) | id, 0, inserted );
+    if( ++count > v.count ) { v.id = id; v.count = count; } // on tie, the id that got the votes first wins
+    v.sum += point;
+    points_.push_back( slot );
+}
+
+struct claim_less_ { bool operator()( const std::pair< comma::uint32, comma::uint32 >& lhs, const std::pair< comma::uint32, comma::uint32 >& rhs ) const { return lhs.first < rhs.first; } };
+
+void partition_tracking::match_()
+{
+    partition_table_.clear();
+    partitions_.clear();
+    voxel_votes_.clear();
+    for( std::size_t i = 0; i < voxels_.size(); ++i )
+    {
+        voxel& v = voxels_[i];
+        bool inserted;
+        v.partition = partition_table_.touch( v.id, partitions_.size(), inserted );
+        if( inserted ) { partition p; p.id = v.id; p.size = 0; p.votes = 0; partitions_.push_back( p ); }
+        ++partitions_[ v.partition ].size;
+        const comma::uint32* previous = previous_.find( voxel_map< int, 3 >::index_of( v.sum / v.count, origin_, resolution_ ) ); // sic: mean of votes for the voxel id, as in the original algorithm
+        if( previous ) { voxel_votes_.push_back( std::make_pair( v.partition, *previous ) ); ++partitions_[ v.partition ].votes; }
+    }
+    comma::uint32 begin = 0;
+    for( std::size_t i = 0; i < partitions_.size(); ++i ) { partitions_[i].begin = partitions_[i].end = begin; begin += partitions_[i].votes; }
+    ballot_.resize( voxel_votes_.size() );
+    for( std::size_t i = 0; i < voxel_votes_.size(); ++i ) { ballot_[ partitions_[ voxel_votes_[i].first ].end++ ] = voxel_votes_[i].second; }
+    order_.resize( partitions_.size() );
+    for( std::size_t i = 0; i < order_.size(); ++i ) { order_[i] = std::make_pair( partitions_[i].id, comma::uint32( i ) ); }
+    std::sort( order_.begin(), order_.end() );
+    claims_.clear();
+    for( std::size_t i = 0; i < order_.size(); ++i ) // partitions in order of their ids, since new ids are given in this order
+    {
+        partition& p = partitions_[ order_[i].second ];
+        votes_.clear();
+        comma::uint32 best = 0;
+        comma::uint32 best_count = 0;
+        for( comma::uint32 j = p.begin; j < p.end; ++j )
+        {
+            bool inserted;
+            comma::uint32 count = ++votes_.touch( ballot_[j], 0, inserted );
+            if( count > best_count || ( count == best_count && ballot_[j] < best ) ) { best = ballot_[j]; best_count = count; } // on tie, the smallest id wins
+        }
+        p.tracked = best_count == 0 ? vacant_ : best;
+        if( p.tracked == vacant_ ) { ++vacant_; } // sic: also if the vacant id won the vote, as in the original algorithm
+        claims_.push_back( std::make_pair( p.tracked, order_[i].second ) );
+    }
+    std::stable_sort( claims_.begin(), claims_.end(), claim_less_() );
+    for( std::size_t i = 0; i < claims_.size(); ) // the largest partition keeps the id it claims, others get new ids; on tie, the first claim wins
+    {
+        std::size_t largest = i++;
+        for( ; i < claims_.size() && claims_[i].first == claims_[largest].first; ++i )
+        {
+            if( partitions_[ claims_[largest].second ].size >= partitions_[ claims_[i].second ].size ) { partitions_[ claims_[i].second ].tracked = vacant_++; }
+            else { partitions_[ claims_[largest].second ].tracked = vacant_++; largest = i; }
+        }
+    }
+    for( std::size_t i = 0; i < voxels_.size(); ++i ) { voxels_[i].id = partitions_[ voxels_[i].partition ].tracked; }
+}
+
+const std::vector< comma::uint32 >& partition_tracking::commit()
+{
+    if( has_previous_ ) { match_(); }
+    ids_.resize( points_.size() );
+    for( std::size_t i = 0; i < points_.size(); ++i ) { ids_[i] = voxels_[ points_[i] ].id; }
+    previous_.clear();
+    for( std::size_t i = 0; i < voxels_.size(); ++i ) { bool inserted; previous_.touch( voxels_[i].index, voxels_[i].id, inserted ); }
+    has_previous_ = true;
+    voxel_table_.clear();
+    point_votes_.clear();
+    voxels_.clear();
+    points_.clear();
+    return ids_;
+}
+
+} // namespace snark {
@@ -0,0 +1,113 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SNARK_POINT_CLOUD_PARTITION_TRACKING_H_
+#define SNARK_POINT_CLOUD_PARTITION_TRACKING_H_
+
+#include <utility>
+#include <vector>
+#include <boost/array.hpp>
+#include <Eigen/Core>
+#include <comma/base/types.h>
+#include <snark/point_cloud/impl/flat_table.h>
+
+namespace snark {
+
+/// keep partition ids consistent in subsequent partitioned point blocks by voting
+///
+/// each voxel takes the partition id of most of its points; each partition then
+/// takes the id most of its voxels had in the previous block, looked up at the
+/// voxel mean; if partitions claim the same id, the one with most voxels gets it;
+/// the others and partitions without votes get new ids
+///
+/// same results as voxel_map with voted_tracking in points-track-partitions, but
+/// voxels, votes and partitions are kept in flat tables reused from block to block
+class partition_tracking
+{
+    public:
+        /// constructor
+        partition_tracking( const Eigen::Vector3d& origin, const Eigen::Vector3d& resolution );
+
+        /// add point of current block with its partition id
+        void add( const Eigen::Vector3d& point, comma::uint32 id );
+
+        /// match current block against the previous one and start a new block
+        /// @return tracked ids of points of the block in the order they were added
+        const std::vector< comma::uint32 >& commit();
+
+        /// return id the next new partition will get
+        comma::uint32 vacant() const { return vacant_; }
+
+    private:
+        typedef boost::array< comma::int32, 3 > index_type;
+        typedef impl::flat_table< index_type, impl::voxel_index_hash > voxel_table;
+        typedef impl::flat_table< comma::uint64, impl::uint64_hash > id_table;
+
+        struct voxel
+        {
+            index_type index;
+            Eigen::Vector3d sum;
+            comma::uint32 id;
+            comma::uint32 count; // votes for id, i.e. not number of points
+            comma::uint32 partition;
+        };
+
+        struct partition
+        {
+            comma::uint32 id;
+            comma::uint32 size; // number of voxels
+            comma::uint32 votes; // number of voxels found in previous block
+            comma::uint32 begin;
+            comma::uint32 end;
+            comma::uint32 tracked;
+        };
+
+        Eigen::Vector3d origin_;
+        Eigen::Vector3d resolution_;
+        comma::uint32 vacant_;
+        bool has_previous_;
+        voxel_table voxel_table_;
+        voxel_table previous_;
+        id_table point_votes_;
+        id_table partition_table_;
+        id_table votes_;
+        std::vector< voxel > voxels_;
+        std::vector< comma::uint32 > points_;
+        std::vector< comma::uint32 > ids_;
+        std::vector< partition > partitions_;
+        std::vector< std::pair< comma::uint32, comma::uint32 > > order_;
+        std::vector< std::pair< comma::uint32, comma::uint32 > > voxel_votes_;
+        std::vector< comma::uint32 > ballot_;
+        std::vector< std::pair< comma::uint32, comma::uint32 > > claims_;
+        void match_();
+};
+
+} // namespace snark {
+
+#endif // SNARK_POINT_CLOUD_PARTITION_TRACKING_H_
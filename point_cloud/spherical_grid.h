@@ -1,7 +1,13 @@
 #ifndef SNARK_POINT_CLOUD_SPHERICAL_GRID_H_
 #define SNARK_POINT_CLOUD_SPHERICAL_GRID_H_
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
 #include <boost/multi_array.hpp>
+#include <comma/base/exception.h>
+#include <comma/base/types.h>
 #include <snark/math/range_bearing_elevation.h>
 
 namespace snark {
@@ -143,10 +149,193 @@ struct bearing_elevation_grid
     };
 };
 
-/// spherical grid based on range-bearing-elevation coordinates
-/// @todo implement based on voxel grid + bearing_elevation_grid
+/// spherical grid based on range-bearing-elevation coordinates:
+/// bearing-elevation grid of columns along rays, each column keeping only non-empty
+/// range cells as a vector sorted by range index
 template < typename T >
-class spherical_grid;
+class spherical_grid
+{
+    public:
+        /// types
+        typedef T voxel_type;
+        typedef boost::array< std::size_t, 3 > index_type; // bearing, elevation, range
+        typedef std::pair< comma::uint32, T > cell_type; // range index, value
+        typedef std::vector< cell_type > column_type;
+
+        /// constructor
+        spherical_grid( const snark::bearing_elevation& resolution, double range_resolution );
+
+        /// @return index of cell covering given point
+        index_type index_of( const snark::range_bearing_elevation& p ) const;
+
+        /// @return index of cell covering given point in cartesian coordinates
+        index_type index_of( const Eigen::Vector3d& p ) const { return index_of( snark::range_bearing_elevation( p ) ); }
+
+        /// @return reference to cell; creates cell, if it does not exist
+        T& touch( const index_type& i );
+
+        /// @return reference to cell covering given point; creates cell, if it does not exist
+        T& touch_at( const snark::range_bearing_elevation& p ) { return touch( index_of( p ) ); }
+
+        /// @return reference to cell covering given point in cartesian coordinates; creates cell, if it does not exist
+        T& touch_at( const Eigen::Vector3d& p ) { return touch( index_of( p ) ); }
+
+        /// @return pointer to cell, if it exists, NULL otherwise
+        T* find( const index_type& i );
+        const T* find( const index_type& i ) const;
+
+        /// erase cell, if it exists
+        void erase( const index_type& i );
+
+        /// @return column of non-empty cells along ray, sorted by range
+        const column_type& column( std::size_t bearing, std::size_t elevation ) const { return grid_[bearing][elevation]; }
+
+        /// @return number of bearing and elevation cells
+        const bearing_elevation_grid::index::type& size() const { return size_; }
+
+        /// @return number of non-empty cells
+        std::size_t count() const { return count_; }
+
+        /// @return lower corner of cell in range, bearing, elevation
+        snark::range_bearing_elevation origin( const index_type& i ) const;
+
+        /// call f( index, value ) for each non-empty cell within given radius (in cells) around centre,
+        /// excluding centre itself; bearing wraps around, elevation does not
+        template < typename F > void for_each_neighbour( const index_type& centre, F& f, std::size_t radius = 1 ) const;
+
+        /// call f( index, value ) for each non-empty cell
+        template < typename F > void for_each( F& f ) const;
+
+        /// @return bearing-elevation index
+        const bearing_elevation_grid::index& index() const { return index_; }
+
+        /// @return range resolution
+        double range_resolution() const { return range_resolution_; }
+
+    private:
+        bearing_elevation_grid::index index_;
+        bearing_elevation_grid::index::type size_;
+        bearing_elevation_grid::type< column_type > grid_;
+        double range_resolution_;
+        std::size_t count_;
+        struct less_ { bool operator()( const cell_type& lhs, comma::uint32 rhs ) const { return lhs.first < rhs; } };
+        static typename column_type::const_iterator lower_bound_( const column_type& c, std::size_t k ) { return std::lower_bound( c.begin(), c.end(), comma::uint32( k ), less_() ); }
+        static typename column_type::iterator lower_bound_( column_type& c, std::size_t k ) { return std::lower_bound( c.begin(), c.end(), comma::uint32( k ), less_() ); }
+        static bearing_elevation_grid::index::type size_of_( const snark::bearing_elevation& resolution );
+};
+
+template < typename T >
+inline bearing_elevation_grid::index::type spherical_grid< T >::size_of_( const snark::bearing_elevation& resolution )
+{
+    bearing_elevation_grid::index::type s = {{ std::max( std::size_t( M_PI * 2 / resolution.b() ), std::size_t( 1 ) ) // same as bearing wrap-around in bearing_elevation_grid::index
+                                             , bearing_elevation_grid::index( resolution )( 0, M_PI / 2 )[1] + 1 }};
+    return s;
+}
+
+template < typename T >
+inline spherical_grid< T >::spherical_grid( const snark::bearing_elevation& resolution, double range_resolution )
+    : index_( resolution )
+    , size_( size_of_( resolution ) )
+    , grid_( index_, size_[0], size_[1] )
+    , range_resolution_( range_resolution )
+    , count_( 0 )
+{
+}
+
+template < typename T >
+inline typename spherical_grid< T >::index_type spherical_grid< T >::index_of( const snark::range_bearing_elevation& p ) const
+{
+    const bearing_elevation_grid::index::type& i = index_( p.bearing(), p.elevation() );
+    double r = p.range() / range_resolution_;
+    if( r < 0 || r >= double( std::numeric_limits< comma::uint32 >::max() ) ) { COMMA_THROW( comma::exception, "expected range between 0 and " << range_resolution_ * std::numeric_limits< comma::uint32 >::max() << "; got " << p.range() ); }
+    index_type j = {{ i[0], i[1], std::size_t( r ) }};
+    return j;
+}
+
+template < typename T >
+inline T& spherical_grid< T >::touch( const index_type& i )
+{
+    column_type& c = grid_[ i[0] ][ i[1] ];
+    typename column_type::iterator it = lower_bound_( c, i[2] );
+    if( it != c.end() && it->first == i[2] ) { return it->second; }
+    ++count_;
+    return c.insert( it, cell_type( i[2], T() ) )->second;
+}
+
+template < typename T >
+inline T* spherical_grid< T >::find( const index_type& i )
+{
+    column_type& c = grid_[ i[0] ][ i[1] ];
+    typename column_type::iterator it = lower_bound_( c, i[2] );
+    return it == c.end() || it->first != i[2] ? NULL : &it->second;
+}
+
+template < typename T >
+inline const T* spherical_grid< T >::find( const index_type& i ) const
+{
+    const column_type& c = grid_[ i[0] ][ i[1] ];
+    typename column_type::const_iterator it = lower_bound_( c, i[2] );
+    return it == c.end() || it->first != i[2] ? NULL : &it->second;
+}
+
+template < typename T >
+inline void spherical_grid< T >::erase( const index_type& i )
+{
+    column_type& c = grid_[ i[0] ][ i[1] ];
+    typename column_type::iterator it = lower_bound_( c, i[2] );
+    if( it == c.end() || it->first != i[2] ) { return; }
+    c.erase( it );
+    --count_;
+}
+
+template < typename T >
+inline snark::range_bearing_elevation spherical_grid< T >::origin( const index_type& i ) const
+{
+    bearing_elevation_grid::index::type j = {{ i[0], i[1] }};
+    const snark::bearing_elevation& b = index_.bearing_elevation( j );
+    return snark::range_bearing_elevation( range_resolution_ * i[2], b.bearing(), b.elevation() );
+}
+
+template < typename T >
+template < typename F >
+inline void spherical_grid< T >::for_each_neighbour( const index_type& centre, F& f, std::size_t radius ) const
+{
+    std::size_t bearing_size = std::min( 2 * radius + 1, size_[0] ); // do not visit the same column twice
+    std::size_t bearing_begin = centre[0] + size_[0] * ( radius / size_[0] + 1 ) - radius;
+    std::size_t elevation_begin = centre[1] > radius ? centre[1] - radius : 0;
+    std::size_t elevation_end = std::min( centre[1] + radius + 1, size_[1] );
+    std::size_t range_begin = centre[2] > radius ? centre[2] - radius : 0;
+    std::size_t range_end = centre[2] + radius + 1;
+    for( std::size_t k = 0; k < bearing_size; ++k )
+    {
+        index_type i;
+        i[0] = ( bearing_begin + k ) % size_[0];
+        for( i[1] = elevation_begin; i[1] < elevation_end; ++i[1] )
+        {
+            const column_type& c = grid_[ i[0] ][ i[1] ];
+            for( typename column_type::const_iterator it = lower_bound_( c, range_begin ); it != c.end() && it->first < range_end; ++it )
+            {
+                i[2] = it->first;
+                if( i != centre ) { f( i, it->second ); }
+            }
+        }
+    }
+}
+
+template < typename T >
+template < typename F >
+inline void spherical_grid< T >::for_each( F& f ) const
+{
+    index_type i;
+    for( i[0] = 0; i[0] < size_[0]; ++i[0] )
+    {
+        for( i[1] = 0; i[1] < size_[1]; ++i[1] )
+        {
+            const column_type& c = grid_[ i[0] ][ i[1] ];
+            for( typename column_type::const_iterator it = c.begin(); it != c.end(); ++it ) { i[2] = it->first; f( i, it->second ); }
+        }
+    }
+}
 
 } // namespace snark {
 
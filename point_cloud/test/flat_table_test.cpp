@@ -0,0 +1,72 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstdlib>
+#include <map>
+#include <gtest/gtest.h>
+#include <snark/point_cloud/impl/flat_table.h>
+
+namespace snark {
+
+TEST( flat_table, touch_find_erase )
+{
+    impl::flat_table< comma::uint64, impl::uint64_hash > table;
+    std::map< comma::uint64, comma::uint32 > expected;
+    std::srand( 1 );
+    for( unsigned int i = 0; i < 100000; ++i )
+    {
+        comma::uint64 key = std::rand() % 500;
+        if( std::rand() % 3 == 0 )
+        {
+            table.erase( key );
+            expected.erase( key );
+        }
+        else
+        {
+            bool inserted;
+            comma::uint32 value = table.touch( key, i, inserted );
+            EXPECT_EQ( expected.find( key ) == expected.end(), inserted );
+            if( inserted ) { expected[key] = i; }
+            EXPECT_EQ( expected[key], value );
+        }
+        EXPECT_EQ( expected.size(), table.size() );
+    }
+    for( comma::uint64 key = 0; key < 500; ++key )
+    {
+        const comma::uint32* value = table.find( key );
+        std::map< comma::uint64, comma::uint32 >::const_iterator it = expected.find( key );
+        ASSERT_EQ( it == expected.end(), value == NULL );
+        if( value ) { EXPECT_EQ( it->second, *value ); }
+    }
+    table.clear();
+    EXPECT_EQ( 0u, table.size() );
+    for( comma::uint64 key = 0; key < 500; ++key ) { EXPECT_TRUE( table.find( key ) == NULL ); }
+}
+
+} // namespace snark {
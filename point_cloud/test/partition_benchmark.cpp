@@ -0,0 +1,107 @@
+/// time partitioning a point cloud with voxel grid columns stored as std::map and as flat_column
+/// and parallel partition commit on 1 to 16 threads
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <tbb/task_scheduler_init.h>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/optional.hpp>
+#include <snark/point_cloud/equivalence_classes.h>
+#include <snark/point_cloud/partition.h>
+#include <snark/point_cloud/voxel_grid.h>
+
+struct voxel
+{
+    boost::optional< comma::uint32 > id;
+    std::size_t count;
+    bool visited;
+    voxel() : count( 0 ), visited( false ) {}
+};
+
+struct methods
+{
+    static bool skip( const voxel& e ) { return e.count == 0; }
+    static bool same( const voxel&, const voxel& ) { return true; }
+    static bool visited( const voxel& e ) { return e.visited; }
+    static void set_visited( voxel& e, bool v ) { e.visited = v; }
+    static comma::uint32 id( const voxel& e ) { return *e.id; }
+    static void set_id( voxel& e, comma::uint32 id ) { e.id = id; }
+};
+
+static double seconds_since( const boost::posix_time::ptime& start ) { return double( ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() ) / 1e6; }
+
+template < typename C >
+static void run( const std::string& name, const std::vector< Eigen::Vector3d >& points, const snark::partition::extents_type& extents, const Eigen::Vector3d& resolution )
+{
+    typedef snark::voxel_grid< voxel, Eigen::Vector3d, C > grid_type;
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    grid_type grid( extents, resolution, true );
+    for( std::size_t i = 0; i < points.size(); ++i ) { voxel* v = grid.touch_at( points[i] ); if( v ) { ++v->count; } }
+    double insert = seconds_since( start );
+    start = boost::posix_time::microsec_clock::universal_time();
+    std::size_t partitions = snark::equivalence_classes< typename grid_type::iterator, typename grid_type::neighbourhood_iterator, methods >( grid.begin(), grid.end(), 0 ).size();
+    std::cout << name << ": insert: " << insert << " seconds; commit: " << seconds_since( start ) << " seconds; " << partitions << " partitions" << std::endl;
+}
+
+int main( int argc, char** argv )
+{
+    double resolution = argc > 1 ? boost::lexical_cast< double >( argv[1] ) : 0.2;
+    std::cerr << "usage: partition-benchmark [<resolution>] [<file>]; <file>: x,y,z per line, e.g. a real scan; if not given, a synthetic scan is used" << std::endl;
+    std::vector< Eigen::Vector3d > points;
+    if( argc > 2 )
+    {
+        std::ifstream ifs( argv[2] );
+        if( !ifs.is_open() ) { std::cerr << "partition-benchmark: failed to open " << argv[2] << std::endl; return 1; }
+        std::string line;
+        while( std::getline( ifs, line ) )
+        {
+            Eigen::Vector3d p;
+            char comma;
+            std::istringstream iss( line );
+            if( iss >> p.x() >> comma >> p.y() >> comma >> p.z() ) { points.push_back( p ); }
+        }
+    }
+    else
+    {
+        std::srand( 1 );
+        for( unsigned int i = 0; i < 2000000; ++i ) // ground plane with scattered objects, 100x100 metres
+        {
+            Eigen::Vector3d p( 100.0 * std::rand() / RAND_MAX, 100.0 * std::rand() / RAND_MAX, 0.05 * std::rand() / RAND_MAX );
+            if( i % 4 == 0 ) { p.x() = std::floor( p.x() / 10 ) * 10 + 0.5 * std::rand() / RAND_MAX; p.y() = std::floor( p.y() / 10 ) * 10 + 0.5 * std::rand() / RAND_MAX; p.z() = 5.0 * std::rand() / RAND_MAX; }
+            points.push_back( p );
+        }
+    }
+    if( points.empty() ) { std::cerr << "partition-benchmark: no points" << std::endl; return 1; }
+    Eigen::Vector3d min = points[0];
+    Eigen::Vector3d max = points[0];
+    for( std::size_t i = 1; i < points.size(); ++i ) { min = min.cwiseMin( points[i] ); max = max.cwiseMax( points[i] ); }
+    snark::partition::extents_type extents( min, max );
+    std::cerr << "partition-benchmark: " << points.size() << " points, resolution " << resolution << std::endl;
+    run< std::map< std::size_t, voxel > >( "map", points, extents, Eigen::Vector3d( resolution, resolution, resolution ) );
+    run< snark::flat_column< voxel > >( "flat", points, extents, Eigen::Vector3d( resolution, resolution, resolution ) );
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    snark::partition partition( extents, Eigen::Vector3d( resolution, resolution, resolution ) );
+    for( std::size_t i = 0; i < points.size(); ++i ) { partition.insert( points[i] ); }
+    double insert = seconds_since( start );
+    start = boost::posix_time::microsec_clock::universal_time();
+    partition.commit();
+    std::cout << "snark::partition: insert: " << insert << " seconds; commit: " << seconds_since( start ) << " seconds" << std::endl;
+    for( unsigned int threads = 1; threads <= 16; threads *= 2 )
+    {
+        tbb::task_scheduler_init init( threads );
+        snark::partition p( extents, Eigen::Vector3d( resolution, resolution, resolution ) );
+        for( std::size_t i = 0; i < points.size(); ++i ) { p.insert( points[i] ); }
+        start = boost::posix_time::microsec_clock::universal_time();
+        p.commit( 1, 1, 0, 0, threads );
+        std::cout << "snark::partition: parallel commit: " << threads << " thread(s): " << seconds_since( start ) << " seconds" << std::endl;
+    }
+    return 0;
+}
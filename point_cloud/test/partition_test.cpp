@@ -0,0 +1,110 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstdlib>
+#include <map>
+#include <vector>
+#include <boost/optional/optional_io.hpp>
+#include <gtest/gtest.h>
+#include <snark/point_cloud/partition.h>
+
+namespace snark { namespace test {
+
+typedef std::vector< boost::optional< comma::uint32 > > ids_type;
+
+static std::vector< Eigen::Vector3d > random_cloud( unsigned int size, unsigned int seed )
+{
+    std::vector< Eigen::Vector3d > points( size );
+    std::srand( seed );
+    for( unsigned int i = 0; i < size; ++i ) { points[i] = Eigen::Vector3d( 20.0 * std::rand() / RAND_MAX, 20.0 * std::rand() / RAND_MAX, 4.0 * std::rand() / RAND_MAX ); }
+    return points;
+}
+
+static ids_type partition_ids( const std::vector< Eigen::Vector3d >& points, std::size_t min_points_per_voxel, std::size_t min_voxels, std::size_t min_points, double min_density, unsigned int tiles )
+{
+    partition::extents_type extents;
+    for( std::size_t i = 0; i < points.size(); ++i ) { extents.set_hull( points[i] ); }
+    partition p( extents, Eigen::Vector3d( 0.5, 0.5, 0.5 ), min_points_per_voxel );
+    std::vector< const boost::optional< comma::uint32 >* > refs( points.size() );
+    for( std::size_t i = 0; i < points.size(); ++i ) { refs[i] = &p.insert( points[i] ); }
+    if( tiles == 0 ) { p.commit( min_voxels, min_points, 5, min_density ); }
+    else { p.commit( min_voxels, min_points, 5, min_density, tiles ); }
+    ids_type ids( points.size() );
+    for( std::size_t i = 0; i < points.size(); ++i ) { ids[i] = *refs[i]; }
+    return ids;
+}
+
+static void expect_same_partitions( const ids_type& lhs, const ids_type& rhs )
+{
+    ASSERT_EQ( lhs.size(), rhs.size() );
+    std::map< comma::uint32, comma::uint32 > forward;
+    std::map< comma::uint32, comma::uint32 > backward;
+    for( std::size_t i = 0; i < lhs.size(); ++i )
+    {
+        ASSERT_EQ( bool( lhs[i] ), bool( rhs[i] ) );
+        if( !lhs[i] ) { continue; }
+        std::pair< std::map< comma::uint32, comma::uint32 >::iterator, bool > f = forward.insert( std::make_pair( *lhs[i], *rhs[i] ) );
+        std::pair< std::map< comma::uint32, comma::uint32 >::iterator, bool > b = backward.insert( std::make_pair( *rhs[i], *lhs[i] ) );
+        EXPECT_EQ( f.first->second, *rhs[i] );
+        EXPECT_EQ( b.first->second, *lhs[i] );
+    }
+}
+
+TEST( partition, parallel_commit )
+{
+    std::vector< Eigen::Vector3d > points = random_cloud( 3000, 1 );
+    ids_type serial = partition_ids( points, 1, 1, 1, 0, 0 );
+    ids_type single = partition_ids( points, 1, 1, 1, 0, 1 );
+    expect_same_partitions( serial, single );
+    for( unsigned int tiles = 2; tiles < 50; tiles += 7 ) { EXPECT_EQ( single, partition_ids( points, 1, 1, 1, 0, tiles ) ); }
+}
+
+TEST( partition, parallel_commit_filters )
+{
+    std::vector< Eigen::Vector3d > points = random_cloud( 6000, 2 );
+    ids_type serial = partition_ids( points, 2, 3, 10, 1.5, 0 );
+    ids_type single = partition_ids( points, 2, 3, 10, 1.5, 1 );
+    expect_same_partitions( serial, single );
+    for( unsigned int tiles = 2; tiles < 50; tiles += 7 ) { EXPECT_EQ( single, partition_ids( points, 2, 3, 10, 1.5, tiles ) ); }
+    std::size_t partitioned = 0;
+    for( std::size_t i = 0; i < single.size(); ++i ) { if( single[i] ) { ++partitioned; } }
+    EXPECT_GT( partitioned, 0u );
+    EXPECT_LT( partitioned, single.size() );
+}
+
+TEST( partition, parallel_commit_canonical_ids )
+{
+    std::vector< Eigen::Vector3d > points = random_cloud( 1000, 3 );
+    ids_type ids = partition_ids( points, 1, 1, 1, 0, 4 );
+    std::vector< bool > seen;
+    for( std::size_t i = 0; i < ids.size(); ++i ) { if( ids[i] ) { ASSERT_GE( *ids[i], 5u ); if( seen.size() <= *ids[i] - 5 ) { seen.resize( *ids[i] - 4, false ); } seen[ *ids[i] - 5 ] = true; } }
+    for( std::size_t i = 0; i < seen.size(); ++i ) { EXPECT_TRUE( seen[i] ); } // ids are consecutive
+}
+
+} } // namespace snark { namespace test {
@@ -0,0 +1,90 @@
+/// time partition tracking on a sequence of partitioned blocks with voxel_map and voted_tracking and with partition_tracking
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/lexical_cast.hpp>
+#include <snark/point_cloud/partition_tracking.h>
+#include "voted_tracking_reference.h"
+
+struct point_t
+{
+    Eigen::Vector3d point;
+    comma::uint32 id;
+    point_t( const Eigen::Vector3d& point, comma::uint32 id ) : point( point ), id( id ) {}
+};
+
+typedef std::vector< std::vector< point_t > > blocks_t;
+
+static double seconds_since( const boost::posix_time::ptime& start ) { return double( ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() ) / 1e6; }
+
+template < typename T >
+static std::vector< std::vector< comma::uint32 > > run( const std::string& name, T& tracking, const blocks_t& blocks )
+{
+    std::vector< std::vector< comma::uint32 > > ids( blocks.size() );
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    for( std::size_t b = 0; b < blocks.size(); ++b )
+    {
+        for( std::size_t i = 0; i < blocks[b].size(); ++i ) { tracking.add( blocks[b][i].point, blocks[b][i].id ); }
+        ids[b] = tracking.commit();
+    }
+    double seconds = seconds_since( start );
+    std::cout << name << ": " << seconds << " seconds; " << ( blocks.size() / seconds ) << " blocks/s" << std::endl;
+    return ids;
+}
+
+int main( int argc, char** argv )
+{
+    double resolution = argc > 1 ? boost::lexical_cast< double >( argv[1] ) : 0.2;
+    std::cerr << "usage: partition-tracking-benchmark [<resolution>] [<file>]; <file>: x,y,z,block,id per line, e.g. output of points-to-partitions; if not given, a synthetic sequence is used" << std::endl;
+    blocks_t blocks;
+    if( argc > 2 )
+    {
+        std::ifstream ifs( argv[2] );
+        if( !ifs.is_open() ) { std::cerr << "partition-tracking-benchmark: failed to open " << argv[2] << std::endl; return 1; }
+        std::string line;
+        bool first = true;
+        comma::uint32 block = 0;
+        while( std::getline( ifs, line ) )
+        {
+            Eigen::Vector3d p;
+            comma::uint32 b;
+            comma::uint32 id;
+            char comma;
+            std::istringstream iss( line );
+            if( !( iss >> p.x() >> comma >> p.y() >> comma >> p.z() >> comma >> b >> comma >> id ) ) { continue; }
+            if( first || b != block ) { blocks.push_back( std::vector< point_t >() ); block = b; first = false; }
+            blocks.back().push_back( point_t( p, id ) );
+        }
+    }
+    else
+    {
+        std::srand( 1 );
+        std::vector< Eigen::Vector3d > centres( 300 );
+        for( unsigned int i = 0; i < centres.size(); ++i ) { centres[i] = Eigen::Vector3d( 100.0 * std::rand() / RAND_MAX - 50, 100.0 * std::rand() / RAND_MAX - 50, 0 ); }
+        blocks.resize( 50 );
+        for( unsigned int b = 0; b < blocks.size(); ++b ) // 300 partitions of 1000 points per block, drifting, with shuffled ids
+        {
+            for( unsigned int i = 0; i < centres.size(); ++i )
+            {
+                centres[i] += Eigen::Vector3d( 0.02, 0.01, 0 );
+                comma::uint32 id = ( i * 7 + b * 13 ) % centres.size();
+                for( unsigned int k = 0; k < 1000; ++k ) { blocks[b].push_back( point_t( centres[i] + Eigen::Vector3d( 2.0 * std::rand() / RAND_MAX - 1, 2.0 * std::rand() / RAND_MAX - 1, 2.0 * std::rand() / RAND_MAX ), id ) ); }
+            }
+        }
+    }
+    std::size_t size = 0;
+    for( std::size_t b = 0; b < blocks.size(); ++b ) { size += blocks[b].size(); }
+    std::cerr << "partition-tracking-benchmark: " << blocks.size() << " blocks, " << size << " points, resolution " << resolution << std::endl;
+    Eigen::Vector3d r( resolution, resolution, resolution );
+    snark::test::voted_tracking_reference reference( Eigen::Vector3d::Zero(), r );
+    snark::partition_tracking tracking( Eigen::Vector3d::Zero(), r );
+    std::vector< std::vector< comma::uint32 > > expected = run( "voxel_map and voted_tracking", reference, blocks );
+    bool same = run( "partition_tracking", tracking, blocks ) == expected;
+    std::cout << "output " << ( same ? "identical" : "different" ) << std::endl;
+    return same ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2011 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstdlib>
+#include <vector>
+#include <gtest/gtest.h>
+#include <snark/point_cloud/partition_tracking.h>
+#include "voted_tracking_reference.h"
+
+namespace snark { namespace test {
+
+struct point_t
+{
+    Eigen::Vector3d point;
+    comma::uint32 id;
+    point_t( const Eigen::Vector3d& point, comma::uint32 id ) : point( point ), id( id ) {}
+};
+
+static double random( double from, double to ) { return from + ( to - from ) * std::rand() / RAND_MAX; }
+
+/// objects drifting from block to block, partitioned with random ids, sometimes split in two or mislabelled
+static std::vector< std::vector< point_t > > sequence( unsigned int blocks, unsigned int objects, unsigned int seed )
+{
+    std::srand( seed );
+    std::vector< Eigen::Vector3d > centres( objects );
+    for( unsigned int i = 0; i < objects; ++i ) { centres[i] = Eigen::Vector3d( random( -20, 20 ), random( -20, 20 ), random( 0, 2 ) ); }
+    std::vector< std::vector< point_t > > s( blocks );
+    for( unsigned int b = 0; b < blocks; ++b )
+    {
+        for( unsigned int i = 0; i < objects; ++i )
+        {
+            centres[i] += Eigen::Vector3d( random( -0.1, 0.1 ), random( -0.1, 0.1 ), 0 );
+            comma::uint32 id = std::rand() % ( objects * 2 );
+            comma::uint32 other = std::rand() % ( objects * 2 );
+            bool split = std::rand() % 5 == 0;
+            for( unsigned int k = 0; k < 200; ++k )
+            {
+                Eigen::Vector3d p = centres[i] + Eigen::Vector3d( random( -1, 1 ), random( -1, 1 ), random( -1, 1 ) );
+                comma::uint32 label = split && p.x() > centres[i].x() ? other : id;
+                if( std::rand() % 20 == 0 ) { label = std::rand() % ( objects * 2 ); }
+                s[b].push_back( point_t( p, label ) );
+            }
+        }
+    }
+    return s;
+}
+
+static void expect_same_as_reference( const std::vector< std::vector< point_t > >& blocks, double resolution )
+{
+    Eigen::Vector3d origin( 0.05, -0.1, 0 );
+    voted_tracking_reference reference( origin, Eigen::Vector3d( resolution, resolution, resolution ) );
+    partition_tracking tracking( origin, Eigen::Vector3d( resolution, resolution, resolution ) );
+    for( std::size_t b = 0; b < blocks.size(); ++b )
+    {
+        for( std::size_t i = 0; i < blocks[b].size(); ++i )
+        {
+            reference.add( blocks[b][i].point, blocks[b][i].id );
+            tracking.add( blocks[b][i].point, blocks[b][i].id );
+        }
+        std::vector< comma::uint32 > expected = reference.commit();
+        const std::vector< comma::uint32 >& ids = tracking.commit();
+        EXPECT_EQ( expected, ids ) << "block " << b;
+    }
+}
+
+TEST( partition_tracking, same_as_voted_tracking )
+{
+    expect_same_as_reference( sequence( 30, 20, 1 ), 0.2 );
+    expect_same_as_reference( sequence( 30, 50, 2 ), 0.5 );
+    expect_same_as_reference( sequence( 10, 100, 3 ), 1.0 );
+}
+
+TEST( partition_tracking, empty_blocks )
+{
+    std::vector< std::vector< point_t > > blocks = sequence( 6, 10, 4 );
+    blocks[2].clear();
+    blocks[3].clear();
+    expect_same_as_reference( blocks, 0.2 );
+}
+
+TEST( partition_tracking, static_object )
+{
+    partition_tracking tracking( Eigen::Vector3d::Zero(), Eigen::Vector3d( 0.5, 0.5, 0.5 ) );
+    for( unsigned int b = 0; b < 5; ++b )
+    {
+        for( unsigned int i = 0; i < 10; ++i ) { tracking.add( Eigen::Vector3d( 0.1 * i, 0.1, 0.1 ), 7 + b ); }
+        const std::vector< comma::uint32 >& ids = tracking.commit();
+        ASSERT_EQ( ids.size(), 10u );
+        for( unsigned int i = 0; i < ids.size(); ++i ) { EXPECT_EQ( ids[i], 7u ); }
+    }
+}
+
+} } // namespace snark { namespace test {
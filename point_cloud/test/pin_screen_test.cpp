@@ -37,9 +37,10 @@ namespace snark { namespace Robotics {
 typedef pin_screen< int >::index_type index_type;
 typedef pin_screen< int >::size_type size_type;
 
-TEST( pin_screen, grid )
+template < typename P >
+static void Testpin_screengrid()
 {
-    pin_screen< int > grid( 10, 12 );
+    P grid( 10, 12 );
     grid( 2, 3, 4 ) = 5;
     EXPECT_EQ( grid.size(), ( size_type( 10, 12 ) ) );
     EXPECT_EQ( grid( 2, 3, 4 ), 5 );
@@ -57,6 +58,39 @@ TEST( pin_screen, grid )
     EXPECT_EQ( grid.height( 2, 3 ), 0u );
 }
 
+TEST( pin_screen, grid )
+{
+    Testpin_screengrid< pin_screen< int > >();
+    Testpin_screengrid< pin_screen< int, flat_column< int > > >();
+}
+
+TEST( pin_screen, flat_column )
+{
+    flat_column< int > column;
+    column[5] = 5;
+    column[1] = 1;
+    column[9] = 9;
+    column[3] = 3;
+    column[5] = 55;
+    EXPECT_EQ( column.size(), 4u );
+    std::size_t keys[] = { 1, 3, 5, 9 };
+    int values[] = { 1, 3, 55, 9 };
+    unsigned int n = 0;
+    for( flat_column< int >::const_iterator it = column.begin(); it != column.end(); ++it, ++n ) { EXPECT_EQ( it->first, keys[n] ); EXPECT_EQ( it->second, values[n] ); }
+    EXPECT_EQ( n, 4u );
+    EXPECT_EQ( column.rbegin()->first, 9u );
+    EXPECT_TRUE( column.find( 4 ) == column.end() );
+    EXPECT_EQ( column.find( 3 )->second, 3 );
+    EXPECT_EQ( column.upper_bound( 3 )->first, 5u );
+    EXPECT_EQ( column.upper_bound( 4 )->first, 5u );
+    EXPECT_TRUE( column.upper_bound( 9 ) == column.end() );
+    EXPECT_EQ( column.erase( 4 ), 0u );
+    EXPECT_EQ( column.erase( 3 ), 1u );
+    EXPECT_EQ( column.size(), 3u );
+    EXPECT_TRUE( column.find( 3 ) == column.end() );
+    EXPECT_EQ( column.find( 5 )->second, 55 );
+}
+
 TEST( pin_screen, copy )
 {
     {
@@ -67,11 +101,19 @@ TEST( pin_screen, copy )
         q = p;
         EXPECT_EQ( q( 1, 2, 3 ), 5 );
     }
+    {
+        pin_screen< int, flat_column< int > > p( 4, 4 );
+        p( 1, 2, 3 ) = 5;
+        pin_screen< int, flat_column< int > > q( p );
+        EXPECT_EQ( q( 1, 2, 3 ), 5 );
+        q = p;
+        EXPECT_EQ( q( 1, 2, 3 ), 5 );
+    }
 }
 
 static const unsigned int size( 3 );
 
-template < typename It, typename S >
+template < typename P, typename It, typename S >
 static void Testpin_screeniterator( S& shape )
 {
 //     std::cerr << std::endl << "Testpin_screeniterator" << std::endl;
@@ -87,7 +129,7 @@ static void Testpin_screeniterator( S& shape )
 //     std::cerr << std::endl;
     {
         unsigned int count( 0 );
-        pin_screen< int > pinscreen( size, size );
+        P pinscreen( size, size );
         for( unsigned int i = 0; i < size; ++i )
         {
             for( unsigned int j = 0; j < size; ++j )
@@ -113,7 +155,7 @@ static void Testpin_screeniterator( S& shape )
     }
     {
         unsigned int count( 0 );
-        pin_screen< int > pinscreen( size, size );
+        P pinscreen( size, size );
         for( unsigned int i = 0; i < size; ++i )
         {
             for( unsigned int j = 0; j < size; ++j )
@@ -138,7 +180,7 @@ static void Testpin_screeniterator( S& shape )
     }
 }
 
-template < typename S >
+template < typename P, typename S >
 static void Testpin_screenneighbourhood_iterator( S& shape, S& sizes )
 {
 //    for( unsigned int i = 0; i < size; ++i )
@@ -152,7 +194,7 @@ static void Testpin_screenneighbourhood_iterator( S& shape, S& sizes )
 //    std::cerr << std::endl;
     {
         unsigned int count( 0 );
-        pin_screen< int > pinscreen( size, size );
+        P pinscreen( size, size );
         for( unsigned int i = 0; i < size; ++i )
         {
             for( unsigned int j = 0; j < size; ++j )
@@ -167,14 +209,14 @@ static void Testpin_screenneighbourhood_iterator( S& shape, S& sizes )
                 EXPECT_EQ( pinscreen.height( i, j ), 0u + k );
             }
         }
-        for( pin_screen< int >::iterator it = pinscreen.begin(); it != pinscreen.end(); ++it )
+        for( typename P::iterator it = pinscreen.begin(); it != pinscreen.end(); ++it )
         {
             //TEST_PRINT( it() );
             EXPECT_TRUE( pinscreen.exists( it() ) );
-            pin_screen< int >::neighbourhood_iterator begin( pin_screen< int >::neighbourhood_iterator::begin( it ) );
-            pin_screen< int >::neighbourhood_iterator end( pin_screen< int >::neighbourhood_iterator::end( it ) );
-            std::set< pin_screen< int >::iterator > s;
-            for( pin_screen< int >::neighbourhood_iterator nit( begin ); nit != end; ++nit )
+            typename P::neighbourhood_iterator begin( P::neighbourhood_iterator::begin( it ) );
+            typename P::neighbourhood_iterator end( P::neighbourhood_iterator::end( it ) );
+            std::set< typename P::iterator > s;
+            for( typename P::neighbourhood_iterator nit( begin ); nit != end; ++nit )
             {
                 //TEST_PRINT( nit() );
                 s.insert( nit );
@@ -185,11 +227,12 @@ static void Testpin_screenneighbourhood_iterator( S& shape, S& sizes )
 }
 
 
-TEST( pin_screen, Largepin_screenneighbourhood_iterator )
+template < typename P >
+static void TestLargepin_screenneighbourhood_iterator()
 {
     static const unsigned int sizeLarge( 10 );
     {
-        pin_screen< int > pinscreen( sizeLarge , sizeLarge );
+        P pinscreen( sizeLarge , sizeLarge );
         unsigned int check[sizeLarge][sizeLarge];
         for( unsigned int i = 0; i < sizeLarge ; ++i )
         {
@@ -199,7 +242,7 @@ TEST( pin_screen, Largepin_screenneighbourhood_iterator )
                 if( i == j ) { pinscreen( i, j , 0 ) = i; }
             }
         }
-        for( pin_screen< int >::iterator it = pinscreen.begin(); it != pinscreen.end(); ++it )
+        for( typename P::iterator it = pinscreen.begin(); it != pinscreen.end(); ++it )
         {
             EXPECT_EQ( check[it()[0]][it()[1]] , 0u );
             check[it()[0]][it()[1]] = 1;
@@ -208,18 +251,18 @@ TEST( pin_screen, Largepin_screenneighbourhood_iterator )
                 EXPECT_TRUE( pinscreen.exists( it()[0], it()[1], it()[2] ) );
                 EXPECT_EQ( it()[2] , 0u );
                 EXPECT_EQ( static_cast<unsigned int>( pinscreen( it() ) ) , it()[0] );
-                pin_screen< int >::neighbourhood_iterator begin( pin_screen< int >::neighbourhood_iterator::begin( it ) );
-                pin_screen< int >::neighbourhood_iterator end( pin_screen< int >::neighbourhood_iterator::end( it ) );
-                std::set< pin_screen< int >::iterator > s;
-                for( pin_screen< int >::neighbourhood_iterator nit( begin ); nit != end; ++nit )
+                typename P::neighbourhood_iterator begin( P::neighbourhood_iterator::begin( it ) );
+                typename P::neighbourhood_iterator end( P::neighbourhood_iterator::end( it ) );
+                std::set< typename P::iterator > s;
+                for( typename P::neighbourhood_iterator nit( begin ); nit != end; ++nit )
                 {
                     s.insert( nit );
                     if( nit()[0] == nit()[1] && nit()[0] > 0 && nit()[0] < sizeLarge-1 )
                     {
-                        pin_screen< int >::neighbourhood_iterator begin2( pin_screen< int >::neighbourhood_iterator::begin( nit ) );
-                        pin_screen< int >::neighbourhood_iterator end2( pin_screen< int >::neighbourhood_iterator::end( nit ) );
-                        std::set< pin_screen< int >::iterator > s2;
-                        for( pin_screen< int >::neighbourhood_iterator nit2( begin2 ); nit2 != end2; ++nit2 )
+                        typename P::neighbourhood_iterator begin2( P::neighbourhood_iterator::begin( nit ) );
+                        typename P::neighbourhood_iterator end2( P::neighbourhood_iterator::end( nit ) );
+                        std::set< typename P::iterator > s2;
+                        for( typename P::neighbourhood_iterator nit2( begin2 ); nit2 != end2; ++nit2 )
                         {
                             s2.insert( nit2 );
                         }
@@ -238,42 +281,49 @@ TEST( pin_screen, Largepin_screenneighbourhood_iterator )
     }
 }
 
-template < typename It >
+TEST( pin_screen, Largepin_screenneighbourhood_iterator )
+{
+    TestLargepin_screenneighbourhood_iterator< pin_screen< int > >();
+    TestLargepin_screenneighbourhood_iterator< pin_screen< int, flat_column< int > > >();
+}
+
+template < typename P, typename It >
 static void Testpin_screeniterator()
 {
     {
         const int shape[size][size] = { { 0, 0, 0 }
                                       , { 0, 0, 0 }
                                       , { 0, 0, 0 } };
-        Testpin_screeniterator< It >( shape );
+        Testpin_screeniterator< P, It >( shape );
     }
     {
         const int shape[size][size] = { { 0, 0, 0 }
                                       , { 0, 0, 0 }
                                       , { 0, 0, 1 } };
-        Testpin_screeniterator< It >( shape );
+        Testpin_screeniterator< P, It >( shape );
     }
     {
         const int shape[size][size] = { { 0, 5, 0 }
                                       , { 0, 6, 0 }
                                       , { 0, 0, 1 } };
-        Testpin_screeniterator< It >( shape );
+        Testpin_screeniterator< P, It >( shape );
     }
     {
         const int shape[size][size] = { { 1, 1, 1 }
                                       , { 1, 1, 1 }
                                       , { 1, 1, 1 } };
-        Testpin_screeniterator< It >( shape );
+        Testpin_screeniterator< P, It >( shape );
     }
     {
         const int shape[size][size] = { { 2, 2, 2 }
                                       , { 2, 2, 2 }
                                       , { 2, 2, 2 } };
-        Testpin_screeniterator< It >( shape );
+        Testpin_screeniterator< P, It >( shape );
     }
 }
 
-TEST( Pinscreen, neighbourhood_iterator )
+template < typename P >
+static void Testpin_screenneighbourhood_iterator()
 {
     {
         const unsigned int shape[size][size] = { { 0, 0, 0 }
@@ -282,7 +332,7 @@ TEST( Pinscreen, neighbourhood_iterator )
         const unsigned int sizes[size][size] = { { 0, 0, 0 }
                                                , { 0, 0, 0 }
                                                , { 0, 0, 0 } };
-        Testpin_screenneighbourhood_iterator( shape, sizes );
+        Testpin_screenneighbourhood_iterator< P >( shape, sizes );
     }
     {
         for( unsigned int i = 0; i < size; ++i )
@@ -296,9 +346,9 @@ TEST( Pinscreen, neighbourhood_iterator )
                                                  , { 0, 0, 0 }
                                                  , { 0, 0, 0 } };
                 shape[i][j] = 1;
-                Testpin_screenneighbourhood_iterator( shape, sizes );
+                Testpin_screenneighbourhood_iterator< P >( shape, sizes );
                 shape[i][j] = 2;
-                Testpin_screenneighbourhood_iterator( shape, sizes );
+                Testpin_screenneighbourhood_iterator< P >( shape, sizes );
             }
         }
     }
@@ -309,7 +359,7 @@ TEST( Pinscreen, neighbourhood_iterator )
         const unsigned int sizes[size][size] = { { 1, 1, 0 }
                                                , { 0, 0, 0 }
                                                , { 0, 0, 0 } };
-        Testpin_screenneighbourhood_iterator( shape, sizes );
+        Testpin_screenneighbourhood_iterator< P >( shape, sizes );
     }
     {
         const unsigned int shape[size][size] = { { 1, 2, 0 }
@@ -318,7 +368,7 @@ TEST( Pinscreen, neighbourhood_iterator )
         const unsigned int sizes[size][size] = { { 1, 1, 0 }
                                                , { 0, 0, 0 }
                                                , { 0, 0, 0 } };
-        Testpin_screenneighbourhood_iterator( shape, sizes );
+        Testpin_screenneighbourhood_iterator< P >( shape, sizes );
     }
     {
         const unsigned int shape[size][size] = { { 1, 3, 0 }
@@ -327,7 +377,7 @@ TEST( Pinscreen, neighbourhood_iterator )
         const unsigned int sizes[size][size] = { { 0, 0, 0 }
                                                , { 0, 0, 0 }
                                                , { 0, 0, 0 } };
-        Testpin_screenneighbourhood_iterator( shape, sizes );
+        Testpin_screenneighbourhood_iterator< P >( shape, sizes );
     }
     {
         const unsigned int shape[size][size] = { { 2, 3, 0 }
@@ -336,7 +386,7 @@ TEST( Pinscreen, neighbourhood_iterator )
         const unsigned int sizes[size][size] = { { 3, 2, 0 }
                                                , { 2, 3, 0 }
                                                , { 0, 0, 0 } };
-        Testpin_screenneighbourhood_iterator( shape, sizes );
+        Testpin_screenneighbourhood_iterator< P >( shape, sizes );
     }
     {
         const unsigned int shape[size][size] = { { 0, 0, 0 }
@@ -345,7 +395,7 @@ TEST( Pinscreen, neighbourhood_iterator )
         const unsigned int sizes[size][size] = { { 0, 0, 0 }
                                                , { 1, 1, 0 }
                                                , { 0, 0, 0 } };
-        Testpin_screenneighbourhood_iterator( shape, sizes );
+        Testpin_screenneighbourhood_iterator< P >( shape, sizes );
     }
     {
         const unsigned int shape[size][size] = { { 0, 0, 0 }
@@ -354,7 +404,7 @@ TEST( Pinscreen, neighbourhood_iterator )
         const unsigned int sizes[size][size] = { { 0, 0, 0 }
                                                , { 1, 1, 0 }
                                                , { 0, 0, 0 } };
-        Testpin_screenneighbourhood_iterator( shape, sizes );
+        Testpin_screenneighbourhood_iterator< P >( shape, sizes );
     }
     {
         const unsigned int shape[size][size] = { { 0, 0, 0 }
@@ -363,7 +413,7 @@ TEST( Pinscreen, neighbourhood_iterator )
         const unsigned int sizes[size][size] = { { 0, 0, 0 }
                                                , { 0, 0, 0 }
                                                , { 0, 0, 0 } };
-        Testpin_screenneighbourhood_iterator( shape, sizes );
+        Testpin_screenneighbourhood_iterator< P >( shape, sizes );
     }
     {
         const unsigned int shape[size][size] = { { 0, 0, 0 }
@@ -372,7 +422,7 @@ TEST( Pinscreen, neighbourhood_iterator )
         const unsigned int sizes[size][size] = { { 0, 0, 0 }
                                                , { 3, 2, 0 }
                                                , { 2, 3, 0 } };
-        Testpin_screenneighbourhood_iterator( shape, sizes );
+        Testpin_screenneighbourhood_iterator< P >( shape, sizes );
     }
     {
         const unsigned int shape[size][size] = { { 0, 0, 0 }
@@ -381,16 +431,24 @@ TEST( Pinscreen, neighbourhood_iterator )
         const unsigned int sizes[size][size] = { { 0, 0, 0 }
                                                , { 0, 3, 2 }
                                                , { 0, 2, 3 } };
-        Testpin_screenneighbourhood_iterator( shape, sizes );
+        Testpin_screenneighbourhood_iterator< P >( shape, sizes );
     }
     // TODO: more unit tests
 }
 
+TEST( Pinscreen, neighbourhood_iterator )
+{
+    Testpin_screenneighbourhood_iterator< pin_screen< int > >();
+    Testpin_screenneighbourhood_iterator< pin_screen< int, flat_column< int > > >();
+}
+
 
 TEST( pin_screen, iterators )
 {
-    Testpin_screeniterator< pin_screen< int >::const_iterator >();
-    Testpin_screeniterator< pin_screen< int >::iterator >();
+    Testpin_screeniterator< pin_screen< int >, pin_screen< int >::const_iterator >();
+    Testpin_screeniterator< pin_screen< int >, pin_screen< int >::iterator >();
+    Testpin_screeniterator< pin_screen< int, flat_column< int > >, pin_screen< int, flat_column< int > >::const_iterator >();
+    Testpin_screeniterator< pin_screen< int, flat_column< int > >, pin_screen< int, flat_column< int > >::iterator >();
 }
 
 
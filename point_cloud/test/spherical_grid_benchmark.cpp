@@ -0,0 +1,46 @@
+/// time building a spherical grid from cartesian points and querying cell neighbourhoods
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/lexical_cast.hpp>
+#include <snark/point_cloud/spherical_grid.h>
+
+struct count_neighbours
+{
+    std::size_t count;
+    count_neighbours() : count( 0 ) {}
+    void operator()( const snark::spherical_grid< unsigned int >::index_type&, unsigned int n ) { count += n; }
+};
+
+static double seconds_since( const boost::posix_time::ptime& start ) { return double( ( boost::posix_time::microsec_clock::universal_time() - start ).total_microseconds() ) / 1e6; }
+
+int main( int argc, char** argv )
+{
+    unsigned int size = argc > 1 ? boost::lexical_cast< unsigned int >( argv[1] ) : 2000000;
+    double resolution = argc > 2 ? boost::lexical_cast< double >( argv[2] ) : 0.005;
+    double range_resolution = argc > 3 ? boost::lexical_cast< double >( argv[3] ) : 0.1;
+    std::cerr << "usage: spherical-grid-benchmark [<number of points>] [<angular resolution>] [<range resolution>]; running with " << size << " points, resolution " << resolution << ", range resolution " << range_resolution << std::endl;
+    std::vector< Eigen::Vector3d > points( size );
+    std::srand( 1 );
+    for( unsigned int i = 0; i < size; ++i ) // full 360 degree scan, elevation -15 to 15 degrees, ranges up to 50 metres
+    {
+        double b = 2 * M_PI * std::rand() / RAND_MAX - M_PI;
+        double e = ( 30.0 * std::rand() / RAND_MAX - 15 ) * M_PI / 180;
+        points[i] = snark::range_bearing_elevation( 1 + 49.0 * std::rand() / RAND_MAX, b, e ).to_cartesian();
+    }
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    snark::spherical_grid< unsigned int > grid( snark::bearing_elevation( resolution, resolution ), range_resolution );
+    for( unsigned int i = 0; i < size; ++i ) { ++grid.touch_at( points[i] ); }
+    std::cout << "build: " << seconds_since( start ) << " seconds; " << grid.count() << " non-empty cells in " << grid.size()[0] << "x" << grid.size()[1] << " columns" << std::endl;
+    start = boost::posix_time::microsec_clock::universal_time();
+    std::size_t found = 0;
+    for( unsigned int i = 0; i < size; ++i ) { found += grid.find( grid.index_of( points[i] ) ) != NULL; }
+    std::cout << "find: " << seconds_since( start ) << " seconds; " << found << " points found" << std::endl;
+    start = boost::posix_time::microsec_clock::universal_time();
+    count_neighbours neighbours;
+    for( unsigned int i = 0; i < size; ++i ) { grid.for_each_neighbour( grid.index_of( points[i] ), neighbours ); }
+    std::cout << "neighbourhood: " << seconds_since( start ) << " seconds; " << neighbours.count << " neighbour points" << std::endl;
+    return 0;
+}
@@ -29,6 +29,8 @@
 
 #include <gtest/gtest.h>
 #include <cmath>
+#include <cstdlib>
+#include <set>
 #include <snark/point_cloud/spherical_grid.h>
 
 namespace snark {
@@ -376,4 +378,140 @@ TEST( elevation_index, get_bounds )
     }
 }
 
+TEST( spherical_grid, index_of )
+{
+    spherical_grid< int > grid( bearing_elevation( one_degree, one_degree ), 0.5 );
+    EXPECT_EQ( 360u, grid.size()[0] );
+    EXPECT_EQ( 181u, grid.size()[1] );
+    spherical_grid< int >::index_type i = grid.index_of( range_bearing_elevation( 10.2, 20.5 * one_degree, -30.5 * one_degree ) );
+    EXPECT_EQ( 200u, i[0] );
+    EXPECT_EQ( 59u, i[1] );
+    EXPECT_EQ( 20u, i[2] );
+    spherical_grid< int >::index_type j = grid.index_of( Eigen::Vector3d( 0, 2, 0 ) ); // bearing 90 degrees, elevation 0, range 2
+    EXPECT_EQ( 270u, j[0] );
+    EXPECT_EQ( 90u, j[1] );
+    EXPECT_EQ( 4u, j[2] );
+    range_bearing_elevation o = grid.origin( i );
+    EXPECT_NEAR( 10, o.range(), 1e-9 );
+    EXPECT_NEAR( 20 * one_degree, o.bearing(), 1e-9 );
+    EXPECT_NEAR( -31 * one_degree, o.elevation(), 1e-9 );
+    EXPECT_THROW( grid.index_of( range_bearing_elevation( 1e20, 0, 0 ) ), comma::exception );
+}
+
+TEST( spherical_grid, touch_find_erase )
+{
+    spherical_grid< int > grid( bearing_elevation( one_degree, one_degree ), 1 );
+    spherical_grid< int >::index_type i = {{ 10, 20, 7 }};
+    spherical_grid< int >::index_type j = {{ 10, 20, 3 }};
+    spherical_grid< int >::index_type k = {{ 10, 20, 100 }};
+    EXPECT_TRUE( grid.find( i ) == NULL );
+    grid.touch( i ) = 1;
+    grid.touch( k ) = 3;
+    grid.touch( j ) = 2;
+    grid.touch( i ) += 10;
+    EXPECT_EQ( 3u, grid.count() );
+    EXPECT_EQ( 11, *grid.find( i ) );
+    EXPECT_EQ( 2, *grid.find( j ) );
+    EXPECT_EQ( 3, *grid.find( k ) );
+    const spherical_grid< int >::column_type& c = grid.column( 10, 20 );
+    ASSERT_EQ( 3u, c.size() );
+    EXPECT_EQ( 3u, c[0].first );
+    EXPECT_EQ( 7u, c[1].first );
+    EXPECT_EQ( 100u, c[2].first );
+    EXPECT_TRUE( grid.column( 10, 21 ).empty() );
+    grid.erase( i );
+    grid.erase( i );
+    EXPECT_EQ( 2u, grid.count() );
+    EXPECT_TRUE( grid.find( i ) == NULL );
+    EXPECT_EQ( 2u, grid.column( 10, 20 ).size() );
+    Eigen::Vector3d p( 3, -4, 5 );
+    grid.touch_at( p ) = 42;
+    EXPECT_EQ( 42, *grid.find( grid.index_of( range_bearing_elevation( p ) ) ) );
+}
+
+namespace {
+
+struct collect_neighbours
+{
+    std::set< spherical_grid< int >::index_type > indices;
+    void operator()( const spherical_grid< int >::index_type& i, int value ) { EXPECT_EQ( int( i[0] * 10000 + i[1] * 100 + i[2] ), value ); indices.insert( i ); }
+};
+
+std::size_t bearing_distance( std::size_t a, std::size_t b, std::size_t size ) { std::size_t d = a > b ? a - b : b - a; return std::min( d, size - d ); }
+
+std::size_t distance( std::size_t a, std::size_t b ) { return a > b ? a - b : b - a; }
+
+} // namespace {
+
+TEST( spherical_grid, neighbourhood )
+{
+    spherical_grid< int > grid( bearing_elevation( 30 * one_degree, 30 * one_degree ), 1 ); // 12 bearing cells, 7 elevation cells
+    std::set< spherical_grid< int >::index_type > all;
+    std::srand( 1 );
+    for( unsigned int k = 0; k < 300; ++k )
+    {
+        spherical_grid< int >::index_type i = {{ std::size_t( std::rand() % grid.size()[0] ), std::size_t( std::rand() % grid.size()[1] ), std::size_t( std::rand() % 8 ) }};
+        grid.touch( i ) = i[0] * 10000 + i[1] * 100 + i[2];
+        all.insert( i );
+    }
+    EXPECT_EQ( all.size(), grid.count() );
+    collect_neighbours every;
+    grid.for_each( every );
+    EXPECT_EQ( all, every.indices );
+    for( std::set< spherical_grid< int >::index_type >::const_iterator it = all.begin(); it != all.end(); ++it )
+    {
+        for( std::size_t radius = 0; radius < 8; radius += 1 + radius )
+        {
+            std::set< spherical_grid< int >::index_type > expected;
+            for( std::set< spherical_grid< int >::index_type >::const_iterator jt = all.begin(); jt != all.end(); ++jt )
+            {
+                if(    *jt != *it
+                    && bearing_distance( ( *jt )[0], ( *it )[0], grid.size()[0] ) <= radius
+                    && distance( ( *jt )[1], ( *it )[1] ) <= radius
+                    && distance( ( *jt )[2], ( *it )[2] ) <= radius ) { expected.insert( *jt ); }
+            }
+            collect_neighbours neighbours;
+            grid.for_each_neighbour( *it, neighbours, radius );
+            EXPECT_EQ( expected, neighbours.indices );
+        }
+    }
+}
+
+TEST( spherical_grid, cartesian_points )
+{
+    spherical_grid< std::vector< Eigen::Vector3d > > grid( bearing_elevation( 2 * one_degree, 2 * one_degree ), 0.25 );
+    std::srand( 2 );
+    std::vector< Eigen::Vector3d > points;
+    for( unsigned int k = 0; k < 2000; ++k )
+    {
+        Eigen::Vector3d p( 20.0 * std::rand() / RAND_MAX - 10, 20.0 * std::rand() / RAND_MAX - 10, 20.0 * std::rand() / RAND_MAX - 10 );
+        points.push_back( p );
+        grid.touch_at( p ).push_back( p );
+    }
+    std::size_t count = 0;
+    for( std::size_t b = 0; b < grid.size()[0]; ++b )
+    {
+        for( std::size_t e = 0; e < grid.size()[1]; ++e )
+        {
+            const spherical_grid< std::vector< Eigen::Vector3d > >::column_type& c = grid.column( b, e );
+            for( std::size_t k = 0; k < c.size(); ++k )
+            {
+                if( k > 0 ) { EXPECT_LT( c[ k - 1 ].first, c[k].first ); }
+                for( std::size_t n = 0; n < c[k].second.size(); ++n )
+                {
+                    range_bearing_elevation p( c[k].second[n] );
+                    range_bearing_elevation o = grid.origin( grid.index_of( p ) );
+                    EXPECT_EQ( c[k].first, grid.index_of( p )[2] );
+                    EXPECT_LE( o.range(), p.range() );
+                    EXPECT_LT( p.range(), o.range() + 0.25 );
+                    EXPECT_NEAR( o.bearing() + one_degree, p.bearing(), one_degree + 1e-6 );
+                    EXPECT_NEAR( o.elevation() + one_degree, p.elevation(), one_degree + 1e-6 );
+                    ++count;
+                }
+            }
+        }
+    }
+    EXPECT_EQ( points.size(), count );
+}
+
 } // namespace snark {
@@ -0,0 +1,116 @@
+/// points-track-partitions matching as implemented with voxel_map and voted_tracking,
+/// used as reference for partition_tracking in test and benchmark
+
+#ifndef SNARK_POINT_CLOUD_TEST_VOTED_TRACKING_REFERENCE_H_
+#define SNARK_POINT_CLOUD_TEST_VOTED_TRACKING_REFERENCE_H_
+
+#include <deque>
+#include <map>
+#include <vector>
+#include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
+#include <snark/point_cloud/voted_tracking.h>
+#include <snark/point_cloud/voxel_map.h>
+
+namespace snark { namespace test {
+
+class voted_tracking_reference
+{
+    public:
+        voted_tracking_reference( const Eigen::Vector3d& origin, const Eigen::Vector3d& resolution ) : origin_( origin ), resolution_( resolution ), vacant_( 0 ) {}
+
+        void add( const Eigen::Vector3d& point, comma::uint32 id )
+        {
+            if( !current_ ) { current_.reset( new map_t( origin_, resolution_ ) ); }
+            map_t::iterator it = current_->touch_at( point );
+            it->second.add( point, id );
+            points_.push_back( &it->second );
+        }
+
+        std::vector< comma::uint32 > commit()
+        {
+            if( !current_ ) { current_.reset( new map_t( origin_, resolution_ ) ); }
+            if( previous_ ) { match_(); }
+            std::vector< comma::uint32 > ids( points_.size() );
+            for( std::size_t i = 0; i < points_.size(); ++i ) { ids[i] = points_[i]->id(); }
+            points_.clear();
+            previous_ = current_;
+            current_.reset();
+            return ids;
+        }
+
+    private:
+        class voxel
+        {
+            public:
+                voxel() : sum_( 0, 0, 0 ), id_( 0 ), count_( 0 ) {}
+                void add( const Eigen::Vector3d& point, comma::uint32 id )
+                {
+                    unsigned int count = ++map_[id];
+                    if( count > count_ ) { id_ = id; count_ = count; }
+                    sum_ += point;
+                }
+                Eigen::Vector3d mean() const { return sum_ / count_; }
+                comma::uint32 id() const { return id_; }
+                void set( comma::uint32 v ) { id_ = v; }
+
+            private:
+                std::map< comma::uint32, unsigned int > map_;
+                Eigen::Vector3d sum_;
+                comma::uint32 id_;
+                unsigned int count_;
+        };
+
+        typedef snark::voxel_map< voxel, 3 > map_t;
+        typedef std::deque< std::pair< voxel*, const voxel* > > partition_t; // current voxel and matching previous voxel, if any
+        struct id_element
+        {
+            comma::uint32 id;
+            partition_t* partition;
+            id_element( comma::uint32 id, partition_t* partition ) : id( id ), partition( partition ) {}
+        };
+        typedef std::multimap< comma::uint32, id_element > id_map;
+
+        static boost::optional< comma::uint32 > previous_id_( partition_t::const_iterator it ) { return it->second ? boost::optional< comma::uint32 >( it->second->id() ) : boost::none; }
+
+        void match_()
+        {
+            std::map< comma::uint32, partition_t > partitions;
+            for( map_t::iterator it = current_->begin(); it != current_->end(); ++it )
+            {
+                map_t::const_iterator v = previous_->find( it->second.mean() );
+                partitions[ it->second.id() ].push_back( std::make_pair( &it->second, v == previous_->end() ? NULL : &v->second ) );
+            }
+            id_map ids;
+            for( std::map< comma::uint32, partition_t >::iterator it = partitions.begin(); it != partitions.end(); ++it )
+            {
+                comma::uint32 id = snark::voted_tracking( it->second.begin(), it->second.end(), previous_id_, vacant_ );
+                if( id == vacant_ ) { ++vacant_; }
+                ids.insert( std::make_pair( id, id_element( id, &( it->second ) ) ) );
+            }
+            for( id_map::iterator it = ids.begin(); it != ids.end(); )
+            {
+                id_map::iterator largest = it++;
+                for( ; it != ids.end() && it->first == largest->first; ++it )
+                {
+                    if( largest->second.partition->size() >= it->second.partition->size() ) { it->second.id = vacant_++; }
+                    else { largest->second.id = vacant_++; largest = it; }
+                }
+            }
+            for( id_map::iterator it = ids.begin(); it != ids.end(); ++it )
+            {
+                for( partition_t::iterator j = it->second.partition->begin(); j != it->second.partition->end(); ++j ) { j->first->set( it->second.id ); }
+            }
+        }
+
+        Eigen::Vector3d origin_;
+        Eigen::Vector3d resolution_;
+        comma::uint32 vacant_;
+        boost::shared_ptr< map_t > current_;
+        boost::shared_ptr< map_t > previous_;
+        std::vector< voxel* > points_;
+};
+
+} } // namespace snark { namespace test {
+
+#endif // SNARK_POINT_CLOUD_TEST_VOTED_TRACKING_REFERENCE_H_
@@ -97,6 +97,41 @@ TEST( voxel_grid, test )
     }
 }
 
+TEST( voxel_grid, flat_column )
+{
+    typedef snark::voxel_grid< int > map_grid;
+    typedef snark::voxel_grid< int, point, snark::flat_column< int > > flat_grid;
+    extents_type e( point( 0, 0, 0 ), point( 4, 4, 4 ) );
+    point resolution( 0.5, 0.5, 0.5 );
+    map_grid m( e, resolution );
+    flat_grid f( e, resolution );
+    ::srand( 1 );
+    for( unsigned int i = 0; i < 2000; ++i )
+    {
+        point p( 4.0 * ::rand() / RAND_MAX, 4.0 * ::rand() / RAND_MAX, 4.0 * ::rand() / RAND_MAX );
+        ++( *m.touch_at( p ) );
+        ++( *f.touch_at( p ) );
+        if( i % 7 == 0 ) { m.erase_at( p ); f.erase_at( p ); }
+    }
+    map_grid::iterator mit = m.begin();
+    flat_grid::iterator fit = f.begin();
+    for( ; mit != m.end() && fit != f.end(); ++mit, ++fit )
+    {
+        EXPECT_EQ( mit(), fit() );
+        EXPECT_EQ( *mit, *fit );
+        std::vector< index_type > mn;
+        std::vector< index_type > fn;
+        for( map_grid::neighbourhood_iterator nit = map_grid::neighbourhood_iterator::begin( mit ); nit != map_grid::neighbourhood_iterator::end( mit ); ++nit ) { mn.push_back( nit() ); }
+        for( flat_grid::neighbourhood_iterator nit = flat_grid::neighbourhood_iterator::begin( fit ); nit != flat_grid::neighbourhood_iterator::end( fit ); ++nit ) { fn.push_back( nit() ); }
+        EXPECT_EQ( mn, fn );
+    }
+    EXPECT_TRUE( mit == m.end() );
+    EXPECT_TRUE( fit == f.end() );
+    const flat_grid::column_type* c = f.column( point( 1, 1, 1 ) );
+    EXPECT_TRUE( c != NULL );
+    EXPECT_EQ( c->size(), m.column( point( 1, 1, 1 ) )->size() );
+}
+
 } } // namespace snark {  namespace test {
 
 int main(int argc, char *argv[])
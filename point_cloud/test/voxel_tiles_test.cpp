@@ -0,0 +1,188 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <unistd.h>
+#include <gtest/gtest.h>
+#include <snark/point_cloud/voxel_tiles.h>
+
+namespace snark {
+
+typedef voxel_tiles::index_type index_type;
+
+struct voxel
+{
+    Eigen::Vector3d sum;
+    std::size_t size;
+    voxel() : sum( 0, 0, 0 ), size( 0 ) {}
+};
+
+typedef std::map< index_type, voxel > voxels_type;
+
+static void add( voxels_type& voxels, const voxel_tiles& tiles, const std::vector< Eigen::Vector3d >& points )
+{
+    for( std::size_t i = 0; i < points.size(); ++i ) { voxel& v = voxels[ tiles.index_of( points[i] ) ]; v.sum += points[i]; ++v.size; }
+}
+
+static std::size_t neighbours( const voxels_type& voxels, const index_type& index, comma::int32 radius )
+{
+    std::size_t size = 0;
+    index_type i;
+    for( i[0] = index[0] - radius; i[0] <= index[0] + radius; ++i[0] )
+    {
+        for( i[1] = index[1] - radius; i[1] <= index[1] + radius; ++i[1] )
+        {
+            for( i[2] = index[2] - radius; i[2] <= index[2] + radius; ++i[2] )
+            {
+                voxels_type::const_iterator it = voxels.find( i );
+                if( it != voxels.end() ) { size += it->second.size; }
+            }
+        }
+    }
+    return size;
+}
+
+static void compare( comma::uint32 tile_size, comma::uint32 radius, std::size_t buffer_size, std::size_t max_points, bool stale = false )
+{
+    char directory[] = "/tmp/voxel-tiles-test.XXXXXX";
+    ASSERT_TRUE( ::mkdtemp( directory ) != NULL );
+    std::string stale_filename = std::string( directory ) + "/voxel-tiles.0.points";
+    if( stale ) // as left behind by a killed run
+    {
+        std::ofstream ofs( stale_filename.c_str(), std::ios::binary );
+        std::vector< Eigen::Vector3d > garbage( 1000, Eigen::Vector3d( 1e6, -1e6, 1e6 ) );
+        ofs.write( reinterpret_cast< const char* >( &garbage[0] ), garbage.size() * sizeof( Eigen::Vector3d ) );
+    }
+    {
+        std::vector< Eigen::Vector3d > points[2];
+        std::srand( 1 );
+        for( unsigned int b = 0; b < 2; ++b )
+        {
+            for( unsigned int i = 0; i < 20000; ++i ) // dense cluster around origin, sparse points elsewhere, both sides of zero
+            {
+                double scale = i % 2 ? 2.0 : 20.0;
+                points[b].push_back( Eigen::Vector3d( scale * ( double( std::rand() ) / RAND_MAX - 0.5 ), scale * ( double( std::rand() ) / RAND_MAX - 0.5 ), scale * ( double( std::rand() ) / RAND_MAX - 0.5 ) ) );
+            }
+        }
+        voxel_tiles tiles( Eigen::Vector3d( 0.1, 0.1, 0.1 ), Eigen::Vector3d( 0.5, 0.5, 0.5 ), directory, tile_size, radius, buffer_size );
+        for( unsigned int b = 0; b < 2; ++b ) { for( std::size_t i = 0; i < points[b].size(); ++i ) { tiles.insert( points[b][i], b * 5 ); } }
+        tiles.commit( max_points );
+        voxels_type expected[2];
+        for( unsigned int b = 0; b < 2; ++b ) { add( expected[b], tiles, points[b] ); }
+        voxels_type actual[2];
+        std::size_t total = 0;
+        for( std::size_t t = 0; t < tiles.tiles().size(); ++t )
+        {
+            const voxel_tiles::tile& tile = tiles.tiles()[t];
+            ASSERT_TRUE( tile.block == 0 || tile.block == 5 );
+            if( max_points > 0 && tile.size > 1 ) { EXPECT_LE( tile.count + tile.margin, max_points ); }
+            std::vector< Eigen::Vector3d > inside;
+            std::vector< Eigen::Vector3d > margin;
+            tiles.read( t, inside, margin );
+            EXPECT_EQ( tile.count, inside.size() );
+            total += inside.size();
+            voxels_type voxels;
+            add( voxels, tiles, inside );
+            for( voxels_type::const_iterator it = voxels.begin(); it != voxels.end(); ++it ) { EXPECT_TRUE( tile.contains( it->first ) ); }
+            add( voxels, tiles, margin );
+            voxels_type& a = actual[ tile.block / 5 ];
+            for( voxels_type::const_iterator it = voxels.begin(); it != voxels.end(); ++it )
+            {
+                if( !tile.contains( it->first ) ) { continue; }
+                EXPECT_TRUE( a.find( it->first ) == a.end() );
+                a[ it->first ] = it->second;
+                if( radius > 0 ) { EXPECT_EQ( neighbours( expected[ tile.block / 5 ], it->first, radius ), neighbours( voxels, it->first, radius ) ); }
+            }
+        }
+        EXPECT_EQ( points[0].size() + points[1].size(), total );
+        for( unsigned int b = 0; b < 2; ++b )
+        {
+            ASSERT_EQ( expected[b].size(), actual[b].size() );
+            for( voxels_type::const_iterator e = expected[b].begin(), a = actual[b].begin(); e != expected[b].end(); ++e, ++a )
+            {
+                EXPECT_EQ( e->first, a->first );
+                EXPECT_EQ( e->second.size, a->second.size );
+                EXPECT_EQ( e->second.sum, a->second.sum ); // same points in same order, thus exactly same sums
+            }
+        }
+    }
+    if( stale ) { EXPECT_EQ( 0, std::remove( stale_filename.c_str() ) ); } // not touched
+    EXPECT_EQ( 0, ::rmdir( directory ) ); // all tile files removed
+}
+
+TEST( voxel_tiles, same_as_in_memory )
+{
+    compare( 8, 0, 1 << 20, 0 );
+    compare( 5, 0, 1000, 0 );
+}
+
+TEST( voxel_tiles, margin )
+{
+    compare( 8, 1, 1000, 0 );
+    compare( 4, 2, 1 << 20, 0 );
+}
+
+TEST( voxel_tiles, stale_files )
+{
+    compare( 8, 1, 1000, 0, true );
+    compare( 64, 0, 1000, 2000, true );
+}
+
+TEST( voxel_tiles, shared_directory )
+{
+    char directory[] = "/tmp/voxel-tiles-test.XXXXXX";
+    ASSERT_TRUE( ::mkdtemp( directory ) != NULL );
+    {
+        voxel_tiles first( Eigen::Vector3d( 0, 0, 0 ), Eigen::Vector3d( 1, 1, 1 ), directory, 4, 0, 1 );
+        voxel_tiles second( Eigen::Vector3d( 0, 0, 0 ), Eigen::Vector3d( 1, 1, 1 ), directory, 4, 0, 1 );
+        for( unsigned int i = 0; i < 10; ++i ) { first.insert( Eigen::Vector3d( 0.5, 0.5, 0.5 ) ); second.insert( Eigen::Vector3d( 1.5, 1.5, 1.5 ) ); }
+        first.commit();
+        second.commit();
+        ASSERT_EQ( 1u, first.tiles().size() );
+        ASSERT_EQ( 1u, second.tiles().size() );
+        std::vector< Eigen::Vector3d > points;
+        std::vector< Eigen::Vector3d > margin;
+        first.read( 0, points, margin );
+        EXPECT_EQ( std::vector< Eigen::Vector3d >( 10, Eigen::Vector3d( 0.5, 0.5, 0.5 ) ), points );
+        second.read( 0, points, margin );
+        EXPECT_EQ( std::vector< Eigen::Vector3d >( 10, Eigen::Vector3d( 1.5, 1.5, 1.5 ) ), points );
+    }
+    EXPECT_EQ( 0, ::rmdir( directory ) );
+}
+
+TEST( voxel_tiles, split )
+{
+    compare( 64, 0, 1000, 2000 );
+    compare( 64, 1, 1000, 2000 );
+}
+
+} // namespace snark {
@@ -45,15 +45,16 @@ namespace snark {
 /// @todo this class is mostly copy-pasted
 ///       just to allow refactoring elsewhere
 ///       refactor this class further, if needed
-template < typename V = boost::none_t, typename P = Eigen::Vector3d >
-class voxel_grid : public pin_screen< V >
+/// @param C column type, see pin_screen
+template < typename V = boost::none_t, typename P = Eigen::Vector3d, typename C = std::map< std::size_t, V > >
+class voxel_grid : public pin_screen< V, C >
 {
     public:
         typedef V voxel_type;
         typedef P point_type;
-        typedef typename pin_screen< V >::index_type index_type;
-        typedef typename pin_screen< V >::size_type size_type;
-        typedef typename pin_screen< V >::column_type column_type;
+        typedef typename pin_screen< V, C >::index_type index_type;
+        typedef typename pin_screen< V, C >::size_type size_type;
+        typedef typename pin_screen< V, C >::column_type column_type;
         typedef snark::math::closed_interval< typename P::Scalar, P::RowsAtCompileTime > interval_type;
         
         /// constructor
@@ -92,10 +93,10 @@ class voxel_grid : public pin_screen< V >
         const column_type* column( const point_type& p ) const;
         //column_type* column( const point_type& p ); // no non-const class in pin_screen for now
 
-        using typename pin_screen< voxel_type >::iterator;
-        using typename pin_screen< voxel_type >::const_iterator;
-        using typename pin_screen< voxel_type >::neighbourhood_iterator;
-        using pin_screen< voxel_type >::column;
+        using typename pin_screen< voxel_type, C >::iterator;
+        using typename pin_screen< voxel_type, C >::const_iterator;
+        using typename pin_screen< voxel_type, C >::neighbourhood_iterator;
+        using pin_screen< voxel_type, C >::column;
 
     private:
         interval_type extents_;
@@ -120,74 +121,74 @@ inline static Eigen::Matrix< std::size_t, 1, 2 > size( const math::closed_interv
 
 } // namespace detail {
 
-template < typename V, typename P >
-inline voxel_grid< V, P >::voxel_grid( const typename voxel_grid< V, P >::interval_type& extents
-                                , const typename voxel_grid< V, P >::point_type& resolution
+template < typename V, typename P, typename C >
+inline voxel_grid< V, P, C >::voxel_grid( const typename voxel_grid< V, P, C >::interval_type& extents
+                                , const typename voxel_grid< V, P, C >::point_type& resolution
                                 , bool adjusted )
-    : pin_screen< V >( detail::size( extents, resolution, adjusted ) )
+    : pin_screen< V, C >( detail::size( extents, resolution, adjusted ) )
     , extents_( detail::extents( extents, resolution, adjusted ) )
     , resolution_( resolution )
 {
 }
 
-template < typename V, typename P >
-inline const typename voxel_grid< V, P >::interval_type& voxel_grid< V, P >::extents() const { return extents_; }
+template < typename V, typename P, typename C >
+inline const typename voxel_grid< V, P, C >::interval_type& voxel_grid< V, P, C >::extents() const { return extents_; }
 
-template < typename V, typename P >
-inline const P& voxel_grid< V, P >::resolution() const { return resolution_; }
+template < typename V, typename P, typename C >
+inline const P& voxel_grid< V, P, C >::resolution() const { return resolution_; }
 
-template < typename V, typename P >
-inline typename voxel_grid< V, P >::index_type voxel_grid< V, P >::index_of( const P& p ) const
+template < typename V, typename P, typename C >
+inline typename voxel_grid< V, P, C >::index_type voxel_grid< V, P, C >::index_of( const P& p ) const
 {
     return index_type( std::floor( ( p.x() - extents_.min().x() ) / resolution_.x() )
                      , std::floor( ( p.y() - extents_.min().y() ) / resolution_.y() )
                      , std::floor( ( p.z() - extents_.min().z() ) / resolution_.z() ) );
 }
 
-template < typename V, typename P >
-inline bool voxel_grid< V, P >::covers( const P& p ) const
+template < typename V, typename P, typename C >
+inline bool voxel_grid< V, P, C >::covers( const P& p ) const
 {
     return extents_.contains( p );
 }
 
-template < typename V, typename P >
-inline V* voxel_grid< V, P >::touch_at( const P& p )
+template < typename V, typename P, typename C >
+inline V* voxel_grid< V, P, C >::touch_at( const P& p )
 {
     if( !covers( p ) ) { return NULL; }
     const index_type& i = index_of( p );
-    return &pin_screen< V >::touch( i );
+    return &pin_screen< V, C >::touch( i );
 }
 
-template < typename V, typename P >
-inline void voxel_grid< V, P >::erase_at( const P& point )
+template < typename V, typename P, typename C >
+inline void voxel_grid< V, P, C >::erase_at( const P& point )
 {
     if( !covers( point ) ) { return; }
-    pin_screen< V >::erase( index_of( point ) );
+    pin_screen< V, C >::erase( index_of( point ) );
 }
 
-template < typename V, typename P >
-inline P voxel_grid< V, P >::origin( const index_type& i ) const
+template < typename V, typename P, typename C >
+inline P voxel_grid< V, P, C >::origin( const index_type& i ) const
 {
     P p( resolution_[0] * i[0], resolution_[1] * i[1], resolution_[2] * i[2] );
     return extents_.min() + p;
 }
 
-template < typename V, typename P >
-inline P voxel_grid< V, P >::origin_at( const point_type& p ) const
+template < typename V, typename P, typename C >
+inline P voxel_grid< V, P, C >::origin_at( const point_type& p ) const
 {
     return origin( index_of( p ) );
 }
 
-template < typename V, typename P >
-const typename voxel_grid< V, P >::column_type* voxel_grid< V, P >::column( const point_type& p ) const
+template < typename V, typename P, typename C >
+const typename voxel_grid< V, P, C >::column_type* voxel_grid< V, P, C >::column( const point_type& p ) const
 {
     if( !covers( p ) ) { return NULL; }
     index_type index = index_of( p );
-    return &this->pin_screen< V >::column( index.x(), index.y() );
+    return &this->pin_screen< V, C >::column( index.x(), index.y() );
 }
 
-// template < typename V, typename P >
-// typename voxel_grid< V, P >::column_type* voxel_grid< V, P >::column( const point_type& p )
+// template < typename V, typename P, typename C >
+// typename voxel_grid< V, P, C >::column_type* voxel_grid< V, P, C >::column( const point_type& p )
 // {
 //     if( !covers( p ) ) { return NULL; }
 //     index i = index_of( p );
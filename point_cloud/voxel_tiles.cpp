@@ -0,0 +1,225 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <unistd.h>
+#include <boost/lexical_cast.hpp>
+#include <comma/base/exception.h>
+#include <snark/point_cloud/voxel_map.h>
+#include <snark/point_cloud/voxel_tiles.h>
+
+namespace snark {
+
+static comma::int32 floor_divide_( comma::int32 a, comma::int32 b ) { return a >= 0 ? a / b : -( ( -a + b - 1 ) / b ); }
+
+bool voxel_tiles::tile::contains( const voxel_tiles::index_type& voxel ) const
+{
+    for( unsigned int i = 0; i < 3; ++i )
+    {
+        comma::int64 begin = comma::int64( index[i] ) * size;
+        if( voxel[i] < begin || voxel[i] >= begin + size ) { return false; }
+    }
+    return true;
+}
+
+bool voxel_tiles::key::operator<( const voxel_tiles::key& rhs ) const
+{
+    if( block != rhs.block ) { return block < rhs.block; }
+    if( size != rhs.size ) { return size < rhs.size; }
+    return index < rhs.index;
+}
+
+voxel_tiles::voxel_tiles( const Eigen::Vector3d& origin
+                        , const Eigen::Vector3d& resolution
+                        , const std::string& directory
+                        , comma::uint32 size
+                        , comma::uint32 margin
+                        , std::size_t buffer_size )
+    : origin_( origin )
+    , resolution_( resolution )
+    , size_( 1 )
+    , margin_( margin )
+    , buffer_size_( buffer_size == 0 ? 1 : buffer_size )
+    , buffered_( 0 )
+    , files_( 0 )
+{
+    if( size == 0 ) { COMMA_THROW( comma::exception, "expected positive tile size" ); }
+    while( size_ < size ) { size_ *= 2; }
+    std::string pattern = directory + "/voxel-tiles.XXXXXX"; // own subdirectory, so that runs sharing directory or left over from killed runs do not clash
+    std::vector< char > d( pattern.begin(), pattern.end() );
+    d.push_back( 0 );
+    if( !::mkdtemp( &d[0] ) ) { COMMA_THROW( comma::exception, "failed to create temporary directory in " << directory ); }
+    directory_ = &d[0];
+}
+
+voxel_tiles::~voxel_tiles()
+{
+    for( std::size_t i = 0; i < files_; ++i )
+    {
+        std::remove( filename_( i, false ).c_str() );
+        std::remove( filename_( i, true ).c_str() );
+    }
+    ::rmdir( directory_.c_str() );
+}
+
+voxel_tiles::index_type voxel_tiles::index_of( const Eigen::Vector3d& point ) const { return voxel_map< int, 3 >::index_of( point, origin_, resolution_ ); }
+
+void voxel_tiles::insert( const Eigen::Vector3d& point, comma::uint32 block )
+{
+    static const index_type begin = {{ std::numeric_limits< comma::int32 >::min(), std::numeric_limits< comma::int32 >::min(), std::numeric_limits< comma::int32 >::min() }};
+    static const index_type end = {{ std::numeric_limits< comma::int32 >::max(), std::numeric_limits< comma::int32 >::max(), std::numeric_limits< comma::int32 >::max() }};
+    spread_( point, block, size_, begin, end );
+}
+
+void voxel_tiles::spread_( const Eigen::Vector3d& point, comma::uint32 block, comma::uint32 size, const index_type& begin, const index_type& end ) // quick and dirty: margin tiles of a point are all tiles within margin_ voxels, clipped to [begin,end)
+{
+    index_type voxel = index_of( point );
+    index_type home, lower, upper;
+    for( unsigned int i = 0; i < 3; ++i )
+    {
+        home[i] = floor_divide_( voxel[i], size );
+        lower[i] = std::max( floor_divide_( voxel[i] - margin_, size ), begin[i] );
+        upper[i] = std::min( floor_divide_( voxel[i] + margin_, size ) + 1, end[i] );
+    }
+    key k;
+    k.block = block;
+    k.size = size;
+    for( k.index[0] = lower[0]; k.index[0] < upper[0]; ++k.index[0] )
+    {
+        for( k.index[1] = lower[1]; k.index[1] < upper[1]; ++k.index[1] )
+        {
+            for( k.index[2] = lower[2]; k.index[2] < upper[2]; ++k.index[2] )
+            {
+                std::map< key, std::size_t >::iterator it = lookup_.find( k );
+                if( it == lookup_.end() )
+                {
+                    it = lookup_.insert( std::make_pair( k, entries_.size() ) ).first;
+                    entries_.push_back( entry() );
+                    entry& e = entries_.back();
+                    e.tile.block = block;
+                    e.tile.index = k.index;
+                    e.tile.size = size;
+                    e.tile.count = 0;
+                    e.tile.margin = 0;
+                    e.file = files_++;
+                    e.split = false;
+                    std::remove( filename_( e.file, false ).c_str() ); // files are appended to, thus make sure they start empty
+                    std::remove( filename_( e.file, true ).c_str() );
+                }
+                entry& e = entries_[ it->second ];
+                if( k.index == home ) { e.points.push_back( point ); ++e.tile.count; }
+                else { e.margin.push_back( point ); ++e.tile.margin; }
+                ++buffered_;
+            }
+        }
+    }
+    if( buffered_ >= buffer_size_ ) { flush_(); }
+}
+
+void voxel_tiles::commit( std::size_t max_points )
+{
+    flush_();
+    lookup_.clear();
+    if( max_points > 0 )
+    {
+        for( std::size_t i = 0; i < entries_.size(); ++i ) // entries_ grows as tiles get split
+        {
+            if( entries_[i].tile.count > 0 && entries_[i].tile.count + entries_[i].tile.margin > max_points && entries_[i].tile.size > 1 ) { split_( i ); }
+        }
+    }
+    std::vector< std::pair< comma::uint32, std::size_t > > order;
+    for( std::size_t i = 0; i < entries_.size(); ++i ) { if( !entries_[i].split && entries_[i].tile.count > 0 ) { order.push_back( std::make_pair( entries_[i].tile.block, i ) ); } }
+    std::stable_sort( order.begin(), order.end() );
+    tiles_.clear();
+    tile_files_.clear();
+    for( std::size_t i = 0; i < order.size(); ++i )
+    {
+        tiles_.push_back( entries_[ order[i].second ].tile );
+        tile_files_.push_back( entries_[ order[i].second ].file );
+    }
+}
+
+void voxel_tiles::split_( std::size_t i )
+{
+    tile t = entries_[i].tile;
+    std::size_t file = entries_[i].file;
+    index_type begin, end;
+    for( unsigned int d = 0; d < 3; ++d ) { begin[d] = t.index[d] * 2; end[d] = begin[d] + 2; }
+    for( unsigned int m = 0; m < 2; ++m )
+    {
+        std::ifstream ifs( filename_( file, m == 1 ).c_str(), std::ios::binary );
+        Eigen::Vector3d point;
+        while( ifs.read( reinterpret_cast< char* >( &point ), sizeof( Eigen::Vector3d ) ) ) { spread_( point, t.block, t.size / 2, begin, end ); }
+    }
+    flush_();
+    lookup_.clear();
+    std::remove( filename_( file, false ).c_str() );
+    std::remove( filename_( file, true ).c_str() );
+    entries_[i].split = true;
+}
+
+void voxel_tiles::flush_()
+{
+    for( std::size_t i = 0; i < entries_.size(); ++i )
+    {
+        for( unsigned int m = 0; m < 2; ++m )
+        {
+            std::vector< Eigen::Vector3d >& points = m == 0 ? entries_[i].points : entries_[i].margin;
+            if( points.empty() ) { continue; }
+            std::string filename = filename_( entries_[i].file, m == 1 );
+            std::ofstream ofs( filename.c_str(), std::ios::binary | std::ios::app );
+            if( !ofs.is_open() ) { COMMA_THROW( comma::exception, "failed to open " << filename ); }
+            ofs.write( reinterpret_cast< const char* >( &points[0] ), points.size() * sizeof( Eigen::Vector3d ) );
+            if( !ofs.good() ) { COMMA_THROW( comma::exception, "failed to write to " << filename ); }
+            std::vector< Eigen::Vector3d >().swap( points );
+        }
+    }
+    buffered_ = 0;
+}
+
+void voxel_tiles::read( std::size_t i, std::vector< Eigen::Vector3d >& points, std::vector< Eigen::Vector3d >& margin ) const
+{
+    for( unsigned int m = 0; m < 2; ++m )
+    {
+        std::vector< Eigen::Vector3d >& v = m == 0 ? points : margin;
+        v.resize( m == 0 ? tiles_[i].count : tiles_[i].margin );
+        if( v.empty() ) { continue; }
+        std::string filename = filename_( tile_files_[i], m == 1 );
+        std::ifstream ifs( filename.c_str(), std::ios::binary );
+        if( !ifs.read( reinterpret_cast< char* >( &v[0] ), v.size() * sizeof( Eigen::Vector3d ) ) ) { COMMA_THROW( comma::exception, "failed to read " << v.size() << " points from " << filename ); }
+    }
+}
+
+std::string voxel_tiles::filename_( std::size_t file, bool margin ) const { return directory_ + "/voxel-tiles." + boost::lexical_cast< std::string >( file ) + ( margin ? ".margin" : ".points" ); }
+
+} // namespace snark {
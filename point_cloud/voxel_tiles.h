@@ -0,0 +1,136 @@
+// This file is part of snark, a generic and flexible library for robotics research
+// Copyright (c) 2014 The University of Sydney
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+// 3. Neither the name of the University of Sydney nor the
+//    names of its contributors may be used to endorse or promote products
+//    derived from this software without specific prior written permission.
+//
+// NO EXPRESS OR IMPLIED LICENSES TO ANY PARTY'S PATENT RIGHTS ARE
+// GRANTED BY THIS LICENSE.  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT
+// HOLDERS AND CONTRIBUTORS \"AS IS\" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+// BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+// OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+// IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SNARK_POINT_CLOUD_VOXEL_TILES_H_
+#define SNARK_POINT_CLOUD_VOXEL_TILES_H_
+
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/array.hpp>
+#include <Eigen/Core>
+#include <comma/base/types.h>
+
+namespace snark {
+
+/// out-of-core spatial tiling of point clouds too large to voxelise in memory
+///
+/// points are spread into cubic tiles of voxels on disk through buffers of bounded size;
+/// each tile also keeps a copy of the points within a margin of voxels around it,
+/// so that it can be voxelised on its own, even if voxels depend on their neighbours
+///
+/// tiles with too many points are split into octants until they fit, thus memory
+/// needed to process a tile is bounded independently of point cloud size
+class voxel_tiles
+{
+    public:
+        /// voxel or tile index
+        typedef boost::array< comma::int32, 3 > index_type;
+
+        /// tile on disk
+        struct tile
+        {
+            comma::uint32 block;
+            index_type index; // in tiles, i.e. tile begins at voxel index * size
+            comma::uint32 size; // in voxels along each dimension
+            std::size_t count; // number of points in tile
+            std::size_t margin; // number of points in margin
+
+            /// return true, if voxel of given index belongs to tile
+            bool contains( const index_type& voxel ) const;
+        };
+
+        /// constructor
+        /// @param directory existing directory, in which a uniquely named subdirectory for tile files is created; the subdirectory is removed on destruction
+        /// @param size tile size in voxels, rounded up to a power of 2
+        /// @param margin margin around tiles in voxels
+        /// @param buffer_size maximum number of points buffered in memory
+        voxel_tiles( const Eigen::Vector3d& origin
+                   , const Eigen::Vector3d& resolution
+                   , const std::string& directory
+                   , comma::uint32 size
+                   , comma::uint32 margin = 0
+                   , std::size_t buffer_size = 1 << 20 );
+
+        /// destructor, removes tile files and their subdirectory
+        ~voxel_tiles();
+
+        /// add point to its tile and to margins of neighbouring tiles
+        void insert( const Eigen::Vector3d& point, comma::uint32 block = 0 );
+
+        /// flush buffers and split tiles with more than given number of points, including margin, into octants
+        /// @param max_points if 0, do not split tiles
+        void commit( std::size_t max_points = 0 );
+
+        /// return non-empty tiles after commit, ordered by block
+        const std::vector< tile >& tiles() const { return tiles_; }
+
+        /// read points of i-th tile and of its margin in the order they were inserted
+        void read( std::size_t i, std::vector< Eigen::Vector3d >& points, std::vector< Eigen::Vector3d >& margin ) const;
+
+        /// return voxel index of point
+        index_type index_of( const Eigen::Vector3d& point ) const;
+
+    private:
+        struct entry
+        {
+            voxel_tiles::tile tile;
+            std::size_t file;
+            bool split;
+            std::vector< Eigen::Vector3d > points;
+            std::vector< Eigen::Vector3d > margin;
+        };
+        struct key
+        {
+            comma::uint32 block;
+            comma::uint32 size;
+            index_type index;
+            bool operator<( const key& rhs ) const;
+        };
+        Eigen::Vector3d origin_;
+        Eigen::Vector3d resolution_;
+        std::string directory_;
+        comma::uint32 size_;
+        comma::int32 margin_;
+        std::size_t buffer_size_;
+        std::size_t buffered_;
+        std::size_t files_;
+        std::vector< entry > entries_;
+        std::map< key, std::size_t > lookup_;
+        std::vector< tile > tiles_;
+        std::vector< std::size_t > tile_files_;
+        void spread_( const Eigen::Vector3d& point, comma::uint32 block, comma::uint32 size, const index_type& begin, const index_type& end );
+        void split_( std::size_t i );
+        void flush_();
+        std::string filename_( std::size_t file, bool margin ) const;
+};
+
+} // namespace snark {
+
+#endif // SNARK_POINT_CLOUD_VOXEL_TILES_H_